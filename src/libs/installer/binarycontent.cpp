@@ -38,6 +38,7 @@
 #include "errors.h"
 #include "fileio.h"
 #include "fileutils.h"
+#include "operationlog.h"
 
 namespace QInstaller {
 
@@ -70,36 +71,43 @@ qint64 BinaryContent::findMagicCookie(QFile *in, quint64 magicCookie)
 
     const qint64 fileSize = in->size();
     const size_t markerSize = sizeof(qint64);
-    const qint64 maxSearch = qMin((1024LL * 1024LL), fileSize);
+    const qint64 maxSearch = qMin(qint64(MagicCookieSearchRange), fileSize);
 
-    QByteArray data(maxSearch, Qt::Uninitialized);
+    // scan the mapped file in place, read into a buffer only if mapping fails
+    QByteArray buffer;
     uchar *const mapped = in->map(fileSize - maxSearch, maxSearch);
     if (!mapped) {
         // Fallback to read the file content in case we can't map it.
 
         // Note: Failing to map the file can happen for example while having a remote connection
         // established to the privileged server process and we do not support map over the socket.
+        buffer.resize(maxSearch);
         const int pos = in->pos();
         try {
             in->seek(fileSize - maxSearch);
-            QInstaller::blockingRead(in, data.data(), maxSearch);
+            QInstaller::blockingRead(in, buffer.data(), maxSearch);
             in->seek(pos);
         } catch (const Error &error) {
             in->seek(pos);
             throw error;
         }
-    } else {
-        // map does not change QFile::pos()
-        data = QByteArray((const char*) mapped, maxSearch);
-        in->unmap(mapped);
     }
+    const char *const data = mapped ? reinterpret_cast<const char *>(mapped) : buffer.constData();
 
     qint64 searched = maxSearch - markerSize;
     while (searched >= 0) {
-        if (memcmp(&magicCookie, (data.data() + searched), markerSize) == 0)
-            return (fileSize - maxSearch) + searched;
+        if (memcmp(&magicCookie, (data + searched), markerSize) == 0)
+            break;
         --searched;
     }
+
+    // map does not change QFile::pos()
+    if (mapped)
+        in->unmap(mapped);
+
+    if (searched >= 0)
+        return (fileSize - maxSearch) + searched;
+
     throw Error(QCoreApplication::translate("QInstaller", "No marker found, stopped after %1.")
         .arg(humanReadableSize(maxSearch)));
 
@@ -207,16 +215,7 @@ void BinaryContent::readBinaryContent(QFile *file, QList<OperationBlob> *operati
             throw Error(QCoreApplication::translate("BinaryContent",
                 "Could not seek to %1 to read the operation data.").arg(posOfOperationsBlock));
         }
-        // read the operations count
-        qint64 operationsCount = QInstaller::retrieveInt64(file);
-        // read the operations
-        for (int i = 0; i < operationsCount; ++i) {
-            const QString name = QInstaller::retrieveString(file);
-            const QString xml = QInstaller::retrieveString(file);
-            operations->append(OperationBlob(name, xml));
-        }
-        // operations count
-        Q_UNUSED(QInstaller::retrieveInt64(file)) // read it, but deliberately not used
+        operations->append(OperationLog::read(file, layout.endOfExectuable));
     }
 
     if (manager) {    // read the collection index and data
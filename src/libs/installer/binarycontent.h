@@ -58,6 +58,9 @@ public:
     static const quint64 MagicCookie = 0xc2630a1c99d668f8LL;  // binary
     static const quint64 MagicCookieDat = 0xc2630a1c99d668f9LL; // data
 
+    // how far findMagicCookie() searches back from the end of the file
+    static const qint64 MagicCookieSearchRange = 1024LL * 1024LL;
+
     static qint64 findMagicCookie(QFile *file, quint64 magicCookie);
     static BinaryLayout binaryLayout(QFile *file, quint64 magicCookie);
 
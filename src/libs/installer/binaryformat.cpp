@@ -37,6 +37,7 @@
 #include "errors.h"
 #include "fileio.h"
 
+#include <QCryptographicHash>
 #include <QFileInfo>
 #include <QFlags>
 #include <QUuid>
@@ -46,8 +47,10 @@ namespace QInstaller {
 /*!
     \class QInstaller::OperationBlob
     \inmodule QtInstallerFramework
-    \brief The OperationBlob class is a textual representation of an operation that can be
+    \brief The OperationBlob class is a stored representation of an operation that can be
         instantiated and executed by the Qt Installer Framework.
+
+    The operation is either stored as XML or as an entry of a binary OperationLog.
 */
 
 /*!
@@ -57,6 +60,13 @@ namespace QInstaller {
     \a x for the XML representation of the operation.
 */
 
+/*!
+    \fn OperationBlob::OperationBlob(const QString &n, const QSharedPointer<const OperationLog> &l, int i)
+
+    Constructs the operation blob for the operation named \a n, stored at index \a i of the
+    binary operation log \a l.
+*/
+
 /*!
     \variable QInstaller::OperationBlob::name
     \brief The name of the operation.
@@ -67,6 +77,16 @@ namespace QInstaller {
     \brief The XML representation of the operation.
 */
 
+/*!
+    \variable QInstaller::OperationBlob::log
+    \brief The binary operation log holding the operation, if it is not stored as XML.
+*/
+
+/*!
+    \variable QInstaller::OperationBlob::index
+    \brief The index of the operation in \l log.
+*/
+
 /*!
     \class QInstaller::Resource
     \inmodule QtInstallerFramework
@@ -78,6 +98,16 @@ namespace QInstaller {
 
     The resource name can be set at any time using setName() or during construction. The segment
     supplied during construction represents the offset and size of the resource inside the file.
+
+    While open, the segment is memory mapped if possible and reads are served from the mapping. If
+    the file cannot be mapped, the resource falls back to reading from the file.
+*/
+
+/*!
+    \fn const uchar *Resource::mappedData() const
+
+    Returns the memory mapped content of the open resource, or \c 0 if the resource is closed or
+    could not be mapped. The mapping stays valid until the resource gets closed.
 */
 
 /*!
@@ -99,6 +129,7 @@ Resource::Resource(const QString &path)
     : m_file(path)
     , m_name(QFileInfo(path).fileName().toUtf8())
     , m_segment(Range<qint64>::fromStartAndLength(0, m_file.size()))
+    , m_mapped(0)
 {
 }
 
@@ -109,6 +140,7 @@ Resource::Resource(const QString &path, const QByteArray &name)
     : m_file(path)
     , m_name(name)
     , m_segment(Range<qint64>::fromStartAndLength(0, m_file.size()))
+    , m_mapped(0)
 {
 }
 
@@ -119,6 +151,7 @@ Resource::Resource(const QString &path, const Range<qint64> &segment)
     : m_file(path)
     , m_name(QFileInfo(path).fileName().toUtf8())
     , m_segment(segment)
+    , m_mapped(0)
 {
 }
 
@@ -169,8 +202,17 @@ bool Resource::open()
         return false;
     }
 
-    if (!QIODevice::open(QIODevice::ReadOnly)) {
+    // Note: Mapping fails for example over the remote file engine, we read from the file then.
+    if (m_segment.length() > 0)
+        m_mapped = m_file.map(m_segment.start(), m_segment.length(), QFileDevice::NoOptions);
+
+    // reading from the mapping needs no additional buffer
+    OpenMode mode = QIODevice::ReadOnly;
+    if (m_mapped)
+        mode |= QIODevice::Unbuffered;
+    if (!QIODevice::open(mode)) {
         setErrorString(tr("Could not open Resource '%1' read-only.").arg(QString::fromUtf8(m_name)));
+        close();
         return false;
     }
     return true;
@@ -180,6 +222,10 @@ bool Resource::open()
  */
 void Resource::close()
 {
+    if (m_mapped) {
+        m_file.unmap(m_mapped);
+        m_mapped = 0;
+    }
     m_file.close();
     QIODevice::close();
 }
@@ -202,6 +248,11 @@ qint64 Resource::readData(char* data, qint64 maxSize)
     if (maxSize <= 0)
         return 0;
 
+    if (m_mapped) {
+        memcpy(data, m_mapped + pos(), maxSize);
+        return maxSize;
+    }
+
     const qint64 p = m_file.pos();
     m_file.seek(m_segment.start() + pos());
     const qint64 amountRead = m_file.read(data, maxSize);
@@ -233,22 +284,17 @@ qint64 Resource::writeData(const char* data, qint64 maxSize)
 */
 void Resource::copyData(Resource *resource, QFileDevice *out)
 {
-    qint64 left = resource->size();
-    char data[4096];
-    while (left > 0) {
-        const qint64 len = qMin<qint64>(left, 4096);
-        const qint64 bytesRead = resource->read(data, len);
-        if (bytesRead != len) {
-            throw QInstaller::Error(tr("Read failed after %1 bytes: %2")
-                .arg(QString::number(resource->size() - left), resource->errorString()));
-        }
-        const qint64 bytesWritten = out->write(data, len);
-        if (bytesWritten != len) {
-            throw QInstaller::Error(tr("Write failed after %1 bytes: %2")
-                .arg(QString::number(resource->size() - left), out->errorString()));
-        }
-        left -= len;
+    if (const uchar *const mapped = resource->mappedData()) {
+        // Write in bounded blocks, the remote file engine sends every write as one packet.
+        static const qint64 blockSize = 4 * 1024 * 1024;
+        const char *const data = reinterpret_cast<const char *>(mapped);
+        for (qint64 pos = resource->pos(); pos < resource->size(); pos += blockSize)
+            QInstaller::blockingWrite(out, data + pos, qMin(blockSize, resource->size() - pos));
+        resource->seek(resource->size());
+        return;
     }
+
+    QInstaller::blockingCopy(resource, out, resource->size() - resource->pos());
 }
 
 
@@ -370,12 +416,58 @@ void ResourceCollectionManager::read(QFileDevice *dev, qint64 offset)
     }
 }
 
+/*
+    Returns a content key for each resource of \a collections that has the same size as some other
+    resource, so resources with equal keys hold the same data. Resources with a unique size cannot
+    have a duplicate and are neither read nor listed. Throws Error on failure.
+*/
+static QHash<const Resource *, QByteArray> contentKeys(const QList<ResourceCollection> &collections)
+{
+    QHash<qint64, QList<QSharedPointer<Resource> > > bySize;
+    foreach (const ResourceCollection &collection, collections) {
+        foreach (const QSharedPointer<Resource> &resource, collection.resources()) {
+            if (resource->size() > 0)
+                bySize[resource->size()].append(resource);
+        }
+    }
+
+    QHash<const Resource *, QByteArray> keys;
+    foreach (const QList<QSharedPointer<Resource> > &resources, bySize) {
+        if (resources.count() < 2)
+            continue;
+        foreach (const QSharedPointer<Resource> &resource, resources) {
+            if (keys.contains(resource.data()))
+                continue;   // the same resource is part of more than one collection
+            if (!resource->open()) {
+                throw QInstaller::Error(ResourceCollectionManager::tr("Could not open resource "
+                    "%1: %2").arg(QString::fromUtf8(resource->name()), resource->errorString()));
+            }
+            QCryptographicHash hash(QCryptographicHash::Sha1);
+            if (const uchar *const mapped = resource->mappedData())
+                hash.addData(reinterpret_cast<const char *>(mapped), resource->size());
+            else if (!hash.addData(resource.data()))
+                throw QInstaller::Error(ResourceCollectionManager::tr("Could not read resource "
+                    "%1: %2").arg(QString::fromUtf8(resource->name()), resource->errorString()));
+            resource->close();
+            keys.insert(resource.data(), QByteArray::number(resource->size()) + ':'
+                + hash.result());
+        }
+    }
+    return keys;
+}
+
 /*!
     Writes the resource collection to the file \a out. The \a offset argument is used to
     set the collection's segment information.
+
+    Resources with identical content are stored only once, no matter whether they are part of the
+    same or of different collections. The range of each duplicate points to the stored copy.
 */
 Range<qint64> ResourceCollectionManager::write(QFileDevice *out, qint64 offset) const
 {
+    const QHash<const Resource *, QByteArray> keys = contentKeys(m_collections.values());
+    QHash<QByteArray, Range<qint64> > stored;
+
     QHash < QByteArray, Range<qint64> > table;
     QInstaller::appendInt64(out, collectionCount());
     foreach (const ResourceCollection &collection, m_collections) {
@@ -389,14 +481,23 @@ Range<qint64> ResourceCollectionManager::write(QFileDevice *out, qint64 offset)
             + (2 * sizeof(qint64));     // the resource range (see QInstaller::appendInt64Range)
         }
 
+        QList<QSharedPointer<Resource> > data;
         foreach (const QSharedPointer<Resource> &resource, collection.resources()) {
+            const QByteArray key = keys.value(resource.data());
+            Range<qint64> range = stored.value(key);
+            if (key.isEmpty() || !stored.contains(key)) {
+                // the actual range once the table has been written
+                range = Range<qint64>::fromStartAndLength(start, resource->size());
+                start += resource->size();  // adjust for next resource data
+                if (!key.isEmpty())
+                    stored.insert(key, range);
+                data.append(resource);
+            }
             QInstaller::appendByteArray(out, resource->name());
-            QInstaller::appendInt64Range(out, Range<qint64>::fromStartAndLength(start,
-                resource->size()));     // the actual range once the table has been written
-            start += resource->size();  // adjust for next resource data
+            QInstaller::appendInt64Range(out, range);
         }
 
-        foreach (const QSharedPointer<Resource> &resource, collection.resources()) {
+        foreach (const QSharedPointer<Resource> &resource, data) {
             if (!resource->open()) {
                 throw QInstaller::Error(tr("Could not open resource %1: %2")
                     .arg(QString::fromUtf8(resource->name()), resource->errorString()));
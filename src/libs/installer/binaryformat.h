@@ -45,11 +45,17 @@
 
 namespace QInstaller {
 
+class OperationLog;
+
 struct OperationBlob {
     OperationBlob(const QString &n, const QString &x)
-        : name(n), xml(x) {}
+        : name(n), xml(x), index(-1) {}
+    OperationBlob(const QString &n, const QSharedPointer<const OperationLog> &l, int i)
+        : name(n), log(l), index(i) {}
     QString name;
     QString xml;
+    QSharedPointer<const OperationLog> log;
+    int index;
 };
 
 
@@ -76,6 +82,8 @@ public:
     Range<qint64> segment() const { return m_segment; }
     void setSegment(const Range<qint64> &segment) { m_segment = segment; }
 
+    const uchar *mappedData() const { return m_mapped; }
+
     void copyData(QFileDevice *out) { copyData(this, out); }
     static void copyData(Resource *archive, QFileDevice *out);
 
@@ -90,6 +98,7 @@ private:
     QFSFileEngine m_file;
     QByteArray m_name;
     Range<qint64> m_segment;
+    uchar *m_mapped;
 };
 
 
@@ -34,6 +34,8 @@
 
 #include "binaryformatengine.h"
 
+#include "errors.h"
+
 namespace {
 
 class StringListIterator : public QAbstractFileEngineIterator
@@ -195,24 +197,14 @@ bool BinaryFormatEngine::copy(const QString &newName)
     if (!target.open(QIODevice::WriteOnly))
         return false;
 
-    qint64 bytesLeft = size();
     if (!open(QIODevice::ReadOnly))
         return false;
 
-    char data[4096];
-    while(bytesLeft > 0) {
-        const qint64 len = qMin<qint64>(bytesLeft, 4096);
-        const qint64 bytesRead = read(data, len);
-        if (bytesRead != len) {
-            close();
-            return false;
-        }
-        const qint64 bytesWritten = target.write(data, len);
-        if (bytesWritten != len) {
-            close();
-            return false;
-        }
-        bytesLeft -= len;
+    try {
+        m_resource->copyData(&target);
+    } catch (const Error &) {
+        close();
+        return false;
     }
     close();
 
@@ -286,6 +278,42 @@ QStringList BinaryFormatEngine::entryList(QDir::Filters filters, const QStringLi
     return entries;
 }
 
+/*!
+    \internal
+
+    Maps are handed out from the memory mapped resource, so QFile::map() works on resources without
+    another mapping. Unmapping is a no-op, the mapping is released once the resource is closed.
+*/
+bool BinaryFormatEngine::extension(Extension extension, const ExtensionOption *option,
+    ExtensionReturn *output)
+{
+    if (!supportsExtension(extension))
+        return false;
+
+    if (extension == UnMapExtension)
+        return true;
+
+    const MapExtensionOption *const mapOption = static_cast<const MapExtensionOption *>(option);
+    if (mapOption->offset < 0 || mapOption->size < 0
+        || mapOption->offset + mapOption->size > m_resource->size()) {
+            return false;
+    }
+
+    MapExtensionReturn *const mapReturn = static_cast<MapExtensionReturn *>(output);
+    mapReturn->address = const_cast<uchar *>(m_resource->mappedData()) + mapOption->offset;
+    return true;
+}
+
+/*!
+    \internal
+*/
+bool BinaryFormatEngine::supportsExtension(Extension extension) const
+{
+    if (m_resource.isNull() || !m_resource->mappedData())
+        return false;
+    return extension == MapExtension || extension == UnMapExtension;
+}
+
 /*!
     \internal
 */
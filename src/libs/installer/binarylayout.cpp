@@ -46,13 +46,17 @@
         Plain data (QResource)
     [Format]
     ----------------------------------------------------------
-    Operation count (qint64)
-    Operation entry [1 ... n]
+    Operation log segment
     [Format]
-        Name (qint64, QString)
-        XML (qint64, QString)
+        Marker (qint64, -1)
+        Version (qint64)
+        Id (qint64, QByteArray)
+        Chain length (qint64)
+        Stored operations (qint64)
+        Previous segment [Offset (qint64)]
+        Previous segment [Length (qint64)]
+        Payload (qint64, QByteArray)
     [Format]
-    Operation count (qint64)
     ----------------------------------------------------------
     Collection count
     Collection data entry [1 ... n]
@@ -99,4 +103,10 @@
     Magic cookie (qint64)
 
     \endcode
+
+    The maintenance tool may append further operation log segments to its separate data file,
+    each followed by a complete trailer starting at the collection index block. The last trailer
+    is the one that counts; the operations information block points to the last segment, which
+    refers to the segment before it. Data written by earlier versions stores the operations as
+    a list of name and XML entries instead, see OperationLog::read().
 */
@@ -40,6 +40,7 @@
 #include "lib7z_facade.h"
 #include "messageboxhandler.h"
 #include "packagemanagercore.h"
+#include "packagemanagercore_p.h"
 #include "remoteclient.h"
 #include "settings.h"
 #include "utils.h"
@@ -439,6 +440,14 @@ void Component::appendComponent(Component *component)
         parent->removeComponent(component);
     component->d->m_parentComponent = this;
     setTristate(d->m_childComponents.count() > 0);
+
+    // if we are already part of the component tree, the new subtree needs to be found by name too
+    PackageManagerCorePrivate *const core = d->m_core->d;
+    if (core->m_componentIndex.contains(this)) {
+        core->indexComponent(component, core->m_componentIndex);
+        foreach (Component *descendant, component->descendantComponents())
+            core->indexComponent(descendant, core->m_componentIndex);
+    }
 }
 
 /*!
@@ -448,6 +457,13 @@ void Component::appendComponent(Component *component)
 void Component::removeComponent(Component *component)
 {
     if (component->parentComponent() == this) {
+        PackageManagerCorePrivate *const core = d->m_core->d;
+        if (core->m_componentIndex.contains(component)) {
+            foreach (Component *descendant, component->descendantComponents())
+                core->m_componentIndex.remove(descendant);
+            core->m_componentIndex.remove(component);
+        }
+
         component->d->m_parentComponent = 0;
         d->m_childComponents.removeAll(component);
         d->m_allChildComponents.removeAll(component);
@@ -682,8 +698,10 @@ QWidget *Component::userInterface(const QString &name) const
     \note If you call this method from a script, it will not call the script's method with the same
     name.
 
-    The default implementation is recursively creating Copy and Mkdir operations for all files
-    and folders within \a path.
+    The default implementation creates a Copy operation for a file and a single CopyTree operation
+    for a folder. If the component script provides its own createOperationsForPath method, folders
+    are walked recursively instead, creating a Mkdir operation for each folder and calling the
+    script method for each entry.
 
     \sa {component::createOperationsForPath}{component.createOperationsForPath}
 */
@@ -709,6 +727,13 @@ void Component::createOperationsForPath(const QString &path)
         static const QString copy = QString::fromLatin1("Copy");
         addOperation(copy, fi.filePath(), target);
     } else if (fi.isDir()) {
+        // nothing below can be overridden by the script, install the folder as a whole
+        if (!d->m_scriptContext.property(QLatin1String("createOperationsForPath")).isCallable()) {
+            static const QString copyTree = QString::fromLatin1("CopyTree");
+            addOperation(copyTree, fi.filePath(), target);
+            return;
+        }
+
         qApp->processEvents();
         static const QString mkdir = QString::fromLatin1("Mkdir");
         addOperation(mkdir, target);
@@ -54,7 +54,6 @@ QStringList ComponentChecker::checkComponent(Component *component)
     const bool defaultPropertyScriptValue = component->variables().value(scDefault).compare(scScript, Qt::CaseInsensitive) == 0;
     const bool defaultPropertyValue = component->variables().value(scDefault).compare(scTrue, Qt::CaseInsensitive) == 0;
     const QStringList autoDependencies = component->autoDependencies();
-    const QList<Component *> allComponents = core->components(PackageManagerCore::ComponentType::All);
     if (!autoDependencies.isEmpty()) {
         if (component->forcedInstallation()) {
             checkResult << QString::fromLatin1("Component %1 specifies \"ForcedInstallation\" property "
@@ -78,8 +77,7 @@ QStringList ComponentChecker::checkComponent(Component *component)
         }
         const QStringList dependencies = component->dependencies();
         foreach (const QString &dependency, dependencies) {
-            Component *dependencyComponent = PackageManagerCore::componentByName(
-                        dependency, allComponents);
+            Component *dependencyComponent = core->componentByName(dependency);
             if (dependencyComponent && autoDependencies.contains(dependencyComponent->name())) {
                 checkResult << QString::fromLatin1("Component %1 specifies both dependency "
                     "and auto dependency on component %2. The dependency might be superfluous.")
@@ -159,8 +157,7 @@ QStringList ComponentChecker::checkComponent(Component *component)
             }
         }
         foreach (const QString &autoDependency, autoDependencies) {
-            Component *autoDependencyComponent = PackageManagerCore::componentByName(
-                        autoDependency, allComponents);
+            Component *autoDependencyComponent = core->componentByName(autoDependency);
             if (autoDependencyComponent && autoDependencyComponent->childCount()) {
                 checkResult << QString::fromLatin1("Component %1 auto depends on component %2 "
                     "which has children components. This will not work properly.")
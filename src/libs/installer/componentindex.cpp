@@ -0,0 +1,253 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "componentindex.h"
+
+#include "component.h"
+#include "packagemanagercore.h"
+
+namespace QInstaller {
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::ComponentIndex
+    \internal
+    \brief The ComponentIndex class provides constant time lookup of components by name and of
+    the components depending on a given component.
+
+    The index keeps a name to component table and a reverse dependency table with the already
+    parsed version requirements, so that neither lookup has to walk the component tree or split
+    the \c Dependencies value again.
+*/
+
+ComponentIndex::ComponentIndex()
+{
+}
+
+void ComponentIndex::clear()
+{
+    m_entries.clear();
+    m_componentsByName.clear();
+    m_dependees.clear();
+}
+
+void ComponentIndex::reserve(int size)
+{
+    m_entries.reserve(size);
+    m_componentsByName.reserve(size);
+}
+
+bool ComponentIndex::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+int ComponentIndex::count() const
+{
+    return m_entries.count();
+}
+
+bool ComponentIndex::contains(const Component *component) const
+{
+    return m_entries.contains(component);
+}
+
+/*!
+    Adds \a component to the index. Replacement components, marked by \a replacement, are only
+    taken into account when searching for dependees. Inserting an already indexed component does
+    nothing.
+*/
+void ComponentIndex::insert(Component *component, bool replacement)
+{
+    if (!component || m_entries.contains(component))
+        return;
+    insertEntry(component, createEntry(component, replacement));
+}
+
+void ComponentIndex::remove(const Component *component)
+{
+    const QHash<const Component *, Entry>::iterator it = m_entries.find(component);
+    if (it == m_entries.end())
+        return;
+    removeEntry(component, it.value());
+    m_entries.erase(it);
+}
+
+/*!
+    Re-reads the name and dependencies of an already indexed \a component.
+*/
+void ComponentIndex::update(Component *component)
+{
+    const QHash<const Component *, Entry>::iterator it = m_entries.find(component);
+    if (it == m_entries.end())
+        return;
+
+    const bool replacement = it.value().replacement;
+    removeEntry(component, it.value());
+    m_entries.erase(it);
+    insertEntry(component, createEntry(component, replacement));
+}
+
+/*!
+    Returns a non replacement component matching \a name. \a name can also contain a version
+    requirement, see PackageManagerCore::componentByName(). Returns \c 0 if no component matches.
+*/
+Component *ComponentIndex::componentByName(const QString &name) const
+{
+    if (name.isEmpty())
+        return 0;
+
+    QString fixedName;
+    QString fixedVersion;
+    splitNameAndVersion(name, &fixedName, &fixedVersion);
+
+    const QHash<QString, QList<Component *> >::const_iterator it = m_componentsByName.find(fixedName);
+    if (it == m_componentsByName.constEnd())
+        return 0;
+
+    foreach (Component *component, it.value()) {
+        if (m_entries.value(component).replacement)
+            continue;
+        if (fixedVersion.isEmpty()
+            || PackageManagerCore::versionMatches(component->value(scVersion), fixedVersion)) {
+                return component;
+        }
+    }
+    return 0;
+}
+
+/*!
+    Returns the indexed components, including replacements, that have a dependency on
+    \a component. Automatic dependencies are not taken into account.
+*/
+QList<Component *> ComponentIndex::dependees(const Component *component) const
+{
+    QList<Component *> result;
+    if (!component)
+        return result;
+
+    const QString name = component->name();
+    if (name.isEmpty())
+        return result;
+
+    const QHash<QString, QList<Dependee> >::const_iterator it = m_dependees.find(name);
+    if (it == m_dependees.constEnd())
+        return result;
+
+    foreach (const Dependee &dependee, it.value()) {
+        if (dependee.version.isEmpty()
+            || PackageManagerCore::versionMatches(component->value(scVersion), dependee.version)) {
+                result.append(dependee.component);
+        }
+    }
+    return result;
+}
+
+/*!
+    Splits \a requirement of the form \c{name-version} into \a name and \a version. Everything
+    after the first dash is considered to be the version requirement.
+*/
+void ComponentIndex::splitNameAndVersion(const QString &requirement, QString *name,
+    QString *version)
+{
+    const int dash = requirement.indexOf(QLatin1Char('-'));
+    if (dash < 0) {
+        *name = requirement;
+        version->clear();
+    } else {
+        *name = requirement.left(dash);
+        *version = requirement.mid(dash + 1);
+    }
+}
+
+
+// -- private
+
+ComponentIndex::Entry ComponentIndex::createEntry(const Component *component, bool replacement)
+{
+    Entry entry;
+    entry.name = component->name();
+    entry.replacement = replacement;
+
+    const QStringList dependencies = component->dependencies();
+    entry.dependencies.reserve(dependencies.count());
+    foreach (const QString &dependency, dependencies) {
+        Requirement requirement;
+        splitNameAndVersion(dependency, &requirement.name, &requirement.version);
+        entry.dependencies.append(requirement);
+    }
+    return entry;
+}
+
+void ComponentIndex::insertEntry(Component *component, const Entry &entry)
+{
+    m_entries.insert(component, entry);
+    if (!entry.name.isEmpty())
+        m_componentsByName[entry.name].append(component);
+
+    foreach (const Requirement &requirement, entry.dependencies) {
+        Dependee dependee;
+        dependee.component = component;
+        dependee.version = requirement.version;
+        m_dependees[requirement.name].append(dependee);
+    }
+}
+
+void ComponentIndex::removeEntry(const Component *component, const Entry &entry)
+{
+    if (!entry.name.isEmpty()) {
+        QHash<QString, QList<Component *> >::iterator it = m_componentsByName.find(entry.name);
+        if (it != m_componentsByName.end()) {
+            it.value().removeAll(const_cast<Component *>(component));
+            if (it.value().isEmpty())
+                m_componentsByName.erase(it);
+        }
+    }
+
+    foreach (const Requirement &requirement, entry.dependencies) {
+        QHash<QString, QList<Dependee> >::iterator it = m_dependees.find(requirement.name);
+        if (it == m_dependees.end())
+            continue;
+
+        QList<Dependee> &list = it.value();
+        for (int i = list.count() - 1; i >= 0; --i) {
+            if (list.at(i).component == component)
+                list.removeAt(i);
+        }
+        if (list.isEmpty())
+            m_dependees.erase(it);
+    }
+}
+
+} // namespace QInstaller
@@ -0,0 +1,102 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef COMPONENTINDEX_H
+#define COMPONENTINDEX_H
+
+#include "installer_global.h"
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+namespace QInstaller {
+
+class Component;
+
+class INSTALLER_EXPORT ComponentIndex
+{
+public:
+    ComponentIndex();
+
+    void clear();
+    void reserve(int size);
+
+    bool isEmpty() const;
+    int count() const;
+    bool contains(const Component *component) const;
+
+    void insert(Component *component, bool replacement = false);
+    void remove(const Component *component);
+    void update(Component *component);
+
+    Component *componentByName(const QString &name) const;
+    QList<Component *> dependees(const Component *component) const;
+
+    static void splitNameAndVersion(const QString &requirement, QString *name, QString *version);
+
+private:
+    struct Requirement
+    {
+        QString name;
+        QString version;
+    };
+
+    struct Entry
+    {
+        QString name;
+        QList<Requirement> dependencies;
+        bool replacement;
+    };
+
+    struct Dependee
+    {
+        Component *component;
+        QString version;
+    };
+
+    void insertEntry(Component *component, const Entry &entry);
+    void removeEntry(const Component *component, const Entry &entry);
+    static Entry createEntry(const Component *component, bool replacement);
+
+    QHash<const Component *, Entry> m_entries;
+    // component name -> components with that name, in insertion order
+    QHash<QString, QList<Component *> > m_componentsByName;
+    // dependency name -> components depending on it, together with the required version
+    QHash<QString, QList<Dependee> > m_dependees;
+};
+
+} // namespace QInstaller
+
+#endif // COMPONENTINDEX_H
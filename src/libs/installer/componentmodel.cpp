@@ -565,8 +565,10 @@ QSet<QModelIndex> ComponentModel::updateCheckedState(const ComponentSet &compone
 {
     // get all parent nodes for the components we're going to update
     QMap<QString, Component *> sortedNodesMap;
+    ComponentSet visited;
     foreach (Component *component, components) {
-        while (component && !sortedNodesMap.values(component->name()).contains(component)) {
+        while (component && !visited.contains(component)) {
+            visited.insert(component);
             sortedNodesMap.insertMulti(component->name(), component);
             component = component->parentComponent();
         }
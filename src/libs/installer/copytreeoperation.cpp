@@ -0,0 +1,350 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "copytreeoperation.h"
+
+#include "fileremover.h"
+#include "fileutils.h"
+#include "packagemanagercore.h"
+#include "remoteclient.h"
+#include "remotefileoperations.h"
+
+#include <QtConcurrentMap>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSharedPointer>
+
+using namespace QInstaller;
+
+/*!
+    \class QInstaller::CopyTreeOperation
+    \inmodule QtInstallerFramework
+    \brief The CopyTreeOperation class installs a folder with all its contents.
+
+    The operation takes the place of one Mkdir operation per folder and one Copy operation per
+    file. The folders are created first, including missing parents of the target folder, then the
+    files are copied side by side. All created
+    folders and copied files are recorded in one compact list, which undoOperation() removes as
+    a whole. Files that exist already are overwritten; their backups are restored on undo as long
+    as the operation object lives.
+
+    Symbolic links are copied as links, they are not followed. A link to a path inside the copied
+    folder points to the copy of that path. Checksum files next to the file they belong to are not
+    copied.
+*/
+
+class CopyTreeOperation::FileCopier
+{
+public:
+    struct Result
+    {
+        QString backup;
+        QString error;
+    };
+    typedef Result result_type;
+
+    FileCopier(CopyTreeOperation *operation, const QString &sourcePath, const QString &targetPath,
+            int total, RemoteFileOperations *fileOperations = 0)
+        : m_operation(operation)
+        , m_sourcePath(QFileInfo(sourcePath).absoluteFilePath())
+        , m_targetPath(QFileInfo(targetPath).absoluteFilePath())
+        , m_total(total)
+        , m_copied(new QAtomicInt(0))
+        , m_fileOperations(fileOperations)
+    {}
+
+    Result operator()(const QPair<QString, QString> &file) const
+    {
+        Result result;
+        if (m_operation->m_canceled.load() != 0) {
+            result.error = tr("Copying \"%1\" was canceled.").arg(file.first);
+            return result;
+        }
+
+        const QString &target = file.second;
+        if (QFileInfo(target).exists() || QFileInfo(target).isSymLink()) {
+            const QString backup = target + QLatin1String(".tmpUpdate");
+            result.backup = backup;
+            for (int i = 0; QFileInfo(result.backup).exists(); ++i)
+                result.backup = backup + QString::fromLatin1(".%1").arg(i);
+            if (!QFile::rename(target, result.backup)) {
+                result.error = tr("Cannot back up file \"%1\".").arg(target);
+                result.backup.clear();
+                return result;
+            }
+        }
+
+        const QFileInfo sourceInfo(file.first);
+        if (sourceInfo.isSymLink()) {
+            QString linkTarget = sourceInfo.symLinkTarget();
+            if (linkTarget == m_sourcePath
+                || linkTarget.startsWith(m_sourcePath + QLatin1Char('/'))) {
+                linkTarget = m_targetPath + linkTarget.mid(m_sourcePath.length());
+            }
+            if (!QFile::link(linkTarget, target))
+                result.error = tr("Cannot create link \"%1\" to \"%2\".").arg(target, linkTarget);
+        } else if (m_fileOperations) {
+            // one request per file, the server reads and writes the data itself
+            if (!m_fileOperations->copyFile(file.first, target))
+                result.error = m_fileOperations->errorString();
+        } else {
+            QFile source(file.first);
+            if (!source.copy(target)) {
+                result.error = tr("Cannot copy file \"%1\" to \"%2\": %3").arg(file.first, target,
+                    source.errorString());
+            }
+        }
+
+        if (!result.error.isEmpty()) {
+            if (!result.backup.isEmpty() && QFile::rename(result.backup, target))
+                result.backup.clear();
+            return result;
+        }
+
+        emit m_operation->outputTextChanged(QDir::toNativeSeparators(target));
+        emit m_operation->progressChanged(double(m_copied->fetchAndAddRelaxed(1) + 1) / m_total);
+        return result;
+    }
+
+private:
+    CopyTreeOperation *const m_operation;
+    const QString m_sourcePath;
+    const QString m_targetPath;
+    const int m_total;
+    QSharedPointer<QAtomicInt> m_copied;
+    RemoteFileOperations *const m_fileOperations;
+};
+
+// QDir::cleanPath() would turn installer:// into installer:/, only strip trailing separators
+static QString withoutTrailingSeparator(QString path)
+{
+    while (path.length() > 1
+        && (path.endsWith(QLatin1Char('/')) || path.endsWith(QLatin1Char('\\')))) {
+        path.chop(1);
+    }
+    return path;
+}
+
+CopyTreeOperation::CopyTreeOperation()
+{
+    setName(QLatin1String("CopyTree"));
+}
+
+CopyTreeOperation::~CopyTreeOperation()
+{
+    for (int i = 0; i < m_backups.count(); ++i)
+        deleteFileNowOrLater(m_backups.at(i).second);
+}
+
+void CopyTreeOperation::backup()
+{
+    // files that get overwritten are backed up while copying
+}
+
+bool CopyTreeOperation::performOperation()
+{
+    const QStringList args = arguments();
+    if (args.count() != 2) {
+        setError(InvalidArguments);
+        setErrorString(tr("Invalid arguments in %0: %1 arguments given, %2 expected%3.")
+            .arg(name()).arg(arguments().count()).arg(tr("exactly 2"),
+            tr(" (<source> <target>)")));
+        return false;
+    }
+
+    const QString sourcePath = withoutTrailingSeparator(args.at(0));
+    const QString targetPath = withoutTrailingSeparator(args.at(1));
+    if (!QFileInfo(sourcePath).isDir()) {
+        setError(UserDefinedError);
+        setErrorString(tr("Cannot copy \"%1\": Not a folder.").arg(sourcePath));
+        return false;
+    }
+
+    // walk the tree once, a folder is always listed before its contents; links are not followed
+    QStringList directories;
+    QList<QPair<QString, QString> > files;
+    QDirIterator it(sourcePath, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden
+        | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QFileInfo fi(it.next());
+        const QString target = targetPath + fi.filePath().mid(sourcePath.length());
+        if (fi.isSymLink()) {
+            files.append(qMakePair(fi.filePath(), target));
+        } else if (fi.isDir()) {
+            directories.append(target);
+        } else if (fi.suffix() != QLatin1String("sha1")
+            || !QFileInfo(fi.dir(), fi.completeBaseName()).exists()) {
+            files.append(qMakePair(fi.filePath(), target));
+        }
+    }
+
+    // The target may be missing several levels deep. Every level created is recorded, outermost
+    // first, so undo removes all of them.
+    QStringList createdPaths;
+    for (QString path = targetPath; !QFileInfo(path).exists();) {
+        createdPaths.prepend(path);
+        const QString parent = QFileInfo(path).absolutePath();
+        if (parent == QFileInfo(path).absoluteFilePath())
+            break;
+        path = parent;
+    }
+
+    QDir dir;
+    if (!QFileInfo(targetPath).isDir() && !dir.mkpath(targetPath)) {
+        setError(UserDefinedError);
+        setErrorString(tr("Cannot create folder \"%1\".").arg(targetPath));
+        return false;
+    }
+    m_files.append(createdPaths);
+
+    foreach (const QString &directory, directories) {
+        if (QFileInfo(directory).isDir())
+            continue;
+        if (!dir.mkdir(directory)) {
+            setError(UserDefinedError);
+            setErrorString(tr("Cannot create folder \"%1\".").arg(directory));
+            return false;
+        }
+        m_files.append(directory);
+    }
+
+    QMetaObject::Connection connection;
+    if (PackageManagerCore *core = value(QLatin1String("installer")).value<PackageManagerCore*>()) {
+        connection = connect(core, &PackageManagerCore::statusChanged, this,
+            [this](PackageManagerCore::Status status) {
+                if (status == PackageManagerCore::Canceled || status == PackageManagerCore::Failure)
+                    m_canceled.store(1);
+            });
+    }
+
+    // The files are copied side by side. With a running server, the server copies them one by
+    // one; only the backups of overwritten files are made from here.
+    QList<FileCopier::Result> results;
+    if (RemoteClient::instance().isActive()) {
+        RemoteFileOperations fileOperations;
+        const FileCopier copier(this, sourcePath, targetPath, files.count(), &fileOperations);
+        for (int i = 0; i < files.count(); ++i)
+            results.append(copier(files.at(i)));
+    } else {
+        const FileCopier copier(this, sourcePath, targetPath, files.count());
+        results = QtConcurrent::blockingMapped<QList<FileCopier::Result> >(files, copier);
+    }
+    disconnect(connection);
+
+    QString errorString;
+    for (int i = 0; i < files.count(); ++i) {
+        const FileCopier::Result &result = results.at(i);
+        if (!result.error.isEmpty()) {
+            if (errorString.isEmpty())
+                errorString = result.error;
+            continue;
+        }
+        m_files.append(files.at(i).second);
+        if (!result.backup.isEmpty())
+            m_backups.append(qMakePair(files.at(i).second, result.backup));
+    }
+
+    if (!errorString.isEmpty()) {
+        setError(UserDefinedError);
+        setErrorString(errorString);
+        return false;
+    }
+    return true;
+}
+
+bool CopyTreeOperation::undoOperation()
+{
+    FileRemover remover;
+    connect(&remover, &FileRemover::progressChanged, this, [this](int processed, int total) {
+        if (total > 0)
+            emit progressChanged(double(processed) / total);
+    }, Qt::DirectConnection);
+
+    // files that are in use get removed later, folders still containing other files are kept
+    foreach (const QString &file, remover.removePaths(m_files))
+        deleteFileNowOrLater(file);
+
+    for (int i = 0; i < m_backups.count(); ++i)
+        QFile::rename(m_backups.at(i).second, m_backups.at(i).first);
+    m_backups.clear();
+    return true;
+}
+
+bool CopyTreeOperation::testOperation()
+{
+    return true;
+}
+
+Operation *CopyTreeOperation::clone() const
+{
+    return new CopyTreeOperation();
+}
+
+/*!
+    Returns the folders created and files copied by the operation, in the order they were created.
+*/
+QStringList CopyTreeOperation::copiedFiles() const
+{
+    return m_files;
+}
+
+/*!
+    \reimp
+
+    The created folders and copied files are stored as one compressed value.
+*/
+QVariantMap CopyTreeOperation::persistentValues() const
+{
+    QVariantMap values = Operation::persistentValues();
+    if (!m_files.isEmpty())
+        values.insert(QLatin1String("fileList"), encodeFileList(m_files));
+    return values;
+}
+
+/*!
+    \reimp
+*/
+bool CopyTreeOperation::setPersistentValues(const QVariantMap &values)
+{
+    if (!Operation::setPersistentValues(values))
+        return false;
+
+    m_files.clear();
+    if (hasValue(QLatin1String("fileList"))) {
+        m_files = decodeFileList(value(QLatin1String("fileList")).toByteArray());
+        clearValue(QLatin1String("fileList"));
+    }
+    return true;
+}
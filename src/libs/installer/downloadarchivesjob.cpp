@@ -35,19 +35,52 @@
 
 #include "binaryformatenginehandler.h"
 #include "component.h"
+#include "constants.h"
 #include "messageboxhandler.h"
 #include "packagemanagercore.h"
 #include "utils.h"
 
 #include "kdupdaterfiledownloader.h"
+#include "kdupdaterfiledownloader_p.h"
 #include "kdupdaterfiledownloaderfactory.h"
 
 #include <QtCore/QFile>
 #include <QtCore/QTimerEvent>
+#include <QtCore/QUrl>
+#include <QtCore/QVector>
+
+#include <algorithm>
 
 using namespace QInstaller;
 using namespace KDUpdater;
 
+typedef QPair<QString, QString> ArchivePair;
+typedef QPair<qint64, ArchivePair> SizedArchive;
+
+/*
+    One archive in flight. With checksum tests enabled its .sha1 file is fetched in parallel to
+    the archive itself, the archive gets registered once both have arrived.
+*/
+struct DownloadArchivesJob::Download
+{
+    explicit Download(const ArchivePair &a)
+        : archive(a)
+        , archiveDownloader(0)
+        , hashDownloader(0)
+        , archiveFinished(false)
+        , hashFinished(false)
+        , progress(0)
+    {}
+
+    ArchivePair archive;
+    FileDownloader *archiveDownloader;
+    FileDownloader *hashDownloader;
+    QByteArray hash;
+    bool archiveFinished;
+    bool hashFinished;
+    double progress;
+};
+
 
 /*!
     Creates a new DownloadArchivesJob with \a parent.
@@ -55,11 +88,11 @@ using namespace KDUpdater;
 DownloadArchivesJob::DownloadArchivesJob(PackageManagerCore *core)
     : KDJob(core)
     , m_core(core)
-    , m_downloader(0)
     , m_archivesDownloaded(0)
     , m_archivesToDownloadCount(0)
+    , m_maxConcurrentDownloads(4)
+    , m_preserveOrder(false)
     , m_canceled(false)
-    , m_lastFileProgress(0)
     , m_progressChangedTimerId(0)
 {
     setCapabilities(Cancelable);
@@ -70,8 +103,7 @@ DownloadArchivesJob::DownloadArchivesJob(PackageManagerCore *core)
 */
 DownloadArchivesJob::~DownloadArchivesJob()
 {
-    if (m_downloader)
-        m_downloader->deleteLater();
+    abortDownloads();
 }
 
 /*!
@@ -82,6 +114,37 @@ void DownloadArchivesJob::setArchivesToDownload(const QList<QPair<QString, QStri
 {
     m_archivesToDownload = archives;
     m_archivesToDownloadCount = archives.count();
+
+    m_pendingArchives.clear();
+    foreach (const ArchivePair &archive, archives)
+        m_pendingArchives.insert(archive.first);
+}
+
+/*!
+    Sets the number of archives that are downloaded at the same time to \a count. The default
+    is 4.
+*/
+void DownloadArchivesJob::setMaxConcurrentDownloads(int count)
+{
+    m_maxConcurrentDownloads = qMax(1, count);
+}
+
+/*!
+    Sets whether the archives are downloaded in the order they were passed to
+    setArchivesToDownload() to \a preserveOrder. By default the largest archives are fetched first.
+*/
+void DownloadArchivesJob::setPreserveOrder(bool preserveOrder)
+{
+    m_preserveOrder = preserveOrder;
+}
+
+/*!
+    Returns \c true if \a archive is still to be downloaded and registered. Archives that could not
+    be scheduled are not pending.
+*/
+bool DownloadArchivesJob::isArchivePending(const QString &archive) const
+{
+    return m_pendingArchives.contains(archive);
 }
 
 /*!
@@ -90,7 +153,26 @@ void DownloadArchivesJob::setArchivesToDownload(const QList<QPair<QString, QStri
 void DownloadArchivesJob::doStart()
 {
     m_archivesDownloaded = 0;
-    fetchNextArchiveHash();
+    if (m_preserveOrder) {
+        startDownloads();
+        return;
+    }
+
+    // Start with the largest archives, so that a big one does not end up downloading alone.
+    QVector<SizedArchive> archives;
+    archives.reserve(m_archivesToDownload.count());
+    foreach (const ArchivePair &archive, m_archivesToDownload)
+        archives.append(qMakePair(archiveSize(archive), archive));
+    std::stable_sort(archives.begin(), archives.end(),
+        [](const SizedArchive &lhs, const SizedArchive &rhs) {
+            return lhs.first > rhs.first;
+        });
+
+    m_archivesToDownload.clear();
+    foreach (const SizedArchive &archive, archives)
+        m_archivesToDownload.append(archive.second);
+
+    startDownloads();
 }
 
 /*!
@@ -99,93 +181,120 @@ void DownloadArchivesJob::doStart()
 void DownloadArchivesJob::doCancel()
 {
     m_canceled = true;
-    if (m_downloader != 0)
-        m_downloader->cancelDownload();
+    if (m_downloaders.isEmpty()) {
+        QMetaObject::invokeMethod(this, "startDownloads", Qt::QueuedConnection);
+        return;
+    }
+
+    // canceling one downloader finishes the job and aborts the others
+    foreach (FileDownloader *const downloader, m_downloaders.keys()) {
+        if (m_downloaders.contains(downloader))
+            downloader->cancelDownload();
+    }
 }
 
-void DownloadArchivesJob::fetchNextArchiveHash()
+/*!
+    Fills the free download slots from the queue and finishes the job once nothing is left.
+*/
+void DownloadArchivesJob::startDownloads()
 {
-    if (m_core->testChecksum()) {
-        if (m_canceled) {
-            finishWithError(tr("Canceled"));
-            return;
-        }
+    if (m_canceled) {
+        finishWithError(tr("Canceled"), QUrl());
+        return;
+    }
 
-        if (m_archivesToDownload.isEmpty()) {
-            emitFinished();
-            return;
+    while (!m_archivesToDownload.isEmpty()
+        && m_activeDownloads.count() < m_maxConcurrentDownloads) {
+        const ArchivePair archive = m_archivesToDownload.takeFirst();
+
+        Download *const download = new Download(archive);
+        download->archiveDownloader = setupDownloader(archive, QString(),
+            m_core->value(QLatin1String("UrlQueryString")));
+        if (!download->archiveDownloader) {
+            m_pendingArchives.remove(archive.first);
+            delete download;
+            continue;
         }
 
-        if (m_downloader)
-            m_downloader->deleteLater();
-
-        m_downloader = setupDownloader(QLatin1String(".sha1"));
-        if (!m_downloader) {
-            m_archivesToDownload.removeFirst();
-            QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
-            return;
+        if (m_core->testChecksum()) {
+            download->hashDownloader = setupDownloader(archive, QLatin1String(".sha1"));
+            if (!download->hashDownloader) {
+                m_pendingArchives.remove(archive.first);
+                download->archiveDownloader->deleteLater();
+                delete download;
+                continue;
+            }
+            connect(download->hashDownloader, SIGNAL(downloadCompleted()), this,
+                SLOT(finishedHashDownload()), Qt::QueuedConnection);
+            m_downloaders.insert(download->hashDownloader, download);
         }
 
-        connect(m_downloader, SIGNAL(downloadCompleted()), this, SLOT(finishedHashDownload()),
-            Qt::QueuedConnection);
-        m_downloader->download();
-    } else {
-        QMetaObject::invokeMethod(this, "fetchNextArchive", Qt::QueuedConnection);
+        connect(download->archiveDownloader, SIGNAL(downloadProgress(double)), this,
+            SLOT(emitDownloadProgress(double)));
+        connect(download->archiveDownloader, SIGNAL(downloadCompleted()), this,
+            SLOT(finishedArchiveDownload()), Qt::QueuedConnection);
+        m_downloaders.insert(download->archiveDownloader, download);
+        m_activeDownloads.append(download);
+
+        if (download->hashDownloader)
+            download->hashDownloader->download();
+        download->archiveDownloader->download();
     }
+
+    if (m_activeDownloads.isEmpty() && m_archivesToDownload.isEmpty())
+        emitFinished();
 }
 
 void DownloadArchivesJob::finishedHashDownload()
 {
-    Q_ASSERT(m_downloader != 0);
-
-    QFile sha1HashFile(m_downloader->downloadedFileName());
-    if (sha1HashFile.open(QFile::ReadOnly)) {
-        m_currentHash = sha1HashFile.readAll();
-        fetchNextArchive();
-    } else {
-        finishWithError(tr("Downloading hash signature failed."));
-    }
-}
+    FileDownloader *const downloader = qobject_cast<FileDownloader *>(sender());
+    Download *const download = m_downloaders.value(downloader);
+    if (!download)
+        return;
 
-/*!
-    Fetches the next archive and registers it in the installer.
-*/
-void DownloadArchivesJob::fetchNextArchive()
-{
     if (m_canceled) {
-        finishWithError(tr("Canceled"));
+        finishWithError(tr("Canceled"), downloader->url());
         return;
     }
 
-    if (m_archivesToDownload.isEmpty()) {
-        emitFinished();
+    QFile sha1HashFile(downloader->downloadedFileName());
+    if (!sha1HashFile.open(QFile::ReadOnly)) {
+        finishWithError(tr("Downloading hash signature failed."), downloader->url());
         return;
     }
 
-    if (m_downloader != 0)
-        m_downloader->deleteLater();
+    download->hash = sha1HashFile.readAll();
+    download->hashFinished = true;
+    if (download->archiveFinished)
+        registerFile(download);
+}
 
-    m_downloader = setupDownloader(QString(), m_core->value(QLatin1String("UrlQueryString")));
-    if (!m_downloader) {
-        m_archivesToDownload.removeFirst();
-        QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
+void DownloadArchivesJob::finishedArchiveDownload()
+{
+    FileDownloader *const downloader = qobject_cast<FileDownloader *>(sender());
+    Download *const download = m_downloaders.value(downloader);
+    if (!download)
         return;
-    }
 
-    emit progressChanged(double(m_archivesDownloaded) / m_archivesToDownloadCount);
-    connect(m_downloader, SIGNAL(downloadProgress(double)), this, SLOT(emitDownloadProgress(double)));
-    connect(m_downloader, SIGNAL(downloadCompleted()), this, SLOT(registerFile()), Qt::QueuedConnection);
+    if (m_canceled) {
+        finishWithError(tr("Canceled"), downloader->url());
+        return;
+    }
 
-    m_downloader->download();
+    download->archiveFinished = true;
+    download->progress = 1.0;
+    if (!download->hashDownloader || download->hashFinished)
+        registerFile(download);
 }
 
 /*!
-    Emits the global download progress during a single download in a lazy way (uses a timer to reduce to
-    much processChanged).
+    Emits the global download progress during the downloads in a lazy way (uses a timer to reduce
+    to much processChanged).
 */
 void DownloadArchivesJob::emitDownloadProgress(double progress)
 {
-    m_lastFileProgress = progress;
+    if (Download *const download = m_downloaders.value(qobject_cast<FileDownloader *>(sender())))
+        download->progress = progress;
     if (!m_progressChangedTimerId)
         m_progressChangedTimerId = startTimer(5);
 }
@@ -198,21 +307,25 @@ void DownloadArchivesJob::timerEvent(QTimerEvent *event)
     if (event->timerId() == m_progressChangedTimerId) {
         killTimer(m_progressChangedTimerId);
         m_progressChangedTimerId = 0;
-        emit progressChanged((double(m_archivesDownloaded) + m_lastFileProgress) / m_archivesToDownloadCount);
+
+        double progress = m_archivesDownloaded;
+        foreach (const Download *const download, m_activeDownloads)
+            progress += download->progress;
+        emit progressChanged(progress / m_archivesToDownloadCount);
     }
 }
 
 /*!
-    Registers the just downloaded file in the installer's file system.
+    Registers the downloaded file of \a download in the installer's file system.
 */
-void DownloadArchivesJob::registerFile()
+void DownloadArchivesJob::registerFile(Download *download)
 {
-    Q_ASSERT(m_downloader != 0);
-
-    if (m_canceled)
-        return;
+    const QByteArray sha1 = download->archiveDownloader->sha1Sum().toHex();
+    if (m_core->testChecksum() && download->hash != sha1) {
+        // The message box runs an event loop, a cancel may delete the download meanwhile.
+        const ArchivePair archive = download->archive;
+        const QUrl url = download->archiveDownloader->url();
 
-    if (m_core->testChecksum() && m_currentHash != m_downloader->sha1Sum().toHex()) {
         //TODO: Maybe we should try to download the file again automatically
         const QMessageBox::Button res =
             MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(),
@@ -220,28 +333,42 @@ void DownloadArchivesJob::registerFile()
             "downloading failed. This is a temporary error, please retry."),
             QMessageBox::Retry | QMessageBox::Cancel, QMessageBox::Cancel);
 
+        if (m_canceled || !isActiveDownload(download, archive))
+            return;
         if (res == QMessageBox::Cancel) {
-            finishWithError(tr("Could not verify Hash"));
+            finishWithError(tr("Could not verify Hash"), url);
             return;
         }
-    } else {
-        ++m_archivesDownloaded;
-        if (m_progressChangedTimerId) {
-            killTimer(m_progressChangedTimerId);
-            m_progressChangedTimerId = 0;
-            emit progressChanged(double(m_archivesDownloaded) / m_archivesToDownloadCount);
-        }
+        retryDownload(download);
+        return;
+    }
 
-        const QPair<QString, QString> pair = m_archivesToDownload.takeFirst();
-        BinaryFormatEngineHandler::instance()->registerResource(pair.first,
-            m_downloader->downloadedFileName());
+    ++m_archivesDownloaded;
+    const QString archive = download->archive.first;
+    BinaryFormatEngineHandler::instance()->registerResource(archive,
+        download->archiveDownloader->downloadedFileName());
+    m_pendingArchives.remove(archive);
+    removeDownload(download);
+    emit archiveDownloaded(archive);
+
+    if (m_progressChangedTimerId) {
+        killTimer(m_progressChangedTimerId);
+        m_progressChangedTimerId = 0;
     }
-    fetchNextArchiveHash();
+    double progress = m_archivesDownloaded;
+    foreach (const Download *const active, m_activeDownloads)
+        progress += active->progress;
+    emit progressChanged(progress / m_archivesToDownloadCount);
+
+    startDownloads();
 }
 
 void DownloadArchivesJob::downloadCanceled()
 {
-    emitFinishedWithError(KDJob::Canceled, m_downloader->errorString());
+    const FileDownloader *const downloader = qobject_cast<const FileDownloader *>(sender());
+    const QString error = downloader ? downloader->errorString() : QString();
+    abortDownloads();
+    emitFinishedWithError(KDJob::Canceled, error);
 }
 
 void DownloadArchivesJob::downloadFailed(const QString &error)
@@ -249,37 +376,102 @@ void DownloadArchivesJob::downloadFailed(const QString &error)
     if (m_canceled)
         return;
 
+    Download *const download = m_downloaders.value(qobject_cast<FileDownloader *>(sender()));
+    if (!download)
+        return; // already retried because of the archive or hash file
+
+    // The message box runs an event loop, a cancel may delete the download meanwhile.
+    const ArchivePair archive = download->archive;
     const QMessageBox::StandardButton b =
         MessageBoxHandler::critical(MessageBoxHandler::currentBestSuitParent(),
         QLatin1String("archiveDownloadError"), tr("Download Error"), tr("Could not download archive: %1 : %2")
-        .arg(m_archivesToDownload.first().second, error), QMessageBox::Retry | QMessageBox::Cancel);
+        .arg(archive.second, error), QMessageBox::Retry | QMessageBox::Cancel);
+
+    if (m_canceled || !isActiveDownload(download, archive))
+        return;
+    if (b == QMessageBox::Retry) {
+        retryDownload(download);
+    } else {
+        abortDownloads();
+        emitFinishedWithError(KDJob::Canceled, error);
+    }
+}
+
+/*!
+    Drops \a download and puts its archive back in front of the queue.
+*/
+void DownloadArchivesJob::retryDownload(Download *download)
+{
+    m_archivesToDownload.prepend(download->archive);
+    removeDownload(download);
+    QMetaObject::invokeMethod(this, "startDownloads", Qt::QueuedConnection);
+}
+
+void DownloadArchivesJob::removeDownload(Download *download)
+{
+    m_activeDownloads.removeOne(download);
+    foreach (FileDownloader *const downloader, QList<FileDownloader *>()
+        << download->archiveDownloader << download->hashDownloader) {
+        if (!downloader)
+            continue;
+        m_downloaders.remove(downloader);
+        downloader->disconnect(this);
+        if (!downloader->isDownloaded())
+            downloader->cancelDownload();
+        downloader->deleteLater();
+    }
+    delete download;
+}
+
+/*
+    Returns whether \a download still fetches \a archive. The download may have been deleted, and
+    its address reused, while a message box was shown.
+*/
+bool DownloadArchivesJob::isActiveDownload(const Download *download,
+    const ArchivePair &archive) const
+{
+    foreach (const Download *const active, m_activeDownloads) {
+        if (active == download)
+            return active->archive == archive;
+    }
+    return false;
+}
 
-    if (b == QMessageBox::Retry)
-        QMetaObject::invokeMethod(this, "fetchNextArchiveHash", Qt::QueuedConnection);
-    else
-        downloadCanceled();
+void DownloadArchivesJob::abortDownloads()
+{
+    while (!m_activeDownloads.isEmpty())
+        removeDownload(m_activeDownloads.first());
 }
 
-void DownloadArchivesJob::finishWithError(const QString &error)
+void DownloadArchivesJob::finishWithError(const QString &error, const QUrl &url)
 {
-    const FileDownloader *const dl = qobject_cast<const FileDownloader*> (sender());
+    abortDownloads();
     const QString msg = tr("Could not fetch archives: %1\nError while loading %2");
-    if (dl != 0)
-        emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, dl->url().toString()));
-    else
-        emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, m_downloader->url().toString()));
+    emitFinishedWithError(QInstaller::DownloadError, msg.arg(error, url.toString()));
+}
+
+/*!
+    Returns the compressed size of the component \a archive belongs to. It serves as the size
+    estimate when ordering the queue.
+*/
+qint64 DownloadArchivesJob::archiveSize(const ArchivePair &archive) const
+{
+    const Component *const component = m_core->componentByName(QFileInfo(QFileInfo(archive.first)
+        .path()).fileName());
+    return component ? component->value(scCompressedSize).toLongLong() : 0;
 }
 
-KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const QString &suffix, const QString &queryString)
+KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const ArchivePair &archive,
+    const QString &suffix, const QString &queryString)
 {
     KDUpdater::FileDownloader *downloader = 0;
-    const QFileInfo fi = QFileInfo(m_archivesToDownload.first().first);
+    const QFileInfo fi = QFileInfo(archive.first);
     const Component *const component = m_core->componentByName(QFileInfo(fi.path()).fileName());
     if (component) {
         QString fullQueryString;
         if (!queryString.isEmpty())
             fullQueryString = QLatin1String("?") + queryString;
-        const QUrl url(m_archivesToDownload.first().second + suffix + fullQueryString);
+        const QUrl url(archive.second + suffix + fullQueryString);
         const QString &scheme = url.scheme();
         downloader = FileDownloaderFactory::instance().create(scheme, this);
 
@@ -297,7 +489,10 @@ KDUpdater::FileDownloader *DownloadArchivesJob::setupDownloader(const QString &s
                 Qt::QueuedConnection);
             connect(downloader, SIGNAL(downloadStatus(QString)), this, SIGNAL(downloadStatusChanged(QString)));
 
-            if (FileDownloaderFactory::isSupportedScheme(scheme)) {
+            // Archives on the local file system are registered where they are, no need to copy.
+            if (LocalFileDownloader *const local = qobject_cast<LocalFileDownloader *>(downloader)) {
+                local->setUseSourceInPlace(true);
+            } else if (FileDownloaderFactory::isSupportedScheme(scheme)) {
                 downloader->setDownloadedFileName(component->localTempPath() + QLatin1Char('/')
                     + component->name() + QLatin1Char('/') + fi.fileName() + suffix);
             }
@@ -37,10 +37,13 @@
 
 #include <kdjob.h>
 
+#include <QtCore/QHash>
 #include <QtCore/QPair>
+#include <QtCore/QSet>
 
 QT_BEGIN_NAMESPACE
 class QTimerEvent;
+class QUrl;
 QT_END_NAMESPACE
 
 namespace KDUpdater {
@@ -55,6 +58,7 @@ class PackageManagerCore;
 class DownloadArchivesJob : public KDJob
 {
     Q_OBJECT
+    struct Download;
 
 public:
     explicit DownloadArchivesJob(PackageManagerCore *core);
@@ -63,7 +67,16 @@ public:
     int numberOfDownloads() const { return m_archivesDownloaded; }
     void setArchivesToDownload(const QList<QPair<QString, QString> > &archives);
 
+    int maxConcurrentDownloads() const { return m_maxConcurrentDownloads; }
+    void setMaxConcurrentDownloads(int count);
+
+    bool preserveOrder() const { return m_preserveOrder; }
+    void setPreserveOrder(bool preserveOrder);
+
+    bool isArchivePending(const QString &archive) const;
+
 Q_SIGNALS:
+    void archiveDownloaded(const QString &archive);
     void progressChanged(double progress);
     void outputTextChanged(const QString &progress);
     void downloadStatusChanged(const QString &status);
@@ -74,29 +87,39 @@ protected:
     void timerEvent(QTimerEvent *event);
 
 protected Q_SLOTS:
-    void registerFile();
+    void startDownloads();
     void downloadCanceled();
     void downloadFailed(const QString &error);
-    void finishWithError(const QString &error);
-    void fetchNextArchive();
-    void fetchNextArchiveHash();
     void finishedHashDownload();
+    void finishedArchiveDownload();
     void emitDownloadProgress(double progress);
 
 private:
-    KDUpdater::FileDownloader *setupDownloader(const QString &suffix = QString(), const QString &queryString = QString());
+    KDUpdater::FileDownloader *setupDownloader(const QPair<QString, QString> &archive,
+        const QString &suffix = QString(), const QString &queryString = QString());
+    qint64 archiveSize(const QPair<QString, QString> &archive) const;
+
+    void registerFile(Download *download);
+    void retryDownload(Download *download);
+    void removeDownload(Download *download);
+    bool isActiveDownload(const Download *download, const QPair<QString, QString> &archive) const;
+    void abortDownloads();
+    void finishWithError(const QString &error, const QUrl &url);
 
 private:
     PackageManagerCore *m_core;
-    KDUpdater::FileDownloader *m_downloader;
 
     int m_archivesDownloaded;
     int m_archivesToDownloadCount;
+    int m_maxConcurrentDownloads;
+    bool m_preserveOrder;
     QList<QPair<QString, QString> > m_archivesToDownload;
+    QSet<QString> m_pendingArchives;
+
+    QList<Download *> m_activeDownloads;
+    QHash<KDUpdater::FileDownloader *, Download *> m_downloaders;
 
     bool m_canceled;
-    QByteArray m_currentHash;
-    double m_lastFileProgress;
     int m_progressChangedTimerId;
 };
 
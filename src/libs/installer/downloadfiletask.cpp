@@ -216,6 +216,29 @@ void Downloader::onFinished(QNetworkReply *reply)
         }
     }
 
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+        if (data.file)
+            data.file->remove();
+        data.taskItem.insert(TaskRole::NotModified, true);
+        m_futureInterface->reportResult(FileTaskResult(QString(), QByteArray(), data.taskItem));
+
+        m_downloads.erase(reply);
+        m_redirects.remove(reply);
+        reply->deleteLater();
+
+        m_finished++;
+        if (m_downloads.empty() || m_futureInterface->isCanceled()) {
+            m_futureInterface->reportFinished();
+            emit finished();    // emit finished, so the event loop can shutdown
+        }
+        return;
+    }
+
+    if (data.taskItem.value(TaskRole::ETag).isValid())
+        data.taskItem.insert(TaskRole::ETag, reply->rawHeader("ETag"));
+    if (data.taskItem.value(TaskRole::LastModified).isValid())
+        data.taskItem.insert(TaskRole::LastModified, reply->rawHeader("Last-Modified"));
+
     const QByteArray ba = reply->readAll();
     if (!ba.isEmpty()) {
         data.observer->addSample(ba.size());
@@ -341,7 +364,21 @@ QNetworkReply *Downloader::startDownload(const FileTaskItem &item)
         return 0;
     }
 
-    QNetworkReply *reply = m_nam.get(QNetworkRequest(source));
+    QNetworkRequest request(source);
+    const QVariant etag = item.value(TaskRole::ETag);
+    const QVariant lastModified = item.value(TaskRole::LastModified);
+    if (etag.isValid() || lastModified.isValid()) {
+        // Conditional request, only the origin server may decide whether the file changed.
+        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+            QNetworkRequest::AlwaysNetwork);
+        request.setRawHeader("Cache-Control", "no-cache");
+        if (!etag.toByteArray().isEmpty())
+            request.setRawHeader("If-None-Match", etag.toByteArray());
+        if (!lastModified.toByteArray().isEmpty())
+            request.setRawHeader("If-Modified-Since", lastModified.toByteArray());
+    }
+
+    QNetworkReply *reply = m_nam.get(request);
     std::unique_ptr<Data> data(new Data(item));
     m_downloads[reply] = std::move(data);
 
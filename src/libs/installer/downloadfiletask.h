@@ -46,7 +46,10 @@ namespace QInstaller {
 namespace TaskRole {
 enum
 {
-    Authenticator = TaskRole::TargetFile + 10
+    Authenticator = TaskRole::TargetFile + 10,
+    ETag,           // If-None-Match on the request, the server's ETag on the result
+    LastModified,   // If-Modified-Since on the request, the server's Last-Modified on the result
+    NotModified     // set on the result if the server answered 304, no file is written then
 };
 }
 
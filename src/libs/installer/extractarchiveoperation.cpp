@@ -35,12 +35,15 @@
 #include "extractarchiveoperation.h"
 #include "extractarchiveoperation_p.h"
 
+#include "fileutils.h"
+
 #include <QtCore/QEventLoop>
 #include <QtCore/QThread>
 #include <QtCore/QThreadPool>
 
 using namespace QInstaller;
 
+QAtomicInt ExtractArchiveOperation::Runnable::runningExtractions;
 
 ExtractArchiveOperation::ExtractArchiveOperation()
 {
@@ -114,9 +117,7 @@ bool ExtractArchiveOperation::undoOperation()
     //const QString archivePath = arguments().first();
     //const QString targetDir = arguments().last();
 
-    const QStringList files = value(QLatin1String("files")).toStringList();
-
-    WorkerThread *const thread = new WorkerThread(this, files);
+    WorkerThread *const thread = new WorkerThread(this, m_files);
     connect(thread, SIGNAL(currentFileChanged(QString)), this, SIGNAL(outputTextChanged(QString)));
     connect(thread, SIGNAL(progressChanged(double)), this, SIGNAL(progressChanged(double)));
 
@@ -138,13 +139,59 @@ Operation *ExtractArchiveOperation::clone() const
     return new ExtractArchiveOperation();
 }
 
+/*!
+    Returns the files and directories created by the operation, in the order they were extracted.
+*/
+QStringList ExtractArchiveOperation::extractedFiles() const
+{
+    return m_files;
+}
+
+/*!
+    \reimp
+
+    The extracted files are stored as one compressed value instead of a string list.
+*/
+QVariantMap ExtractArchiveOperation::persistentValues() const
+{
+    QVariantMap values = Operation::persistentValues();
+    if (!m_files.isEmpty())
+        values.insert(QLatin1String("fileList"), encodeFileList(m_files));
+    return values;
+}
+
+/*!
+    \reimp
+
+    Also reads the plain \c files list written by older versions, which holds the newest entry
+    first, and the base64 encoded \c fileList of versions that stored the operation as XML text.
+*/
+bool ExtractArchiveOperation::setPersistentValues(const QVariantMap &values)
+{
+    if (!Operation::setPersistentValues(values))
+        return false;
+
+    m_files.clear();
+    if (hasValue(QLatin1String("fileList"))) {
+        const QVariant fileList = value(QLatin1String("fileList"));
+        m_files = decodeFileList(fileList.type() == QVariant::ByteArray ? fileList.toByteArray()
+            : QByteArray::fromBase64(fileList.toString().toLatin1()));
+        clearValue(QLatin1String("fileList"));
+    } else if (hasValue(QLatin1String("files"))) {
+        const QStringList files = value(QLatin1String("files")).toStringList();
+        m_files.reserve(files.count());
+        for (int i = files.count() - 1; i >= 0; --i)
+            m_files.append(files.at(i));
+        clearValue(QLatin1String("files"));
+    }
+    return true;
+}
+
 /*!
     This slot is direct connected to the caller so please don't call it from another thread in the same time.
 */
 void ExtractArchiveOperation::fileFinished(const QString &filename)
 {
-    QStringList files = value(QLatin1String("files")).toStringList();
-    files.prepend(filename);
-    setValue(QLatin1String("files"), files);
+    m_files.append(filename);
     emit outputTextChanged(filename);
 }
@@ -38,6 +38,7 @@
 #include "qinstallerglobal.h"
 
 #include <QtCore/QObject>
+#include <QtCore/QStringList>
 
 namespace QInstaller {
 
@@ -55,6 +56,11 @@ public:
     bool testOperation();
     Operation *clone() const;
 
+    QStringList extractedFiles() const;
+
+    QVariantMap persistentValues() const;
+    bool setPersistentValues(const QVariantMap &values);
+
 Q_SIGNALS:
     void outputTextChanged(const QString &progress);
     void progressChanged(double);
@@ -66,6 +72,9 @@ private:
     class Callback;
     class Runnable;
     class Receiver;
+
+    // extracted files and directories in extraction order, append only
+    QStringList m_files;
 };
 
 }
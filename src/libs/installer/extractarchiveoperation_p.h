@@ -36,10 +36,14 @@
 
 #include "extractarchiveoperation.h"
 
+#include "fileremover.h"
 #include "fileutils.h"
 #include "lib7z_facade.h"
 #include "packagemanagercore.h"
+#include "remoteclient.h"
+#include "remotefileoperations.h"
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QPair>
@@ -66,30 +70,23 @@ public:
         ExtractArchiveOperation *const op = m_op;//dynamic_cast< ExtractArchiveOperation* >(parent());
         Q_ASSERT(op != 0);
 
-        int removedCounter = 0;
-        foreach (const QString &file, m_files) {
-            removedCounter++;
-#ifdef LUMIT_INSTALLER
-            {
-                // Delete readonly flag for file
-                QFile qFile(file);
-                QFile::Permissions permissions = qFile.permissions();
-                bool writeable = permissions & QFile::WriteOther;
-                if (!writeable)
-                    qFile.setPermissions(permissions | QFile::WriteOther);
-            }
-#endif
-            const QFileInfo fi(file);
-            emit currentFileChanged(file);
-            emit progressChanged(double(removedCounter) / m_files.count());
-            if (fi.isFile() || fi.isSymLink()) {
-                op->deleteFileNowOrLater(fi.absoluteFilePath());
-            } else if (fi.isDir()) {
-                const QDir d = fi.dir();
-                removeSystemGeneratedFiles(file);
-                d.rmdir(file); // directory may not exist
-            }
-        }
+        // the remover reports from its pool threads, forward that right away
+        FileRemover remover;
+        connect(&remover, SIGNAL(currentFileChanged(QString)), this,
+            SIGNAL(currentFileChanged(QString)), Qt::DirectConnection);
+        connect(&remover, SIGNAL(progressChanged(int,int)), this,
+            SLOT(removerProgressChanged(int,int)), Qt::DirectConnection);
+
+        // files that are in use get removed later
+        foreach (const QString &file, remover.removePaths(m_files))
+            op->deleteFileNowOrLater(file);
+    }
+
+private Q_SLOTS:
+    void removerProgressChanged(int processed, int total)
+    {
+        if (total > 0)
+            emit progressChanged(double(processed) / total);
     }
 
 Q_SIGNALS:
@@ -116,6 +113,7 @@ public:
 Q_SIGNALS:
     void currentFileChanged(const QString &filename);
     void progressChanged(double progress);
+    void canceled();
 
 public Q_SLOTS:
     void statusChanged(QInstaller::PackageManagerCore::Status status)
@@ -123,9 +121,11 @@ public Q_SLOTS:
         switch(status) {
             case PackageManagerCore::Canceled:
                 state = E_ABORT;
+                emit canceled();
                 break;
             case PackageManagerCore::Failure:
                 state = E_FAIL;
+                emit canceled();
                 break;
             default:    // fall through
                 // PackageManagerCore::Unfinished, PackageManagerCore::Success, PackageManagerCore::Running
@@ -137,6 +137,18 @@ public Q_SLOTS:
         }
     }
 
+    // used while the remote server extracts the archive
+    void remoteFileExtracted(const QString &filename)
+    {
+        setCurrentFile(filename);
+    }
+
+    void remoteProgressChanged(qint64 completed, qint64 total)
+    {
+        if (total > 0)
+            setCompleted(completed, total);
+    }
+
 protected:
     void setCurrentFile(const QString &filename)
     {
@@ -192,6 +204,11 @@ public:
 
     void run()
     {
+        if (RemoteClient::instance().isActive()) {
+            runOnServer();
+            return;
+        }
+
         QFile archive(archivePath);
         if (!archive.open(QIODevice::ReadOnly)) {
 
@@ -199,13 +216,15 @@ public:
             return;
         }
 
+        // share the cores with extractions running at the same time
+        const int running = runningExtractions.fetchAndAddOrdered(1) + 1;
+        const int threadCount = qMax(1, QThread::idealThreadCount() / running);
+
         try {
-            Lib7z::extractArchive(&archive, targetDir, callback);
+            Lib7z::extractArchive(&archive, targetDir, callback, threadCount);
 
             // change files permission
-            QFile::Permissions permissions = QFile::ReadUser | QFile::ReadGroup | QFile::ReadOwner | QFile::ReadOther
-                                    | QFile::WriteUser | QFile::WriteGroup | QFile::WriteOwner | QFile::WriteOther
-                                    | QFile::ExeUser | QFile::ExeGroup | QFile::ExeOwner | QFile::ExeOther;
+            const QFile::Permissions permissions = directoryPermissions();
             QDirIterator iterator(targetDir, QDir::Dirs, QDirIterator::Subdirectories);
             do
             {
@@ -213,10 +232,13 @@ public:
                 iterator.next();
             } while (iterator.hasNext());
 
+            runningExtractions.fetchAndAddOrdered(-1);
             emit finished(true, QString());
         } catch (const Lib7z::SevenZipException& e) {
+            runningExtractions.fetchAndAddOrdered(-1);
             emit finished(false, tr("Error while extracting '%1': %2").arg(archivePath, e.message()));
         } catch (...) {
+            runningExtractions.fetchAndAddOrdered(-1);
             emit finished(false, tr("Unknown exception caught while extracting %1.").arg(archivePath));
         }
     }
@@ -224,10 +246,52 @@ public:
 Q_SIGNALS:
     void finished(bool success, const QString &errorString);
 
+private:
+    static QFile::Permissions directoryPermissions()
+    {
+        return QFile::ReadUser | QFile::ReadGroup | QFile::ReadOwner | QFile::ReadOther
+            | QFile::WriteUser | QFile::WriteGroup | QFile::WriteOwner | QFile::WriteOther
+            | QFile::ExeUser | QFile::ExeGroup | QFile::ExeOwner | QFile::ExeOther;
+    }
+
+    // The privileged server reads the archive and writes the files itself, only progress and
+    // the names of the extracted files are sent back. Archives the server cannot read, like the
+    // installer:// resources of this process, are extracted here through the remote file engine.
+    void runOnServer()
+    {
+        RemoteFileOperations operations;
+        connect(&operations, SIGNAL(fileProcessed(QString)), callback,
+            SLOT(remoteFileExtracted(QString)), Qt::DirectConnection);
+        connect(&operations, SIGNAL(progressChanged(qint64,qint64)), callback,
+            SLOT(remoteProgressChanged(qint64,qint64)), Qt::DirectConnection);
+        connect(callback, SIGNAL(canceled()), &operations, SLOT(cancel()),
+            Qt::DirectConnection);
+        if (callback->state != S_OK)
+            operations.cancel();
+
+        try {
+            const bool extracted = operations.extractArchive(archivePath, targetDir);
+            foreach (const QString &backup, operations.leftoverFiles())
+                callback->backupFiles.push_back(qMakePair(QString(), backup));
+            if (!extracted) {
+                emit finished(false, tr("Error while extracting '%1': %2").arg(archivePath,
+                    operations.errorString()));
+                return;
+            }
+            operations.setPermissionsRecursively(targetDir, directoryPermissions(), QDir::Dirs);
+            emit finished(true, QString());
+        } catch (const Error &e) {
+            emit finished(false, tr("Error while extracting '%1': %2").arg(archivePath,
+                e.message()));
+        }
+    }
+
 private:
     const QString archivePath;
     const QString targetDir;
     ExtractArchiveOperation::Callback *const callback;
+
+    static QAtomicInt runningExtractions;
 };
 
 
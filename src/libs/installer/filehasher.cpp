@@ -0,0 +1,273 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "filehasher.h"
+
+#include "utils.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+namespace QInstaller {
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::FileHasher
+    \brief The FileHasher class calculates the cryptographic hashes of files on a thread pool.
+
+    Every thread of the pool reads through its own buffer, so any number of files can be hashed
+    in parallel with hashFiles() or checked against known hashes with verifyFiles(). The hasher
+    keeps counters of the files and bytes it has processed and of the time spent, which can be
+    used to report the throughput.
+*/
+
+/*!
+    \class QInstaller::FileHasher::Result
+    \brief The Result struct holds the hash of one file, or the reason why it could not be hashed.
+*/
+
+/*
+    Takes the next file from the shared list until all files are hashed. One runnable is started
+    per thread, the results are written to distinct slots and need no locking.
+*/
+class FileHasher::Runnable : public QRunnable
+{
+public:
+    Runnable(FileHasher *hasher, const QStringList &fileNames, QVector<Result> *results,
+            QAtomicInt *next)
+        : m_hasher(hasher)
+        , m_fileNames(fileNames)
+        , m_results(results)
+        , m_next(next)
+    {}
+
+    void run()
+    {
+        int index;
+        while ((index = m_next->fetchAndAddRelaxed(1)) < m_fileNames.count())
+            (*m_results)[index] = m_hasher->hash(m_fileNames.at(index));
+    }
+
+private:
+    FileHasher *m_hasher;
+    const QStringList m_fileNames;
+    QVector<Result> *m_results;
+    QAtomicInt *m_next;
+};
+
+/*!
+    Creates a file hasher that uses \a algorithm. The number of threads defaults to
+    QThread::idealThreadCount().
+*/
+FileHasher::FileHasher(QCryptographicHash::Algorithm algorithm)
+    : m_algorithm(algorithm)
+    , m_filesHashed(0)
+    , m_bytesHashed(0)
+    , m_elapsed(0)
+{
+}
+
+/*!
+    Destroys the file hasher.
+*/
+FileHasher::~FileHasher()
+{
+    m_pool.waitForDone();
+}
+
+/*!
+    Returns the hash algorithm.
+*/
+QCryptographicHash::Algorithm FileHasher::algorithm() const
+{
+    return m_algorithm;
+}
+
+/*!
+    Returns the maximum number of files hashed in parallel.
+*/
+int FileHasher::maxThreadCount() const
+{
+    return m_pool.maxThreadCount();
+}
+
+/*!
+    Sets the maximum number of files hashed in parallel to \a threadCount.
+*/
+void FileHasher::setMaxThreadCount(int threadCount)
+{
+    m_pool.setMaxThreadCount(qMax(1, threadCount));
+}
+
+/*!
+    Hashes the file \a fileName in the calling thread and returns the result.
+*/
+FileHasher::Result FileHasher::hashFile(const QString &fileName)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const Result result = hash(fileName);
+    addElapsed(timer.elapsed());
+    return result;
+}
+
+/*!
+    Hashes all files in \a fileNames in parallel and returns the results in the same order. The
+    function blocks until all files are hashed.
+*/
+QList<FileHasher::Result> FileHasher::hashFiles(const QStringList &fileNames)
+{
+    QVector<Result> results(fileNames.count());
+    QAtomicInt next(0);
+
+    QElapsedTimer timer;
+    timer.start();
+    const int threadCount = qMin(m_pool.maxThreadCount(), fileNames.count());
+    for (int i = 0; i < threadCount; ++i)
+        m_pool.start(new Runnable(this, fileNames, &results, &next));
+    m_pool.waitForDone();
+    addElapsed(timer.elapsed());
+
+    return results.toList();
+}
+
+/*!
+    Hashes the files that are the keys of \a expectedHashes in parallel and compares each result
+    with the hash stored as value. Returns the names of the files that could not be read or whose
+    hash does not match. A description of the first failure is stored in \a errorString.
+*/
+QStringList FileHasher::verifyFiles(const QHash<QString, QByteArray> &expectedHashes,
+    QString *errorString)
+{
+    QStringList failed;
+    foreach (const Result &result, hashFiles(expectedHashes.keys())) {
+        QString error = result.errorString;
+        if (error.isEmpty() && result.hash != expectedHashes.value(result.fileName))
+            error = tr("Hash of file %1 does not match.").arg(result.fileName);
+        if (error.isEmpty())
+            continue;
+
+        if (errorString && failed.isEmpty())
+            *errorString = error;
+        failed.append(result.fileName);
+    }
+    return failed;
+}
+
+/*!
+    Returns the number of files hashed since the last call to resetCounters().
+*/
+int FileHasher::filesHashed() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_filesHashed;
+}
+
+/*!
+    Returns the number of bytes hashed since the last call to resetCounters().
+*/
+qint64 FileHasher::bytesHashed() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_bytesHashed;
+}
+
+/*!
+    Returns the time in milliseconds spent in hashFile() and hashFiles() since the last call to
+    resetCounters().
+*/
+qint64 FileHasher::elapsed() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_elapsed;
+}
+
+/*!
+    Returns the average number of bytes hashed per second, over all threads.
+*/
+qint64 FileHasher::bytesPerSecond() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_bytesHashed * 1000 / qMax<qint64>(m_elapsed, 1);
+}
+
+/*!
+    Resets the throughput counters.
+*/
+void FileHasher::resetCounters()
+{
+    QMutexLocker _(&m_mutex);
+    m_filesHashed = 0;
+    m_bytesHashed = 0;
+    m_elapsed = 0;
+}
+
+/*
+    Hashes \a fileName and updates the file and byte counters. Called from the pool threads.
+*/
+FileHasher::Result FileHasher::hash(const QString &fileName)
+{
+    Result result;
+    result.fileName = fileName;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.errorString = tr("Cannot open file %1 for reading: %2").arg(fileName,
+            file.errorString());
+        return result;
+    }
+
+    const QByteArray checkSum = QInstaller::calculateHash(&file, m_algorithm);
+    if (file.error() != QFile::NoError) {
+        result.errorString = tr("Cannot read file %1: %2").arg(fileName, file.errorString());
+        return result;
+    }
+    result.hash = checkSum;
+
+    QMutexLocker _(&m_mutex);
+    ++m_filesHashed;
+    m_bytesHashed += file.pos();
+    return result;
+}
+
+void FileHasher::addElapsed(qint64 elapsed)
+{
+    QMutexLocker _(&m_mutex);
+    m_elapsed += elapsed;
+}
+
+} // namespace QInstaller
@@ -0,0 +1,99 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef FILEHASHER_H
+#define FILEHASHER_H
+
+#include "installer_global.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT FileHasher
+{
+    Q_DISABLE_COPY(FileHasher)
+    Q_DECLARE_TR_FUNCTIONS(FileHasher)
+
+public:
+    struct Result
+    {
+        QString fileName;
+        QByteArray hash;
+        QString errorString;
+    };
+
+    explicit FileHasher(QCryptographicHash::Algorithm algorithm = QCryptographicHash::Sha1);
+    ~FileHasher();
+
+    QCryptographicHash::Algorithm algorithm() const;
+
+    int maxThreadCount() const;
+    void setMaxThreadCount(int threadCount);
+
+    Result hashFile(const QString &fileName);
+    QList<Result> hashFiles(const QStringList &fileNames);
+    QStringList verifyFiles(const QHash<QString, QByteArray> &expectedHashes,
+        QString *errorString = 0);
+
+    int filesHashed() const;
+    qint64 bytesHashed() const;
+    qint64 elapsed() const;
+    qint64 bytesPerSecond() const;
+    void resetCounters();
+
+private:
+    class Runnable;
+
+    Result hash(const QString &fileName);
+    void addElapsed(qint64 elapsed);
+
+private:
+    QCryptographicHash::Algorithm m_algorithm;
+    QThreadPool m_pool;
+
+    mutable QMutex m_mutex;
+    int m_filesHashed;
+    qint64 m_bytesHashed;
+    qint64 m_elapsed;
+};
+
+} // namespace QInstaller
+
+#endif // FILEHASHER_H
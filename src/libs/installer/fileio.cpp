@@ -42,6 +42,14 @@
 #include <QFileDevice>
 #include <QString>
 
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 qint64 QInstaller::retrieveInt64(QFileDevice *in)
 {
     qint64 n = 0;
@@ -97,7 +105,7 @@ QByteArray QInstaller::retrieveData(QFileDevice *in, qint64 size)
     return ba;
 }
 
-void QInstaller::appendData(QFileDevice *out, QFileDevice *in, qint64 size)
+void QInstaller::appendData(QFileDevice *out, QIODevice *in, qint64 size)
 {
     Q_ASSERT(!in->isSequential());
     QInstaller::blockingCopy(in, out, size);
@@ -130,7 +138,33 @@ void QInstaller::openForAppend(QFileDevice *dev)
     }
 }
 
-qint64 QInstaller::blockingRead(QFileDevice *in, char *buffer, qint64 size)
+/*!
+    Reserves disk space for the first \a size bytes of \a out, so that a large file written
+    sequentially does not get fragmented and a full disk is noticed before any data is written.
+    The file may grow to \a size bytes; resize it once the real size is known. Returns \c false
+    if the space could not be reserved. Where the platform or file system does not support
+    reserving space, nothing happens and \c true is returned.
+*/
+bool QInstaller::preallocate(QFileDevice *out, qint64 size)
+{
+    Q_ASSERT(out);
+    if (size <= out->size())
+        return true;
+#if defined(Q_OS_LINUX)
+    const int fd = out->handle();
+    if (fd < 0 || !out->flush())
+        return true;    // e.g. the remote file engine
+    if (::fallocate(fd, 0, 0, size) == 0)
+        return true;
+    return errno != ENOSPC && errno != EFBIG;  // e.g. EOPNOTSUPP
+#elif defined(Q_OS_WIN)
+    return out->resize(size);
+#else
+    return true;
+#endif
+}
+
+qint64 QInstaller::blockingRead(QIODevice *in, char *buffer, qint64 size)
 {
     if (in->atEnd())
         return 0;
@@ -148,21 +182,101 @@ qint64 QInstaller::blockingRead(QFileDevice *in, char *buffer, qint64 size)
     return size;
 }
 
-qint64 QInstaller::blockingCopy(QFileDevice *in, QFileDevice *out, qint64 size)
+/*
+    Lets the kernel copy \a size bytes between two regular files, starting at the current
+    positions of \a in and \a out. Returns the number of bytes copied, which is less than \a size
+    if the kernel cannot (or can no longer) copy between the files; the remainder is then left to
+    the buffered copy.
+*/
+static qint64 kernelCopy(QFileDevice *in, QFileDevice *out, qint64 size)
+{
+#ifdef Q_OS_LINUX
+    // Both ends need a real file descriptor, e.g. not the remote file engine. Neither
+    // copy_file_range nor sendfile write to a file opened in append mode.
+    if (size <= 0 || in->isSequential() || out->isSequential()
+        || (out->openMode() & QIODevice::Append)) {
+        return 0;
+    }
+    const int inFd = in->handle();
+    const int outFd = out->handle();
+    if (inFd < 0 || outFd < 0)
+        return 0;
+
+    // Any data still in the Qt buffers has to reach the file first.
+    if (!out->flush())
+        return 0;
+
+    static const qint64 maxChunk = 1024 * 1024 * 1024;
+    loff_t inPos = in->pos();
+    loff_t outPos = out->pos();
+    qint64 copied = 0;
+
+#ifdef __NR_copy_file_range
+    while (copied < size) {
+        const ssize_t n = ::syscall(__NR_copy_file_range, inFd, &inPos, outFd, &outPos,
+            size_t(qMin(size - copied, maxChunk)), 0u);
+        if (n <= 0)
+            break; // e.g. ENOSYS, EXDEV or EINVAL, try sendfile
+        copied += n;
+    }
+#endif
+
+    if (copied < size && ::lseek(outFd, outPos, SEEK_SET) == outPos) {
+        off_t offset = inPos;
+        while (copied < size) {
+            const ssize_t n = ::sendfile(outFd, inFd, &offset,
+                size_t(qMin(size - copied, maxChunk)));
+            if (n <= 0)
+                break;
+            copied += n;
+            outPos += n;
+        }
+        inPos = offset;
+    }
+
+    // Bring the positions of the Qt devices in sync with what has been copied.
+    in->seek(inPos);
+    out->seek(outPos);
+    return copied;
+#else
+    Q_UNUSED(in);
+    Q_UNUSED(out);
+    Q_UNUSED(size);
+    return 0;
+#endif
+}
+
+/*!
+    Copies \a size bytes from \a in to \a out, starting at the current positions of both devices.
+    Throws Error on failure.
+
+    If both devices are regular files, the data is copied by the kernel where supported. Otherwise
+    the data is copied through a buffer that grows with the amount of data copied.
+*/
+qint64 QInstaller::blockingCopy(QIODevice *in, QFileDevice *out, qint64 size)
 {
-    static const qint64 blockSize = 4096;
-    QByteArray ba(blockSize, '\0');
-    qint64 actual = qMin(blockSize, size);
-    while (actual > 0) {
+    static const qint64 minBlockSize = 64 * 1024;
+    static const qint64 maxBlockSize = 4 * 1024 * 1024;
+
+    qint64 left = size;
+    if (QFileDevice *const file = qobject_cast<QFileDevice *>(in))
+        left -= kernelCopy(file, out, left);
+
+    QByteArray ba;
+    qint64 blockSize = minBlockSize;
+    while (left > 0) {
+        const qint64 actual = qMin(blockSize, left);
+        if (ba.size() < actual)
+            ba.resize(actual);
         try {
             QInstaller::blockingRead(in, ba.data(), actual);
             QInstaller::blockingWrite(out, ba.constData(), actual);
-            size -= actual;
-            actual = qMin(blockSize, size);
         } catch (const Error &error) {
             throw Error(QCoreApplication::translate("QInstaller", "Copy failed. Error: %1")
                 .arg(error.message()));
         }
+        left -= actual;
+        blockSize = qMin(blockSize * 2, maxBlockSize);
     }
     return size;
 }
@@ -176,7 +290,7 @@ qint64 QInstaller::blockingWrite(QFileDevice *out, const char *data, qint64 size
 {
     qint64 left = size;
     while (left > 0) {
-        const qint64 n = out->write(data, left);
+        const qint64 n = out->write(data + (size - left), left);
         if (n < 0) {
             throw Error(QCoreApplication::translate("QInstaller",
                 "Write failed after %1 bytes: %2").arg(QString::number(size - left),
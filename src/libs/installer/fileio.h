@@ -40,6 +40,7 @@
 QT_BEGIN_NAMESPACE
 class QByteArray;
 class QFileDevice;
+class QIODevice;
 class QString;
 QT_END_NAMESPACE
 
@@ -61,14 +62,16 @@ QByteArray INSTALLER_EXPORT retrieveByteArray(QFileDevice *in);
 void INSTALLER_EXPORT appendByteArray(QFileDevice *out, const QByteArray &ba);
 
 QByteArray INSTALLER_EXPORT retrieveData(QFileDevice *in, qint64 size);
-void INSTALLER_EXPORT appendData(QFileDevice *out, QFileDevice *in, qint64 size);
+void INSTALLER_EXPORT appendData(QFileDevice *out, QIODevice *in, qint64 size);
 
 void INSTALLER_EXPORT openForRead(QFileDevice *dev);
 void INSTALLER_EXPORT openForWrite(QFileDevice *dev);
 void INSTALLER_EXPORT openForAppend(QFileDevice *dev);
 
-qint64 INSTALLER_EXPORT blockingRead(QFileDevice *in, char *buffer, qint64 size);
-qint64 INSTALLER_EXPORT blockingCopy(QFileDevice *in, QFileDevice *out, qint64 size);
+bool INSTALLER_EXPORT preallocate(QFileDevice *out, qint64 size);
+
+qint64 INSTALLER_EXPORT blockingRead(QIODevice *in, char *buffer, qint64 size);
+qint64 INSTALLER_EXPORT blockingCopy(QIODevice *in, QFileDevice *out, qint64 size);
 
 qint64 INSTALLER_EXPORT blockingWrite(QFileDevice *out, const QByteArray &data);
 qint64 INSTALLER_EXPORT blockingWrite(QFileDevice *out, const char *data, qint64 size);
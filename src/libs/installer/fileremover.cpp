@@ -0,0 +1,508 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "fileremover.h"
+
+#include "fileutils.h"
+#include "remoteclient.h"
+#include "remotefileoperations.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QVector>
+#include <QWaitCondition>
+
+#ifdef Q_OS_UNIX
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace QInstaller {
+
+static const int scProgressBatchSize = 256;
+
+#ifdef Q_OS_UNIX
+static QString errnoToQString(int error)
+{
+    return QString::fromLocal8Bit(strerror(error));
+}
+
+static bool isDirectoryAt(int dirFd, const struct dirent *entry)
+{
+#ifdef DT_DIR
+    if (entry->d_type != DT_UNKNOWN)
+        return entry->d_type == DT_DIR;
+#endif
+    struct stat st;
+    return ::fstatat(dirFd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+}
+#endif
+
+/*!
+    \inmodule QtInstallerFramework
+    \class QInstaller::FileRemover
+    \brief The FileRemover class removes large numbers of files and folders on a thread pool.
+
+    removeTree() removes a folder with all its contents. On Unix, every folder is opened once and
+    its entries are removed relative to it with \c unlinkat, while the subfolders are handed to
+    the other threads of the pool. removePaths() removes a list of files and folders, for example
+    the ones an operation created, and leaves folders alone that still contain other files.
+
+    Paths that go through the remote file engine are removed one by one in the calling thread,
+    the connection to the server is not meant to be used by several threads.
+
+    Progress is reported in batches rather than per file, through the progressChanged() and
+    currentFileChanged() signals. They are emitted from the pool threads.
+*/
+
+/*!
+    \fn void QInstaller::FileRemover::progressChanged(int processed, int total)
+
+    Emitted after every batch of removed entries and once when the removal has finished.
+    \a processed is the number of entries handled so far, \a total the number of entries known
+    so far. While removeTree() runs, \a total grows as more folders are listed.
+*/
+
+/*!
+    \fn void QInstaller::FileRemover::currentFileChanged(const QString &path)
+
+    Emitted together with progressChanged() with the \a path of the last removed entry.
+*/
+
+/*
+    Takes the next path from the shared list until all paths are handled. Folders are only
+    recorded, they get removed afterwards once their contents are gone.
+*/
+class FileRemover::PathRunnable : public QRunnable
+{
+public:
+    PathRunnable(FileRemover *remover, const QStringList &paths, QVector<Entry> *results,
+            QAtomicInt *next)
+        : m_remover(remover)
+        , m_paths(paths)
+        , m_results(results)
+        , m_next(next)
+    {}
+
+    void run()
+    {
+        int index;
+        while ((index = m_next->fetchAndAddRelaxed(1)) < m_paths.count())
+            (*m_results)[index] = m_remover->removeEntry(m_paths.at(index), true);
+    }
+
+private:
+    FileRemover *m_remover;
+    const QStringList m_paths;
+    QVector<Entry> *m_results;
+    QAtomicInt *m_next;
+};
+
+/*
+    The folders of a tree that still need to be emptied, shared by all threads removing the tree.
+    Every folder found is also appended to folders, so a folder is always listed before the
+    folders below it.
+*/
+struct FileRemover::TreeState
+{
+    TreeState() : busy(0) {}
+
+    QMutex mutex;
+    QWaitCondition condition;
+    QStringList pending;
+    QStringList folders;
+    int busy;
+};
+
+#ifdef Q_OS_UNIX
+class FileRemover::TreeRunnable : public QRunnable
+{
+public:
+    TreeRunnable(FileRemover *remover, TreeState *state)
+        : m_remover(remover)
+        , m_state(state)
+    {}
+
+    void run()
+    {
+        forever {
+            QString folder;
+            {
+                QMutexLocker _(&m_state->mutex);
+                while (m_state->pending.isEmpty() && m_state->busy > 0)
+                    m_state->condition.wait(&m_state->mutex);
+                if (m_state->pending.isEmpty()) {
+                    m_state->condition.wakeAll();
+                    return;
+                }
+                folder = m_state->pending.takeLast();
+                ++m_state->busy;
+            }
+
+            const QStringList subfolders = m_remover->clearFolder(folder);
+
+            QMutexLocker _(&m_state->mutex);
+            m_state->pending.append(subfolders);
+            m_state->folders.append(subfolders);
+            --m_state->busy;
+            m_state->condition.wakeAll();
+        }
+    }
+
+private:
+    FileRemover *m_remover;
+    TreeState *m_state;
+};
+#endif
+
+/*!
+    Creates a file remover with the given \a parent. The number of threads defaults to
+    QThread::idealThreadCount().
+*/
+FileRemover::FileRemover(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/*!
+    Destroys the file remover.
+*/
+FileRemover::~FileRemover()
+{
+    m_pool.waitForDone();
+}
+
+/*!
+    Returns the maximum number of threads removing files in parallel.
+*/
+int FileRemover::maxThreadCount() const
+{
+    return m_pool.maxThreadCount();
+}
+
+/*!
+    Sets the maximum number of threads removing files in parallel to \a threadCount.
+*/
+void FileRemover::setMaxThreadCount(int threadCount)
+{
+    m_pool.setMaxThreadCount(qMax(1, threadCount));
+}
+
+/*!
+    Removes the folder \a path with all its contents. Symbolic links are removed, but never
+    followed. Removing continues after an error, so as much as possible is removed. Returns
+    \c false if anything could not be removed; errorString() describes the first failure. A
+    \a path that does not exist is not an error.
+
+    If the installer runs with elevated rights, the server removes the whole tree in one request
+    and stops at the first error.
+
+    The function blocks until the removal has finished.
+*/
+bool FileRemover::removeTree(const QString &path)
+{
+    reset(0);
+    // QDir("") points to the working directory! We never want to remove that one.
+    if (path.isEmpty()) {
+        setError(tr("Cannot remove a folder without a name."));
+        return false;
+    }
+
+#ifdef Q_OS_UNIX
+    if (!RemoteClient::instance().isActive()) {
+        TreeState state;
+        state.pending.append(path);
+        for (int i = 0; i < m_pool.maxThreadCount(); ++i)
+            m_pool.start(new TreeRunnable(this, &state));
+        m_pool.waitForDone();
+
+        // folders in reverse order of discovery, so the ones below are gone first
+        m_total.fetchAndAddRelaxed(1);
+        for (int i = state.folders.count() - 1; i >= 0; --i)
+            removeFolder(state.folders.at(i));
+        removeFolder(path);
+        emitProgress(path);
+        return errorString().isEmpty();
+    }
+#endif
+
+    if (RemoteClient::instance().isActive()) {
+        if (!QFileInfo(path).exists() && !QFileInfo(path).isSymLink())
+            return true;
+
+        // one request, the server walks the tree and removes it itself
+        RemoteFileOperations operations;
+        connect(&operations, &RemoteFileOperations::progressChanged, this,
+            [this](qint64 completed, qint64 total) {
+                Q_UNUSED(completed);
+                m_total.store(int(total));
+            }, Qt::DirectConnection);
+        connect(&operations, &RemoteFileOperations::fileProcessed, this,
+            [this](const QString &file) { entryProcessed(file); }, Qt::DirectConnection);
+        if (!operations.removeTree(path))
+            setError(operations.errorString());
+        emitProgress(path);
+        return errorString().isEmpty();
+    }
+
+    // a folder is listed before its contents
+    QStringList entries;
+    QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System,
+        QDirIterator::Subdirectories);
+    while (it.hasNext())
+        entries.append(it.next());
+    removePaths(entries);
+
+    m_total.fetchAndAddRelaxed(1);
+    removeFolder(path);
+    emitProgress(path);
+    return errorString().isEmpty();
+}
+
+/*!
+    Removes the files and folders in \a paths, which are expected in the order they were created:
+    a folder before its contents. Files are removed in parallel, folders afterwards one by one,
+    the ones created last first. Folders that still contain other files are left alone. Paths
+    that do not exist are skipped.
+
+    Returns the files that could not be removed; errorString() describes the first failure. The
+    function blocks until the removal has finished.
+*/
+QStringList FileRemover::removePaths(const QStringList &paths)
+{
+    reset(paths.count());
+    QVector<Entry> results(paths.count());
+    if (RemoteClient::instance().isActive()) {
+        for (int i = 0; i < paths.count(); ++i)
+            results[i] = removeEntry(paths.at(i), false);
+    } else {
+        QAtomicInt next(0);
+        const int threadCount = qMin(m_pool.maxThreadCount(), paths.count());
+        for (int i = 0; i < threadCount; ++i)
+            m_pool.start(new PathRunnable(this, paths, &results, &next));
+        m_pool.waitForDone();
+    }
+
+    QStringList failed;
+    QDir dir;
+    for (int i = paths.count() - 1; i >= 0; --i) {
+        if (results.at(i) == Failed) {
+            failed.prepend(paths.at(i));
+        } else if (results.at(i) == Directory) {
+            removeSystemGeneratedFiles(paths.at(i));
+            dir.rmdir(paths.at(i)); // may contain files not created by us
+            entryProcessed(paths.at(i));
+        }
+    }
+    if (!paths.isEmpty())
+        emitProgress(paths.last());
+    return failed;
+}
+
+/*!
+    Returns the number of entries handled by the last call to removeTree() or removePaths().
+*/
+int FileRemover::entriesProcessed() const
+{
+    return m_processed.load();
+}
+
+/*!
+    Returns a description of the first failure of the last call to removeTree() or
+    removePaths(), or an empty string if everything was removed.
+*/
+QString FileRemover::errorString() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_errorString;
+}
+
+void FileRemover::reset(int total)
+{
+    m_processed.store(0);
+    m_total.store(total);
+    QMutexLocker _(&m_mutex);
+    m_errorString.clear();
+}
+
+/*
+    Counts the entry \a path as handled and reports the progress after every full batch. Called
+    from the pool threads.
+*/
+void FileRemover::entryProcessed(const QString &path)
+{
+    if ((m_processed.fetchAndAddRelaxed(1) + 1) % scProgressBatchSize == 0)
+        emitProgress(path);
+}
+
+void FileRemover::emitProgress(const QString &path)
+{
+    emit currentFileChanged(path);
+    emit progressChanged(m_processed.load(), m_total.load());
+}
+
+void FileRemover::setError(const QString &errorString)
+{
+    QMutexLocker _(&m_mutex);
+    if (m_errorString.isEmpty())
+        m_errorString = errorString;
+}
+
+/*
+    Removes \a path unless it is a folder. If \a local is \c true, the path is known not to go
+    through the remote file engine. Called from the pool threads.
+*/
+FileRemover::Entry FileRemover::removeEntry(const QString &path, bool local)
+{
+#ifdef Q_OS_UNIX
+    if (local) {
+        const QByteArray nativePath = QFile::encodeName(path);
+        if (::unlink(nativePath.constData()) == 0 || errno == ENOENT) {
+            entryProcessed(path);
+            return Removed;
+        }
+        const int error = errno;
+        struct stat st;
+        if ((error == EISDIR || error == EPERM) && ::lstat(nativePath.constData(), &st) == 0
+            && S_ISDIR(st.st_mode)) {
+            return Directory;
+        }
+        setError(tr("Could not remove file %1: %2").arg(path, errnoToQString(error)));
+        entryProcessed(path);
+        return Failed;
+    }
+#else
+    Q_UNUSED(local);
+#endif
+
+    const QFileInfo fi(path);
+    if (fi.isDir() && !fi.isSymLink())
+        return Directory;
+    if (!fi.exists() && !fi.isSymLink()) {
+        entryProcessed(path);
+        return Removed;
+    }
+
+    QFile file(path);
+#ifdef LUMIT_INSTALLER
+    {
+        // Delete readonly flag for file
+        QFile::Permissions permissions = file.permissions();
+        bool writeable = permissions & QFile::WriteOther;
+        if (!writeable)
+            file.setPermissions(permissions | QFile::WriteOther);
+    }
+#endif
+    if (!file.remove()) {
+        setError(tr("Could not remove file %1: %2").arg(path, file.errorString()));
+        entryProcessed(path);
+        return Failed;
+    }
+    entryProcessed(path);
+    return Removed;
+}
+
+/*
+    Removes the empty folder \a path, a folder that does not exist is not an error.
+*/
+void FileRemover::removeFolder(const QString &path)
+{
+    removeSystemGeneratedFiles(path);
+#ifdef Q_OS_UNIX
+    if (!RemoteClient::instance().isActive()) {
+        if (::rmdir(QFile::encodeName(path).constData()) != 0 && errno != ENOENT)
+            setError(tr("Could not remove folder %1: %2").arg(path, errnoToQString(errno)));
+        entryProcessed(path);
+        return;
+    }
+#endif
+    QDir dir;
+    if (dir.exists(path) && !dir.rmdir(path))
+        setError(tr("Could not remove folder %1.").arg(path));
+    entryProcessed(path);
+}
+
+#ifdef Q_OS_UNIX
+/*
+    Removes everything inside the folder \a path except the folders, which are returned instead.
+    The entries are listed first and removed afterwards, relative to the open folder. Called from
+    the pool threads.
+*/
+QStringList FileRemover::clearFolder(const QString &path)
+{
+    QStringList subfolders;
+    const int dirFd = ::open(QFile::encodeName(path).constData(),
+        O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (dirFd < 0) {
+        if (errno != ENOENT)
+            setError(tr("Could not open folder %1: %2").arg(path, errnoToQString(errno)));
+        return subfolders;
+    }
+    DIR *const stream = ::fdopendir(dirFd);
+    if (!stream) {
+        setError(tr("Could not open folder %1: %2").arg(path, errnoToQString(errno)));
+        ::close(dirFd);
+        return subfolders;
+    }
+
+    QList<QByteArray> files;
+    while (const struct dirent *entry = ::readdir(stream)) {
+        if (::strcmp(entry->d_name, ".") == 0 || ::strcmp(entry->d_name, "..") == 0)
+            continue;
+        if (isDirectoryAt(dirFd, entry))
+            subfolders.append(path + QLatin1Char('/') + QFile::decodeName(entry->d_name));
+        else
+            files.append(QByteArray(entry->d_name));
+    }
+    m_total.fetchAndAddRelaxed(files.count() + subfolders.count());
+
+    foreach (const QByteArray &file, files) {
+        const QString filePath = path + QLatin1Char('/') + QFile::decodeName(file);
+        if (::unlinkat(dirFd, file.constData(), 0) != 0 && errno != ENOENT)
+            setError(tr("Could not remove file %1: %2").arg(filePath, errnoToQString(errno)));
+        entryProcessed(filePath);
+    }
+    ::closedir(stream);
+    return subfolders;
+}
+#endif
+
+} // namespace QInstaller
@@ -0,0 +1,103 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef FILEREMOVER_H
+#define FILEREMOVER_H
+
+#include "installer_global.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT FileRemover : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(FileRemover)
+
+public:
+    explicit FileRemover(QObject *parent = 0);
+    ~FileRemover();
+
+    int maxThreadCount() const;
+    void setMaxThreadCount(int threadCount);
+
+    bool removeTree(const QString &path);
+    QStringList removePaths(const QStringList &paths);
+
+    int entriesProcessed() const;
+    QString errorString() const;
+
+signals:
+    void progressChanged(int processed, int total);
+    void currentFileChanged(const QString &path);
+
+private:
+    enum Entry {
+        Removed,
+        Failed,
+        Directory
+    };
+
+    class PathRunnable;
+    class TreeRunnable;
+    struct TreeState;
+
+    void reset(int total);
+    void entryProcessed(const QString &path);
+    void emitProgress(const QString &path);
+    void setError(const QString &errorString);
+
+    Entry removeEntry(const QString &path, bool local);
+    void removeFolder(const QString &path);
+#ifdef Q_OS_UNIX
+    QStringList clearFolder(const QString &path);
+#endif
+
+private:
+    QThreadPool m_pool;
+    QAtomicInt m_processed;
+    QAtomicInt m_total;
+
+    mutable QMutex m_mutex;
+    QString m_errorString;
+};
+
+} // namespace QInstaller
+
+#endif // FILEREMOVER_H
@@ -33,8 +33,11 @@
 **************************************************************************/
 #include "fileutils.h"
 
+#include "fileremover.h"
+
 #include <errors.h>
 
+#include <QtCore/QDataStream>
 #include <QtCore/QDateTime>
 #include <QtCore/QDir>
 #include <QtCore/QDirIterator>
@@ -208,18 +211,18 @@ void QInstaller::removeDirectory(const QString &path, bool ignoreErrors)
     if (path.isEmpty()) // QDir("") points to the working directory! We never want to remove that one.
         return;
 
-    QStringList dirs;
+    QStringList dirs(path);
     QDirIterator it(path, QDir::NoDotAndDotDot | QDir::Dirs | QDir::NoSymLinks | QDir::Hidden,
         QDirIterator::Subdirectories);
     while (it.hasNext()) {
-        dirs.prepend(it.next());
-        removeFiles(dirs.at(0), ignoreErrors);
+        dirs.append(it.next());
+        removeFiles(dirs.last(), ignoreErrors);
     }
 
     QDir d;
-    dirs.append(path);
     removeFiles(path, ignoreErrors);
-    foreach (const QString &dir, dirs) {
+    for (int i = dirs.count() - 1; i >= 0; --i) {   // a folder is listed before its subfolders
+        const QString &dir = dirs.at(i);
         errno = 0;
         if (d.exists(path) && !d.rmdir(dir)) {
             const QString errorMessage = QCoreApplication::translate("QInstaller",
@@ -253,11 +256,17 @@ protected:
      */
     void run()
     {
-        try {
-            removeDirectory(p, ignore);
-        } catch (const Error &e) {
-            err = e.message();
-        }
+        if (p.isEmpty()) // QDir("") points to the working directory! We never want to remove that one.
+            return;
+
+        // whole installations are removed on a thread pool
+        FileRemover remover;
+        if (remover.removeTree(p))
+            return;
+        if (!ignore)
+            err = remover.errorString();
+        else
+            qWarning() << remover.errorString();
     }
 
 private:
@@ -288,6 +297,30 @@ void QInstaller::removeSystemGeneratedFiles(const QString &path)
 #endif
 }
 
+/*!
+    Returns the target of a copy of the symbolic link \a link, made while copying the folder
+    \a sourceDir to \a targetDir. Relative targets are kept as they are, so they resolve within
+    the copy. Absolute targets inside \a sourceDir point to their copy in \a targetDir.
+*/
+QString QInstaller::linkTargetForCopy(const QString &link, const QString &sourceDir,
+    const QString &targetDir)
+{
+#ifdef Q_OS_UNIX
+    char buffer[4096];
+    const ssize_t length = ::readlink(QFile::encodeName(link).constData(), buffer, sizeof(buffer));
+    if (length > 0 && length < ssize_t(sizeof(buffer))) {
+        const QString target = QFile::decodeName(QByteArray(buffer, length));
+        if (QDir::isRelativePath(target))
+            return target;
+    }
+#endif
+    QString target = QFileInfo(link).symLinkTarget();
+    const QString source = QFileInfo(sourceDir).absoluteFilePath();
+    if (target == source || target.startsWith(source + QLatin1Char('/')))
+        target = QFileInfo(targetDir).absoluteFilePath() + target.mid(source.length());
+    return target;
+}
+
 void QInstaller::copyDirectoryContents(const QString &sourceDir, const QString &targetDir)
 {
     Q_ASSERT(QFileInfo(sourceDir).isDir());
@@ -580,3 +613,51 @@ bool QInstaller::isInBundle(const QString &path, QString *bundlePath)
 #endif
     return false;
 }
+
+/*!
+    Encodes the paths \a files in a compact form, for operations that record the files they
+    created. Paths mostly share long prefixes with their predecessor, so each one is stored as the
+    length of the shared prefix and the remaining UTF-8 suffix. The result is zlib compressed.
+
+    \sa decodeFileList()
+*/
+QByteArray QInstaller::encodeFileList(const QStringList &files)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << quint32(files.count());
+
+    QString previous;
+    foreach (const QString &file, files) {
+        const int length = qMin(previous.length(), file.length());
+        int shared = 0;
+        while (shared < length && previous.at(shared) == file.at(shared))
+            ++shared;
+        stream << quint32(shared) << file.mid(shared).toUtf8();
+        previous = file;
+    }
+    return qCompress(data);
+}
+
+/*!
+    Returns the paths encoded by encodeFileList() in \a data.
+*/
+QStringList QInstaller::decodeFileList(const QByteArray &data)
+{
+    const QByteArray uncompressed = qUncompress(data);
+    QDataStream stream(uncompressed);
+
+    quint32 count = 0;
+    stream >> count;
+
+    QStringList files;
+    QString previous;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        quint32 shared = 0;
+        QByteArray suffix;
+        stream >> shared >> suffix;
+        previous = previous.left(shared) + QString::fromUtf8(suffix);
+        files.append(previous);
+    }
+    return files;
+}
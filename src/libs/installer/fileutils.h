@@ -90,6 +90,8 @@ private:
 
     void INSTALLER_EXPORT moveDirectoryContents(const QString &sourceDir, const QString &targetDir);
     void INSTALLER_EXPORT copyDirectoryContents(const QString &sourceDir, const QString &targetDir);
+    QString INSTALLER_EXPORT linkTargetForCopy(const QString &link, const QString &sourceDir,
+        const QString &targetDir);
 
     bool INSTALLER_EXPORT isLocalUrl(const QUrl &url);
     QString INSTALLER_EXPORT pathFromUrl(const QUrl &url);
@@ -100,6 +102,9 @@ private:
     quint64 INSTALLER_EXPORT fileSize(const QFileInfo &info);
     bool INSTALLER_EXPORT isInBundle(const QString &path, QString *bundlePath = 0);
 
+    QByteArray INSTALLER_EXPORT encodeFileList(const QStringList &files);
+    QStringList INSTALLER_EXPORT decodeFileList(const QByteArray &data);
+
 #ifdef Q_OS_WIN
     QString INSTALLER_EXPORT getLongPathName(const QString &name);
     QString INSTALLER_EXPORT getShortPathName(const QString &name);
@@ -39,42 +39,66 @@
 #include <QList>
 #include <QPair>
 #include <QSet>
+#include <QVector>
+
+#include <algorithm>
 
 namespace QInstaller {
 
+/*
+    Nodes are mapped to dense integer ids on insertion. The adjacency lists are flattened into a
+    compressed sparse row (CSR) layout when sorting, so that the depth first search can run
+    iteratively on plain arrays in O(V + E) without hashing a node more than once.
+*/
 template <class T> class Graph
 {
 public:
-    inline Graph() {}
+    inline Graph() : m_hasCycle(false) {}
     explicit Graph(const QList<T> &nodes)
+        : m_hasCycle(false)
     {
         addNodes(nodes);
     }
 
     const QList<T> nodes() const
     {
-        return m_graph.keys();
+        return m_nodes.toList();
     }
 
     void addNode(const T &node)
     {
-        m_graph.insert(node, QSet<T>());
+        nodeId(node);
     }
 
     void addNodes(const QList<T> &nodes)
     {
+        m_nodes.reserve(m_nodes.count() + nodes.count());
         foreach (const T &node, nodes)
             addNode(node);
     }
 
     QList<T> edges(const T &node) const
     {
-        return m_graph.value(node).toList();
+        QList<T> result;
+        const int id = m_ids.value(node, -1);
+        if (id < 0)
+            return result;
+        const QVector<int> &adjacencies = m_adjacencies.at(id);
+        result.reserve(adjacencies.count());
+        foreach (int adjacency, adjacencies)
+            result.append(m_nodes.at(adjacency));
+        return result;
     }
 
     void addEdge(const T &node, const T &edge)
     {
-        m_graph[node].insert(edge);
+        const int from = nodeId(node);
+        const int to = nodeId(edge);
+        const quint64 key = edgeKey(from, to);
+        if (m_edgeSet.contains(key))
+            return;
+        m_edgeSet.insert(key);
+        m_adjacencies[from].append(to);
     }
 
     void addEdges(const T &node, const QList<T> &edges)
@@ -88,20 +112,82 @@ public:
         return m_hasCycle;
     }
 
+    /*
+        Returns the pair of nodes closing the detected cycle: the second node has an indirect
+        dependency on the first one.
+    */
     QPair<T, T> cycle() const
     {
-        return m_cycle;
+        if (m_cyclePath.count() < 2)
+            return qMakePair(T(), T());
+        return qMakePair(m_cyclePath.at(m_cyclePath.count() - 2), m_cyclePath.last());
+    }
+
+    /*
+        Returns the full path of the detected cycle, starting and ending with the same node.
+    */
+    QList<T> cyclePath() const
+    {
+        return m_cyclePath;
     }
 
     QList<T> sort() const
     {
-        QSet<T> visitedNodes;
+        enum Color { White, Gray, Black };
+
+        const int nodeCount = m_nodes.count();
+
+        // build the CSR adjacency, keeping the insertion order of the edges per node
+        QVector<int> offsets(nodeCount + 1, 0);
+        QVector<int> targets;
+        targets.reserve(m_edgeSet.count());
+        for (int i = 0; i < nodeCount; ++i) {
+            targets += m_adjacencies.at(i);
+            offsets[i + 1] = targets.count();
+        }
+
+        QVector<char> colors(nodeCount, White);
+        QVector<int> nextEdge(nodeCount, 0);
+        QVector<int> stack;
+        stack.reserve(nodeCount);
+
         QList<T> resolvedNodes;
+        resolvedNodes.reserve(nodeCount);
 
         m_hasCycle = false;
-        m_cycle = qMakePair(T(), T());
-        foreach (const T &node, nodes())
-            visit(node, &resolvedNodes, &visitedNodes);
+        m_cyclePath.clear();
+        for (int root = 0; root < nodeCount && !m_hasCycle; ++root) {
+            if (colors.at(root) != White)
+                continue;
+
+            colors[root] = Gray;
+            nextEdge[root] = offsets.at(root);
+            stack.append(root);
+            while (!stack.isEmpty()) {
+                const int node = stack.last();
+                if (nextEdge.at(node) == offsets.at(node + 1)) {
+                    // all adjacencies resolved, append this node to the ordered list
+                    colors[node] = Black;
+                    resolvedNodes.append(m_nodes.at(node));
+                    stack.removeLast();
+                    continue;
+                }
+
+                const int adjacency = targets.at(nextEdge[node]++);
+                if (colors.at(adjacency) == White) {
+                    colors[adjacency] = Gray;
+                    nextEdge[adjacency] = offsets.at(adjacency);
+                    stack.append(adjacency);
+                } else if (colors.at(adjacency) == Gray) {
+                    // the adjacency is still on the stack, so we detected a cycle
+                    m_hasCycle = true;
+                    for (int i = stack.lastIndexOf(adjacency); i < stack.count(); ++i)
+                        m_cyclePath.append(m_nodes.at(stack.at(i)));
+                    m_cyclePath.append(m_nodes.at(adjacency));
+                    break;
+                }
+            }
+        }
         return resolvedNodes;
     }
 
@@ -113,38 +199,32 @@ public:
     }
 
 private:
-    void visit(const T &node, QList<T> *const resolvedNodes, QSet<T> *const visitedNodes) const
+    int nodeId(const T &node)
     {
-        if (m_hasCycle)
-            return;
-
-        // if we visited this node already
-        if (visitedNodes->contains(node)) {
-            // and if the node is already in the ordered list
-            if (resolvedNodes->contains(node))
-                return;
-
-            m_hasCycle = true;
-            m_cycle.second = node;
-            return; // if not yet in the ordered list, we detected a cycle
-        }
-
-        // mark this node as visited
-        visitedNodes->insert(node);
-
-        m_cycle.first = node;
-        // recursively visit all adjacency
-        foreach (const T &adjacency, edges(node))
-            visit(adjacency, resolvedNodes, visitedNodes);
+        typename QHash<T, int>::const_iterator it = m_ids.constFind(node);
+        if (it != m_ids.constEnd())
+            return it.value();
+
+        const int id = m_nodes.count();
+        m_ids.insert(node, id);
+        m_nodes.append(node);
+        m_adjacencies.append(QVector<int>());
+        return id;
+    }
 
-        // append this node to the ordered list
-        resolvedNodes->append(node);
+    static quint64 edgeKey(int from, int to)
+    {
+        return (quint64(quint32(from)) << 32) | quint32(to);
     }
 
 private:
+    QHash<T, int> m_ids;
+    QVector<T> m_nodes;
+    QVector<QVector<int> > m_adjacencies;
+    QSet<quint64> m_edgeSet;
+
     mutable bool m_hasCycle;
-    QHash<T, QSet<T> > m_graph;
-    mutable QPair<T,T> m_cycle;
+    mutable QList<T> m_cyclePath;
 };
 
 }
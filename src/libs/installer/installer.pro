@@ -59,6 +59,7 @@ HEADERS += packagemanagercore.h \
     replaceoperation.h \
     linereplaceoperation.h \
     copydirectoryoperation.h \
+    copytreeoperation.h \
     simplemovefileoperation.h \
     extractarchiveoperation.h \
     extractarchiveoperation_p.h \
@@ -117,14 +118,20 @@ HEADERS += packagemanagercore.h \
     remoteclient_p.h \
     remoteserver_p.h \
     remotefileengine.h \
+    remotefileoperations.h \
+    remotefileoperations_p.h \
     remoteserverconnection.h \
     remoteserverconnection_p.h \
     fileio.h \
+    filehasher.h \
+    fileremover.h \
+    operationlog.h \
     binarycontent.h \
     binarylayout.h \
     installercalculator.h \
     uninstallercalculator.h \
     componentchecker.h \
+    componentindex.h \
     proxycredentialsdialog.h \
     serverauthenticationdialog.h \
     keepaliveobject.h \
@@ -148,6 +155,7 @@ SOURCES += packagemanagercore.cpp \
     replaceoperation.cpp \
     linereplaceoperation.cpp \
     copydirectoryoperation.cpp \
+    copytreeoperation.cpp \
     simplemovefileoperation.cpp \
     extractarchiveoperation.cpp \
     globalsettingsoperation.cpp \
@@ -194,13 +202,18 @@ SOURCES += packagemanagercore.cpp \
     remoteclient.cpp \
     remoteserver.cpp \
     remotefileengine.cpp \
+    remotefileoperations.cpp \
     remoteserverconnection.cpp \
     fileio.cpp \
+    filehasher.cpp \
+    fileremover.cpp \
+    operationlog.cpp \
     binarycontent.cpp \
     binarylayout.cpp \
     installercalculator.cpp \
     uninstallercalculator.cpp \
     componentchecker.cpp \
+    componentindex.cpp \
     proxycredentialsdialog.cpp \
     serverauthenticationdialog.cpp \
     keepaliveobject.cpp \
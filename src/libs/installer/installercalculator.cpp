@@ -35,14 +35,17 @@
 #include "installercalculator.h"
 
 #include "component.h"
+#include "componentindex.h"
 #include "packagemanagercore.h"
 
 #include <QDebug>
 
 namespace QInstaller {
 
-InstallerCalculator::InstallerCalculator(const QList<Component *> &allComponents)
+InstallerCalculator::InstallerCalculator(const QList<Component *> &allComponents,
+        const ComponentIndex *componentIndex)
     : m_allComponents(allComponents)
+    , m_componentIndex(componentIndex)
 {
 }
 
@@ -167,8 +170,9 @@ bool InstallerCalculator::appendComponentToInstall(Component *component)
     foreach (const QString &dependencyComponentName, allDependencies) {
         // PackageManagerCore::componentByName returns 0 if dependencyComponentName contains a
         // version which is not available
-        Component *dependencyComponent =
-            PackageManagerCore::componentByName(dependencyComponentName, m_allComponents);
+        Component *dependencyComponent = m_componentIndex
+            ? m_componentIndex->componentByName(dependencyComponentName)
+            : PackageManagerCore::componentByName(dependencyComponentName, m_allComponents);
         if (!dependencyComponent) {
             const QString errorMessage = QCoreApplication::translate("InstallerCalculator",
                 "Cannot find missing dependency '%1' for '%2'.").arg(dependencyComponentName,
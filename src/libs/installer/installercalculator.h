@@ -44,11 +44,13 @@
 namespace QInstaller {
 
 class Component;
+class ComponentIndex;
 
 class INSTALLER_EXPORT InstallerCalculator
 {
 public:
-    InstallerCalculator(const QList<Component *> &allComponents);
+    InstallerCalculator(const QList<Component *> &allComponents,
+        const ComponentIndex *componentIndex = 0);
 
     enum InstallReasonType
     {
@@ -75,6 +77,7 @@ private:
     QString recursionError(Component *component);
 
     QList<Component*> m_allComponents;
+    const ComponentIndex *m_componentIndex;
     QHash<Component*, QSet<Component*> > m_visitedComponents;
     QSet<QString> m_toInstallComponentIds; //for faster lookups
     QString m_componentsToInstallError;
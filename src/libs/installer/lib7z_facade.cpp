@@ -43,8 +43,11 @@
 #include "Common/MyInitGuid.h"
 
 #include "7zip/Archive/IArchive.h"
+#include "7zip/UI/Common/EnumDirItems.h"
 #include "7zip/UI/Common/OpenArchive.h"
+#include "7zip/UI/Common/SetProperties.h"
 #include "7zip/UI/Common/Update.h"
+#include "7zip/UI/Common/UpdateProduce.h"
 
 #include "Windows/FileIO.h"
 #include "Windows/PropVariant.h"
@@ -54,8 +57,12 @@
 #include <QFileInfo>
 #include <QIODevice>
 #include <QtCore/QMutexLocker>
+#include <QtCore/QQueue>
+#include <QtCore/QSet>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
 #include <QPointer>
-#include <QTemporaryFile>
 #include <QReadWriteLock>
 
 #ifdef _MSC_VER
@@ -203,14 +210,41 @@ static QString UString2QString(const UString& str)
     return QString::fromStdWString(static_cast<const wchar_t*>(str));
 }
 
-static QString generateTempFileName()
+namespace {
+/*
+    Keeps the codecs and archive formats compiled into the library. Loading them is expensive, so
+    it happens only once; afterwards they are only read and can be shared between threads.
+*/
+class LoadedCodecs
 {
-    QTemporaryFile tmp;
-    if (!tmp.open()) {
-        throw SevenZipException(QCoreApplication::translate("QInstaller",
-            "Could not create temporary file"));
+public:
+    LoadedCodecs()
+        : m_codecs(new CCodecs)
+        , m_result(m_codecs->Load())
+    {}
+
+    CCodecs *codecs() const
+    {
+        return m_result == S_OK ? m_codecs.data() : 0;
     }
-    return QDir::toNativeSeparators(tmp.fileName());
+
+private:
+    QScopedPointer<CCodecs> m_codecs;
+    const HRESULT m_result;
+};
+}
+
+Q_GLOBAL_STATIC(LoadedCodecs, loadedCodecs)
+
+/*
+    Returns the shared codecs. Throws SevenZipException if they could not be loaded.
+*/
+static CCodecs *sharedCodecs()
+{
+    CCodecs *const codecs = loadedCodecs()->codecs();
+    if (!codecs)
+        throw SevenZipException(QCoreApplication::translate("Lib7z", "Could not load codecs"));
+    return codecs;
 }
 
 /*
@@ -465,6 +499,182 @@ public:
 private:
     QPointer<QIODevice> m_device;
 };
+
+/*
+    Reads straight from the memory mapped content of a file device, without going through
+    QIODevice::read() and its buffer. The mapping is released together with the stream.
+*/
+class QFileDeviceMappedInStream : public IInStream, public CMyUnknownImp
+{
+public:
+    MY_UNKNOWN_IMP
+
+    QFileDeviceMappedInStream(QFileDevice* device, uchar* data, qint64 size)
+        : IInStream()
+        , CMyUnknownImp()
+        , m_device(device)
+        , m_data(data)
+        , m_size(size)
+        , m_pos(0)
+    {
+        assert(m_device);
+        assert(m_data);
+    }
+
+    ~QFileDeviceMappedInStream()
+    {
+        if (m_device && m_device->isOpen())
+            m_device->unmap(m_data);
+    }
+
+    /* reimp */ STDMETHOD(Read)(void* data, UInt32 size, UInt32* processedSize)
+    {
+        if (processedSize)
+            *processedSize = 0;
+        // the mapping is gone once the device got closed
+        if (!m_device || !m_device->isOpen())
+            return E_FAIL;
+
+        const qint64 actual = qBound<qint64>(0, m_size - m_pos, size);
+        memcpy(data, m_data + m_pos, actual);
+        m_pos += actual;
+        if (processedSize)
+            *processedSize = actual;
+        return S_OK;
+    }
+
+    /* reimp */ STDMETHOD(Seek)(Int64 offset, UInt32 seekOrigin, UInt64* newPosition)
+    {
+        qint64 np = 0;
+        switch(seekOrigin) {
+        case STREAM_SEEK_SET:
+            np = offset;
+            break;
+        case STREAM_SEEK_CUR:
+            np = m_pos + offset;
+            break;
+        case STREAM_SEEK_END:
+            np = m_size + offset;
+            break;
+        default:
+            return STG_E_INVALIDFUNCTION;
+        }
+        if (np < 0)
+            return STG_E_INVALIDFUNCTION;
+
+        m_pos = np;
+        if (newPosition)
+            *newPosition = np;
+        return S_OK;
+    }
+
+private:
+    QPointer<QFileDevice> m_device;
+    uchar* const m_data;
+    const qint64 m_size;
+    qint64 m_pos;
+};
+
+/*
+    Returns a stream reading from the memory mapped \a device, or falls back to reading through
+    the device if it cannot be mapped, e.g. over the remote file engine.
+*/
+static IInStream* createInStream(QFileDevice* device)
+{
+    if (uchar* const mapped = device->map(0, device->size()))
+        return new QFileDeviceMappedInStream(device, mapped, device->size());
+    return new QIODeviceInStream(device);
+}
+
+/*
+    Writes to a file device, starting at the position the device had when the stream got created.
+    Unlike QIODeviceSequentialOutStream it can seek, which the 7z format needs to write its start
+    header once all data has been compressed.
+*/
+class QFileDeviceOutStream : public IOutStream, public CMyUnknownImp
+{
+public:
+    MY_UNKNOWN_IMP1(IOutStream)
+
+    explicit QFileDeviceOutStream(QFileDevice* device)
+        : IOutStream()
+        , CMyUnknownImp()
+        , m_device(device)
+        , m_start(device->pos())
+    {
+        assert(m_device);
+        assert(!m_device->isSequential());
+    }
+
+    QString errorString() const
+    {
+        return m_errorString;
+    }
+
+    /* reimp */ STDMETHOD(Write)(const void* data, UInt32 size, UInt32* processedSize)
+    {
+        if (processedSize)
+            *processedSize = 0;
+        if (!m_device)
+            return E_FAIL;
+
+        const qint64 written = m_device->write(reinterpret_cast<const char*>(data), size);
+        if (written < 0) {
+            m_errorString = m_device->errorString();
+            return E_FAIL;
+        }
+        if (processedSize)
+            *processedSize = written;
+        return S_OK;
+    }
+
+    /* reimp */ STDMETHOD(Seek)(Int64 offset, UInt32 seekOrigin, UInt64* newPosition)
+    {
+        if (!m_device)
+            return E_FAIL;
+
+        qint64 np = 0;
+        switch(seekOrigin) {
+        case STREAM_SEEK_SET:
+            np = offset;
+            break;
+        case STREAM_SEEK_CUR:
+            np = m_device->pos() - m_start + offset;
+            break;
+        case STREAM_SEEK_END:
+            np = m_device->size() - m_start + offset;
+            break;
+        default:
+            return STG_E_INVALIDFUNCTION;
+        }
+        if (np < 0)
+            return STG_E_INVALIDFUNCTION;
+
+        if (!m_device->seek(m_start + np)) {
+            m_errorString = m_device->errorString();
+            return E_FAIL;
+        }
+        if (newPosition)
+            *newPosition = np;
+        return S_OK;
+    }
+
+    /* reimp */ STDMETHOD(SetSize)(UInt64 newSize)
+    {
+        if (!m_device)
+            return E_FAIL;
+        if (!m_device->resize(m_start + newSize)) {
+            m_errorString = m_device->errorString();
+            return E_FAIL;
+        }
+        return S_OK;
+    }
+
+private:
+    QPointer<QFileDevice> m_device;
+    const qint64 m_start;
+    QString m_errorString;
+};
 }
 
 File::File()
@@ -633,18 +843,14 @@ class OpenArchiveInfo
 {
 private:
     OpenArchiveInfo(QFileDevice* device)
-        : codecs(new CCodecs)
+        : codecs(sharedCodecs())
     {
-        if (codecs->Load() != S_OK) {
-            throw SevenZipException(QCoreApplication::translate("OpenArchiveInfo",
-                "Could not load codecs"));
-        }
         if (!codecs->FindFormatForArchiveType(L"", formatIndices)) {
             throw SevenZipException(QCoreApplication::translate("OpenArchiveInfo",
                 "Could not retrieve default format"));
         }
-        stream = new QIODeviceInStream(device);
-        if (archiveLink.Open2(codecs.data(), formatIndices, false, stream, UString(), 0) != S_OK) {
+        stream = createInStream(device);
+        if (archiveLink.Open2(codecs, formatIndices, false, stream, UString(), 0) != S_OK) {
             throw SevenZipException(QCoreApplication::translate("OpenArchiveInfo",
                 "Could not open archive"));
         }
@@ -683,7 +889,7 @@ public:
 private:
     CIntVector formatIndices;
     CMyComPtr<IInStream> stream;
-    QScopedPointer<CCodecs> codecs;
+    CCodecs *const codecs;
     OpenArchiveInfoCleaner *m_cleaner;
 
     static QMutex m_mutex;
@@ -765,6 +971,364 @@ void ListArchiveJob::doStart()
     emitResult();
 }
 
+namespace {
+/**
+* Everything needed to finish an extracted item once its content is on disk.
+*/
+struct ExtractedItem {
+    ExtractedItem()
+        : isSymLink(false)
+        , hasPermissions(false)
+        , hasMTime(false)
+#ifdef Q_OS_WIN
+        , hasCATime(false)
+#endif
+    {}
+
+    QString path;
+    bool isSymLink;
+    bool hasPermissions;
+    QFile::Permissions permissions;
+    bool hasMTime;
+    FILETIME mTime;
+#ifdef Q_OS_WIN
+    bool hasCATime;
+    FILETIME cTime;
+    FILETIME aTime;
+#endif
+};
+
+/**
+* Turns a symlink placeholder into the link, restores the time stamps and sets the permissions.
+*/
+static bool finishExtractedItem(const ExtractedItem &item, QString *errorString)
+{
+    if (item.isSymLink) {
+#ifdef Q_OS_WIN
+        qFatal(QString::fromLatin1("Creating a link from archive is not implemented for windows. "
+            "Link filename: %1").arg(item.path).toLatin1());
+        // TODO
+//        if (!CreateHardLinkWrapper(item.path, QLatin1String(symlinkTarget))) {
+//            return false;
+//        }
+#else
+        QFileInfo symlinkPlaceHolderFileInfo(item.path);
+        if (symlinkPlaceHolderFileInfo.isSymLink()) {
+            *errorString = QCoreApplication::translate("ExtractCallbackImpl",
+                "Could not create symlink at '%1'. Another one is already existing.").arg(item.path);
+            return false;
+        }
+        QFile symlinkPlaceHolderFile(item.path);
+        if (!symlinkPlaceHolderFile.open(QIODevice::ReadOnly)) {
+            *errorString = QCoreApplication::translate("ExtractCallbackImpl",
+                "Could not read symlink target from file '%1'.").arg(item.path);
+            return false;
+        }
+
+        const QByteArray symlinkTarget = symlinkPlaceHolderFile.readAll();
+        symlinkPlaceHolderFile.close();
+        symlinkPlaceHolderFile.remove();
+        QFile targetFile(QString::fromLatin1(symlinkTarget));
+        if (!targetFile.link(item.path)) {
+            *errorString = QCoreApplication::translate("ExtractCallbackImpl",
+                "Could not create symlink at %1. %2").arg(item.path, targetFile.errorString());
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    try {
+        if (!item.path.isEmpty()) {
+            if (item.hasMTime) {
+                NWindows::NFile::NIO::COutFile file;
+                if (file.Open(QString2UString(item.path), 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL))
+                    file.SetTime(&item.mTime, &item.mTime, &item.mTime);
+            }
+#ifdef Q_OS_WIN
+            if (item.hasCATime) {
+                NWindows::NFile::NIO::COutFile file;
+                if (file.Open(QString2UString(item.path), 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL))
+                    file.SetTime(&item.cTime, &item.aTime, &item.mTime);
+            }
+#endif
+        }
+    } catch (...) {}
+
+    if (item.hasPermissions)
+        QFile::setPermissions(item.path, item.permissions);
+    return true;
+}
+
+/**
+* Writes extracted files on a pool of worker threads, so that the decoder does not have to wait
+* for the disk. The chunks of one file are written in order by one worker at a time, different
+* files are written in parallel. A file is finished once its last chunk has been written.
+*
+* At most MaxOpenFiles files are open at the same time, and a path is only opened again once the
+* file written to it before is finished.
+*/
+class FileWriter
+{
+    Q_DISABLE_COPY(FileWriter)
+
+public:
+    enum {
+        MaxPendingBytes = 64 * 1024 * 1024,
+        MaxOpenFiles = 64
+    };
+
+    struct Queue {
+        explicit Queue(const QString &path)
+            : file(path)
+            , scheduled(false)
+            , closed(false)
+        {}
+
+        QFile file;
+        QQueue<QByteArray> chunks;
+        bool scheduled;
+        bool closed;
+        ExtractedItem item;
+    };
+    typedef QSharedPointer<Queue> QueuePointer;
+
+    explicit FileWriter(int threadCount)
+        : m_pendingBytes(0)
+    {
+        m_pool.setMaxThreadCount(threadCount);
+    }
+
+    ~FileWriter()
+    {
+        m_pool.waitForDone();
+    }
+
+    // Blocks until the file written to \a path before, if any, is finished. An archive may
+    // contain the same path twice, the later entry has to win.
+    void waitForPath(const QString &path)
+    {
+        QMutexLocker _(&m_mutex);
+        while (m_errorString.isEmpty() && m_openPaths.contains(pathKey(path)))
+            m_condition.wait(&m_mutex);
+    }
+
+    // Blocks while too many files are open or \a path is still being written.
+    QueuePointer open(const QString &path, QString *errorString)
+    {
+        const QString key = pathKey(path);
+        {
+            QMutexLocker _(&m_mutex);
+            while (m_errorString.isEmpty()
+                && (m_openPaths.count() >= MaxOpenFiles || m_openPaths.contains(key))) {
+                m_condition.wait(&m_mutex);
+            }
+            if (!m_errorString.isEmpty()) {
+                *errorString = m_errorString;
+                return QueuePointer();
+            }
+            m_openPaths.insert(key);
+        }
+
+        QueuePointer queue(new Queue(path));
+        if (!queue->file.open(QIODevice::WriteOnly)) {
+            *errorString = queue->file.errorString();
+            QMutexLocker _(&m_mutex);
+            m_openPaths.remove(key);
+            m_condition.wakeAll();
+            return QueuePointer();
+        }
+        return queue;
+    }
+
+    // Blocks while too much data is waiting to be written. Returns false after any write failed.
+    bool write(const QueuePointer &queue, const QByteArray &chunk)
+    {
+        QMutexLocker _(&m_mutex);
+        while (m_errorString.isEmpty() && m_pendingBytes > MaxPendingBytes)
+            m_condition.wait(&m_mutex);
+        if (!m_errorString.isEmpty())
+            return false;
+
+        m_pendingBytes += chunk.size();
+        queue->chunks.enqueue(chunk);
+        schedule(queue);
+        return true;
+    }
+
+    void close(const QueuePointer &queue, const ExtractedItem &item)
+    {
+        QMutexLocker _(&m_mutex);
+        queue->item = item;
+        queue->closed = true;
+        schedule(queue);
+    }
+
+    QString errorString() const
+    {
+        QMutexLocker _(&m_mutex);
+        return m_errorString;
+    }
+
+    QString waitForDone()
+    {
+        m_pool.waitForDone();
+        return errorString();
+    }
+
+private:
+    class Runnable : public QRunnable
+    {
+    public:
+        Runnable(FileWriter *writer, const QueuePointer &queue)
+            : m_writer(writer)
+            , m_queue(queue)
+        {}
+
+        void run()
+        {
+            m_writer->drain(m_queue);
+        }
+
+    private:
+        FileWriter *const m_writer;
+        const QueuePointer m_queue;
+    };
+
+    // needs to be called with the mutex locked
+    void schedule(const QueuePointer &queue)
+    {
+        if (queue->scheduled)
+            return;
+        queue->scheduled = true;
+        m_pool.start(new Runnable(this, queue));
+    }
+
+    void drain(const QueuePointer &queue)
+    {
+        QMutexLocker locker(&m_mutex);
+        forever {
+            QString errorString;
+            if (!queue->chunks.isEmpty()) {
+                const QByteArray chunk = queue->chunks.dequeue();
+                const bool failed = !m_errorString.isEmpty();
+                locker.unlock();
+                if (!failed && queue->file.write(chunk) != chunk.size()) {
+                    errorString = QCoreApplication::translate("FileWriter",
+                        "Could not write to file %1: %2").arg(queue->file.fileName(),
+                        queue->file.errorString());
+                }
+                locker.relock();
+                m_pendingBytes -= chunk.size();
+                m_condition.wakeAll();
+            } else if (queue->closed) {
+                queue->closed = false;
+                const bool failed = !m_errorString.isEmpty();
+                locker.unlock();
+                queue->file.close();
+                if (!failed)
+                    finishExtractedItem(queue->item, &errorString);
+                locker.relock();
+                m_openPaths.remove(pathKey(queue->file.fileName()));
+                m_condition.wakeAll();
+            } else {
+                queue->scheduled = false;
+                return;
+            }
+
+            if (!errorString.isEmpty() && m_errorString.isEmpty()) {
+                m_errorString = errorString;
+                m_condition.wakeAll();
+            }
+        }
+    }
+
+    static QString pathKey(const QString &path)
+    {
+#ifdef Q_OS_WIN
+        return path.toLower();
+#else
+        return path;
+#endif
+    }
+
+    QThreadPool m_pool;
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    qint64 m_pendingBytes;
+    QSet<QString> m_openPaths;
+    QString m_errorString;
+};
+
+/**
+* Output stream handing the extracted content over to a FileWriter in large chunks.
+*/
+class QueuedFileOutStream : public ISequentialOutStream, public CMyUnknownImp
+{
+public:
+    enum {
+        ChunkSize = 1024 * 1024
+    };
+
+    MY_UNKNOWN_IMP
+    QueuedFileOutStream(FileWriter *writer, const FileWriter::QueuePointer &queue)
+        : ISequentialOutStream()
+        , CMyUnknownImp()
+        , m_writer(writer)
+        , m_queue(queue)
+    {
+    }
+
+    ~QueuedFileOutStream()
+    {
+        flush();
+    }
+
+    /* reimp */ STDMETHOD(Write)(const void* data, UInt32 size, UInt32* processedSize)
+    {
+        if (processedSize)
+            *processedSize = 0;
+        m_buffer.append(reinterpret_cast<const char*>(data), size);
+        if (m_buffer.size() >= ChunkSize && !flush()) {
+            Lib7z::setLastError(m_writer->errorString());
+            return E_FAIL;
+        }
+        if (processedSize)
+            *processedSize = size;
+        return S_OK;
+    }
+
+private:
+    bool flush()
+    {
+        if (m_buffer.isEmpty())
+            return true;
+        const bool written = m_writer->write(m_queue, m_buffer);
+        m_buffer = QByteArray();
+        return written;
+    }
+
+    FileWriter *const m_writer;
+    const FileWriter::QueuePointer m_queue;
+    QByteArray m_buffer;
+};
+
+/**
+* Sets the number of threads the decoders of \a archive may use.
+*/
+static void setDecoderThreadCount(IInArchive *archive, int threadCount)
+{
+    CMyComPtr<ISetProperties> setProperties;
+    archive->QueryInterface(IID_ISetProperties, (void **)&setProperties);
+    if (!setProperties)
+        return;
+
+    const wchar_t *names[] = { L"MT" };
+    NCOM::CPropVariant value(static_cast<UInt32>(threadCount));
+    setProperties->SetProperties(names, &value, 1);
+}
+}
+
 class Lib7z::ExtractCallbackImpl : public IArchiveExtractCallback, public CMyUnknownImp
 {
 public:
@@ -776,6 +1340,7 @@ public:
         , total(0)
         , completed(0)
         , device(0)
+        , writer(0)
     {
     }
 
@@ -809,6 +1374,7 @@ public:
             assert(arc);
 
             currentIndex = index;
+            currentQueue.clear();
 
             UString s;
             if (arc->GetItemPath(index, s) != S_OK) {
@@ -832,6 +1398,9 @@ public:
             foreach (const QString &directory, directories)
                 q->setCurrentFile(directory);
 
+            // a file written to the same path before has to be finished before it gets replaced
+            if (!isDir && writer)
+                writer->waitForPath(fi.absoluteFilePath());
             if (!isDir && !q->prepareForFile(fi.absoluteFilePath()))
                 return E_FAIL;
 
@@ -846,17 +1415,30 @@ public:
                     return E_FAIL;
                 }
 #endif
-                QIODeviceSequentialOutStream *qOutStream = new QIODeviceSequentialOutStream(
-                    new QFile(fi.absoluteFilePath()), QIODeviceSequentialOutStream::CloseAndDeleteDevice);
-                if (!qOutStream->errorString().isEmpty()) {
-                    Lib7z::setLastError(QCoreApplication::translate("ExtractCallbackImpl",
-                        "Could not open file: %1 (%2)").arg(fi.absoluteFilePath(),
-                        qOutStream->errorString()));
-                    return E_FAIL;
+                if (writer) {
+                    QString errorString;
+                    currentQueue = writer->open(fi.absoluteFilePath(), &errorString);
+                    if (!currentQueue) {
+                        Lib7z::setLastError(QCoreApplication::translate("ExtractCallbackImpl",
+                            "Could not open file: %1 (%2)").arg(fi.absoluteFilePath(), errorString));
+                        return E_FAIL;
+                    }
+                    CMyComPtr<ISequentialOutStream> stream = new QueuedFileOutStream(writer,
+                        currentQueue);
+                    *outStream = stream.Detach();
+                } else {
+                    QIODeviceSequentialOutStream *qOutStream = new QIODeviceSequentialOutStream(
+                        new QFile(fi.absoluteFilePath()), QIODeviceSequentialOutStream::CloseAndDeleteDevice);
+                    if (!qOutStream->errorString().isEmpty()) {
+                        Lib7z::setLastError(QCoreApplication::translate("ExtractCallbackImpl",
+                            "Could not open file: %1 (%2)").arg(fi.absoluteFilePath(),
+                            qOutStream->errorString()));
+                        return E_FAIL;
+                    }
+                    CMyComPtr<ISequentialOutStream> stream = qOutStream;
+                    *outStream = stream;
+                    stream.Detach();
                 }
-                CMyComPtr<ISequentialOutStream> stream = qOutStream;
-                *outStream = stream;
-                stream.Detach();
             }
 
             guard.release();
@@ -876,8 +1458,8 @@ public:
         Q_UNUSED(resultEOperationResult)
 
         if (!targetDir.isEmpty()) {
-            bool hasPerm = false;
-            const QFile::Permissions permissions = getPermissions(arc->Archive, currentIndex, &hasPerm);
+            ExtractedItem item;
+            item.permissions = getPermissions(arc->Archive, currentIndex, &item.hasPermissions);
 
             UString s;
             if (arc->GetItemPath(currentIndex, s) != S_OK) {
@@ -886,76 +1468,40 @@ public:
                 return E_FAIL;
             }
             const QString path = UString2QString(s).replace(QLatin1Char('\\'), QLatin1Char('/'));
-            const QString absFilePath = QFileInfo(QString::fromLatin1("%1/%2").arg(targetDir, path))
-                .absoluteFilePath();
+            item.path = QFileInfo(QString::fromLatin1("%1/%2").arg(targetDir, path)).absoluteFilePath();
 
             // do we have a symlink?
             const quint32 attributes = getUInt32Property(arc->Archive, currentIndex, kpidAttrib, 0);
             struct stat stat_info;
             stat_info.st_mode = attributes >> 16;
-            if (S_ISLNK(stat_info.st_mode)) {
-#ifdef Q_OS_WIN
-                qFatal(QString::fromLatin1("Creating a link from archive is not implemented for windows. "
-                    "Link filename: %1").arg(absFilePath).toLatin1());
-                // TODO
-//                if (!CreateHardLinkWrapper(absFilePath, QLatin1String(symlinkTarget))) {
-//                    return S_FALSE;
-//                }
-#else
-                QFileInfo symlinkPlaceHolderFileInfo(absFilePath);
-                if (symlinkPlaceHolderFileInfo.isSymLink()) {
-                    Lib7z::setLastError(QCoreApplication::translate("ExtractCallbackImpl",
-                        "Could not create symlink at '%1'. Another one is already existing.")
-                        .arg(absFilePath));
-                    return E_FAIL;
-                }
-                QFile symlinkPlaceHolderFile(absFilePath);
-                if (!symlinkPlaceHolderFile.open(QIODevice::ReadOnly)) {
-                    Lib7z::setLastError(QCoreApplication::translate("ExtractCallbackImpl",
-                        "Could not read symlink target from file '%1'.").arg(absFilePath));
-                    return E_FAIL;
-                }
-
-                const QByteArray symlinkTarget = symlinkPlaceHolderFile.readAll();
-                symlinkPlaceHolderFile.close();
-                symlinkPlaceHolderFile.remove();
-                QFile targetFile(QString::fromLatin1(symlinkTarget));
-                if (!targetFile.link(absFilePath)) {
-                    Lib7z::setLastError(QCoreApplication::translate("ExtractCallbackImpl",
-                        "Could not create symlink at %1. %2").arg(absFilePath,
-                        targetFile.errorString()));
-                    return E_FAIL;
-                }
-                return S_OK;
-#endif
-            }
+            item.isSymLink = S_ISLNK(stat_info.st_mode);
 
+            // This might fail for archives without all properties, we can only be sure about
+            // modification time, as it's always stored by default in 7z archives. Also note that
+            // we restore modification time on Unix only, as access time and change time are
+            // supposed to be set to the time of installation.
             try {
-                if (!absFilePath.isEmpty()) {
-                    // This might fail for archives without all properties, we can only be sure about
-                    // modification time, as it's always stored by default in 7z archives. Also note that
-                    // we restore modification time on Unix only, as access time and change time are
-                    // supposed to be set to the time of installation.
-                    FILETIME mTime;
-                    if (getFileTimeFromProperty(arc->Archive, currentIndex, kpidMTime, &mTime)) {
-                        NWindows::NFile::NIO::COutFile file;
-                        if (file.Open(QString2UString(absFilePath), 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL))
-                            file.SetTime(&mTime, &mTime, &mTime);
-                    }
+                item.hasMTime = getFileTimeFromProperty(arc->Archive, currentIndex, kpidMTime,
+                    &item.mTime);
 #ifdef Q_OS_WIN
-                    FILETIME cTime, aTime;
-                    bool success = getFileTimeFromProperty(arc->Archive, currentIndex, kpidCTime, &cTime);
-                    if (success && getFileTimeFromProperty(arc->Archive, currentIndex, kpidATime, &aTime)) {
-                        NWindows::NFile::NIO::COutFile file;
-                        if (file.Open(QString2UString(absFilePath), 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL))
-                            file.SetTime(&cTime, &aTime, &mTime);
-                    }
+                item.hasCATime = item.hasMTime
+                    && getFileTimeFromProperty(arc->Archive, currentIndex, kpidCTime, &item.cTime)
+                    && getFileTimeFromProperty(arc->Archive, currentIndex, kpidATime, &item.aTime);
 #endif
-                }
             } catch (...) {}
 
-            if (hasPerm)
-                QFile::setPermissions(absFilePath, permissions);
+            // the content might still be on its way to the disk, let the writer finish the file
+            if (currentQueue) {
+                writer->close(currentQueue, item);
+                currentQueue.clear();
+                return S_OK;
+            }
+
+            QString errorString;
+            if (!finishExtractedItem(item, &errorString)) {
+                Lib7z::setLastError(errorString);
+                return E_FAIL;
+            }
         }
 
         return S_OK;
@@ -980,6 +1526,12 @@ public:
         arc = archive;
     }
 
+    void setFileWriter(FileWriter* fileWriter)
+    {
+        writer = fileWriter;
+        currentQueue.clear();
+    }
+
 private:
     ExtractCallback* const q;
     UInt32 currentIndex;
@@ -988,6 +1540,8 @@ private:
     UInt64 completed;
     QPointer<QIODevice> device;
     QString targetDir;
+    FileWriter* writer;
+    FileWriter::QueuePointer currentQueue;
 };
 
 
@@ -1320,7 +1874,91 @@ namespace{
     }
 }
 
+/*!
+    \class Lib7z::CompressionOptions
+    \internal
+
+    Describes how createArchive() compresses the source paths. The default constructed options
+    leave every choice to 7-Zip, which creates a solid LZMA archive at level 5 and uses one
+    thread per processor core.
+*/
+
+CompressionOptions::CompressionOptions()
+    : level(-1)
+    , method(DefaultMethod)
+    , dictionarySize(0)
+    , solidBlockSize(0)
+    , threadCount(0)
+{
+}
+
+static void addProperty(CObjectVector<CProperty> *properties, const QString &name, const QString &value)
+{
+    CProperty property;
+    property.Name = QString2UString(name);
+    property.Value = QString2UString(value);
+    properties->Add(property);
+}
+
+/*
+    Translates \a options into the properties known from the 7z command line switches, e.g.
+    -mx=9 -m0=LZMA2 -md=64m -ms=off -mmt=4.
+*/
+static CObjectVector<CProperty> propertiesFromOptions(const CompressionOptions &options)
+{
+    CObjectVector<CProperty> properties;
+
+    // preserve creation and access time
+    addProperty(&properties, QLatin1String("TC"), QLatin1String("ON"));
+    addProperty(&properties, QLatin1String("TA"), QLatin1String("ON"));
+
+    if (options.level >= 0)
+        addProperty(&properties, QLatin1String("X"), QString::number(options.level));
+
+    switch (options.method) {
+    case CompressionOptions::Lzma:
+        addProperty(&properties, QLatin1String("0"), QLatin1String("LZMA"));
+        break;
+    case CompressionOptions::Lzma2:
+        addProperty(&properties, QLatin1String("0"), QLatin1String("LZMA2"));
+        break;
+    case CompressionOptions::Store:
+        addProperty(&properties, QLatin1String("0"), QLatin1String("Copy"));
+        break;
+    default:
+        break;
+    }
+
+    // plain numbers are taken as powers of two, the suffix makes them a size in bytes
+    if (options.dictionarySize > 0)
+        addProperty(&properties, QLatin1String("D"), QString::number(options.dictionarySize)
+            + QLatin1Char('b'));
+
+    if (options.solidBlockSize < 0)
+        addProperty(&properties, QLatin1String("S"), QLatin1String("OFF"));
+    else if (options.solidBlockSize > 0)
+        addProperty(&properties, QLatin1String("S"), QString::number(options.solidBlockSize)
+            + QLatin1Char('b'));
+
+    if (options.threadCount > 0)
+        addProperty(&properties, QLatin1String("MT"), QString::number(options.threadCount));
+
+    return properties;
+}
+
 void Lib7z::createArchive(QFileDevice* archive, const QStringList &sourcePaths, UpdateCallback* callback)
+{
+    createArchive(archive, sourcePaths, CompressionOptions(), callback);
+}
+
+/*!
+    Compresses \a sourcePaths into a 7z archive using \a options. The archive is written
+    straight to \a archive, starting at its current position.
+
+    Throws Lib7z::SevenZipException on error.
+*/
+void Lib7z::createArchive(QFileDevice* archive, const QStringList &sourcePaths,
+    const CompressionOptions &options, UpdateCallback* callback)
 {
     assert(archive);
 
@@ -1331,21 +1969,14 @@ void Lib7z::createArchive(QFileDevice* archive, const QStringList &sourcePaths,
     try {
         callback->setTarget(archive);
 
-        QScopedPointer<CCodecs> codecs(new CCodecs);
-        if (codecs->Load() != S_OK)
-            throw SevenZipException(QCoreApplication::translate("Lib7z", "Could not load codecs"));
-
-        CIntVector formatIndices;
-
-        if (!codecs.data()->FindFormatForArchiveType(L"", formatIndices)) {
+        CCodecs *const codecs = sharedCodecs();
+        CMyComPtr<IOutArchive> outArchive;
+        const int formatIndex = codecs->FindFormatForArchiveType(L"7z");
+        if (formatIndex < 0 || codecs->CreateOutArchive(formatIndex, outArchive) != S_OK || !outArchive) {
             throw SevenZipException(QCoreApplication::translate("Lib7z",
                 "Could not retrieve default format"));
         }
 
-        // yes this is crap, but there seems to be no streaming solution to this...
-
-        const QString tempFile = generateTempFileName();
-
         NWildcard::CCensor censor;
         foreach (const QString &path, sourcePaths) {
             const QString cleanPath = QDir::toNativeSeparators(QDir::cleanPath(path));
@@ -1358,49 +1989,55 @@ void Lib7z::createArchive(QFileDevice* archive, const QStringList &sourcePaths,
         }
         callback->setSourcePaths(sourcePaths);
 
-        CArchivePath archivePath;
-        archivePath.ParseFromPath(QString2UString(tempFile));
-
-        CUpdateArchiveCommand command;
-        command.ArchivePath = archivePath;
-        command.ActionSet = NUpdateArchive::kAddActionSet;
-
-        CUpdateOptions options;
-        options.Commands.Add(command);
-        options.ArchivePath = archivePath;
-        options.MethodMode.FormatIndex = codecs->FindFormatForArchiveType(L"7z");
-
-        // preserve creation time
-        CProperty tc;
-        tc.Name = UString(L"TC");
-        tc.Value = UString(L"ON");
-        options.MethodMode.Properties.Add(tc);
-
-        // preserve access time
-        CProperty ta;
-        ta.Name = UString(L"TA");
-        ta.Value = UString(L"ON");
-        options.MethodMode.Properties.Add(ta);
-
-        CUpdateErrorInfo errorInfo;
-        const HRESULT res = UpdateArchive(codecs.data(), censor, options, errorInfo, 0, callback->impl());
-        if (res != S_OK || !QFile::exists(tempFile)) {
+        CDirItems dirItems;
+        UStringVector errorPaths;
+        CRecordVector<DWORD> errorCodes;
+        HRESULT res = EnumerateItems(censor, dirItems, 0, errorPaths, errorCodes);
+        for (int i = 0; i < errorPaths.Size(); ++i)
+            callback->impl()->CanNotFindError(errorPaths[i], errorCodes[i]);
+        if (res != S_OK) {
             throw SevenZipException(QCoreApplication::translate("Lib7z",
-                "Could not create archive %1. %2").arg(tempFile, errorMessageFrom7zResult(res)));
+                "Could not scan the files to compress. %1").arg(errorMessageFrom7zResult(res)));
         }
 
+        UInt32 fileTimeType = NFileTimeType::kWindows;
+        if (outArchive->GetFileTimeType(&fileTimeType) != S_OK)
+            fileTimeType = NFileTimeType::kWindows;
+
+        // there is no existing archive to update, every item found on disk gets added
+        const CObjectVector<CArcItem> arcItems;
+        CRecordVector<CUpdatePair2> updatePairs;
         {
-            //TODO remove temp file even if one the following throws
-            QFile file(tempFile);
-            QInstaller::openForRead(&file);
-            QInstaller::blockingCopy(&file, archive, file.size());
+            CRecordVector<CUpdatePair> pairs;
+            GetUpdatePairInfoList(dirItems, arcItems, NFileTimeType::EEnum(fileTimeType), pairs);
+            UpdateProduce(pairs, NUpdateArchive::kAddActionSet, updatePairs, 0);
+        }
+        callback->impl()->SetNumFiles(updatePairs.Size());
+
+        CArchiveUpdateCallback *updateCallbackSpec = new CArchiveUpdateCallback;
+        CMyComPtr<IArchiveUpdateCallback> updateCallback(updateCallbackSpec);
+        updateCallbackSpec->Callback = callback->impl();
+        updateCallbackSpec->DirItems = &dirItems;
+        updateCallbackSpec->ArcItems = &arcItems;
+        updateCallbackSpec->UpdatePairs = &updatePairs;
+
+        res = SetProperties(outArchive, propertiesFromOptions(options));
+        if (res != S_OK) {
+            throw SevenZipException(QCoreApplication::translate("Lib7z",
+                "Invalid compression options. %1").arg(errorMessageFrom7zResult(res)));
         }
 
-        QFile file(tempFile);
-        if (!file.remove()) {
-            qWarning("%s: Could not remove temporary file %s: %s", Q_FUNC_INFO, qPrintable(tempFile),
-                qPrintable(file.errorString()));
+        QFileDeviceOutStream *outStreamSpec = new QFileDeviceOutStream(archive);
+        CMyComPtr<ISequentialOutStream> outStream(outStreamSpec);
+        res = outArchive->UpdateItems(outStream, updatePairs.Size(), updateCallback);
+        callback->impl()->Finilize();
+        if (res != S_OK) {
+            throw SevenZipException(QCoreApplication::translate("Lib7z",
+                "Could not create archive %1. %2").arg(archive->fileName(), outStreamSpec->errorString()
+                .isEmpty() ? errorMessageFrom7zResult(res) : outStreamSpec->errorString()));
         }
+    } catch (const SevenZipException &) {
+        throw;
     } catch (const char *err) {
         qDebug() << err;
         throw SevenZipException(err);
@@ -1493,7 +2130,7 @@ void Lib7z::extractFileFromArchive(QFileDevice* archive, const File& item,
 }
 
 void Lib7z::extractArchive(QFileDevice* archive, const QString &targetDirectory,
-    ExtractCallback* callback)
+    ExtractCallback* callback, int threadCount)
 {
     assert(archive);
 
@@ -1509,17 +2146,29 @@ void Lib7z::extractArchive(QFileDevice* archive, const QString &targetDirectory,
 
     const OpenArchiveInfo* const openArchive = OpenArchiveInfo::value(archive);
 
+    QScopedPointer<FileWriter> writer(threadCount > 1 ? new FileWriter(threadCount) : 0);
+    callback->impl()->setFileWriter(writer.data());
+
     for (int a = 0; a < openArchive->archiveLink.Arcs.Size(); ++a)
     {
         const CArc& arc = openArchive->archiveLink.Arcs[a];
         IInArchive* const arch = arc.Archive;
+        if (threadCount > 1)
+            setDecoderThreadCount(arch, threadCount);
         callback->impl()->setArchive(&arc);
         const LONG extractResult = arch->Extract(0, static_cast< UInt32 >(-1), false, callback->impl());
 
+        // a failed write aborts the extraction, report the reason instead of the abort
+        const QString writeError = writer ? writer->waitForDone() : QString();
+        if (!writeError.isEmpty() || extractResult != S_OK)
+            callback->impl()->setFileWriter(0);
+        if (!writeError.isEmpty())
+            throw SevenZipException(writeError);
         if (extractResult != S_OK)
             throw SevenZipException(errorMessageFrom7zResult(extractResult));
     }
 
+    callback->impl()->setFileWriter(0);
     outDir.release();
 }
 
@@ -1538,9 +2187,7 @@ bool Lib7z::isSupportedArchive(QFileDevice* archive)
     assert(!archive->isSequential());
     const qint64 initialPos = archive->pos();
     try {
-        QScopedPointer<CCodecs> codecs(new CCodecs);
-        if (codecs->Load() != S_OK)
-            throw SevenZipException(QCoreApplication::translate("Lib7z", "Could not load codecs"));
+        CCodecs *const codecs = sharedCodecs();
 
         CIntVector formatIndices;
 
@@ -1552,7 +2199,7 @@ bool Lib7z::isSupportedArchive(QFileDevice* archive)
         //CMyComPtr is needed, otherwise it crashes in OpenStream()
         const CMyComPtr<IInStream> stream = new QIODeviceInStream(archive);
 
-        const HRESULT result = archiveLink.Open2(codecs.data(), formatIndices, /*stdInMode*/false, stream,
+        const HRESULT result = archiveLink.Open2(codecs, formatIndices, /*stdInMode*/false, stream,
             UString(), 0);
 
         archive->seek(initialPos);
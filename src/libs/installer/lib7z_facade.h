@@ -167,10 +167,32 @@ namespace Lib7z {
         provided extract callback \a callback. The output filenames are deduced from the \a archive
         content.
 
+        If \a threadCount is greater than one, the decoders may use that many threads and the files
+        are written by a pool of \a threadCount worker threads while decoding continues. The
+        callback is still called from the calling thread only.
+
         Throws Lib7z::SevenZipException on error.
     */
     void INSTALLER_EXPORT extractArchive(QFileDevice* archive, const QString& targetDirectory,
-        ExtractCallback* callback = 0);
+        ExtractCallback* callback = 0, int threadCount = 1);
+
+    class INSTALLER_EXPORT CompressionOptions {
+    public:
+        enum Method {
+            DefaultMethod,
+            Lzma,
+            Lzma2,
+            Store
+        };
+
+        CompressionOptions();
+
+        int level;              // 0 (no compression) to 9 (ultra), -1 for the default
+        Method method;
+        quint32 dictionarySize; // in bytes, 0 for the default of the level
+        qint64 solidBlockSize;  // in bytes, 0 for the default, -1 to disable solid compression
+        int threadCount;        // 0 for the default
+    };
 
     /*
      * @thows Lib7z::SevenZipException
@@ -178,6 +200,9 @@ namespace Lib7z {
     void INSTALLER_EXPORT createArchive(QFileDevice* archive, const QStringList& sourcePaths,
         UpdateCallback* callback = 0 );
 
+    void INSTALLER_EXPORT createArchive(QFileDevice* archive, const QStringList& sourcePaths,
+        const CompressionOptions& options, UpdateCallback* callback = 0);
+
     /*
      * @throws Lib7z::SevenZipException
      */
@@ -33,6 +33,7 @@
 **************************************************************************/
 #include "metadatajob.h"
 
+#include "errors.h"
 #include "metadatajob_p.h"
 #include "packagemanagercore.h"
 #include "packagemanagerproxyfactory.h"
@@ -41,10 +42,26 @@
 #include "serverauthenticationdialog.h"
 #include "settings.h"
 
+#include "kdupdaterupdatesinfo_p.h"
+
+#include <QCryptographicHash>
+#include <QSettings>
 #include <QTemporaryDir>
 
 namespace QInstaller {
 
+namespace TaskRole {
+enum
+{
+    PackageName = TaskRole::UserRole + 1,
+    PackageSha1,
+    CacheDirectory
+};
+}
+
+static const QLatin1String scCacheIni("cache.ini");
+static const QLatin1String scUpdatesXml("Updates.xml");
+
 MetadataJob::MetadataJob(QObject *parent)
     : KDJob(parent)
     , m_core(0)
@@ -93,10 +110,31 @@ void MetadataJob::doStart()
                 if (!m_core->value(QLatin1String("UrlQueryString")).isEmpty())
                     url += m_core->value(QLatin1String("UrlQueryString")) + QLatin1Char('&');
 
-                // also append a random string to avoid proxy caches
-                FileTaskItem item(url.append(QString::number(qrand() * qrand())));
+                const QString cacheDir = cacheDirectory(repo);
+                if (cacheDir.isEmpty()) {
+                    // without a cache, append a random string to avoid proxy caches
+                    url.append(QString::number(qrand() * qrand()));
+                } else {
+                    url.chop(1);
+                }
+
+                FileTaskItem item(url);
                 item.insert(TaskRole::UserRole, QVariant::fromValue(repo));
                 item.insert(TaskRole::Authenticator, QVariant::fromValue(authenticator));
+
+                // ask the server whether the cached Updates.xml is still current, the request
+                // tells proxies not to answer from their own caches
+                if (!cacheDir.isEmpty()) {
+                    QByteArray etag, lastModified;
+                    if (QFileInfo(cacheDir + QLatin1Char('/') + scUpdatesXml).isFile()) {
+                        const QSettings cache(cacheDir + QLatin1Char('/') + scCacheIni,
+                            QSettings::IniFormat);
+                        etag = cache.value(QLatin1String("ETag")).toByteArray();
+                        lastModified = cache.value(QLatin1String("LastModified")).toByteArray();
+                    }
+                    item.insert(TaskRole::ETag, etag);
+                    item.insert(TaskRole::LastModified, lastModified);
+                }
                 items.append(item);
             }
         }
@@ -217,6 +255,8 @@ void MetadataJob::unzipTaskFinished()
     if (error() != KDJob::NoError)
         return;
 
+    updateCache(m_unzipItems.take(watcher));
+
     delete m_unzipTasks.value(watcher);
     m_unzipTasks.remove(watcher);
     delete watcher;
@@ -246,6 +286,7 @@ void MetadataJob::metadataTaskFinished()
 
                 QFutureWatcher<void> *watcher = new QFutureWatcher<void>();
                 m_unzipTasks.insert(watcher, qobject_cast<QObject*> (task));
+                m_unzipItems.insert(watcher, item);
                 connect(watcher, SIGNAL(finished()), this, SLOT(unzipTaskFinished()));
                 watcher->setFuture(QtConcurrent::run(&UnzipArchiveTask::doTask, task));
             }
@@ -271,6 +312,7 @@ void MetadataJob::reset()
 {
     m_packages.clear();
     m_metadata.clear();
+    KDUpdater::UpdatesInfo::clearCache();
 
     setError(KDJob::NoError);
     setErrorString(QString());
@@ -286,6 +328,7 @@ void MetadataJob::reset()
         foreach (QObject *const object, m_unzipTasks)
             object->deleteLater();
         m_unzipTasks.clear();
+        m_unzipItems.clear();
     } catch (...) {}
     m_tempDirDeleter.releaseAndDeleteAll();
 }
@@ -307,113 +350,154 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
         metadata.directory = tmp.path();
         m_tempDirDeleter.add(metadata.directory);
 
-        QFile file(result.target());
-        if (!file.rename(metadata.directory + QLatin1String("/Updates.xml"))) {
-            qDebug() << "Could not rename target to Updates.xml. Error:" << file.errorString();
-            return XmlDownloadFailure;
-        }
+        const FileTaskItem item = result.value(TaskRole::TaskItem).value<FileTaskItem>();
+        metadata.repository = item.value(TaskRole::UserRole).value<Repository>();
+        const bool online = !(metadata.repository.url().scheme()).isEmpty();
 
-        if (!file.open(QIODevice::ReadOnly)) {
-            qDebug() << "Could not open Updates.xml for reading. Error:" << file.errorString();
-            return XmlDownloadFailure;
+        const QString cacheDir = cacheDirectory(metadata.repository);
+        QFile file(cacheDir + QLatin1Char('/') + scUpdatesXml);
+        if (item.value(TaskRole::NotModified).toBool()) {
+            if (!file.copy(metadata.directory + QLatin1Char('/') + scUpdatesXml)) {
+                qDebug() << "Could not copy cached Updates.xml. Error:" << file.errorString();
+                return XmlDownloadFailure;
+            }
+        } else {
+            file.setFileName(result.target());
+            if (!file.rename(metadata.directory + QLatin1Char('/') + scUpdatesXml)) {
+                qDebug() << "Could not rename target to Updates.xml. Error:" << file.errorString();
+                return XmlDownloadFailure;
+            }
         }
 
-        QString error;
-        QDomDocument doc;
-        if (!doc.setContent(&file, &error)) {
-            qDebug() << QString::fromLatin1("Could not fetch a valid version of Updates.xml from "
-                "repository: %1. Error: %2").arg(metadata.repository.displayname(), error);
-            return XmlDownloadFailure;
+        // Parsed once here, the package manager core and the update finder reuse the same table.
+        const KDUpdater::UpdatesInfo updatesInfo =
+            KDUpdater::UpdatesInfo::fromFile(metadata.directory + QLatin1Char('/') + scUpdatesXml);
+        if (updatesInfo.error() != KDUpdater::UpdatesInfo::NoError
+            && updatesInfo.error() != KDUpdater::UpdatesInfo::InvalidContentError) {
+                qDebug() << QString::fromLatin1("Could not fetch a valid version of Updates.xml "
+                    "from repository: %1. Error: %2").arg(metadata.repository.displayname(),
+                    updatesInfo.errorString());
+                return XmlDownloadFailure;
         }
-        file.close();
-
-        const FileTaskItem item = result.value(TaskRole::TaskItem).value<FileTaskItem>();
-        metadata.repository = item.value(TaskRole::UserRole).value<Repository>();
-        const bool online = !(metadata.repository.url().scheme()).isEmpty();
 
-        bool testCheckSum = true;
-        const QDomElement root = doc.documentElement();
-        const QDomNode checksum = root.firstChildElement(QLatin1String("Checksum"));
-        if (!checksum.isNull())
-            testCheckSum = (checksum.toElement().text().toLower() == scTrue);
-
-        QDomNodeList children = root.childNodes();
-        for (int i = 0; i < children.count(); ++i) {
-            const QDomElement el = children.at(i).toElement();
-            if (!el.isNull() && el.tagName() == QLatin1String("PackageUpdate")) {
-                const QDomNodeList c2 = el.childNodes();
-                QString packageName, packageVersion, packageHash;
-                for (int j = 0; j < c2.count(); ++j) {
-                    if (c2.at(j).toElement().tagName() == scName)
-                        packageName = c2.at(j).toElement().text();
-                    else if (c2.at(j).toElement().tagName() == scRemoteVersion)
-                        packageVersion = (online ? c2.at(j).toElement().text() : QString());
-                    else if ((c2.at(j).toElement().tagName() == QLatin1String("SHA1")) && testCheckSum)
-                        packageHash = c2.at(j).toElement().text();
+        QScopedPointer<QSettings> cache;
+        if (!cacheDir.isEmpty()) {
+            cache.reset(new QSettings(cacheDir + QLatin1Char('/') + scCacheIni,
+                QSettings::IniFormat));
+            if (!item.value(TaskRole::NotModified).toBool()) {
+                // keep the new file, packages that are gone from the repository leave the cache
+                QFile::remove(cacheDir + QLatin1Char('/') + scUpdatesXml);
+                if (QFile::copy(metadata.directory + QLatin1Char('/') + scUpdatesXml,
+                    cacheDir + QLatin1Char('/') + scUpdatesXml)) {
+                        cache->setValue(QLatin1String("ETag"), item.value(TaskRole::ETag));
+                        cache->setValue(QLatin1String("LastModified"),
+                            item.value(TaskRole::LastModified));
+                } else {
+                    cache->remove(QLatin1String("ETag"));
+                    cache->remove(QLatin1String("LastModified"));
                 }
 
-                const QString repoUrl = metadata.repository.url().toString();
-                FileTaskItem item(QString::fromLatin1("%1/%2/%3meta.7z").arg(repoUrl, packageName,
-                    packageVersion), metadata.directory + QString::fromLatin1("/%1-%2-meta.7z")
-                    .arg(packageName, packageVersion));
+                QSet<QString> names;
+                foreach (const KDUpdater::UpdateInfo &info, updatesInfo.updatesInfo())
+                    names.insert(info.data.value(scName).toString());
 
-                QAuthenticator authenticator;
-                authenticator.setUser(metadata.repository.username());
-                authenticator.setPassword(metadata.repository.password());
+                cache->beginGroup(QLatin1String("Packages"));
+                foreach (const QString &name, cache->childKeys()) {
+                    if (names.contains(name))
+                        continue;
+                    cache->remove(name);
+                    QInstaller::removeDirectory(cacheDir + QLatin1Char('/') + name, true);
+                }
+                cache->endGroup();
+            }
+        }
 
-                item.insert(TaskRole::UserRole, metadata.directory);
-                item.insert(TaskRole::Checksum, packageHash.toLatin1());
-                item.insert(TaskRole::Authenticator, QVariant::fromValue(authenticator));
-                m_packages.append(item);
+        bool testCheckSum = true;
+        if (updatesInfo.hasChecksum())
+            testCheckSum = updatesInfo.checksum();
+
+        const QString repoUrl = metadata.repository.url().toString();
+        QAuthenticator authenticator;
+        authenticator.setUser(metadata.repository.username());
+        authenticator.setPassword(metadata.repository.password());
+
+        foreach (const KDUpdater::UpdateInfo &info, updatesInfo.updatesInfo()) {
+            const QString packageName = info.data.value(scName).toString();
+            const QString packageVersion = (online ? info.data.value(scRemoteVersion).toString()
+                : QString());
+            const QString sha1 = info.data.value(QLatin1String("SHA1")).toString();
+            const QString packageHash = (testCheckSum ? sha1 : QString());
+
+            if (cache && !sha1.isEmpty() && cache->value(QLatin1String("Packages/")
+                + packageName).toString() == sha1) {
+                    // unchanged since the last run, no need to download and extract meta.7z
+                    try {
+                        QInstaller::copyDirectoryContents(cacheDir + QLatin1Char('/') + packageName,
+                            metadata.directory + QLatin1Char('/') + packageName);
+                        continue;
+                    } catch (const Error &e) {
+                        qDebug() << "Could not use cached meta data:" << e.message();
+                    }
+            }
+
+            FileTaskItem item(QString::fromLatin1("%1/%2/%3meta.7z").arg(repoUrl, packageName,
+                packageVersion), metadata.directory + QString::fromLatin1("/%1-%2-meta.7z")
+                .arg(packageName, packageVersion));
+
+            item.insert(TaskRole::UserRole, metadata.directory);
+            item.insert(TaskRole::Checksum, packageHash.toLatin1());
+            item.insert(TaskRole::Authenticator, QVariant::fromValue(authenticator));
+            if (cache && !sha1.isEmpty()) {
+                item.insert(TaskRole::PackageName, packageName);
+                item.insert(TaskRole::PackageSha1, sha1);
+                item.insert(TaskRole::CacheDirectory, cacheDir);
             }
+            m_packages.append(item);
         }
         m_metadata.insert(metadata.directory, metadata);
 
         // search for additional repositories that we might need to check
-        const QDomNode repositoryUpdate = root.firstChildElement(QLatin1String("RepositoryUpdate"));
-        if (repositoryUpdate.isNull())
+        const QList<KDUpdater::RepositoryUpdateInfo> updates = updatesInfo.repositoryUpdates();
+        if (updates.isEmpty())
             continue;
 
         QHash<QString, QPair<Repository, Repository> > repositoryUpdates;
-        children = repositoryUpdate.toElement().childNodes();
-        for (int i = 0; i < children.count(); ++i) {
-            const QDomElement el = children.at(i).toElement();
-            if (!el.isNull() && el.tagName() == QLatin1String("Repository")) {
-                const QString action = el.attribute(QLatin1String("action"));
-                if (action == QLatin1String("add")) {
-                    // add a new repository to the defaults list
-                    Repository repository(el.attribute(QLatin1String("url")), true);
-                    repository.setUsername(el.attribute(QLatin1String("username")));
-                    repository.setPassword(el.attribute(QLatin1String("password")));
-                    repository.setDisplayName(el.attribute(QLatin1String("displayname")));
-                    if (ProductKeyCheck::instance()->isValidRepository(repository)) {
-                        repositoryUpdates.insertMulti(action, qMakePair(repository, Repository()));
-                        qDebug() << "Repository to add:" << repository.displayname();
-                    }
-                } else if (action == QLatin1String("remove")) {
-                    // remove possible default repositories using the given server url
-                    Repository repository(el.attribute(QLatin1String("url")), true);
+        foreach (const KDUpdater::RepositoryUpdateInfo &update, updates) {
+            const QString &action = update.action;
+            const QHash<QString, QString> &attributes = update.attributes;
+            if (action == QLatin1String("add")) {
+                // add a new repository to the defaults list
+                Repository repository(attributes.value(QLatin1String("url")), true);
+                repository.setUsername(attributes.value(QLatin1String("username")));
+                repository.setPassword(attributes.value(QLatin1String("password")));
+                repository.setDisplayName(attributes.value(QLatin1String("displayname")));
+                if (ProductKeyCheck::instance()->isValidRepository(repository)) {
                     repositoryUpdates.insertMulti(action, qMakePair(repository, Repository()));
-
-                    qDebug() << "Repository to remove:" << repository.displayname();
-                } else if (action == QLatin1String("replace")) {
-                    // replace possible default repositories using the given server url
-                    Repository oldRepository(el.attribute(QLatin1String("oldUrl")), true);
-                    Repository newRepository(el.attribute(QLatin1String("newUrl")), true);
-                    newRepository.setUsername(el.attribute(QLatin1String("username")));
-                    newRepository.setPassword(el.attribute(QLatin1String("password")));
-                    newRepository.setDisplayName(el.attribute(QLatin1String("displayname")));
-
-                    if (ProductKeyCheck::instance()->isValidRepository(newRepository)) {
-                        // store the new repository and the one old it replaces
-                        repositoryUpdates.insertMulti(action, qMakePair(newRepository, oldRepository));
-                        qDebug() << "Replace repository:" << oldRepository.displayname() << "with:"
-                            << newRepository.displayname();
-                    }
-                } else {
-                    qDebug() << "Invalid additional repositories action set in Updates.xml fetched "
-                        "from:" << metadata.repository.displayname() << "Line:" << el.lineNumber();
+                    qDebug() << "Repository to add:" << repository.displayname();
                 }
+            } else if (action == QLatin1String("remove")) {
+                // remove possible default repositories using the given server url
+                Repository repository(attributes.value(QLatin1String("url")), true);
+                repositoryUpdates.insertMulti(action, qMakePair(repository, Repository()));
+
+                qDebug() << "Repository to remove:" << repository.displayname();
+            } else if (action == QLatin1String("replace")) {
+                // replace possible default repositories using the given server url
+                Repository oldRepository(attributes.value(QLatin1String("oldUrl")), true);
+                Repository newRepository(attributes.value(QLatin1String("newUrl")), true);
+                newRepository.setUsername(attributes.value(QLatin1String("username")));
+                newRepository.setPassword(attributes.value(QLatin1String("password")));
+                newRepository.setDisplayName(attributes.value(QLatin1String("displayname")));
+
+                if (ProductKeyCheck::instance()->isValidRepository(newRepository)) {
+                    // store the new repository and the one old it replaces
+                    repositoryUpdates.insertMulti(action, qMakePair(newRepository, oldRepository));
+                    qDebug() << "Replace repository:" << oldRepository.displayname() << "with:"
+                        << newRepository.displayname();
+                }
+            } else {
+                qDebug() << "Invalid additional repositories action set in Updates.xml fetched "
+                    "from:" << metadata.repository.displayname() << "Line:" << update.lineNumber;
             }
         }
 
@@ -450,4 +534,50 @@ MetadataJob::Status MetadataJob::parseUpdatesXml(const QList<FileTaskResult> &re
     return XmlDownloadSuccess;
 }
 
+/*!
+    Returns the folder that keeps the meta data of \a repository across runs, or an empty string
+    if there is none. The cache lives next to the maintenance tool, so the installer itself does
+    not use it.
+*/
+QString MetadataJob::cacheDirectory(const Repository &repository) const
+{
+    if (m_core->isInstaller())
+        return QString();
+
+    const QString path = QFileInfo(m_core->maintenanceToolName()).absolutePath()
+        + QLatin1String("/metadatacache/") + QString::fromLatin1(QCryptographicHash::hash(repository
+        .url().toString().toUtf8(), QCryptographicHash::Sha1).toHex());
+    if (!QDir().mkpath(path) || !QFileInfo(path).isWritable())
+        return QString();
+    return path;
+}
+
+/*!
+    Stores the extracted meta data described by \a item in the cache, so the next run can skip
+    downloading and extracting it.
+*/
+void MetadataJob::updateCache(const FileTaskItem &item)
+{
+    const QString cacheDir = item.value(TaskRole::CacheDirectory).toString();
+    if (cacheDir.isEmpty())
+        return;
+
+    const QString name = item.value(TaskRole::PackageName).toString();
+    const QString source = item.value(TaskRole::UserRole).toString() + QLatin1Char('/') + name;
+    const QString target = cacheDir + QLatin1Char('/') + name;
+
+    QSettings cache(cacheDir + QLatin1Char('/') + scCacheIni, QSettings::IniFormat);
+    cache.remove(QLatin1String("Packages/") + name);
+    try {
+        QInstaller::removeDirectory(target, true);
+        if (QFileInfo(source).isDir())
+            QInstaller::copyDirectoryContents(source, target);
+        else
+            QDir().mkpath(target); // no files besides the package entry in Updates.xml
+        cache.setValue(QLatin1String("Packages/") + name, item.value(TaskRole::PackageSha1));
+    } catch (const Error &e) {
+        qDebug() << "Could not cache meta data of" << name << ":" << e.message();
+    }
+}
+
 }   // namespace QInstaller
@@ -84,6 +84,9 @@ private:
     void reset();
     Status parseUpdatesXml(const QList<FileTaskResult> &results);
 
+    QString cacheDirectory(const Repository &repository) const;
+    void updateCache(const FileTaskItem &item);
+
 private:
     PackageManagerCore *m_core;
 
@@ -93,6 +96,7 @@ private:
     QFutureWatcher<FileTaskResult> m_xmlTask;
     QFutureWatcher<FileTaskResult> m_metadataTask;
     QHash<QFutureWatcher<void> *, QObject*> m_unzipTasks;
+    QHash<QFutureWatcher<void> *, FileTaskItem> m_unzipItems;
 };
 
 }   // namespace QInstaller
@@ -0,0 +1,565 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "operationlog.h"
+
+#include "errors.h"
+#include "fileio.h"
+
+#include <QDataStream>
+#include <QFileDevice>
+#include <QUuid>
+
+namespace QInstaller {
+
+/*!
+    \class QInstaller::OperationLog
+    \inmodule QtInstallerFramework
+    \brief The OperationLog class stores the performed operations in a compact binary form.
+
+    The maintenance tool keeps every operation performed during installation. The log stores the
+    name, arguments and persistent values of each operation with their types. Every string is
+    stored once per segment; paths are split at their last separator, so a path costs little more
+    than its file name if its directory has been stored before.
+
+    A log is a chain of segments. The first segment is written by write() and holds all
+    operations. Each segment added by append() refers to the one before it, holds only the
+    operations that were not stored yet and describes the order of the whole list as runs of
+    either previously stored or new operations. The cost of appending therefore depends on what
+    changed, not on the size of the log. Operations that are no longer used stay in their segment
+    until the log is written anew; chain() tells when that is worth doing.
+
+    Operations are decoded on demand with restore(); value() reads a single persistent value
+    without an operation to restore into. Logs written as XML by earlier versions can
+    still be read, see read().
+*/
+
+/*!
+    \variable QInstaller::OperationLog::Marker
+
+    Written in place of the operation count of a legacy log to mark a binary log segment.
+*/
+
+/*!
+    \variable QInstaller::OperationLog::Version
+
+    The version of the segments written by write() and append().
+*/
+
+/*!
+    \class QInstaller::OperationLog::Chain
+    \inmodule QtInstallerFramework
+    \brief The Chain class identifies the last segment of a log and the size of its chain.
+*/
+
+namespace {
+
+enum ValueType {
+    Variant,    // anything else, written through QDataStream
+    String,
+    StringList,
+    Bool,
+    Int,
+    LongLong,
+    ByteArray
+};
+
+enum RunSource {
+    PreviousSegments,   // operations of the list described by the segment before
+    ThisSegment         // operations stored in this segment
+};
+
+struct Run
+{
+    quint8 source;
+    quint32 first;
+    quint32 count;
+};
+
+class StringPool
+{
+public:
+    quint32 intern(const QString &string)
+    {
+        const QHash<QString, quint32>::const_iterator it = m_ids.constFind(string);
+        if (it != m_ids.constEnd())
+            return it.value();
+
+        qint32 parent = -1;
+        int separator = qMax(string.lastIndexOf(QLatin1Char('/')),
+            string.lastIndexOf(QLatin1Char('\\')));
+        if (separator > 0)
+            parent = intern(string.left(separator));
+        else
+            separator = 0;
+
+        const quint32 id = m_entries.count();
+        m_entries.append(qMakePair(parent, string.mid(separator)));
+        m_ids.insert(string, id);
+        return id;
+    }
+
+    void write(QDataStream &stream) const
+    {
+        stream << quint32(m_entries.count());
+        for (int i = 0; i < m_entries.count(); ++i)
+            stream << m_entries.at(i).first << m_entries.at(i).second;
+    }
+
+private:
+    QHash<QString, quint32> m_ids;
+    QVector<QPair<qint32, QString> > m_entries; // parent, suffix
+};
+
+void writeOperation(QDataStream &stream, StringPool *pool, const Operation *operation)
+{
+    const QStringList arguments = operation->arguments();
+    stream << quint32(arguments.count());
+    foreach (const QString &argument, arguments)
+        stream << pool->intern(argument);
+
+    const QVariantMap values = operation->persistentValues();
+    stream << quint32(values.count());
+    for (QVariantMap::const_iterator it = values.constBegin(); it != values.constEnd(); ++it) {
+        stream << pool->intern(it.key());
+        const QVariant &value = it.value();
+        switch (value.type()) {
+            case QVariant::String:
+                stream << quint8(String) << pool->intern(value.toString());
+                break;
+            case QVariant::StringList: {
+                const QStringList list = value.toStringList();
+                stream << quint8(StringList) << quint32(list.count());
+                foreach (const QString &entry, list)
+                    stream << pool->intern(entry);
+            }   break;
+            case QVariant::Bool:
+                stream << quint8(Bool) << value.toBool();
+                break;
+            case QVariant::Int:
+                stream << quint8(Int) << qint32(value.toInt());
+                break;
+            case QVariant::LongLong:
+                stream << quint8(LongLong) << value.toLongLong();
+                break;
+            case QVariant::ByteArray:
+                stream << quint8(ByteArray) << value.toByteArray();
+                break;
+            default:
+                stream << quint8(Variant) << value;
+                break;
+        }
+    }
+}
+
+QString string(QDataStream &stream, const QVector<QString> &strings)
+{
+    quint32 id = 0;
+    stream >> id;
+    if (id >= quint32(strings.count())) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return QString();
+    }
+    return strings.at(id);
+}
+
+} // namespace
+
+/*!
+    Writes \a operations as the first segment of a new log to \a out and returns its chain.
+    Throws Error on failure.
+*/
+OperationLog::Chain OperationLog::write(QFileDevice *out, const OperationList &operations)
+{
+    return append(out, operations, QHash<const Operation *, int>(), Chain(), Range<qint64>());
+}
+
+/*!
+    Writes a segment to \a out that extends the log \a chain, whose last segment is stored at
+    \a previous, to the list \a operations. \a positions maps each operation that is part of the
+    list described by \a chain to its index there; only the other operations get stored.
+    Returns the extended chain. Throws Error on failure.
+
+    The range \a previous has to be relative to the same offset that is later passed to read().
+*/
+OperationLog::Chain OperationLog::append(QFileDevice *out, const OperationList &operations,
+    const QHash<const Operation *, int> &positions, const Chain &chain,
+    const Range<qint64> &previous)
+{
+    Q_ASSERT(positions.isEmpty() || previous.length() > 0);
+
+    StringPool pool;
+    QVector<QPair<quint32, quint32> > index;
+    QVector<Run> runs;
+
+    QByteArray records;
+    {
+        QDataStream stream(&records, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_0);
+        foreach (const Operation *operation, operations) {
+            Run run = { ThisSegment, quint32(index.count()), 1 };
+            const int position = positions.value(operation, -1);
+            if (position >= 0) {
+                run.source = PreviousSegments;
+                run.first = position;
+            } else {
+                index.append(qMakePair(pool.intern(operation->name()),
+                    quint32(stream.device()->pos())));
+                writeOperation(stream, &pool, operation);
+            }
+
+            if (!runs.isEmpty() && runs.last().source == run.source
+                && runs.last().first + runs.last().count == run.first) {
+                ++runs.last().count;
+            } else {
+                runs.append(run);
+            }
+        }
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    pool.write(stream);
+    stream << quint32(index.count());
+    for (int i = 0; i < index.count(); ++i)
+        stream << index.at(i).first << index.at(i).second;
+    stream << records;
+    stream << quint32(runs.count());
+    foreach (const Run &run, runs)
+        stream << run.source << run.first << run.count;
+
+    Chain result;
+    result.id = QUuid::createUuid().toRfc4122();
+    result.length = chain.length + 1;
+    result.stored = chain.stored + index.count();
+
+    QInstaller::appendInt64(out, Marker);
+    QInstaller::appendInt64(out, Version);
+    QInstaller::appendByteArray(out, result.id);
+    QInstaller::appendInt64(out, result.length);
+    QInstaller::appendInt64(out, result.stored);
+    QInstaller::appendInt64Range(out, previous);
+    QInstaller::appendByteArray(out, data);
+    return result;
+}
+
+/*!
+    Reads the chain of the log segment at the current position of \a in, without reading the
+    operations. The identifier of the chain is empty for logs that cannot be appended to, such
+    as legacy logs. Throws Error on failure.
+*/
+OperationLog::Chain OperationLog::readChain(QFileDevice *in)
+{
+    Chain chain;
+    if (QInstaller::retrieveInt64(in) != Marker)
+        return chain;
+    if (QInstaller::retrieveInt64(in) < 2)
+        return chain;
+
+    chain.id = QInstaller::retrieveByteArray(in);
+    chain.length = QInstaller::retrieveInt64(in);
+    chain.stored = QInstaller::retrieveInt64(in);
+    return chain;
+}
+
+/*!
+    Reads the operations of the log starting at the current position of \a in. The segments the
+    log refers to are located by adding \a offset to their stored position. The returned blobs
+    share the log and decode their operation only once it gets restored. Throws Error on failure.
+
+    Logs of earlier versions, which store each operation as XML, are read as well; their blobs
+    carry the XML instead.
+*/
+QList<OperationBlob> OperationLog::read(QFileDevice *in, qint64 offset)
+{
+    QList<OperationBlob> operations;
+
+    const qint64 pos = in->pos();
+    const qint64 count = QInstaller::retrieveInt64(in);
+    if (count >= 0) {
+        for (qint64 i = 0; i < count; ++i) {
+            const QString name = QInstaller::retrieveString(in);
+            const QString xml = QInstaller::retrieveString(in);
+            operations.append(OperationBlob(name, xml));
+        }
+        Q_UNUSED(QInstaller::retrieveInt64(in)) // read it, but deliberately not used
+        return operations;
+    }
+
+    if (!in->seek(pos))
+        throw Error(tr("Could not seek to %1 to read the operation log.").arg(pos));
+    const QSharedPointer<OperationLog> log(new OperationLog);
+    log->readSegments(in, offset);
+    for (int i = 0; i < log->count(); ++i)
+        operations.append(OperationBlob(log->name(i), log, i));
+    return operations;
+}
+
+/*!
+    Returns the chain of the log.
+*/
+OperationLog::Chain OperationLog::chain() const
+{
+    return m_chain;
+}
+
+/*!
+    Returns the number of operations in the log.
+*/
+int OperationLog::count() const
+{
+    return m_operations.count();
+}
+
+/*!
+    Returns the name of the operation at \a index.
+*/
+QString OperationLog::name(int index) const
+{
+    const Segment &segment = m_segments.at(m_operations.at(index).first);
+    return segment.strings.value(segment.operations.at(m_operations.at(index).second).first);
+}
+
+/*!
+    Sets the arguments and persistent values of \a operation to the ones of the operation at
+    \a index. Returns \c true on success, otherwise \c false.
+*/
+bool OperationLog::restore(int index, Operation *operation) const
+{
+    QStringList arguments;
+    QVariantMap values;
+    if (!decode(index, &arguments, &values))
+        return false;
+    operation->setArguments(arguments);
+    return operation->setPersistentValues(values);
+}
+
+/*!
+    Returns the persistent value \a key of the operation at \a index without restoring the
+    operation, or an invalid QVariant if the operation has no such value.
+*/
+QVariant OperationLog::value(int index, const QString &key) const
+{
+    QStringList arguments;
+    QVariantMap values;
+    if (!decode(index, &arguments, &values))
+        return QVariant();
+    return values.value(key);
+}
+
+/*!
+    \internal
+*/
+bool OperationLog::decode(int index, QStringList *arguments, QVariantMap *values) const
+{
+    const Segment &segment = m_segments.at(m_operations.at(index).first);
+    QDataStream stream(segment.records);
+    stream.setVersion(QDataStream::Qt_5_0);
+    if (!stream.device()->seek(segment.operations.at(m_operations.at(index).second).second))
+        return false;
+
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+        arguments->append(string(stream, segment.strings));
+
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        const QString key = string(stream, segment.strings);
+        quint8 type = Variant;
+        stream >> type;
+        switch (type) {
+            case String:
+                values->insert(key, string(stream, segment.strings));
+                break;
+            case StringList: {
+                quint32 entries = 0;
+                stream >> entries;
+                QStringList list;
+                for (quint32 j = 0; j < entries && stream.status() == QDataStream::Ok; ++j)
+                    list.append(string(stream, segment.strings));
+                values->insert(key, list);
+            }   break;
+            case Bool: {
+                bool value = false;
+                stream >> value;
+                values->insert(key, value);
+            }   break;
+            case Int: {
+                qint32 value = 0;
+                stream >> value;
+                values->insert(key, int(value));
+            }   break;
+            case LongLong: {
+                qint64 value = 0;
+                stream >> value;
+                values->insert(key, value);
+            }   break;
+            case ByteArray: {
+                QByteArray value;
+                stream >> value;
+                values->insert(key, value);
+            }   break;
+            case Variant: {
+                QVariant value;
+                stream >> value;
+                values->insert(key, value);
+            }   break;
+            default:
+                stream.setStatus(QDataStream::ReadCorruptData);
+                break;
+        }
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+/*!
+    \internal
+
+    Reads the segment at the current position of \a in and all segments it refers to, then
+    resolves the list of operations. Throws Error on failure.
+*/
+void OperationLog::readSegments(QFileDevice *in, qint64 offset)
+{
+    QVector<Segment> segments;  // the last segment first
+    QVector<QVector<Run> > runs;
+
+    forever {
+        if (QInstaller::retrieveInt64(in) != Marker)
+            throw Error(tr("Unknown operation log format."));
+        const qint64 version = QInstaller::retrieveInt64(in);
+        if (version < 1 || version > Version)
+            throw Error(tr("Unsupported operation log version %1.").arg(version));
+
+        Range<qint64> previous;
+        if (version >= 2) {
+            const QByteArray id = QInstaller::retrieveByteArray(in);
+            const qint64 length = QInstaller::retrieveInt64(in);
+            const qint64 stored = QInstaller::retrieveInt64(in);
+            previous = QInstaller::retrieveInt64Range(in);
+            if (segments.isEmpty()) {
+                m_chain.id = id;
+                m_chain.length = length;
+                m_chain.stored = stored;
+            }
+        }
+
+        const QByteArray data = QInstaller::retrieveByteArray(in);
+        QDataStream stream(data);
+        stream.setVersion(QDataStream::Qt_5_0);
+
+        // parents are always stored before the strings that extend them
+        Segment segment;
+        quint32 count = 0;
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            qint32 parent = -1;
+            QString suffix;
+            stream >> parent >> suffix;
+            if (parent >= segment.strings.count()) {
+                stream.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+            segment.strings.append(parent < 0 ? suffix : segment.strings.at(parent) + suffix);
+        }
+
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            quint32 name = 0;
+            quint32 position = 0;
+            stream >> name >> position;
+            if (name >= quint32(segment.strings.count()))
+                stream.setStatus(QDataStream::ReadCorruptData);
+            else
+                segment.operations.append(qMakePair(name, position));
+        }
+        stream >> segment.records;
+
+        QVector<Run> segmentRuns;
+        if (version >= 2) {
+            stream >> count;
+            for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+                Run run;
+                stream >> run.source >> run.first >> run.count;
+                segmentRuns.append(run);
+            }
+        } else {
+            const Run run = { ThisSegment, 0, quint32(segment.operations.count()) };
+            segmentRuns.append(run);
+            if (segments.isEmpty()) {
+                m_chain.length = 1;
+                m_chain.stored = segment.operations.count();
+            }
+        }
+
+        if (stream.status() != QDataStream::Ok)
+            throw Error(tr("Corrupt operation log."));
+        segments.append(segment);
+        runs.append(segmentRuns);
+
+        if (previous.length() <= 0)
+            break;
+        if (segments.count() >= m_chain.length)
+            throw Error(tr("Corrupt operation log."));
+        if (!in->seek(previous.start() + offset)) {
+            throw Error(tr("Could not seek to %1 to read the operation log.")
+                .arg(previous.start() + offset));
+        }
+    }
+
+    // resolve the list of operations from the first segment on
+    for (int i = segments.count() - 1; i >= 0; --i) {
+        const int segment = m_segments.count();
+        m_segments.append(segments.at(i));
+
+        QVector<QPair<int, quint32> > operations;
+        foreach (const Run &run, runs.at(i)) {
+            if (run.source == PreviousSegments
+                && quint64(run.first) + run.count <= quint64(m_operations.count())) {
+                operations += m_operations.mid(run.first, run.count);
+            } else if (run.source == ThisSegment && quint64(run.first) + run.count
+                <= quint64(segments.at(i).operations.count())) {
+                for (quint32 j = 0; j < run.count; ++j)
+                    operations.append(qMakePair(segment, run.first + j));
+            } else {
+                throw Error(tr("Corrupt operation log."));
+            }
+        }
+        m_operations = operations;
+    }
+}
+
+} // namespace QInstaller
@@ -0,0 +1,106 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef OPERATIONLOG_H
+#define OPERATIONLOG_H
+
+#include "binaryformat.h"
+#include "qinstallerglobal.h"
+#include "range.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QFileDevice;
+QT_END_NAMESPACE
+
+namespace QInstaller {
+
+class INSTALLER_EXPORT OperationLog
+{
+    Q_DISABLE_COPY(OperationLog)
+    Q_DECLARE_TR_FUNCTIONS(OperationLog)
+
+public:
+    // a legacy log starts with the number of operations instead
+    static const qint64 Marker = -1;
+    static const qint64 Version = 2;
+
+    struct Chain
+    {
+        Chain() : length(0), stored(0) {}
+
+        QByteArray id;  // of the last segment
+        qint64 length;  // number of segments
+        qint64 stored;  // operations stored in all segments, including the ones no longer used
+    };
+
+    static Chain write(QFileDevice *out, const OperationList &operations);
+    static Chain append(QFileDevice *out, const OperationList &operations,
+        const QHash<const Operation *, int> &positions, const Chain &chain,
+        const Range<qint64> &previous);
+
+    static Chain readChain(QFileDevice *in);
+    static QList<OperationBlob> read(QFileDevice *in, qint64 offset = 0);
+
+    Chain chain() const;
+    int count() const;
+    QString name(int index) const;
+    bool restore(int index, Operation *operation) const;
+    QVariant value(int index, const QString &key) const;
+
+private:
+    struct Segment
+    {
+        QVector<QString> strings;
+        QVector<QPair<quint32, quint32> > operations;   // name, offset into records
+        QByteArray records;
+    };
+
+    OperationLog() {}
+    bool decode(int index, QStringList *arguments, QVariantMap *values) const;
+    void readSegments(QFileDevice *in, qint64 offset);
+
+private:
+    Chain m_chain;
+    QVector<Segment> m_segments;
+    QVector<QPair<int, quint32> > m_operations;  // segment, operation in the segment
+};
+
+} // namespace QInstaller
+
+#endif // OPERATIONLOG_H
@@ -419,7 +419,8 @@ void PackageManagerCore::writeMaintenanceTool()
 {
     if (d->m_needToWriteMaintenanceTool) {
         try {
-            d->writeMaintenanceTool(d->m_performedOperationsOld + d->m_performedOperationsCurrentSession);
+            d->writeMaintenanceTool(d->performedOperationsOld()
+                + d->m_performedOperationsCurrentSession);
 
             bool gainedAdminRights = false;
             QTemporaryFile tempAdminFile(d->targetDir()
@@ -619,45 +620,19 @@ int PackageManagerCore::downloadNeededArchives(double partProgressSize)
 {
     Q_ASSERT(partProgressSize >= 0 && partProgressSize <= 1);
 
-    QList<QPair<QString, QString> > archivesToDownload;
-    QList<Component*> neededComponents = orderedComponentsToInstall();
-    foreach (Component *component, neededComponents) {
-        // collect all archives to be downloaded
-        const QStringList toDownload = component->downloadableArchives();
-        foreach (const QString &versionFreeString, toDownload) {
-            archivesToDownload.push_back(qMakePair(QString::fromLatin1("installer://%1/%2")
-                .arg(component->name(), versionFreeString), QString::fromLatin1("%1/%2/%3")
-                .arg(component->repositoryUrl().toString(), component->name(), versionFreeString)));
-        }
-    }
-
+    const QList<QPair<QString, QString> > archivesToDownload =
+        d->archivesToDownload(orderedComponentsToInstall());
     if (archivesToDownload.isEmpty())
         return 0;
 
     ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("\nDownloading packages..."));
 
     DownloadArchivesJob archivesJob(this);
-    archivesJob.setAutoDelete(false);
-    archivesJob.setArchivesToDownload(archivesToDownload);
-    connect(this, SIGNAL(installationInterrupted()), &archivesJob, SLOT(cancel()));
-    connect(&archivesJob, SIGNAL(outputTextChanged(QString)), ProgressCoordinator::instance(),
-        SLOT(emitLabelAndDetailTextChanged(QString)));
-    connect(&archivesJob, SIGNAL(downloadStatusChanged(QString)), ProgressCoordinator::instance(),
-        SIGNAL(downloadStatusChanged(QString)));
-
-    ProgressCoordinator::instance()->registerPartProgress(&archivesJob,
-        SIGNAL(progressChanged(double)), partProgressSize);
+    d->setupArchivesJob(&archivesJob, archivesToDownload, partProgressSize);
 
     archivesJob.start();
     archivesJob.waitForFinished();
-
-    if (archivesJob.error() == KDJob::Canceled)
-        interrupt();
-    else if (archivesJob.error() != KDJob::NoError)
-        throw Error(archivesJob.errorString());
-
-    if (d->statusCanceledOrFailed())
-        throw Error(tr("Installation canceled by user"));
+    d->checkArchivesJob(&archivesJob);
 
     ProgressCoordinator::instance()->emitDownloadStatus(tr("All downloads finished."));
 
@@ -737,11 +712,12 @@ void PackageManagerCore::rollBackInstallation()
                 }
             }
 
-            packages.writeToDisk();
+            packages.writeToJournal();
             if (isInstaller()) {
                 if (packages.packageInfoCount() == 0) {
-                    QFile file(packages.fileName());
-                    file.remove();
+                    // nothing left to remember, make sure the target directory can be removed
+                    QFile::remove(packages.fileName());
+                    QFile::remove(packages.journalFileName());
                 }
             }
 
@@ -758,6 +734,8 @@ void PackageManagerCore::rollBackInstallation()
                 "error happened."));
         }
     }
+    // fold the journal written during the rollback into components.xml
+    packages.writeToDisk();
 }
 
 /*!
@@ -830,11 +808,7 @@ PackageManagerCore::PackageManagerCore(qint64 magicmaker, const QList<OperationB
     // Every installed package should have at least one MinimalProgress operation.
     //
     QSet<QString> installedPackages = d->m_core->localInstalledPackages().keys().toSet();
-    QSet<QString> operationPackages;
-    foreach (QInstaller::Operation *operation, d->m_performedOperationsOld) {
-        if (operation->hasValue(QLatin1String("component")))
-            operationPackages.insert(operation->value(QLatin1String("component")).toString());
-    }
+    QSet<QString> operationPackages = d->performedOperationsComponents();
 
     QSet<QString> packagesWithoutOperation = installedPackages - operationPackages;
     QSet<QString> orphanedOperations = operationPackages - installedPackages;
@@ -1342,6 +1316,9 @@ ScriptEngine *PackageManagerCore::controlScriptEngine() const
 void PackageManagerCore::appendRootComponent(Component *component)
 {
     d->m_rootComponents.append(component);
+    d->indexComponent(component, d->m_componentIndex);
+    foreach (Component *descendant, component->descendantComponents())
+        d->indexComponent(descendant, d->m_componentIndex);
     emit componentAdded(component);
 }
 
@@ -1418,6 +1395,7 @@ void PackageManagerCore::appendUpdaterComponent(Component *component)
 {
     component->setUpdateAvailable(true);
     d->m_updaterComponents.append(component);
+    d->indexComponent(component, d->m_updaterComponentIndex);
     emit componentAdded(component);
 }
 
@@ -1429,7 +1407,7 @@ void PackageManagerCore::appendUpdaterComponent(Component *component)
 */
 Component *PackageManagerCore::componentByName(const QString &name) const
 {
-    return componentByName(name, components(ComponentType::AllNoReplacements));
+    return d->componentIndex().componentByName(name);
 }
 
 /*!
@@ -1592,26 +1570,7 @@ QString PackageManagerCore::installReason(Component *component) const
 */
 QList<Component*> PackageManagerCore::dependees(const Component *_component) const
 {
-    if (!_component)
-        return QList<Component *>();
-
-    const QList<QInstaller::Component *> availableComponents = components(ComponentType::All);
-    if (availableComponents.isEmpty())
-        return QList<Component *>();
-
-    const QLatin1Char dash('-');
-    QList<Component *> dependees;
-    foreach (Component *component, availableComponents) {
-        const QStringList &dependencies = component->dependencies();
-        foreach (const QString &dependency, dependencies) {
-            // the last part is considered to be the version then
-            const QString name = dependency.contains(dash) ? dependency.section(dash, 0, 0) : dependency;
-            const QString version = dependency.contains(dash) ? dependency.section(dash, 1) : QString();
-            if (componentMatches(_component, name, version))
-                dependees.append(component);
-        }
-    }
-    return dependees;
+    return d->componentIndex().dependees(_component);
 }
 
 /*!
@@ -2574,6 +2533,10 @@ bool PackageManagerCore::fetchUpdaterPackages(const PackagesList &remotes, const
             foreach (QInstaller::Component *component, components) {
                 appendUpdaterComponent(component);
             }
+            foreach (QInstaller::Component *component, d->m_updaterComponentsDeps)
+                d->indexComponent(component, d->m_updaterComponentIndex);
+            foreach (QInstaller::Component *component, d->m_updaterDependencyReplacements)
+                d->indexComponent(component, d->m_updaterComponentIndex, true);
 
             // after everything is set up, load the scripts
             foreach (QInstaller::Component *component, components) {
@@ -344,6 +344,9 @@ private:
     PackageManagerCorePrivate *const d;
     friend class PackageManagerCorePrivate;
 
+    // keeps the component index in sync when children are appended or removed
+    friend class Component;
+
 private:
     // remove once we deprecate isSelected, setSelected etc...
     friend class ComponentSelectionPage;
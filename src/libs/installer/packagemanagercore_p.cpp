@@ -40,17 +40,21 @@
 #include "component.h"
 #include "scriptengine.h"
 #include "componentmodel.h"
+#include "downloadarchivesjob.h"
 #include "errors.h"
 #include "fileio.h"
+#include "filehasher.h"
 #include "remotefileengine.h"
 #include "graph.h"
 #include "messageboxhandler.h"
+#include "operationlog.h"
 #include "packagemanagercore.h"
 #include "progresscoordinator.h"
 #include "qprocesswrapper.h"
 #include "protocol.h"
 #include "qsettingswrapper.h"
 #include "installercalculator.h"
+#include "lib7z_facade.h"
 #include "uninstallercalculator.h"
 #include "componentchecker.h"
 #include "globals.h"
@@ -58,14 +62,17 @@
 #include "kdselfrestarter.h"
 #include "kdupdaterfiledownloaderfactory.h"
 #include "kdupdaterupdatesourcesinfo.h"
+#include "kdupdaterupdatesinfo_p.h"
 #include "kdupdaterupdateoperationfactory.h"
 
 #include <productkeycheck.h>
 
+#include <QtConcurrentMap>
 #include <QtConcurrentRun>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
 #include <QtCore/QDirIterator>
+#include <QtCore/QEventLoop>
 #include <QtCore/QUuid>
 #include <QtCore/QFuture>
 #include <QtCore/QFutureWatcher>
@@ -78,6 +85,9 @@
 
 #ifdef Q_OS_WIN
 #include <qt_windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
 #endif
 
 #define QUOTE_(x) #x
@@ -132,6 +142,163 @@ static bool runOperation(Operation *operation, PackageManagerCorePrivate::Operat
     return false;
 }
 
+class OperationRunner
+{
+public:
+    typedef bool result_type;
+
+    explicit OperationRunner(PackageManagerCorePrivate::OperationType type) : m_type(type) {}
+    bool operator()(Operation *operation) const
+    {
+        return runOperation(operation, m_type);
+    }
+private:
+    PackageManagerCorePrivate::OperationType m_type;
+};
+
+/*
+    Keeps track of the paths used by operations that run at the same time. A path conflicts with
+    another one if they are equal or one of them is a directory containing the other.
+*/
+class OperationResources
+{
+public:
+    bool conflicts(const QString &path) const
+    {
+        if (m_paths.contains(path) || m_parents.contains(path))
+            return true;
+        for (QString parent = parentPath(path); !parent.isEmpty(); parent = parentPath(parent)) {
+            if (m_paths.contains(parent))
+                return true;
+        }
+        return false;
+    }
+
+    void insert(const QString &path)
+    {
+        m_paths.insert(path);
+        for (QString parent = parentPath(path); !parent.isEmpty(); parent = parentPath(parent))
+            m_parents.insert(parent);
+    }
+
+private:
+    static QString parentPath(const QString &path)
+    {
+        const int index = path.lastIndexOf(QLatin1Char('/'));
+        return index > 0 ? path.left(index) : QString();
+    }
+
+    QSet<QString> m_paths;
+    QSet<QString> m_parents;
+};
+
+static QString resourcePath(const QString &path)
+{
+    const QString result = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+#ifdef Q_OS_WIN
+    return result.toLower();
+#else
+    return result;
+#endif
+}
+
+/*
+    Adds the paths in \a resources to \a used, unless one of them conflicts with a path in use
+    already. Returns \c false in that case.
+*/
+static bool reserveResources(OperationResources *used, const QStringList &resources)
+{
+    QStringList paths;
+    foreach (const QString &resource, resources) {
+        const QString path = resourcePath(resource);
+        if (used->conflicts(path))
+            return false;
+        paths.append(path);
+    }
+    foreach (const QString &path, paths)
+        used->insert(path);
+    return true;
+}
+
+/*
+    Returns the outermost directory that creating \a path also creates, or \a path itself if its
+    parent directory exists already.
+*/
+static QString firstMissingPath(const QString &path)
+{
+    QFileInfo info(path);
+    while (!info.exists()) {
+        const QFileInfo parent(info.absolutePath());
+        if (parent.exists() || parent.absoluteFilePath() == info.absoluteFilePath())
+            break;
+        info = parent;
+    }
+    return info.absoluteFilePath();
+}
+
+/*
+    Collects the paths \a operation reads or writes in \a resources. Returns \c false if the side
+    effects of the operation are not known, for example because it starts a process or runs a
+    script; such an operation has to run on its own.
+*/
+static bool operationResources(const Operation *operation, QStringList *resources)
+{
+    const QString name = operation->name();
+    const QStringList arguments = operation->arguments();
+    if (name == QLatin1String("MinimumProgress"))
+        return true;
+
+    if ((name == QLatin1String("Copy") || name == QLatin1String("Move")) && arguments.count() == 2) {
+        const QString source = arguments.at(0);
+        QString destination = arguments.at(1);
+        if (QFileInfo(destination).isDir())
+            destination += QLatin1Char('/') + QFileInfo(source).fileName();
+        *resources << source << destination;
+        return true;
+    }
+
+    if (name == QLatin1String("CopyTree") && arguments.count() == 2) {
+        *resources << arguments.at(0) << firstMissingPath(arguments.at(1));
+        return true;
+    }
+
+    if (name == QLatin1String("Delete") && arguments.count() == 1) {
+        *resources << arguments.at(0);
+        return true;
+    }
+
+    if (name == QLatin1String("Mkdir") && arguments.count() == 1) {
+        *resources << firstMissingPath(arguments.at(0));
+        return true;
+    }
+
+    if (name == QLatin1String("Settings")) {
+        const QString path = operation->argumentKeyValue(QLatin1String("path"));
+        if (path.isEmpty())
+            return false;
+        *resources << firstMissingPath(path);   // creates the directory of the file if needed
+        return true;
+    }
+
+    if (name == QLatin1String("Extract") && arguments.count() == 2) {
+        QFile archive(arguments.at(0));
+        if (!archive.open(QIODevice::ReadOnly))
+            return false;
+        try {
+            const QString targetDir = arguments.at(1);
+            foreach (const Lib7z::File &file, Lib7z::listArchive(&archive)) {
+                if (!file.isDirectory)
+                    *resources << (targetDir + QLatin1Char('/') + file.path);
+            }
+        } catch (const Lib7z::SevenZipException &) {
+            return false;
+        }
+        *resources << archive.fileName();
+        return true;
+    }
+    return false;
+}
+
 static QStringList checkRunningProcessesFromList(const QStringList &processList)
 {
     const QList<ProcessInfo> allProcesses = runningProcesses();
@@ -214,6 +381,7 @@ PackageManagerCorePrivate::PackageManagerCorePrivate(PackageManagerCore *core, q
     , m_launchedAsRoot(AdminAuthorization::hasAdminRights())
     , m_completeUninstall(false)
     , m_needToWriteMaintenanceTool(false)
+    , m_performedOperationBlobs(performedOperations)
     , m_dependsOnLocalInstallerBinary(false)
     , m_core(core)
     , m_updates(false)
@@ -231,22 +399,6 @@ PackageManagerCorePrivate::PackageManagerCorePrivate(PackageManagerCore *core, q
     , m_guiObject(0)
     , m_remoteFileEngineHandler(new RemoteFileEngineHandler)
 {
-    foreach (const OperationBlob &operation, performedOperations) {
-        QScopedPointer<QInstaller::Operation> op(KDUpdater::UpdateOperationFactory::instance()
-            .create(operation.name));
-        if (op.isNull()) {
-            qWarning() << QString::fromLatin1("Failed to load unknown operation %1")
-                .arg(operation.name);
-            continue;
-        }
-
-        if (!op->fromXml(operation.xml)) {
-            qWarning() << "Failed to load XML for operation:" << operation.name;
-            continue;
-        }
-        m_performedOperationsOld.append(op.take());
-    }
-
     connect(this, SIGNAL(installationStarted()), m_core, SIGNAL(installationStarted()));
     connect(this, SIGNAL(installationFinished()), m_core, SIGNAL(installationFinished()));
     connect(this, SIGNAL(uninstallationStarted()), m_core, SIGNAL(uninstallationStarted()));
@@ -321,6 +473,23 @@ bool PackageManagerCorePrivate::performOperationThreaded(Operation *operation, O
     return future.result();
 }
 
+/* static */
+QList<bool> PackageManagerCorePrivate::performOperationsThreaded(const OperationList &operations,
+    OperationType type)
+{
+    QFutureWatcher<bool> futureWatcher;
+    const QFuture<bool> future = QtConcurrent::mapped(operations, OperationRunner(type));
+
+    QEventLoop loop;
+    loop.connect(&futureWatcher, SIGNAL(finished()), SLOT(quit()), Qt::QueuedConnection);
+    futureWatcher.setFuture(future);
+
+    if (!future.isFinished())
+        loop.exec();
+
+    return future.results();
+}
+
 QString PackageManagerCorePrivate::targetDir() const
 {
     return m_core->value(scTargetDir);
@@ -354,11 +523,14 @@ bool PackageManagerCorePrivate::buildComponentTree(QHash<QString, Component*> &c
             }
         }
 
-        // append all components w/o parent to the direct list
+        // append all components w/o parent to the direct list, this indexes the whole tree
+        m_componentIndex.reserve(components.count() + m_rootDependencyReplacements.count());
         foreach (QInstaller::Component *component, components) {
             if (component->parentComponent() == 0)
                 m_core->appendRootComponent(component);
         }
+        foreach (QInstaller::Component *component, m_rootDependencyReplacements)
+            indexComponent(component, m_componentIndex, true);
 
         // after everything is set up, load the scripts if needed
         if (loadScript) {
@@ -445,6 +617,7 @@ void PackageManagerCorePrivate::clearAllComponentLists()
     m_rootComponents.clear();
 
     m_rootDependencyReplacements.clear();
+    m_componentIndex.clear();
 
     const QList<QPair<Component*, Component*> > list = m_componentsToReplaceAllMode.values();
     for (int i = 0; i < list.count(); ++i)
@@ -473,6 +646,7 @@ void PackageManagerCorePrivate::clearUpdaterComponentLists()
     m_updaterComponentsDeps.clear();
 
     m_updaterDependencyReplacements.clear();
+    m_updaterComponentIndex.clear();
 
     m_componentsToReplaceUpdaterMode.clear();
     m_componentsToInstallCalculated = false;
@@ -491,6 +665,28 @@ QHash<QString, QPair<Component*, Component*> > &PackageManagerCorePrivate::compo
     return (!isUpdater()) ? m_componentsToReplaceAllMode : m_componentsToReplaceUpdaterMode;
 }
 
+ComponentIndex &PackageManagerCorePrivate::componentIndex()
+{
+    return (!isUpdater()) ? m_componentIndex : m_updaterComponentIndex;
+}
+
+const ComponentIndex &PackageManagerCorePrivate::componentIndex() const
+{
+    return (!isUpdater()) ? m_componentIndex : m_updaterComponentIndex;
+}
+
+/*!
+    Adds \a component to \a index and keeps the index entry up to date when the component's name
+    or dependencies change later on, for example from within a component script.
+*/
+void PackageManagerCorePrivate::indexComponent(Component *component, ComponentIndex &index,
+    bool replacement)
+{
+    index.insert(component, replacement);
+    connect(component, SIGNAL(valueChanged(QString,QString)), this,
+        SLOT(componentValueChanged(QString)), Qt::UniqueConnection);
+}
+
 void PackageManagerCorePrivate::clearInstallerCalculator()
 {
     delete m_installerCalculator;
@@ -502,7 +698,8 @@ InstallerCalculator *PackageManagerCorePrivate::installerCalculator() const
     if (!m_installerCalculator) {
         PackageManagerCorePrivate *const pmcp = const_cast<PackageManagerCorePrivate *> (this);
         pmcp->m_installerCalculator = new InstallerCalculator(
-            m_core->components(PackageManagerCore::ComponentType::AllNoReplacements));
+            m_core->components(PackageManagerCore::ComponentType::AllNoReplacements),
+            &componentIndex());
     }
     return m_installerCalculator;
 }
@@ -550,9 +747,6 @@ void PackageManagerCorePrivate::initialize(const QHash<QString, QString> &params
 #endif
     }
 
-    foreach (Operation *currentOperation, m_performedOperationsOld)
-        currentOperation->setValue(QLatin1String("installer"), QVariant::fromValue(m_core));
-
     disconnect(this, SIGNAL(installationStarted()), ProgressCoordinator::instance(), SLOT(reset()));
     connect(this, SIGNAL(installationStarted()), ProgressCoordinator::instance(), SLOT(reset()));
     disconnect(this, SIGNAL(uninstallationStarted()), ProgressCoordinator::instance(), SLOT(reset()));
@@ -1061,6 +1255,24 @@ void PackageManagerCorePrivate::writeMaintenanceToolBinary(QFile *const input, q
     }
 }
 
+/*
+    Writes the trailer of the maintenance tool binary data: the given segments relative to
+    \a dataBlockStart, the meta resource count, the size of the data block and the marker.
+*/
+static void appendMaintenanceToolTrailer(QFileDevice *output, qint64 dataBlockStart,
+    const Range<qint64> &collectionIndex, const QVector<Range<qint64> > &resourceSegments,
+    const Range<qint64> &operations, qint64 metaCount)
+{
+    QInstaller::appendInt64Range(output, collectionIndex.moved(-dataBlockStart));
+    foreach (const Range<qint64> segment, resourceSegments)
+        QInstaller::appendInt64Range(output, segment.moved(-dataBlockStart));
+    QInstaller::appendInt64Range(output, operations.moved(-dataBlockStart));
+    QInstaller::appendInt64(output, metaCount);
+    // data block size, from end of .exe to end of file
+    QInstaller::appendInt64(output, output->pos() + 3 * sizeof(qint64) -dataBlockStart);
+    QInstaller::appendInt64(output, BinaryContent::MagicUninstallerMarker);
+}
+
 void PackageManagerCorePrivate::writeMaintenanceToolBinaryData(QFileDevice *output, QFile *const input,
     const OperationList &performedOperations, const BinaryLayout &layout)
 {
@@ -1092,18 +1304,7 @@ void PackageManagerCorePrivate::writeMaintenanceToolBinaryData(QFileDevice *outp
     }
 
     const qint64 operationsStart = output->pos();
-    QInstaller::appendInt64(output, performedOperations.count());
-    foreach (Operation *operation, performedOperations) {
-        // the installer can't be put into XML, remove it first
-        operation->clearValue(QLatin1String("installer"));
-
-        QInstaller::appendString(output, operation->name());
-        QInstaller::appendString(output, operation->toXml().toString());
-
-        // for the ui not to get blocked
-        qApp->processEvents();
-    }
-    QInstaller::appendInt64(output, performedOperations.count());
+    const OperationLog::Chain chain = OperationLog::write(output, performedOperations);
     const qint64 operationsEnd = output->pos();
 
     // we don't save any component-indexes.
@@ -1115,16 +1316,199 @@ void PackageManagerCorePrivate::writeMaintenanceToolBinaryData(QFileDevice *outp
     QInstaller::appendInt64(output, numComponents); // one before and one after the components
     const qint64 compIndexEnd = output->pos();
 
-    QInstaller::appendInt64Range(output, Range<qint64>::fromStartAndEnd(compIndexStart, compIndexEnd)
-        .moved(-dataBlockStart));
-    foreach (const Range<qint64> segment, resourceSegments)
-        QInstaller::appendInt64Range(output, segment.moved(-dataBlockStart));
-    QInstaller::appendInt64Range(output, Range<qint64>::fromStartAndEnd(operationsStart, operationsEnd)
-        .moved(-dataBlockStart));
-    QInstaller::appendInt64(output, layout.metaResourceSegments.count());
-    // data block size, from end of .exe to end of file
-    QInstaller::appendInt64(output, output->pos() + 3 * sizeof(qint64) -dataBlockStart);
-    QInstaller::appendInt64(output, BinaryContent::MagicUninstallerMarker);
+    appendMaintenanceToolTrailer(output, dataBlockStart, Range<qint64>::fromStartAndEnd(compIndexStart,
+        compIndexEnd), resourceSegments, Range<qint64>::fromStartAndEnd(operationsStart,
+        operationsEnd), layout.metaResourceSegments.count());
+    setOperationLogChain(chain, performedOperations);
+}
+
+static const int scMaxOperationLogChainLength = 16;
+
+/*
+    Flushes \a file and waits until the system wrote it to the disk. Returns \c true on success.
+*/
+static bool syncToDisk(QFile *file)
+{
+    if (!file->flush())
+        return false;
+#ifdef Q_OS_WIN
+    return FlushFileBuffers(HANDLE(_get_osfhandle(file->handle()))) != 0;
+#else
+    return fsync(file->handle()) == 0;
+#endif
+}
+
+/*!
+    Appends the operations of \a performed that are not stored yet to the maintenance tool data
+    file \a dataFile, together with a new trailer. The meta resources and the operations stored
+    before are left in place. Returns \c false if the file cannot be updated that way, for example
+    because it was not written by this session or its operation log is due for compaction; the
+    caller then writes the data anew.
+
+    The new segment and trailer are written before the magic cookie that ends them. Until the
+    cookie is on the disk, BinaryContent::findMagicCookie() still finds the previous one, so an
+    interrupted or failed append leaves the previous trailer valid. The file is not truncated
+    afterwards; the next append finds the tail and writes the data anew instead.
+*/
+bool PackageManagerCorePrivate::appendMaintenanceToolOperations(const QString &dataFile,
+    const OperationList &performed)
+{
+    if (m_operationLogChain.id.isEmpty())
+        return false;
+
+    // Operations no longer used stay in the log until it gets written anew. Do so once they
+    // outnumber the used ones, or the chain of segments gets too long to read quickly.
+    int added = 0;
+    foreach (const Operation *operation, performed) {
+        if (!m_operationLogPositions.contains(operation))
+            ++added;
+    }
+    if (m_operationLogChain.length >= scMaxOperationLogChainLength
+        || m_operationLogChain.stored + added > 2 * qMax(performed.count(), 256)) {
+        qDebug() << "Compacting the operation log of the maintenance tool.";
+        return false;
+    }
+
+    QFile file(dataFile);
+    if (!file.open(QIODevice::ReadWrite))
+        return false;
+
+    try {
+        const qint64 size = file.size();
+        const BinaryLayout layout = BinaryContent::binaryLayout(&file,
+            BinaryContent::MagicCookieDat);
+        if (layout.endOfBinaryContent != size || !file.seek(layout.operationsSegment.start())
+            || OperationLog::readChain(&file).id != m_operationLogChain.id) {
+            return false;   // not what we have read or written before
+        }
+
+        // Write the tail aside first, it starts at the current end of the data file.
+        QTemporaryFile tail;
+        if (!tail.open())
+            throw Error(tr("Could not create temporary file: %1").arg(tail.errorString()));
+
+        const qint64 dataBlockStart = layout.endOfExectuable;
+        const OperationLog::Chain chain = OperationLog::append(&tail, performed,
+            m_operationLogPositions, m_operationLogChain,
+            layout.operationsSegment.moved(-dataBlockStart));
+        const qint64 operationsLength = tail.pos();
+
+        QVector<Range<qint64> > resourceSegments;
+        foreach (const Range<qint64> &segment, layout.metaResourceSegments)
+            resourceSegments.append(segment.moved(-size));
+        appendMaintenanceToolTrailer(&tail, dataBlockStart - size,
+            layout.resourceCollectionsSegment.moved(-size), resourceSegments,
+            Range<qint64>::fromStartAndLength(0, operationsLength),
+            layout.metaResourceSegments.count());
+
+        // the previous cookie has to stay within reach while the tail is incomplete
+        const qint64 tailSize = tail.pos();
+        if (tailSize + qint64(sizeof(qint64)) > BinaryContent::MagicCookieSearchRange) {
+            qDebug() << "Operation log segment too large to append.";
+            return false;
+        }
+
+        if (!file.seek(size) || !tail.seek(0)) {
+            throw Error(tr("Could not seek to %1 in %2: %3").arg(QString::number(size),
+                file.fileName(), file.errorString()));
+        }
+        QInstaller::appendData(&file, &tail, tailSize);
+        if (!syncToDisk(&file)) {
+            throw Error(tr("Could not write maintenance tool binary data to %1: %2")
+                .arg(file.fileName(), file.errorString()));
+        }
+        QInstaller::appendInt64(&file, BinaryContent::MagicCookieDat);
+        if (!syncToDisk(&file)) {
+            throw Error(tr("Could not write maintenance tool binary data to %1: %2")
+                .arg(file.fileName(), file.errorString()));
+        }
+
+        qDebug() << "Appended" << added << "operations to" << dataFile;
+        setOperationLogChain(chain, performed);
+    } catch (const Error &error) {
+        qDebug() << error.message();
+        return false;
+    }
+    return true;
+}
+
+/*!
+    Deletes \a operations and drops them from the positions of the operation log, so that an
+    operation created later at the same address is not taken for one that is stored already.
+*/
+void PackageManagerCorePrivate::deleteOperations(const OperationList &operations)
+{
+    foreach (Operation *operation, operations)
+        m_operationLogPositions.remove(operation);
+    qDeleteAll(operations);
+}
+
+void PackageManagerCorePrivate::setOperationLogChain(const OperationLog::Chain &chain,
+    const OperationList &operations)
+{
+    m_operationLogChain = chain;
+    m_operationLogPositions.clear();
+    for (int i = 0; i < operations.count(); ++i)
+        m_operationLogPositions.insert(operations.at(i), i);
+}
+
+/*!
+    Returns the operations performed by earlier sessions. They are created from the operation
+    log the first time they are needed, so starting the maintenance tool does not restore
+    operations that are never undone or written again.
+*/
+OperationList &PackageManagerCorePrivate::performedOperationsOld()
+{
+    foreach (const OperationBlob &operation, m_performedOperationBlobs) {
+        QScopedPointer<QInstaller::Operation> op(KDUpdater::UpdateOperationFactory::instance()
+            .create(operation.name));
+        if (op.isNull()) {
+            qWarning() << QString::fromLatin1("Failed to load unknown operation %1")
+                .arg(operation.name);
+            continue;
+        }
+
+        if (operation.log) {
+            if (!operation.log->restore(operation.index, op.data())) {
+                qWarning() << "Failed to load operation:" << operation.name;
+                continue;
+            }
+            m_operationLogChain = operation.log->chain();
+            m_operationLogPositions.insert(op.data(), operation.index);
+        } else if (!op->fromXml(operation.xml)) {
+            qWarning() << "Failed to load XML for operation:" << operation.name;
+            continue;
+        }
+        op->setValue(QLatin1String("installer"), QVariant::fromValue(m_core));
+        m_performedOperationsOld.append(op.take());
+    }
+    m_performedOperationBlobs.clear();
+    return m_performedOperationsOld;
+}
+
+/*!
+    Returns the components the operations performed so far belong to. Operations still in the
+    binary operation log are not restored for that.
+*/
+QSet<QString> PackageManagerCorePrivate::performedOperationsComponents()
+{
+    const QString component = QLatin1String("component");
+
+    QSet<QString> components;
+    if (!m_performedOperationBlobs.isEmpty() && m_performedOperationBlobs.first().log) {
+        foreach (const OperationBlob &operation, m_performedOperationBlobs) {
+            const QVariant value = operation.log->value(operation.index, component);
+            if (value.isValid())
+                components.insert(value.toString());
+        }
+        return components;
+    }
+
+    foreach (const Operation *operation, performedOperationsOld()) {
+        if (operation->hasValue(component))
+            components.insert(operation->value(component).toString());
+    }
+    return components;
 }
 
 void PackageManagerCorePrivate::writeMaintenanceTool(OperationList performedOperations)
@@ -1249,6 +1633,9 @@ void PackageManagerCorePrivate::writeMaintenanceTool(OperationList performedOper
         //          |--- append the binary data based on the loaded input file (see 2), make sure we force
         //                 uncompressing the resource section if we read from a binary data file (see 4.1).
         //
+        //   |--- if we read the input from the binary data file and no new binary is needed, append
+        //          the operations of this session to it in place instead (see 3.2)
+        //
         // 4 - force a deferred rename on the .dat file (see 4.1)
         // 5 - force a deferred rename on the maintenance file (see 5.1)
 
@@ -1257,6 +1644,8 @@ void PackageManagerCorePrivate::writeMaintenanceTool(OperationList performedOper
         //          layout (mostly likely the resource section or we couldn't seek inside the file)
         //
         // 3.1 - most likely the commit operation will fail
+        // 3.2 - if that fails, or the operation log is due for compaction, the file is restored and
+        //          written anew; no rename is needed after appending
         // 4.1 - if 3 failed, this makes sure the .dat file will get removed and on the next run all
         //          binary data is read from the maintenance tool, otherwise it get replaced be the new one
         // 5.1 - this will only happen -if- we wrote out a new binary
@@ -1297,6 +1686,7 @@ void PackageManagerCorePrivate::writeMaintenanceTool(OperationList performedOper
 
         QFile input;
         BinaryLayout layout;
+        bool dataFileRead = false;
         const QString dataFile = targetDir() + QLatin1Char('/') + m_data.settings().maintenanceToolName()
             + QLatin1String(".dat");
         try {
@@ -1311,6 +1701,7 @@ void PackageManagerCorePrivate::writeMaintenanceTool(OperationList performedOper
             input.setFileName(dataFile);
             QInstaller::openForRead(&input);
             layout = BinaryContent::binaryLayout(&input, BinaryContent::MagicCookieDat);
+            dataFileRead = true;
         } catch (const Error &/*error*/) {
 #ifdef Q_OS_OSX
             // On Mac, data is always in a separate file so that the binary can be signed
@@ -1344,46 +1735,63 @@ void PackageManagerCorePrivate::writeMaintenanceTool(OperationList performedOper
         performedOperations = sortOperationsBasedOnComponentDependencies(performedOperations);
         m_core->setValue(QLatin1String("installedOperationAreSorted"), QLatin1String("true"));
 
-        try {
-            QFile file(generateTemporaryFileName());
-            QInstaller::openForWrite(&file);
+        // the installer can't be stored, remove it first
+        foreach (Operation *operation, performedOperations)
+            operation->clearValue(QLatin1String("installer"));
+
+        bool appended = false;
+        if (dataFileRead && !newBinaryWritten
+            && m_core->value(QLatin1String("DefaultResourceReplacement")).isEmpty()) {
+            input.close();
+            appended = appendMaintenanceToolOperations(dataFile, performedOperations);
+            if (!appended)
+                QInstaller::openForRead(&input);
+        }
 
-            writeMaintenanceToolBinaryData(&file, &input, performedOperations, layout);
-            QInstaller::appendInt64(&file, BinaryContent::MagicCookieDat);
+        if (!appended) {
+            try {
+                QFile file(generateTemporaryFileName());
+                QInstaller::openForWrite(&file);
 
-            QFile dummy(dataFile + QLatin1String(".new"));
-            if (dummy.exists() && !dummy.remove()) {
-                throw Error(tr("Could not remove data file '%1': %2").arg(dummy.fileName(),
-                    dummy.errorString()));
-            }
+                writeMaintenanceToolBinaryData(&file, &input, performedOperations, layout);
+                QInstaller::appendInt64(&file, BinaryContent::MagicCookieDat);
 
-            if (!file.rename(dataFile + QLatin1String(".new"))) {
-                throw Error(tr("Could not write maintenance tool binary data to %1: %2")
-                    .arg(file.fileName(), file.errorString()));
-            }
-            file.setPermissions(file.permissions() | QFile::WriteUser | QFile::ReadGroup
-                | QFile::ReadOther);
-        } catch (const Error &/*error*/) {
-            if (!newBinaryWritten) {
-                newBinaryWritten = true;
-                QFile tmp(isInstaller() ? installerBinaryPath() : maintenanceToolName());
-                QInstaller::openForRead(&tmp);
-                BinaryLayout tmpLayout = BinaryContent::binaryLayout(&tmp, BinaryContent::MagicCookie);
-                writeMaintenanceToolBinary(&tmp, tmpLayout.endOfBinaryContent
-                    - tmpLayout.binaryContentSize, false);
-            }
+                QFile dummy(dataFile + QLatin1String(".new"));
+                if (dummy.exists() && !dummy.remove()) {
+                    throw Error(tr("Could not remove data file '%1': %2").arg(dummy.fileName(),
+                        dummy.errorString()));
+                }
+
+                if (!file.rename(dataFile + QLatin1String(".new"))) {
+                    throw Error(tr("Could not write maintenance tool binary data to %1: %2")
+                        .arg(file.fileName(), file.errorString()));
+                }
+                file.setPermissions(file.permissions() | QFile::WriteUser | QFile::ReadGroup
+                    | QFile::ReadOther);
+            } catch (const Error &/*error*/) {
+                if (!newBinaryWritten) {
+                    newBinaryWritten = true;
+                    QFile tmp(isInstaller() ? installerBinaryPath() : maintenanceToolName());
+                    QInstaller::openForRead(&tmp);
+                    BinaryLayout tmpLayout = BinaryContent::binaryLayout(&tmp,
+                        BinaryContent::MagicCookie);
+                    writeMaintenanceToolBinary(&tmp, tmpLayout.endOfBinaryContent
+                        - tmpLayout.binaryContentSize, false);
+                }
 
-            QFile file(maintenanceToolName() + QLatin1String(".new"));
-            QInstaller::openForAppend(&file);
-            file.seek(file.size());
-            writeMaintenanceToolBinaryData(&file, &input, performedOperations, layout);
-            QInstaller::appendInt64(&file, BinaryContent::MagicCookie);
+                QFile file(maintenanceToolName() + QLatin1String(".new"));
+                QInstaller::openForAppend(&file);
+                file.seek(file.size());
+                writeMaintenanceToolBinaryData(&file, &input, performedOperations, layout);
+                QInstaller::appendInt64(&file, BinaryContent::MagicCookie);
+            }
         }
         input.close();
         if (m_core->isInstaller())
             registerMaintenanceTool();
         writeMaintenanceConfigFiles();
-        deferredRename(dataFile + QLatin1String(".new"), dataFile, false);
+        if (!appended)
+            deferredRename(dataFile + QLatin1String(".new"), dataFile, false);
 
         if (newBinaryWritten) {
 #if !defined(LUMIT_INSTALLER) || defined(Q_OS_DARWIN)
@@ -1502,14 +1910,27 @@ bool PackageManagerCorePrivate::runInstaller()
             }
         }
 
+        if (m_core->testChecksum())
+            verifyEmbeddedArchives(componentsToInstall);
+
         const double downloadPartProgressSize = double(1) / double(3);
         double componentsInstallPartProgressSize = double(2) / double(3);
-        const int downloadedArchivesCount = m_core->downloadNeededArchives(downloadPartProgressSize);
+        const QList<QPair<QString, QString> > archives = archivesToDownload(componentsToInstall);
 
-        // if there was no download we have the whole progress for installing components
-        if (!downloadedArchivesCount)
+        // if there is no download we have the whole progress for installing components
+        if (archives.isEmpty())
             componentsInstallPartProgressSize = double(1);
 
+        // Components get installed as soon as their archives arrived, while the remaining ones are
+        // still downloading. Fetch them in installation order for that.
+        DownloadArchivesJob archivesJob(m_core);
+        if (!archives.isEmpty()) {
+            ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("\nDownloading packages..."));
+            setupArchivesJob(&archivesJob, archives, downloadPartProgressSize);
+            archivesJob.setPreserveOrder(true);
+            archivesJob.start();
+        }
+
         // Force an update on the components xml as the install dir might have changed.
         KDUpdater::PackagesInfo &info = *m_updaterApplication.packagesInfo();
         info.setFileName(componentsXmlPath());
@@ -1525,8 +1946,19 @@ bool PackageManagerCorePrivate::runInstaller()
             + (PackageManagerCore::createLocalRepositoryFromBinary() ? 1 : 0);
         double progressOperationSize = componentsInstallPartProgressSize / progressOperationCount;
 
-        foreach (Component *component, componentsToInstall)
+        // dependencies come first in the list, so their archives are in place as well
+        foreach (Component *component, componentsToInstall) {
+            waitForArchives(&archivesJob, component);
             installComponent(component, progressOperationSize, adminRightsGained);
+        }
+
+        if (!archives.isEmpty()) {
+            checkArchivesJob(&archivesJob);
+            ProgressCoordinator::instance()->emitDownloadStatus(tr("All downloads finished."));
+        }
+
+        // fold the install journal into components.xml
+        info.writeToDisk();
 
         if (m_core->isOfflineOnly() && PackageManagerCore::createLocalRepositoryFromBinary()) {
             emit m_core->titleMessageChanged(tr("Creating local repository"));
@@ -1583,7 +2015,7 @@ bool PackageManagerCorePrivate::runInstaller()
 #else
         emit m_core->titleMessageChanged(tr("Creating Maintenance Tool"));
 
-        writeMaintenanceTool(m_performedOperationsOld + m_performedOperationsCurrentSession);
+        writeMaintenanceTool(performedOperationsOld() + m_performedOperationsCurrentSession);
 #endif
 
         // fake a possible wrong value to show a full progress bar
@@ -1661,9 +2093,9 @@ bool PackageManagerCorePrivate::runPackageUpdater()
 
         // order the operations in the right component dependency order
         // next loop will save the needed operations in reverse order for uninstallation
-        OperationList performedOperationsOld = m_performedOperationsOld;
+        OperationList performedOperationsOld = this->performedOperationsOld();
         if (m_core->value(QLatin1String("installedOperationAreSorted")) != QLatin1String("true"))
-            performedOperationsOld = sortOperationsBasedOnComponentDependencies(m_performedOperationsOld);
+            performedOperationsOld = sortOperationsBasedOnComponentDependencies(performedOperationsOld);
 
         // build a list of undo operations based on the checked state of the component
         foreach (Operation *operation, performedOperationsOld) {
@@ -1756,6 +2188,9 @@ bool PackageManagerCorePrivate::runPackageUpdater()
         foreach (Component *component, componentsToInstall)
             installComponent(component, progressOperationSize, adminRightsGained);
 
+        // fold the install journal into components.xml
+        m_updaterApplication.packagesInfo()->writeToDisk();
+
         emit m_core->titleMessageChanged(tr("Creating Maintenance Tool"));
 
         commitSessionOperations(); //end session, move ops to "old"
@@ -1804,7 +2239,7 @@ bool PackageManagerCorePrivate::runUninstaller()
         if (!tempAdminFile.open() || !tempAdminFile.isWritable())
             adminRightsGained = m_core->gainAdminRights();
 
-        OperationList undoOperations = m_performedOperationsOld;
+        OperationList undoOperations = performedOperationsOld();
         std::reverse(undoOperations.begin(), undoOperations.end());
 
 #if defined(LUMIT_INSTALLER) && defined(Q_OS_OSX)
@@ -1888,10 +2323,21 @@ void PackageManagerCorePrivate::installComponent(Component *component, double pr
                 .arg(component->displayName()));
     }
 
-    foreach (Operation *operation, operations) {
+    for (int i = 0; i < operations.count(); ++i) {
         if (statusCanceledOrFailed())
             throw Error(tr("Installation canceled by user"));
 
+        // operations that do not touch the same paths get performed side by side
+        const OperationList independentOperations = concurrentOperations(operations, i,
+            adminRightsGained);
+        if (independentOperations.count() > 1) {
+            installOperationsConcurrently(component, independentOperations, progressOperationSize);
+            i += independentOperations.count() - 1;
+            continue;
+        }
+
+        Operation *const operation = operations.at(i);
+
         // maybe this operations wants us to be admin...
         bool becameAdmin = false;
         if (!adminRightsGained && operation->value(QLatin1String("admin")).toBool()) {
@@ -1907,24 +2353,8 @@ void PackageManagerCorePrivate::installComponent(Component *component, double pr
 
         bool ignoreError = false;
         bool ok = performOperationThreaded(operation);
-        while (!ok && !ignoreError && m_core->status() != PackageManagerCore::Canceled) {
-            qDebug() << QString::fromLatin1("Operation '%1' with arguments: '%2' failed: %3")
-                .arg(operation->name(), operation->arguments().join(QLatin1String("; ")),
-                operation->errorString());
-            const QMessageBox::StandardButton button =
-                MessageBoxHandler::warning(MessageBoxHandler::currentBestSuitParent(),
-                QLatin1String("installationErrorWithRetry"), tr("Installer Error"),
-                tr("Error during installation process (%1):\n%2").arg(component->name(),
-                operation->errorString()),
-                QMessageBox::Retry | QMessageBox::Ignore | QMessageBox::Cancel, QMessageBox::Retry);
-
-            if (button == QMessageBox::Retry)
-                ok = performOperationThreaded(operation);
-            else if (button == QMessageBox::Ignore)
-                ignoreError = true;
-            else if (button == QMessageBox::Cancel)
-                m_core->interrupt();
-        }
+        if (!ok)
+            ok = retryFailedOperation(component, operation, &ignoreError);
 
         if (ok || operation->error() > Operation::InvalidArguments) {
             // Remember that the operation was performed, that allows us to undo it if a following operation
@@ -1959,12 +2389,218 @@ void PackageManagerCorePrivate::installComponent(Component *component, double pr
         component->value(scDescription), component->dependencies(), component->forcedInstallation(),
         component->isVirtual(), component->value(scUncompressedSize).toULongLong(),
         component->value(scInheritVersion));
-    packages.writeToDisk();
+    // only append this component to the journal, components.xml is rewritten once at the end
+    packages.writeToJournal();
 
     component->setInstalled();
     component->markAsPerformedInstallation();
 }
 
+static const int scMaxConcurrentOperations = 256;
+
+/*!
+    Returns the operations starting at \a index in \a operations that can be performed at the same
+    time: their paths do not overlap and none of them needs to gain admin rights first. The list
+    ends before the first operation whose side effects are unknown or conflict with an earlier
+    one, so operations on overlapping paths keep their order.
+*/
+OperationList PackageManagerCorePrivate::concurrentOperations(const OperationList &operations,
+    int index, bool adminRightsGained) const
+{
+    OperationList result;
+    OperationResources used;
+    for (int i = index; i < operations.count() && result.count() < scMaxConcurrentOperations; ++i) {
+        Operation *const operation = operations.at(i);
+        if (!adminRightsGained && operation->value(QLatin1String("admin")).toBool())
+            break;
+
+        QStringList resources;
+        if (!operationResources(operation, &resources) || !reserveResources(&used, resources))
+            break;
+        result.append(operation);
+    }
+    return result;
+}
+
+/*!
+    Performs the independent \a operations of \a component at the same time on the global thread
+    pool. Failed operations are retried one by one afterwards, and all operations are recorded as
+    performed in their original order, so they get undone in a deterministic order.
+*/
+void PackageManagerCorePrivate::installOperationsConcurrently(Component *component,
+    const OperationList &operations, double progressOperationSize)
+{
+    foreach (Operation *operation, operations) {
+        connectOperationToInstaller(operation, progressOperationSize);
+        connectOperationCallMethodRequest(operation);
+    }
+
+    performOperationsThreaded(operations, PackageManagerCorePrivate::Backup);
+    const QList<bool> results = performOperationsThreaded(operations);
+
+    QString errorString;
+    for (int i = 0; i < operations.count(); ++i) {
+        Operation *const operation = operations.at(i);
+        bool ok = results.at(i);
+        bool ignoreError = false;
+        if (!ok && errorString.isEmpty())
+            ok = retryFailedOperation(component, operation, &ignoreError);
+
+        // the remaining operations have been performed already, so they need an undo as well
+        if (ok || operation->error() > Operation::InvalidArguments)
+            addPerformed(operation);
+
+        if (!ok && !ignoreError && errorString.isEmpty())
+            errorString = operation->errorString();
+    }
+
+    if (!errorString.isEmpty())
+        throw Error(errorString);
+
+    if (component->value(scEssential, scFalse) == scTrue)
+        m_needsHardRestart = true;
+}
+
+/*!
+    Asks the user how to continue after \a operation of \a component failed and performs it again
+    as long as requested. Returns \c true if the operation finally succeeded; \a ignoreError is set
+    if the user decided to go on regardless.
+*/
+bool PackageManagerCorePrivate::retryFailedOperation(Component *component, Operation *operation,
+    bool *ignoreError)
+{
+    bool ok = false;
+    while (!ok && !*ignoreError && m_core->status() != PackageManagerCore::Canceled) {
+        qDebug() << QString::fromLatin1("Operation '%1' with arguments: '%2' failed: %3")
+            .arg(operation->name(), operation->arguments().join(QLatin1String("; ")),
+            operation->errorString());
+        const QMessageBox::StandardButton button =
+            MessageBoxHandler::warning(MessageBoxHandler::currentBestSuitParent(),
+            QLatin1String("installationErrorWithRetry"), tr("Installer Error"),
+            tr("Error during installation process (%1):\n%2").arg(component->name(),
+            operation->errorString()),
+            QMessageBox::Retry | QMessageBox::Ignore | QMessageBox::Cancel, QMessageBox::Retry);
+
+        if (button == QMessageBox::Retry)
+            ok = performOperationThreaded(operation);
+        else if (button == QMessageBox::Ignore)
+            *ignoreError = true;
+        else if (button == QMessageBox::Cancel)
+            m_core->interrupt();
+    }
+    return ok;
+}
+
+/*!
+    Returns the archives of \a components that need to be downloaded. The first value of each pair
+    is the name the archive gets registered with, the second one the source url.
+*/
+QList<QPair<QString, QString> > PackageManagerCorePrivate::archivesToDownload(
+    const QList<Component *> &components) const
+{
+    QList<QPair<QString, QString> > archives;
+    foreach (Component *component, components) {
+        foreach (const QString &versionFreeString, component->downloadableArchives()) {
+            archives.push_back(qMakePair(QString::fromLatin1("installer://%1/%2")
+                .arg(component->name(), versionFreeString), QString::fromLatin1("%1/%2/%3")
+                .arg(component->repositoryUrl().toString(), component->name(), versionFreeString)));
+        }
+    }
+    return archives;
+}
+
+void PackageManagerCorePrivate::setupArchivesJob(DownloadArchivesJob *job,
+    const QList<QPair<QString, QString> > &archives, double partProgressSize)
+{
+    job->setAutoDelete(false);
+    job->setArchivesToDownload(archives);
+    job->setMaxConcurrentDownloads(m_data.settings().maxConcurrentDownloads());
+    connect(m_core, SIGNAL(installationInterrupted()), job, SLOT(cancel()));
+    connect(job, SIGNAL(outputTextChanged(QString)), ProgressCoordinator::instance(),
+        SLOT(emitLabelAndDetailTextChanged(QString)));
+    connect(job, SIGNAL(downloadStatusChanged(QString)), ProgressCoordinator::instance(),
+        SIGNAL(downloadStatusChanged(QString)));
+
+    ProgressCoordinator::instance()->registerPartProgress(job, SIGNAL(progressChanged(double)),
+        partProgressSize);
+}
+
+/*!
+    Throws if \a job failed or got canceled.
+*/
+void PackageManagerCorePrivate::checkArchivesJob(const DownloadArchivesJob *job)
+{
+    if (job->error() == KDJob::Canceled)
+        m_core->interrupt();
+    else if (job->error() != KDJob::NoError)
+        throw Error(job->errorString());
+
+    if (statusCanceledOrFailed())
+        throw Error(tr("Installation canceled by user"));
+}
+
+/*!
+    Keeps the event loop running until all archives of \a component have been downloaded by
+    \a job. Installation of already present archives goes on in the meantime.
+*/
+void PackageManagerCorePrivate::waitForArchives(DownloadArchivesJob *job, const Component *component)
+{
+    foreach (const QString &versionFreeString, component->downloadableArchives()) {
+        const QString archive = QString::fromLatin1("installer://%1/%2").arg(component->name(),
+            versionFreeString);
+        while (job->error() == KDJob::NoError && job->isArchivePending(archive)
+            && !statusCanceledOrFailed()) {
+            QEventLoop loop;
+            connect(job, SIGNAL(archiveDownloaded(QString)), &loop, SLOT(quit()));
+            connect(job, SIGNAL(finished(KDJob*)), &loop, SLOT(quit()));
+            connect(m_core, SIGNAL(installationInterrupted()), &loop, SLOT(quit()));
+            loop.exec();
+        }
+        checkArchivesJob(job);
+    }
+}
+
+/*!
+    Checks the archives embedded into the installer binary for \a components against their
+    \c .sha1 files before anything gets installed. The archives are hashed in parallel while the
+    event loop keeps running. Throws if an archive cannot be read or is corrupt.
+*/
+void PackageManagerCorePrivate::verifyEmbeddedArchives(const QList<Component *> &components)
+{
+    QHash<QString, QByteArray> expectedHashes;
+    foreach (const Component *component, components) {
+        if (component->isFromOnlineRepository())
+            continue;
+        foreach (const QString &archive, component->archives()) {
+            QFile hashFile(archive + QLatin1String(".sha1"));
+            if (!hashFile.open(QIODevice::ReadOnly))
+                continue;
+            expectedHashes.insert(archive, QByteArray::fromHex(hashFile.readAll().trimmed()));
+        }
+    }
+    if (expectedHashes.isEmpty())
+        return;
+
+    ProgressCoordinator::instance()->emitLabelAndDetailTextChanged(tr("\nVerifying packages..."));
+
+    FileHasher hasher(QCryptographicHash::Sha1);
+    QString errorString;
+    QFutureWatcher<QStringList> futureWatcher;
+    const QFuture<QStringList> future = QtConcurrent::run(&hasher, &FileHasher::verifyFiles,
+        expectedHashes, &errorString);
+
+    QEventLoop loop;
+    loop.connect(&futureWatcher, SIGNAL(finished()), SLOT(quit()), Qt::QueuedConnection);
+    futureWatcher.setFuture(future);
+    if (!future.isFinished())
+        loop.exec();
+
+    qDebug() << "Verified" << hasher.filesHashed() << "archives," << hasher.bytesHashed()
+        << "bytes in" << hasher.elapsed() << "ms (" << hasher.bytesPerSecond() << "bytes/sec).";
+    if (!future.result().isEmpty())
+        throw Error(tr("Verifying the installer archives failed: %1").arg(errorString));
+}
+
 // -- private
 
 void PackageManagerCorePrivate::deleteMaintenanceTool()
@@ -2003,7 +2639,7 @@ void PackageManagerCorePrivate::deleteMaintenanceTool()
     QStringList arguments;
     arguments << QLatin1String("//Nologo") << batchfile; // execute the batchfile
     arguments << QDir::toNativeSeparators(QFileInfo(installerBinaryPath()).absoluteFilePath());
-    if (!m_performedOperationsOld.isEmpty()) {
+    if (!performedOperationsOld().isEmpty()) {
         const Operation *const op = m_performedOperationsOld.first();
         if (op->name() == QLatin1String("Mkdir")) // the target directory name
             arguments << QDir::toNativeSeparators(QFileInfo(op->arguments().first()).absoluteFilePath());
@@ -2082,10 +2718,23 @@ void PackageManagerCorePrivate::runUndoOperations(const OperationList &undoOpera
 {
     KDUpdater::PackagesInfo &packages = *m_updaterApplication.packagesInfo();
     try {
-        foreach (Operation *undoOperation, undoOperations) {
+        for (int i = 0; i < undoOperations.count(); ++i) {
             if (statusCanceledOrFailed())
                 throw Error(tr("Installation canceled by user"));
 
+            // undo operations of a component that only touch their own paths run side by side
+            const OperationList independentOperations = concurrentUndoOperations(undoOperations, i,
+                adminRightsGained);
+            if (independentOperations.count() > 1) {
+                undoOperationsConcurrently(independentOperations, progressSize);
+                if (deleteOperation)
+                    deleteOperations(independentOperations);
+                i += independentOperations.count() - 1;
+                continue;
+            }
+
+            Operation *const undoOperation = undoOperations.at(i);
+
             bool becameAdmin = false;
             if (!adminRightsGained && undoOperation->value(QLatin1String("admin")).toBool())
                 becameAdmin = m_core->gainAdminRights();
@@ -2093,38 +2742,21 @@ void PackageManagerCorePrivate::runUndoOperations(const OperationList &undoOpera
             connectOperationToInstaller(undoOperation, progressSize);
             qDebug() << "undo operation=" << undoOperation->name();
 
-            bool ignoreError = false;
-            bool ok = performOperationThreaded(undoOperation, PackageManagerCorePrivate::Undo);
+            const bool ok = performOperationThreaded(undoOperation, Undo);
 
             const QString componentName = undoOperation->value(QLatin1String("component")).toString();
 
             if (!componentName.isEmpty()) {
-                while (!ok && !ignoreError && m_core->status() != PackageManagerCore::Canceled) {
-                    const QMessageBox::StandardButton button =
-                        MessageBoxHandler::warning(MessageBoxHandler::currentBestSuitParent(),
-                        QLatin1String("installationErrorWithRetry"), tr("Installer Error"),
-                        tr("Error during uninstallation process:\n%1").arg(undoOperation->errorString()),
-                        QMessageBox::Retry | QMessageBox::Ignore, QMessageBox::Retry);
-
-                    if (button == QMessageBox::Retry)
-                        ok = performOperationThreaded(undoOperation, Undo);
-                    else if (button == QMessageBox::Ignore)
-                        ignoreError = true;
-                }
-                Component *component = m_core->componentByName(componentName);
-                if (!component)
-                    component = componentsToReplace().value(componentName).second;
-                if (component) {
-                    component->setUninstalled();
-                    packages.removePackage(component->name());
-                }
+                if (!ok)
+                    retryFailedUndoOperation(undoOperation);
+                setComponentUninstalled(componentName);
             }
 
             if (becameAdmin)
                 m_core->dropAdminRights();
 
             if (deleteOperation)
-                delete undoOperation;
+                deleteOperations(OperationList() << undoOperation);
         }
     } catch (const Error &error) {
         packages.writeToDisk();
@@ -2136,6 +2768,94 @@ void PackageManagerCorePrivate::runUndoOperations(const OperationList &undoOpera
     packages.writeToDisk();
 }
 
+/*!
+    Returns the undo operations starting at \a index in \a operations that can be undone at the
+    same time: they belong to the same component, their undo only restores or removes the paths
+    they were performed on, and these paths do not overlap. Undoing for example a Mkdir, Extract
+    or CopyTree operation removes folders other operations of the list may still be emptying, so
+    such an operation ends the list.
+*/
+OperationList PackageManagerCorePrivate::concurrentUndoOperations(const OperationList &operations,
+    int index, bool adminRightsGained) const
+{
+    static const QStringList independentUndo = QStringList() << QLatin1String("Copy")
+        << QLatin1String("Move") << QLatin1String("Delete") << QLatin1String("MinimumProgress");
+
+    OperationList result;
+    OperationResources used;
+    const QVariant componentName = operations.at(index)->value(QLatin1String("component"));
+    for (int i = index; i < operations.count() && result.count() < scMaxConcurrentOperations; ++i) {
+        Operation *const operation = operations.at(i);
+        if (!independentUndo.contains(operation->name())
+            || operation->value(QLatin1String("component")) != componentName) {
+            break;
+        }
+        if (!adminRightsGained && operation->value(QLatin1String("admin")).toBool())
+            break;
+
+        QStringList resources;
+        if (!operationResources(operation, &resources) || !reserveResources(&used, resources))
+            break;
+        result.append(operation);
+    }
+    return result;
+}
+
+/*!
+    Undoes the independent \a operations of one component at the same time on the global thread
+    pool. Failed undo operations are retried one by one afterwards, then the component is marked
+    as uninstalled.
+*/
+void PackageManagerCorePrivate::undoOperationsConcurrently(const OperationList &operations,
+    double progressSize)
+{
+    foreach (Operation *operation, operations) {
+        connectOperationToInstaller(operation, progressSize);
+        qDebug() << "undo operation=" << operation->name();
+    }
+
+    const QList<bool> results = performOperationsThreaded(operations, Undo);
+
+    const QString componentName = operations.first()->value(QLatin1String("component")).toString();
+    if (componentName.isEmpty())
+        return;
+
+    for (int i = 0; i < operations.count(); ++i) {
+        if (!results.at(i))
+            retryFailedUndoOperation(operations.at(i));
+    }
+    setComponentUninstalled(componentName);
+}
+
+void PackageManagerCorePrivate::retryFailedUndoOperation(Operation *operation)
+{
+    bool ok = false;
+    bool ignoreError = false;
+    while (!ok && !ignoreError && m_core->status() != PackageManagerCore::Canceled) {
+        const QMessageBox::StandardButton button =
+            MessageBoxHandler::warning(MessageBoxHandler::currentBestSuitParent(),
+            QLatin1String("installationErrorWithRetry"), tr("Installer Error"),
+            tr("Error during uninstallation process:\n%1").arg(operation->errorString()),
+            QMessageBox::Retry | QMessageBox::Ignore, QMessageBox::Retry);
+
+        if (button == QMessageBox::Retry)
+            ok = performOperationThreaded(operation, Undo);
+        else if (button == QMessageBox::Ignore)
+            ignoreError = true;
+    }
+}
+
+void PackageManagerCorePrivate::setComponentUninstalled(const QString &componentName)
+{
+    Component *component = m_core->componentByName(componentName);
+    if (!component)
+        component = componentsToReplace().value(componentName).second;
+    if (component) {
+        component->setUninstalled();
+        m_updaterApplication.packagesInfo()->removePackage(component->name());
+    }
+}
+
 PackagesList PackageManagerCorePrivate::remotePackages()
 {
     if (m_updates && m_updateFinder)
@@ -2254,30 +2974,17 @@ bool PackageManagerCorePrivate::addUpdateResourcesFromRepositories(bool parseChe
             continue;
 
         if (parseChecksum) {
-            const QString updatesXmlPath = data.directory + QLatin1String("/Updates.xml");
-            QFile updatesFile(updatesXmlPath);
-            try {
-                QInstaller::openForRead(&updatesFile);
-            } catch(const Error &e) {
-                qDebug() << "Error opening Updates.xml:" << e.message();
-                setStatus(PackageManagerCore::Failure, tr("Could not add temporary update source information."));
-                return false;
+            const KDUpdater::UpdatesInfo updatesInfo =
+                KDUpdater::UpdatesInfo::fromFile(data.directory + QLatin1String("/Updates.xml"));
+            if (updatesInfo.error() != KDUpdater::UpdatesInfo::NoError
+                && updatesInfo.error() != KDUpdater::UpdatesInfo::InvalidContentError) {
+                    qDebug() << "Error reading Updates.xml:" << updatesInfo.errorString();
+                    setStatus(PackageManagerCore::Failure, tr("Could not add temporary update source information."));
+                    return false;
             }
 
-            int line = 0;
-            int column = 0;
-            QString error;
-            QDomDocument doc;
-            if (!doc.setContent(&updatesFile, &error, &line, &column)) {
-                qDebug() << QString::fromLatin1("Parse error in file %4: %1 at line %2 col %3").arg(error,
-                    QString::number(line), QString::number(column), updatesFile.fileName());
-                setStatus(PackageManagerCore::Failure, tr("Could not add temporary update source information."));
-                return false;
-            }
-
-            const QDomNode checksum = doc.documentElement().firstChildElement(QLatin1String("Checksum"));
-            if (!checksum.isNull())
-                m_core->setTestChecksum(checksum.toElement().text().toLower() == scTrue);
+            if (updatesInfo.hasChecksum())
+                m_core->setTestChecksum(updatesInfo.checksum());
         }
         m_updaterApplication.addUpdateSource(appName, appName, QString(),
             QUrl::fromLocalFile(data.directory), 1);
@@ -2338,12 +3045,8 @@ OperationList PackageManagerCorePrivate::sortOperationsBasedOnComponentDependenc
         const QString componentName = operation->value(QLatin1String("component")).toString();
         if (componentName.isEmpty())
             sortedOperations.append(operation);
-        else {
-            OperationList componentOperationList = componentOperationHash.value(componentName);
-            componentOperationList.append(operation);
-            componentOperationHash.insert(operation->value(QLatin1String("component")).toString(),
-                componentOperationList);
-        }
+        else
+            componentOperationHash[componentName].append(operation);
     }
 
     const QString empty;
@@ -2356,8 +3059,8 @@ OperationList PackageManagerCorePrivate::sortOperationsBasedOnComponentDependenc
 
     const QStringList resolvedComponents = componentGraph.sort();
     if (componentGraph.hasCycle()) {
-        throw Error(tr("Dependency cycle between components detected: '%1' and '%2'.")
-            .arg(componentGraph.cycle().first, componentGraph.cycle().second));
+        throw Error(tr("Dependency cycle between components detected: '%1'.")
+            .arg(QStringList(componentGraph.cyclePath()).join(QLatin1String("' -> '"))));
     }
     foreach (const QString &componentName, resolvedComponents)
         sortedOperations.append(componentOperationHash.value(componentName));
@@ -2372,4 +3075,15 @@ void PackageManagerCorePrivate::handleMethodInvocationRequest(const QString &inv
         QMetaObject::invokeMethod(obj, qPrintable(invokableMethodName));
 }
 
+void PackageManagerCorePrivate::componentValueChanged(const QString &key)
+{
+    if (key != scName && key != scDependencies)
+        return;
+
+    if (Component *component = qobject_cast<Component *>(QObject::sender())) {
+        m_componentIndex.update(component);
+        m_updaterComponentIndex.update(component);
+    }
+}
+
 } // namespace QInstaller
@@ -35,7 +35,9 @@
 #ifndef PACKAGEMANAGERCORE_P_H
 #define PACKAGEMANAGERCORE_P_H
 
+#include "componentindex.h"
 #include "metadatajob.h"
+#include "operationlog.h"
 #include "packagemanagercore.h"
 #include "packagemanagercoredata.h"
 #include "packagemanagerproxyfactory.h"
@@ -46,6 +48,7 @@
 #include "kdupdaterupdatefinder.h"
 
 #include <QObject>
+#include <QSet>
 
 class KDJob;
 
@@ -59,6 +62,7 @@ namespace QInstaller {
 
 struct BinaryLayout;
 class Component;
+class DownloadArchivesJob;
 class ScriptEngine;
 class ComponentModel;
 class TempDirDeleter;
@@ -109,6 +113,8 @@ public:
 
     static bool performOperationThreaded(Operation *op, PackageManagerCorePrivate::OperationType type
         = PackageManagerCorePrivate::Perform);
+    static QList<bool> performOperationsThreaded(const OperationList &operations,
+        PackageManagerCorePrivate::OperationType type = PackageManagerCorePrivate::Perform);
 
     void initialize(const QHash<QString, QString> &params);
     bool isOfflineOnly() const;
@@ -141,6 +147,10 @@ public:
     QList<Component*> &replacementDependencyComponents();
     QHash<QString, QPair<Component*, Component*> > &componentsToReplace();
 
+    ComponentIndex &componentIndex();
+    const ComponentIndex &componentIndex() const;
+    void indexComponent(Component *component, ComponentIndex &index, bool replacement = false);
+
     void clearInstallerCalculator();
     InstallerCalculator *installerCalculator() const;
 
@@ -181,13 +191,28 @@ public:
         m_performedOperationsCurrentSession.append(op);
     }
 
+    OperationList &performedOperationsOld();
+    QSet<QString> performedOperationsComponents();
+
     void commitSessionOperations() {
-        m_performedOperationsOld += m_performedOperationsCurrentSession;
+        performedOperationsOld() += m_performedOperationsCurrentSession;
         m_performedOperationsCurrentSession.clear();
     }
 
     void installComponent(Component *component, double progressOperationSize,
         bool adminRightsGained = false);
+    OperationList concurrentOperations(const OperationList &operations, int index,
+        bool adminRightsGained) const;
+    void installOperationsConcurrently(Component *component, const OperationList &operations,
+        double progressOperationSize);
+    bool retryFailedOperation(Component *component, Operation *operation, bool *ignoreError);
+
+    QList<QPair<QString, QString> > archivesToDownload(const QList<Component *> &components) const;
+    void setupArchivesJob(DownloadArchivesJob *job, const QList<QPair<QString, QString> > &archives,
+        double partProgressSize);
+    void checkArchivesJob(const DownloadArchivesJob *job);
+    void waitForArchives(DownloadArchivesJob *job, const Component *component);
+    void verifyEmbeddedArchives(const QList<Component *> &components);
 
 signals:
     void installationStarted();
@@ -218,8 +243,13 @@ public:
     QList<QInstaller::Component*> m_updaterComponentsDeps;
     QList<QInstaller::Component*> m_updaterDependencyReplacements;
 
+    // name and reverse dependency lookup, one index per component list
+    ComponentIndex m_componentIndex;
+    ComponentIndex m_updaterComponentIndex;
+
     OperationList m_ownedOperations;
     OperationList m_performedOperationsOld;
+    QList<OperationBlob> m_performedOperationBlobs; // restored by performedOperationsOld()
     OperationList m_performedOperationsCurrentSession;
 
     bool m_dependsOnLocalInstallerBinary;
@@ -233,6 +263,7 @@ private slots:
     }
 
     void handleMethodInvocationRequest(const QString &invokableMethodName);
+    void componentValueChanged(const QString &key);
 
 private:
     void deleteMaintenanceTool();
@@ -242,9 +273,17 @@ private:
     void writeMaintenanceToolBinary(QFile *const input, qint64 size, bool writeBinaryLayout);
     void writeMaintenanceToolBinaryData(QFileDevice *output, QFile *const input,
         const OperationList &performed, const BinaryLayout &layout);
+    bool appendMaintenanceToolOperations(const QString &dataFile, const OperationList &performed);
+    void setOperationLogChain(const OperationLog::Chain &chain, const OperationList &operations);
+    void deleteOperations(const OperationList &operations);
 
     void runUndoOperations(const OperationList &undoOperations, double undoOperationProgressSize,
         bool adminRightsGained, bool deleteOperation);
+    OperationList concurrentUndoOperations(const OperationList &operations, int index,
+        bool adminRightsGained) const;
+    void undoOperationsConcurrently(const OperationList &operations, double progressSize);
+    void retryFailedUndoOperation(Operation *operation);
+    void setComponentUninstalled(const QString &componentName);
 
     PackagesList remotePackages();
     LocalPackagesHash localInstalledPackages();
@@ -278,6 +317,10 @@ private:
     QObject *m_guiObject;
     QScopedPointer<RemoteFileEngineHandler> m_remoteFileEngineHandler;
 
+    // the operation log last read or written, and the index of each operation in it
+    OperationLog::Chain m_operationLogChain;
+    QHash<const Operation *, int> m_operationLogPositions;
+
 private:
     // remove once we deprecate isSelected, setSelected etc...
     void restoreCheckState();
@@ -94,6 +94,8 @@ bool ProductKeyCheck::isValidRepository(const QInstaller::Repository &repository
 
 void ProductKeyCheck::addPackagesFromXml(const QString &xmlPath)
 {
+    // Use KDUpdater::UpdatesInfo::fromFile(xmlPath) to get the package list, the file has already
+    // been parsed by the metadata job and is not read again.
     Q_UNUSED(xmlPath)
 }
 
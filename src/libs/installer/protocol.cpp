@@ -44,18 +44,17 @@ typedef qint32 PackageSize;
 
     \note Both client and server need to have the same endianness.
  */
-void sendPacket(QIODevice *device, const QByteArray &command, const QByteArray &data)
+void sendPacket(QIODevice *device, quint16 command, const QByteArray &data)
 {
-    // use aliasing for writing payload size into bytes
-    char payloadBytes[sizeof(PackageSize)];
-    PackageSize *payloadSize = reinterpret_cast<PackageSize*>(&payloadBytes);
-    *payloadSize = command.size() + sizeof(char) + data.size();
+    // use aliasing for writing payload size and command into bytes
+    char headerBytes[sizeof(PackageSize) + sizeof(quint16)];
+    PackageSize *payloadSize = reinterpret_cast<PackageSize*>(&headerBytes);
+    *payloadSize = sizeof(quint16) + data.size();
+    memcpy(headerBytes + sizeof(PackageSize), &command, sizeof(quint16));
 
     QByteArray packet;
     packet.reserve(sizeof(PackageSize) + *payloadSize);
-    packet.append(payloadBytes, sizeof(PackageSize));
-    packet.append(command);
-    packet.append('\0');
+    packet.append(headerBytes, sizeof(headerBytes));
     packet.append(data);
 
     forever {
@@ -74,7 +73,7 @@ void sendPacket(QIODevice *device, const QByteArray &command, const QByteArray &
 
     \note Both client and server need to have the same endianness.
  */
-bool receivePacket(QIODevice *device, QByteArray *command, QByteArray *data)
+bool receivePacket(QIODevice *device, quint16 *command, QByteArray *data)
 {
     if (device->bytesAvailable() < static_cast<qint64>(sizeof(PackageSize)))
         return false;
@@ -92,10 +91,11 @@ bool receivePacket(QIODevice *device, QByteArray *command, QByteArray *data)
     }
 
     const QByteArray payload = device->read(*payloadSize);
-    int separator = payload.indexOf('\0');
+    if (payload.size() < static_cast<int>(sizeof(quint16)))
+        return false;
 
-    *command = payload.left(separator);
-    *data = payload.right(payload.size() - separator - 1);
+    memcpy(command, payload.constData(), sizeof(quint16));
+    *data = payload.mid(sizeof(quint16));
     return true;
 }
 
@@ -57,41 +57,145 @@ enum struct StartAs {
 const char DefaultSocket[] = "ifw_srv";
 const char DefaultAuthorizationKey[] = "DefaultAuthorizationKey";
 
-const char Create[] = "Create";
-const char Destroy[] = "Destroy";
-const char Shutdown[] = "Shutdown";
-const char Authorize[] = "Authorize";
-const char Reply[] = "Reply";
+// Increase whenever the packet layout or the numbering of the commands below changes,
+// client and server refuse to talk to each other if their versions differ.
+const quint32 Version = 4;
+
+// The high byte of a command selects the handler on the server side.
+enum CommandGroup {
+    ConnectionCommands,
+    QProcessCommands,
+    QSettingsCommands,
+    QAbstractFileEngineCommands,
+    FileOperationsCommands
+};
+
+enum Command : quint16 {
+    Create = (ConnectionCommands << 8) + 1,
+    Destroy,
+    Shutdown,
+    Authorize,
+    Reply,
+    Batch,
+    Progress,
+    Cancel,
+    Ping,
+
+    // QProcessWrapper
+    QProcessCloseWriteChannel = QProcessCommands << 8,
+    QProcessExitCode,
+    QProcessExitStatus,
+    QProcessKill,
+    QProcessReadAll,
+    QProcessReadAllStandardOutput,
+    QProcessReadAllStandardError,
+    QProcessStartDetached,
+    QProcessSetWorkingDirectory,
+    QProcessSetEnvironment,
+    QProcessEnvironment,
+    QProcessStart3Arg,
+    QProcessStart2Arg,
+    QProcessState,
+    QProcessTerminate,
+    QProcessWaitForFinished,
+    QProcessWaitForStarted,
+    QProcessWorkingDirectory,
+    QProcessErrorString,
+    QProcessReadChannel,
+    QProcessSetReadChannel,
+    QProcessWrite,
+    QProcessProcessChannelMode,
+    QProcessSetProcessChannelMode,
+    QProcessSetNativeArguments,
+    GetQProcessSignals,
+
+    // QSettingsWrapper
+    QSettingsAllKeys = QSettingsCommands << 8,
+    QSettingsBeginGroup,
+    QSettingsBeginWriteArray,
+    QSettingsBeginReadArray,
+    QSettingsChildGroups,
+    QSettingsChildKeys,
+    QSettingsClear,
+    QSettingsContains,
+    QSettingsEndArray,
+    QSettingsEndGroup,
+    QSettingsFallbacksEnabled,
+    QSettingsFileName,
+    QSettingsGroup,
+    QSettingsIsWritable,
+    QSettingsRemove,
+    QSettingsSetArrayIndex,
+    QSettingsSetFallbacksEnabled,
+    QSettingsStatus,
+    QSettingsSync,
+    QSettingsSetValue,
+    QSettingsValue,
+    QSettingsOrganizationName,
+    QSettingsApplicationName,
+
+    // RemoteFileEngine
+    QAbstractFileEngineAtEnd = QAbstractFileEngineCommands << 8,
+    QAbstractFileEngineCaseSensitive,
+    QAbstractFileEngineClose,
+    QAbstractFileEngineCopy,
+    QAbstractFileEngineEntryList,
+    QAbstractFileEngineError,
+    QAbstractFileEngineErrorString,
+    QAbstractFileEngineFileFlags,
+    QAbstractFileEngineFileName,
+    QAbstractFileEngineFlush,
+    QAbstractFileEngineHandle,
+    QAbstractFileEngineIsRelativePath,
+    QAbstractFileEngineIsSequential,
+    QAbstractFileEngineLink,
+    QAbstractFileEngineMkdir,
+    QAbstractFileEngineOpen,
+    QAbstractFileEngineOwner,
+    QAbstractFileEngineOwnerId,
+    QAbstractFileEnginePos,
+    QAbstractFileEngineRead,
+    QAbstractFileEngineReadLine,
+    QAbstractFileEngineRemove,
+    QAbstractFileEngineRename,
+    QAbstractFileEngineRmdir,
+    QAbstractFileEngineSeek,
+    QAbstractFileEngineSetFileName,
+    QAbstractFileEngineSetPermissions,
+    QAbstractFileEngineSetSize,
+    QAbstractFileEngineSize,
+    QAbstractFileEngineSupportsExtension,
+    QAbstractFileEngineExtension,
+    QAbstractFileEngineWrite,
+    QAbstractFileEngineSyncToDisk,
+    QAbstractFileEngineRenameOverwrite,
+    QAbstractFileEngineFileTime,
+
+    // RemoteFileOperations
+    FileOperationsCopyFile = FileOperationsCommands << 8,
+    FileOperationsCopyTree,
+    FileOperationsExtractArchive,
+    FileOperationsSetPermissionsRecursively,
+    FileOperationsRemoveTree
+};
+
+inline int commandGroup(quint16 command)
+{
+    return command >> 8;
+}
+
+// Void calls of these commands may be deferred by the client and sent in a Batch packet
+// together with the next call that is not deferred, or before control returns to the event loop.
+inline bool isDeferrable(quint16 command)
+{
+    if (command == QSettingsSync)
+        return false;
+    const int group = commandGroup(command);
+    return group == QSettingsCommands || group == QAbstractFileEngineCommands;
+}
 
 // QProcessWrapper
 const char QProcess[] = "QProcess";
-const char QProcessCloseWriteChannel[] = "QProcess::closeWriteChannel";
-const char QProcessExitCode[] = "QProcess::exitCode";
-const char QProcessExitStatus[] = "QProcess::exitStatus";
-const char QProcessKill[] = "QProcess::kill";
-const char QProcessReadAll[] = "QProcess::readAll";
-const char QProcessReadAllStandardOutput[] = "QProcess::readAllStandardOutput";
-const char QProcessReadAllStandardError[] = "QProcess::readAllStandardError";
-const char QProcessStartDetached[] = "QProcess::startDetached";
-const char QProcessSetWorkingDirectory[] = "QProcess::setWorkingDirectory";
-const char QProcessSetEnvironment[] = "QProcess::setEnvironment";
-const char QProcessEnvironment[] = "QProcess::environment";
-const char QProcessStart3Arg[] = "QProcess::start3";
-const char QProcessStart2Arg[] = "QProcess::start2";
-const char QProcessState[] = "QProcess::state";
-const char QProcessTerminate[] = "QProcess::terminate";
-const char QProcessWaitForFinished[] = "QProcess::waitForFinished";
-const char QProcessWaitForStarted[] = "QProcess::waitForStarted";
-const char QProcessWorkingDirectory[] = "QProcess::workingDirectory";
-const char QProcessErrorString[] = "QProcess::errorString";
-const char QProcessReadChannel[] = "QProcess::readChannel";
-const char QProcessSetReadChannel[] = "QProcess::setReadChannel";
-const char QProcessWrite[] = "QProcess::write";
-const char QProcessProcessChannelMode[] = "QProcess::processChannelMode";
-const char QProcessSetProcessChannelMode[] = "QProcess::setProcessChannelMode";
-const char QProcessSetNativeArguments[] = "QProcess::setNativeArguments";
-
-const char GetQProcessSignals[] = "GetQProcessSignals";
 const char QProcessSignalBytesWritten[] = "QProcess::bytesWritten";
 const char QProcessSignalAboutToClose[] = "QProcess::aboutToClose";
 const char QProcessSignalReadChannelFinished[] = "QProcess::readChannelFinished";
@@ -103,76 +207,19 @@ const char QProcessSignalReadyRead[] = "QProcess::readyRead";
 const char QProcessSignalStateChanged[] = "QProcess::stateChanged";
 const char QProcessSignalFinished[] = "QProcess::finished";
 
-
 // QSettingsWrapper
 const char QSettings[] = "QSettings";
-const char QSettingsAllKeys[] = "QSettings::allKeys";
-const char QSettingsBeginGroup[] = "QSettings::beginGroup";
-const char QSettingsBeginWriteArray[] = "QSettings::beginWriteArray";
-const char QSettingsBeginReadArray[] = "QSettings::beginReadArray";
-const char QSettingsChildGroups[] = "QSettings::childGroups";
-const char QSettingsChildKeys[] = "QSettings::childKeys";
-const char QSettingsClear[] = "QSettings::clear";
-const char QSettingsContains[] = "QSettings::contains";
-const char QSettingsEndArray[] = "QSettings::endArray";
-const char QSettingsEndGroup[] = "QSettings::endGroup";
-const char QSettingsFallbacksEnabled[] = "QSettings::fallbacksEnabled";
-const char QSettingsFileName[] = "QSettings::fileName";
-const char QSettingsGroup[] = "QSettings::group";
-const char QSettingsIsWritable[] = "QSettings::isWritable";
-const char QSettingsRemove[] = "QSettings::remove";
-const char QSettingsSetArrayIndex[] = "QSettings::setArrayIndex";
-const char QSettingsSetFallbacksEnabled[] = "QSettings::setFallbacksEnabled";
-const char QSettingsStatus[] = "QSettings::status";
-const char QSettingsSync[] = "QSettings::sync";
-const char QSettingsSetValue[] = "QSettings::setValue";
-const char QSettingsValue[] = "QSettings::value";
-const char QSettingsOrganizationName[] = "QSettings::organizationName";
-const char QSettingsApplicationName[] = "QSettings::applicationName";
-
 
 // RemoteFileEngine
 const char QAbstractFileEngine[] = "QAbstractFileEngine";
-const char QAbstractFileEngineAtEnd[] = "QAbstractFileEngine::atEnd";
-const char QAbstractFileEngineCaseSensitive[] = "QAbstractFileEngine::caseSensitive";
-const char QAbstractFileEngineClose[] = "QAbstractFileEngine::close";
-const char QAbstractFileEngineCopy[] = "QAbstractFileEngine::copy";
-const char QAbstractFileEngineEntryList[] = "QAbstractFileEngine::entryList";
-const char QAbstractFileEngineError[] = "QAbstractFileEngine::error";
-const char QAbstractFileEngineErrorString[] = "QAbstractFileEngine::errorString";
-const char QAbstractFileEngineFileFlags[] = "QAbstractFileEngine::fileFlags";
-const char QAbstractFileEngineFileName[] = "QAbstractFileEngine::fileName";
-const char QAbstractFileEngineFlush[] = "QAbstractFileEngine::flush";
-const char QAbstractFileEngineHandle[] = "QAbstractFileEngine::handle";
-const char QAbstractFileEngineIsRelativePath[] = "QAbstractFileEngine::isRelativePath";
-const char QAbstractFileEngineIsSequential[] = "QAbstractFileEngine::isSequential";
-const char QAbstractFileEngineLink[] = "QAbstractFileEngine::link";
-const char QAbstractFileEngineMkdir[] = "QAbstractFileEngine::mkdir";
-const char QAbstractFileEngineOpen[] = "QAbstractFileEngine::open";
-const char QAbstractFileEngineOwner[] = "QAbstractFileEngine::owner";
-const char QAbstractFileEngineOwnerId[] = "QAbstractFileEngine::ownerId";
-const char QAbstractFileEnginePos[] = "QAbstractFileEngine::pos";
-const char QAbstractFileEngineRead[] = "QAbstractFileEngine::read";
-const char QAbstractFileEngineReadLine[] = "QAbstractFileEngine::readLine";
-const char QAbstractFileEngineRemove[] = "QAbstractFileEngine::remove";
-const char QAbstractFileEngineRename[] = "QAbstractFileEngine::rename";
-const char QAbstractFileEngineRmdir[] = "QAbstractFileEngine::rmdir";
-const char QAbstractFileEngineSeek[] = "QAbstractFileEngine::seek";
-const char QAbstractFileEngineSetFileName[] = "QAbstractFileEngine::setFileName";
-const char QAbstractFileEngineSetPermissions[] = "QAbstractFileEngine::setPermissions";
-const char QAbstractFileEngineSetSize[] = "QAbstractFileEngine::setSize";
-const char QAbstractFileEngineSize[] = "QAbstractFileEngine::size";
-const char QAbstractFileEngineSupportsExtension[] = "QAbstractFileEngine::supportsExtension";
-const char QAbstractFileEngineExtension[] = "QAbstractFileEngine::extension";
-const char QAbstractFileEngineWrite[] = "QAbstractFileEngine::write";
-const char QAbstractFileEngineSyncToDisk[] = "QAbstractFileEngine::syncToDisk";
-const char QAbstractFileEngineRenameOverwrite[] = "QAbstractFileEngine::renameOverwrite";
-const char QAbstractFileEngineFileTime[] = "QAbstractFileEngine::fileTime";
+
+// RemoteFileOperations
+const char FileOperations[] = "FileOperations";
 
 } // namespace Protocol
 
-void INSTALLER_EXPORT sendPacket(QIODevice *device, const QByteArray &command, const QByteArray &data);
-bool INSTALLER_EXPORT receivePacket(QIODevice *device, QByteArray *command, QByteArray *data);
+void INSTALLER_EXPORT sendPacket(QIODevice *device, quint16 command, const QByteArray &data);
+bool INSTALLER_EXPORT receivePacket(QIODevice *device, quint16 *command, QByteArray *data);
 
 } // namespace QInstaller
 
@@ -79,7 +79,7 @@ void QProcessWrapper::processSignals()
         return;
 
     QList<QVariant> receivedSignals =
-        callRemoteMethod<QList<QVariant> >(QString::fromLatin1(Protocol::GetQProcessSignals));
+        callRemoteMethod<QList<QVariant> >(Protocol::GetQProcessSignals);
 
     while (!receivedSignals.isEmpty()) {
         const QString name = receivedSignals.takeFirst().toString();
@@ -117,7 +117,7 @@ bool QProcessWrapper::startDetached(const QString &program, const QStringList &a
     QProcessWrapper w;
     if (w.connectToServer()) {
         const QPair<bool, qint64> result =
-            w.callRemoteMethod<QPair<bool, qint64> >(QLatin1String(Protocol::QProcessStartDetached),
+            w.callRemoteMethod<QPair<bool, qint64> >(Protocol::QProcessStartDetached,
                 program, arguments, workingDirectory);
         if (pid != 0)
             *pid = result.second;
@@ -141,7 +141,7 @@ void QProcessWrapper::setProcessChannelMode(QProcessWrapper::ProcessChannelMode
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessSetProcessChannelMode),
+        callRemoteMethod(Protocol::QProcessSetProcessChannelMode,
             static_cast<QProcess::ProcessChannelMode>(mode), dummy);
         m_lock.unlock();
     } else {
@@ -166,7 +166,7 @@ void QProcessWrapper::setReadChannel(QProcessWrapper::ProcessChannel chan)
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessSetReadChannel),
+        callRemoteMethod(Protocol::QProcessSetReadChannel,
             static_cast<QProcess::ProcessChannel>(chan), dummy);
         m_lock.unlock();
     } else {
@@ -178,7 +178,7 @@ bool QProcessWrapper::waitForFinished(int msecs)
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        const bool value = callRemoteMethod<bool>(QLatin1String(Protocol::QProcessWaitForFinished),
+        const bool value = callRemoteMethod<bool>(Protocol::QProcessWaitForFinished,
             qint32(msecs));
         m_lock.unlock();
         return value;
@@ -190,7 +190,7 @@ bool QProcessWrapper::waitForStarted(int msecs)
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        const bool value = callRemoteMethod<bool>(QLatin1String(Protocol::QProcessWaitForStarted),
+        const bool value = callRemoteMethod<bool>(Protocol::QProcessWaitForStarted,
             qint32(msecs));
         m_lock.unlock();
         return value;
@@ -202,7 +202,7 @@ qint64 QProcessWrapper::write(const QByteArray &data)
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        const qint64 value = callRemoteMethod<qint64>(QLatin1String(Protocol::QProcessWrite), data);
+        const qint64 value = callRemoteMethod<qint64>(Protocol::QProcessWrite, data);
         m_lock.unlock();
         return value;
     }
@@ -213,7 +213,7 @@ void QProcessWrapper::closeWriteChannel()
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessCloseWriteChannel));
+        callRemoteMethod(Protocol::QProcessCloseWriteChannel);
         m_lock.unlock();
     } else {
         process.closeWriteChannel();
@@ -224,7 +224,7 @@ int QProcessWrapper::exitCode() const
 {
     if ((const_cast<QProcessWrapper *>(this))->connectToServer()) {
         m_lock.lockForWrite();
-        const int value = callRemoteMethod<qint32>(QLatin1String(Protocol::QProcessExitCode));
+        const int value = callRemoteMethod<qint32>(Protocol::QProcessExitCode);
         m_lock.unlock();
         return value;
     }
@@ -235,7 +235,7 @@ QProcessWrapper::ExitStatus QProcessWrapper::exitStatus() const
 {
     if ((const_cast<QProcessWrapper *>(this))->connectToServer()) {
         m_lock.lockForWrite();
-        const int status = callRemoteMethod<qint32>(QLatin1String(Protocol::QProcessExitStatus));
+        const int status = callRemoteMethod<qint32>(Protocol::QProcessExitStatus);
         m_lock.unlock();
         return static_cast<QProcessWrapper::ExitStatus>(status);
     }
@@ -246,7 +246,7 @@ void QProcessWrapper::kill()
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessKill));
+        callRemoteMethod(Protocol::QProcessKill);
         m_lock.unlock();
     } else {
         process.kill();
@@ -257,7 +257,7 @@ QByteArray QProcessWrapper::readAll()
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        const QByteArray ba = callRemoteMethod<QByteArray>(QLatin1String(Protocol::QProcessReadAll));
+        const QByteArray ba = callRemoteMethod<QByteArray>(Protocol::QProcessReadAll);
         m_lock.unlock();
         return ba;
     }
@@ -269,7 +269,7 @@ QByteArray QProcessWrapper::readAllStandardOutput()
     if (connectToServer()) {
         m_lock.lockForWrite();
         const QByteArray ba =
-            callRemoteMethod<QByteArray>(QLatin1String(Protocol::QProcessReadAllStandardOutput));
+            callRemoteMethod<QByteArray>(Protocol::QProcessReadAllStandardOutput);
         m_lock.unlock();
         return ba;
     }
@@ -281,7 +281,7 @@ QByteArray QProcessWrapper::readAllStandardError()
     if (connectToServer()) {
         m_lock.lockForWrite();
         const QByteArray ba =
-            callRemoteMethod<QByteArray>(QLatin1String(Protocol::QProcessReadAllStandardError));
+            callRemoteMethod<QByteArray>(Protocol::QProcessReadAllStandardError);
         m_lock.unlock();
         return ba;
     }
@@ -293,7 +293,7 @@ void QProcessWrapper::start(const QString &param1, const QStringList &param2,
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessStart3Arg), param1, param2, param3);
+        callRemoteMethod(Protocol::QProcessStart3Arg, param1, param2, param3);
         m_lock.unlock();
     } else {
         process.start(param1, param2, param3);
@@ -304,7 +304,7 @@ void QProcessWrapper::start(const QString &param1, QIODevice::OpenMode param2)
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessStart2Arg), param1, param2);
+        callRemoteMethod(Protocol::QProcessStart2Arg, param1, param2);
         m_lock.unlock();
     } else {
         process.start(param1, param2);
@@ -315,7 +315,7 @@ QProcessWrapper::ProcessState QProcessWrapper::state() const
 {
     if ((const_cast<QProcessWrapper *>(this))->connectToServer()) {
         m_lock.lockForWrite();
-        const int state = callRemoteMethod<qint32>(QLatin1String(Protocol::QProcessState));
+        const int state = callRemoteMethod<qint32>(Protocol::QProcessState);
         m_lock.unlock();
         return static_cast<QProcessWrapper::ProcessState>(state);
     }
@@ -326,7 +326,7 @@ void QProcessWrapper::terminate()
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessTerminate));
+        callRemoteMethod(Protocol::QProcessTerminate);
         m_lock.unlock();
     } else {
         process.terminate();
@@ -337,7 +337,7 @@ QProcessWrapper::ProcessChannel QProcessWrapper::readChannel() const
 {
     if ((const_cast<QProcessWrapper *>(this))->connectToServer()) {
         m_lock.lockForWrite();
-        const int channel = callRemoteMethod<qint32>(QLatin1String(Protocol::QProcessReadChannel));
+        const int channel = callRemoteMethod<qint32>(Protocol::QProcessReadChannel);
         m_lock.unlock();
         return static_cast<QProcessWrapper::ProcessChannel>(channel);
     }
@@ -348,7 +348,7 @@ QProcessWrapper::ProcessChannelMode QProcessWrapper::processChannelMode() const
 {
     if ((const_cast<QProcessWrapper *>(this))->connectToServer()) {
         m_lock.lockForWrite();
-        const int mode = callRemoteMethod<qint32>(QLatin1String(Protocol::QProcessProcessChannelMode));
+        const int mode = callRemoteMethod<qint32>(Protocol::QProcessProcessChannelMode);
         m_lock.unlock();
         return static_cast<QProcessWrapper::ProcessChannelMode>(mode);
     }
@@ -359,7 +359,7 @@ QString QProcessWrapper::workingDirectory() const
 {
     if ((const_cast<QProcessWrapper *>(this))->connectToServer()) {
         m_lock.lockForWrite();
-        const QString dir = callRemoteMethod<QString>(QLatin1String(Protocol::QProcessWorkingDirectory));
+        const QString dir = callRemoteMethod<QString>(Protocol::QProcessWorkingDirectory);
         m_lock.unlock();
         return dir;
     }
@@ -370,7 +370,7 @@ QString QProcessWrapper::errorString() const
 {
     if ((const_cast<QProcessWrapper *>(this))->connectToServer()) {
         m_lock.lockForWrite();
-        const QString error = callRemoteMethod<QString>(QLatin1String(Protocol::QProcessErrorString));
+        const QString error = callRemoteMethod<QString>(Protocol::QProcessErrorString);
         m_lock.unlock();
         return error;
     }
@@ -382,7 +382,7 @@ QStringList QProcessWrapper::environment() const
     if ((const_cast<QProcessWrapper *>(this))->connectToServer()) {
         m_lock.lockForWrite();
         const QStringList env =
-            callRemoteMethod<QStringList>(QLatin1String(Protocol::QProcessEnvironment));
+            callRemoteMethod<QStringList>(Protocol::QProcessEnvironment);
         m_lock.unlock();
         return env;
     }
@@ -393,7 +393,7 @@ void QProcessWrapper::setEnvironment(const QStringList &param1)
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessSetEnvironment), param1, dummy);
+        callRemoteMethod(Protocol::QProcessSetEnvironment, param1, dummy);
         m_lock.unlock();
     } else {
         process.setEnvironment(param1);
@@ -405,7 +405,7 @@ void QProcessWrapper::setNativeArguments(const QString &param1)
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessSetNativeArguments), param1, dummy);
+        callRemoteMethod(Protocol::QProcessSetNativeArguments, param1, dummy);
         m_lock.unlock();
     } else {
         process.setNativeArguments(param1);
@@ -417,7 +417,7 @@ void QProcessWrapper::setWorkingDirectory(const QString &param1)
 {
     if (connectToServer()) {
         m_lock.lockForWrite();
-        callRemoteMethod(QLatin1String(Protocol::QProcessSetWorkingDirectory), param1, dummy);
+        callRemoteMethod(Protocol::QProcessSetWorkingDirectory, param1, dummy);
         m_lock.unlock();
     } else {
         process.setWorkingDirectory(param1);
@@ -131,21 +131,21 @@ QSettingsWrapper::~QSettingsWrapper()
 QStringList QSettingsWrapper::allKeys() const
 {
     if (createSocket())
-        return callRemoteMethod<QStringList>(QLatin1String(Protocol::QSettingsAllKeys));
+        return callRemoteMethod<QStringList>(Protocol::QSettingsAllKeys);
     return d->settings.allKeys();
 }
 
 QString QSettingsWrapper::applicationName() const
 {
     if (createSocket())
-        return callRemoteMethod<QString>(QLatin1String(Protocol::QSettingsApplicationName));
+        return callRemoteMethod<QString>(Protocol::QSettingsApplicationName);
     return d->settings.applicationName();
 }
 
 void QSettingsWrapper::beginGroup(const QString &param1)
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsBeginGroup), param1, dummy);
+        callRemoteMethod(Protocol::QSettingsBeginGroup, param1, dummy);
     else
         d->settings.beginGroup(param1);
 }
@@ -153,14 +153,14 @@ void QSettingsWrapper::beginGroup(const QString &param1)
 int QSettingsWrapper::beginReadArray(const QString &param1)
 {
     if (createSocket())
-        return callRemoteMethod<qint32>(QLatin1String(Protocol::QSettingsBeginReadArray), param1);
+        return callRemoteMethod<qint32>(Protocol::QSettingsBeginReadArray, param1);
     return d->settings.beginReadArray(param1);
 }
 
 void QSettingsWrapper::beginWriteArray(const QString &param1, int param2)
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsBeginWriteArray), param1, qint32(param2));
+        callRemoteMethod(Protocol::QSettingsBeginWriteArray, param1, qint32(param2));
     else
         d->settings.beginWriteArray(param1, param2);
 }
@@ -168,35 +168,35 @@ void QSettingsWrapper::beginWriteArray(const QString &param1, int param2)
 QStringList QSettingsWrapper::childGroups() const
 {
     if (createSocket())
-        return callRemoteMethod<QStringList>(QLatin1String(Protocol::QSettingsChildGroups));
+        return callRemoteMethod<QStringList>(Protocol::QSettingsChildGroups);
     return d->settings.childGroups();
 }
 
 QStringList QSettingsWrapper::childKeys() const
 {
     if (createSocket())
-        return callRemoteMethod<QStringList>(QLatin1String(Protocol::QSettingsChildKeys));
+        return callRemoteMethod<QStringList>(Protocol::QSettingsChildKeys);
     return d->settings.childKeys();
 }
 
 void QSettingsWrapper::clear()
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsClear));
+        callRemoteMethod(Protocol::QSettingsClear);
     else d->settings.clear();
 }
 
 bool QSettingsWrapper::contains(const QString &param1) const
 {
     if (createSocket())
-        return callRemoteMethod<bool>(QLatin1String(Protocol::QSettingsContains), param1);
+        return callRemoteMethod<bool>(Protocol::QSettingsContains, param1);
     return d->settings.contains(param1);
 }
 
 void QSettingsWrapper::endArray()
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsEndArray));
+        callRemoteMethod(Protocol::QSettingsEndArray);
     else
         d->settings.endArray();
 }
@@ -204,7 +204,7 @@ void QSettingsWrapper::endArray()
 void QSettingsWrapper::endGroup()
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsEndGroup));
+        callRemoteMethod(Protocol::QSettingsEndGroup);
     else
         d->settings.endGroup();
 }
@@ -212,14 +212,14 @@ void QSettingsWrapper::endGroup()
 bool QSettingsWrapper::fallbacksEnabled() const
 {
     if (createSocket())
-        return callRemoteMethod<bool>(QLatin1String(Protocol::QSettingsFallbacksEnabled));
+        return callRemoteMethod<bool>(Protocol::QSettingsFallbacksEnabled);
     return d->settings.fallbacksEnabled();
 }
 
 QString QSettingsWrapper::fileName() const
 {
     if (createSocket())
-        return callRemoteMethod<QString>(QLatin1String(Protocol::QSettingsFileName));
+        return callRemoteMethod<QString>(Protocol::QSettingsFileName);
     return d->settings.fileName();
 }
 
@@ -232,28 +232,28 @@ QSettingsWrapper::Format QSettingsWrapper::format() const
 QString QSettingsWrapper::group() const
 {
     if (createSocket())
-        return callRemoteMethod<QString>(QLatin1String(Protocol::QSettingsGroup));
+        return callRemoteMethod<QString>(Protocol::QSettingsGroup);
     return d->settings.group();
 }
 
 bool QSettingsWrapper::isWritable() const
 {
     if (createSocket())
-        return callRemoteMethod<bool>(QLatin1String(Protocol::QSettingsIsWritable));
+        return callRemoteMethod<bool>(Protocol::QSettingsIsWritable);
     return d->settings.isWritable();
 }
 
 QString QSettingsWrapper::organizationName() const
 {
     if (createSocket())
-        return callRemoteMethod<QString>(QLatin1String(Protocol::QSettingsOrganizationName));
+        return callRemoteMethod<QString>(Protocol::QSettingsOrganizationName);
     return d->settings.organizationName();
 }
 
 void QSettingsWrapper::remove(const QString &param1)
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsRemove), param1, dummy);
+        callRemoteMethod(Protocol::QSettingsRemove, param1, dummy);
     else
         d->settings.remove(param1);
 }
@@ -267,7 +267,7 @@ QSettingsWrapper::Scope QSettingsWrapper::scope() const
 void QSettingsWrapper::setArrayIndex(int param1)
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsSetArrayIndex), qint32(param1), dummy);
+        callRemoteMethod(Protocol::QSettingsSetArrayIndex, qint32(param1), dummy);
     else
         d->settings.setArrayIndex(param1);
 }
@@ -275,7 +275,7 @@ void QSettingsWrapper::setArrayIndex(int param1)
 void QSettingsWrapper::setFallbacksEnabled(bool param1)
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsSetFallbacksEnabled), param1, dummy);
+        callRemoteMethod(Protocol::QSettingsSetFallbacksEnabled, param1, dummy);
     else
         d->settings.setFallbacksEnabled(param1);
 }
@@ -283,7 +283,7 @@ void QSettingsWrapper::setFallbacksEnabled(bool param1)
 void QSettingsWrapper::setValue(const QString &param1, const QVariant &param2)
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsSetValue), param1, param2);
+        callRemoteMethod(Protocol::QSettingsSetValue, param1, param2);
     else
         d->settings.setValue(param1, param2);
 }
@@ -292,7 +292,7 @@ QSettingsWrapper::Status QSettingsWrapper::status() const
 {
     if (createSocket()) {
         return static_cast<QSettingsWrapper::Status>
-            (callRemoteMethod<qint32>(QLatin1String(Protocol::QSettingsStatus)));
+            (callRemoteMethod<qint32>(Protocol::QSettingsStatus));
     }
     return static_cast<QSettingsWrapper::Status>(d->settings.status());
 }
@@ -300,7 +300,7 @@ QSettingsWrapper::Status QSettingsWrapper::status() const
 void QSettingsWrapper::sync()
 {
     if (createSocket())
-        callRemoteMethod(QLatin1String(Protocol::QSettingsSync));
+        callRemoteMethod(Protocol::QSettingsSync);
     else
         d->settings.sync();
 }
@@ -308,7 +308,7 @@ void QSettingsWrapper::sync()
 QVariant QSettingsWrapper::value(const QString &param1, const QVariant &param2) const
 {
     if (createSocket())
-        return callRemoteMethod<QVariant>(QLatin1String(Protocol::QSettingsValue), param1, param2);
+        return callRemoteMethod<QVariant>(Protocol::QSettingsValue, param1, param2);
     return d->settings.value(param1, param2);
 }
 
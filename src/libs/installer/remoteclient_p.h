@@ -170,7 +170,7 @@ public:
 
         if (!authorize())
             return;
-        m_serverStarted = !callRemoteMethod<bool>(QString::fromLatin1(Protocol::Shutdown));
+        m_serverStarted = !callRemoteMethod<bool>(Protocol::Shutdown);
     }
 
 private:
@@ -131,7 +131,7 @@ RemoteFileEngine::~RemoteFileEngine()
 bool RemoteFileEngine::atEnd() const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineAtEnd));
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineAtEnd);
     return m_fileEngine.atEnd();
 }
 
@@ -163,7 +163,7 @@ QAbstractFileEngine::Iterator* RemoteFileEngine::endEntryList()
 bool RemoteFileEngine::caseSensitive() const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineCaseSensitive));
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineCaseSensitive);
     return m_fileEngine.caseSensitive();
 }
 
@@ -173,7 +173,7 @@ bool RemoteFileEngine::caseSensitive() const
 bool RemoteFileEngine::close()
 {
     if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineClose));
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineClose);
     return m_fileEngine.close();
 }
 
@@ -183,7 +183,7 @@ bool RemoteFileEngine::close()
 bool RemoteFileEngine::copy(const QString &newName)
 {
     if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineCopy), newName);
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineCopy, newName);
     return m_fileEngine.copy(newName);
 }
 
@@ -194,7 +194,7 @@ QStringList RemoteFileEngine::entryList(QDir::Filters filters, const QStringList
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
         return callRemoteMethod<QStringList>
-            (QString::fromLatin1(Protocol::QAbstractFileEngineEntryList),
+            (Protocol::QAbstractFileEngineEntryList,
             static_cast<qint32>(filters), filterNames);
     }
     return m_fileEngine.entryList(filters, filterNames);
@@ -207,7 +207,7 @@ QFile::FileError RemoteFileEngine::error() const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
         return static_cast<QFile::FileError>
-            (callRemoteMethod<qint32>(QString::fromLatin1(Protocol::QAbstractFileEngineError)));
+            (callRemoteMethod<qint32>(Protocol::QAbstractFileEngineError));
     }
     return m_fileEngine.error();
 }
@@ -218,7 +218,7 @@ QFile::FileError RemoteFileEngine::error() const
 QString RemoteFileEngine::errorString() const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
-        return callRemoteMethod<QString>(QString::fromLatin1(Protocol::QAbstractFileEngineErrorString));
+        return callRemoteMethod<QString>(Protocol::QAbstractFileEngineErrorString);
     return m_fileEngine.errorString();
 }
 
@@ -239,7 +239,7 @@ QAbstractFileEngine::FileFlags RemoteFileEngine::fileFlags(FileFlags type) const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
         return static_cast<QAbstractFileEngine::FileFlags>
-            (callRemoteMethod<qint32>(QString::fromLatin1(Protocol::QAbstractFileEngineFileFlags),
+            (callRemoteMethod<qint32>(Protocol::QAbstractFileEngineFileFlags,
             static_cast<qint32>(type)));
     }
     return m_fileEngine.fileFlags(type);
@@ -251,7 +251,7 @@ QAbstractFileEngine::FileFlags RemoteFileEngine::fileFlags(FileFlags type) const
 QString RemoteFileEngine::fileName(FileName file) const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
-        return callRemoteMethod<QString>(QString::fromLatin1(Protocol::QAbstractFileEngineFileName),
+        return callRemoteMethod<QString>(Protocol::QAbstractFileEngineFileName,
             static_cast<qint32>(file));
     }
     return m_fileEngine.fileName(file);
@@ -263,7 +263,7 @@ QString RemoteFileEngine::fileName(FileName file) const
 bool RemoteFileEngine::flush()
 {
     if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineFlush));
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineFlush);
     return m_fileEngine.flush();
 }
 
@@ -273,7 +273,7 @@ bool RemoteFileEngine::flush()
 int RemoteFileEngine::handle() const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
-        return callRemoteMethod<qint32>(QString::fromLatin1(Protocol::QAbstractFileEngineHandle));
+        return callRemoteMethod<qint32>(Protocol::QAbstractFileEngineHandle);
     return m_fileEngine.handle();
 }
 
@@ -283,7 +283,7 @@ int RemoteFileEngine::handle() const
 bool RemoteFileEngine::isRelativePath() const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineIsRelativePath));
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineIsRelativePath);
     return m_fileEngine.isRelativePath();
 }
 
@@ -293,7 +293,7 @@ bool RemoteFileEngine::isRelativePath() const
 bool RemoteFileEngine::isSequential() const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineIsSequential));
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineIsSequential);
     return m_fileEngine.isSequential();
 }
 
@@ -303,7 +303,7 @@ bool RemoteFileEngine::isSequential() const
 bool RemoteFileEngine::link(const QString &newName)
 {
     if (connectToServer()) {
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineLink),
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineLink,
             newName);
     }
     return m_fileEngine.link(newName);
@@ -315,7 +315,7 @@ bool RemoteFileEngine::link(const QString &newName)
 bool RemoteFileEngine::mkdir(const QString &dirName, bool createParentDirectories) const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineMkdir),
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineMkdir,
             dirName, createParentDirectories);
     }
     return m_fileEngine.mkdir(dirName, createParentDirectories);
@@ -327,7 +327,7 @@ bool RemoteFileEngine::mkdir(const QString &dirName, bool createParentDirectorie
 bool RemoteFileEngine::open(QIODevice::OpenMode mode)
 {
     if (connectToServer()) {
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineOpen),
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineOpen,
             static_cast<qint32>(mode | QIODevice::Unbuffered));
     }
     return m_fileEngine.open(mode | QIODevice::Unbuffered);
@@ -339,7 +339,7 @@ bool RemoteFileEngine::open(QIODevice::OpenMode mode)
 QString RemoteFileEngine::owner(FileOwner owner) const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
-        return callRemoteMethod<QString>(QString::fromLatin1(Protocol::QAbstractFileEngineOwner),
+        return callRemoteMethod<QString>(Protocol::QAbstractFileEngineOwner,
             static_cast<qint32>(owner));
     }
     return m_fileEngine.owner(owner);
@@ -351,7 +351,7 @@ QString RemoteFileEngine::owner(FileOwner owner) const
 uint RemoteFileEngine::ownerId(FileOwner owner) const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
-        return callRemoteMethod<quint32>(QString::fromLatin1(Protocol::QAbstractFileEngineOwnerId),
+        return callRemoteMethod<quint32>(Protocol::QAbstractFileEngineOwnerId,
             static_cast<qint32>(owner));
     }
     return m_fileEngine.ownerId(owner);
@@ -363,7 +363,7 @@ uint RemoteFileEngine::ownerId(FileOwner owner) const
 qint64 RemoteFileEngine::pos() const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
-        return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEnginePos));
+        return callRemoteMethod<qint64>(Protocol::QAbstractFileEnginePos);
     return m_fileEngine.pos();
 }
 
@@ -373,7 +373,7 @@ qint64 RemoteFileEngine::pos() const
 bool RemoteFileEngine::remove()
 {
     if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineRemove));
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineRemove);
     return m_fileEngine.remove();
 }
 
@@ -383,7 +383,7 @@ bool RemoteFileEngine::remove()
 bool RemoteFileEngine::rename(const QString &newName)
 {
     if (connectToServer()) {
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineRename),
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineRename,
             newName);
     }
     return m_fileEngine.rename(newName);
@@ -395,7 +395,7 @@ bool RemoteFileEngine::rename(const QString &newName)
 bool RemoteFileEngine::rmdir(const QString &dirName, bool recurseParentDirectories) const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineRmdir),
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineRmdir,
             dirName, recurseParentDirectories);
     }
     return m_fileEngine.rmdir(dirName, recurseParentDirectories);
@@ -407,7 +407,7 @@ bool RemoteFileEngine::rmdir(const QString &dirName, bool recurseParentDirectori
 bool RemoteFileEngine::seek(qint64 offset)
 {
     if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSeek), offset);
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineSeek, offset);
     return m_fileEngine.seek(offset);
 }
 
@@ -417,7 +417,7 @@ bool RemoteFileEngine::seek(qint64 offset)
 void RemoteFileEngine::setFileName(const QString &fileName)
 {
     if (connectToServer()) {
-        callRemoteMethod(QString::fromLatin1(Protocol::QAbstractFileEngineSetFileName), fileName,
+        callRemoteMethod(Protocol::QAbstractFileEngineSetFileName, fileName,
             dummy);
     }
     m_fileEngine.setFileName(fileName);
@@ -429,7 +429,7 @@ void RemoteFileEngine::setFileName(const QString &fileName)
 bool RemoteFileEngine::setPermissions(uint perms)
 {
     if (connectToServer()) {
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSetPermissions),
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineSetPermissions,
             perms);
     }
     return m_fileEngine.setPermissions(perms);
@@ -441,7 +441,7 @@ bool RemoteFileEngine::setPermissions(uint perms)
 bool RemoteFileEngine::setSize(qint64 size)
 {
     if (connectToServer()) {
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSetSize),
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineSetSize,
             size);
     }
     return m_fileEngine.setSize(size);
@@ -453,7 +453,7 @@ bool RemoteFileEngine::setSize(qint64 size)
 qint64 RemoteFileEngine::size() const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer())
-        return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineSize));
+        return callRemoteMethod<qint64>(Protocol::QAbstractFileEngineSize);
     return m_fileEngine.size();
 }
 
@@ -474,7 +474,7 @@ qint64 RemoteFileEngine::read(char *data, qint64 maxlen)
 {
     if (connectToServer()) {
         QPair<qint64, QByteArray> result = callRemoteMethod<QPair<qint64, QByteArray> >
-            (QString::fromLatin1(Protocol::QAbstractFileEngineRead), maxlen);
+            (Protocol::QAbstractFileEngineRead, maxlen);
 
         if (result.first <= 0)
             return result.first;
@@ -493,7 +493,7 @@ qint64 RemoteFileEngine::readLine(char *data, qint64 maxlen)
 {
     if (connectToServer()) {
         QPair<qint64, QByteArray> result = callRemoteMethod<QPair<qint64, QByteArray> >
-            (QString::fromLatin1(Protocol::QAbstractFileEngineReadLine), maxlen);
+            (Protocol::QAbstractFileEngineReadLine, maxlen);
 
         if (result.first <= 0)
             return result.first;
@@ -512,7 +512,7 @@ qint64 RemoteFileEngine::write(const char *data, qint64 len)
 {
     if (connectToServer()) {
         QByteArray ba(data, len);
-        return callRemoteMethod<qint64>(QString::fromLatin1(Protocol::QAbstractFileEngineWrite), ba);
+        return callRemoteMethod<qint64>(Protocol::QAbstractFileEngineWrite, ba);
     }
     return m_fileEngine.write(data, len);
 }
@@ -520,7 +520,7 @@ qint64 RemoteFileEngine::write(const char *data, qint64 len)
 bool RemoteFileEngine::syncToDisk()
 {
     if (connectToServer())
-        return callRemoteMethod<bool>(QString::fromLatin1(Protocol::QAbstractFileEngineSyncToDisk));
+        return callRemoteMethod<bool>(Protocol::QAbstractFileEngineSyncToDisk);
     return m_fileEngine.syncToDisk();
 }
 
@@ -528,7 +528,7 @@ bool RemoteFileEngine::renameOverwrite(const QString &newName)
 {
     if (connectToServer()) {
         return callRemoteMethod<bool>
-            (QString::fromLatin1(Protocol::QAbstractFileEngineRenameOverwrite), newName);
+            (Protocol::QAbstractFileEngineRenameOverwrite, newName);
     }
     return m_fileEngine.renameOverwrite(newName);
 }
@@ -537,7 +537,7 @@ QDateTime RemoteFileEngine::fileTime(FileTime time) const
 {
     if ((const_cast<RemoteFileEngine *>(this))->connectToServer()) {
         return callRemoteMethod<QDateTime>
-            (QString::fromLatin1(Protocol::QAbstractFileEngineFileTime),
+            (Protocol::QAbstractFileEngineFileTime,
             static_cast<qint32> (time));
     }
     return m_fileEngine.fileTime(time);
@@ -0,0 +1,512 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "remotefileoperations.h"
+#include "remotefileoperations_p.h"
+
+#include "fileutils.h"
+#include "lib7z_facade.h"
+#include "protocol.h"
+
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QVector>
+
+namespace QInstaller {
+
+static const qint64 CopyChunkSize = 1024 * 1024;
+
+/*!
+    \class QInstaller::RemoteFileOperations
+    \internal
+
+    Runs coarse grained file operations with the rights of the remote server. Each operation
+    is a single request, the server does the file I/O on its own and only streams progress
+    back. If the client is not connected to a server, the operations run in-process.
+
+    The server cannot read resources that only exist in the client process, for example
+    \c installer:// paths. Operations reading from such a source run in-process as well, the
+    files they write still go through the remote file engine.
+*/
+
+class LocalFileOperationsWorker : public FileOperationsWorker
+{
+public:
+    LocalFileOperationsWorker(RemoteFileOperations *operations, const QAtomicInt *canceled)
+        : m_operations(operations)
+        , m_canceled(canceled)
+    {}
+
+protected:
+    bool reportProgress(qint64 completed, qint64 total, const QString &file) Q_DECL_OVERRIDE
+    {
+        emit m_operations->progressChanged(completed, total);
+        if (!file.isEmpty())
+            emit m_operations->fileProcessed(file);
+        return m_canceled->load() == 0;
+    }
+
+private:
+    RemoteFileOperations *const m_operations;
+    const QAtomicInt *const m_canceled;
+};
+
+RemoteFileOperations::RemoteFileOperations(QObject *parent)
+    : RemoteObject(QLatin1String(Protocol::FileOperations), parent)
+{
+}
+
+RemoteFileOperations::~RemoteFileOperations()
+{
+}
+
+/*!
+    Copies the file \a source to \a target. Fails if \a target already exists.
+*/
+bool RemoteFileOperations::copyFile(const QString &source, const QString &target)
+{
+    if (FileOperationsWorker::isFileSystemPath(source) && connectToServer()) {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << source << target;
+        return callServer(Protocol::FileOperationsCopyFile, data);
+    }
+    LocalFileOperationsWorker worker(this, &m_canceled);
+    return takeResult(worker, worker.copyFile(source, target));
+}
+
+/*!
+    Copies the folder \a source with all its contents to \a target, which is created if
+    needed.
+*/
+bool RemoteFileOperations::copyTree(const QString &source, const QString &target)
+{
+    if (FileOperationsWorker::isFileSystemPath(source) && connectToServer()) {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << source << target;
+        return callServer(Protocol::FileOperationsCopyTree, data);
+    }
+    LocalFileOperationsWorker worker(this, &m_canceled);
+    return takeResult(worker, worker.copyTree(source, target));
+}
+
+/*!
+    Extracts \a archive into \a targetDirectory. Existing files are renamed before they get
+    overwritten and removed after the extraction, the ones that could not be removed are
+    returned by leftoverFiles().
+*/
+bool RemoteFileOperations::extractArchive(const QString &archive, const QString &targetDirectory)
+{
+    if (FileOperationsWorker::isFileSystemPath(archive) && connectToServer()) {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << archive << targetDirectory;
+        return callServer(Protocol::FileOperationsExtractArchive, data);
+    }
+    LocalFileOperationsWorker worker(this, &m_canceled);
+    return takeResult(worker, worker.extractArchive(archive, targetDirectory));
+}
+
+/*!
+    Sets \a permissions on \a path and all entries below it matching \a filters.
+*/
+bool RemoteFileOperations::setPermissionsRecursively(const QString &path,
+    QFileDevice::Permissions permissions, QDir::Filters filters)
+{
+    if (connectToServer()) {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << path << qint32(permissions) << qint32(filters);
+        return callServer(Protocol::FileOperationsSetPermissionsRecursively, data);
+    }
+    LocalFileOperationsWorker worker(this, &m_canceled);
+    return takeResult(worker, worker.setPermissionsRecursively(path, permissions, filters));
+}
+
+/*!
+    Removes the folder \a path with all its contents.
+*/
+bool RemoteFileOperations::removeTree(const QString &path)
+{
+    if (connectToServer()) {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << path;
+        return callServer(Protocol::FileOperationsRemoveTree, data);
+    }
+    LocalFileOperationsWorker worker(this, &m_canceled);
+    return takeResult(worker, worker.removeTree(path));
+}
+
+QString RemoteFileOperations::errorString() const
+{
+    return m_errorString;
+}
+
+QStringList RemoteFileOperations::leftoverFiles() const
+{
+    return m_leftoverFiles;
+}
+
+/*!
+    Cancels the running operation, all following operations fail. Can be called from any
+    thread.
+*/
+void RemoteFileOperations::cancel()
+{
+    m_canceled.store(1);
+}
+
+void RemoteFileOperations::progressReceived(const QByteArray &data)
+{
+    QDataStream in(data);
+    qint64 completed;
+    qint64 total;
+    QString file;
+    in >> completed >> total >> file;
+
+    emit progressChanged(completed, total);
+    if (!file.isEmpty())
+        emit fileProcessed(file);
+}
+
+bool RemoteFileOperations::isCanceled() const
+{
+    return m_canceled.load() != 0;
+}
+
+bool RemoteFileOperations::callServer(Protocol::Command command, const QByteArray &data)
+{
+    if (isCanceled()) {
+        m_errorString = tr("The operation was canceled.");
+        m_leftoverFiles.clear();
+        return false;
+    }
+
+    QByteArray reply = callStreamingRemoteMethod(command, data);
+    QDataStream in(&reply, QIODevice::ReadOnly);
+
+    bool success;
+    in >> success >> m_errorString >> m_leftoverFiles;
+    Q_ASSERT(in.status() == QDataStream::Ok);
+    return success;
+}
+
+bool RemoteFileOperations::takeResult(const FileOperationsWorker &worker, bool success)
+{
+    m_errorString = worker.errorString();
+    m_leftoverFiles = worker.leftoverFiles();
+    return success;
+}
+
+
+// -- FileOperationsWorker::ExtractCallback
+
+class FileOperationsWorker::ExtractCallback : public Lib7z::ExtractCallback
+{
+public:
+    explicit ExtractCallback(FileOperationsWorker *worker)
+        : m_worker(worker)
+        , m_completed(0)
+        , m_total(0)
+        , m_canceled(false)
+    {}
+
+    QStringList backupFiles;
+
+protected:
+    bool prepareForFile(const QString &filename) Q_DECL_OVERRIDE
+    {
+        if (!QFile::exists(filename))
+            return true;
+
+        const QString bfn = filename + QLatin1String(".tmpUpdate");
+        QString backup = bfn;
+        int i = 0;
+        while (QFile::exists(backup))
+            backup = bfn + QString::fromLatin1(".%1").arg(i++);
+
+        QFile f(filename);
+        const bool renamed = f.rename(backup);
+        if (f.exists() && !renamed) {
+            qCritical("Could not rename %s to %s: %s", qPrintable(filename), qPrintable(backup),
+                qPrintable(f.errorString()));
+            return false;
+        }
+        backupFiles.append(backup);
+        return true;
+    }
+
+    void setCurrentFile(const QString &filename) Q_DECL_OVERRIDE
+    {
+        if (!m_worker->reportProgress(m_completed, m_total, filename))
+            m_canceled = true;
+    }
+
+    HRESULT setCompleted(quint64 completed, quint64 total) Q_DECL_OVERRIDE
+    {
+        m_completed = completed;
+        m_total = total;
+        if (!m_worker->reportProgress(completed, total, QString()))
+            m_canceled = true;
+        return m_canceled ? E_ABORT : S_OK;
+    }
+
+private:
+    FileOperationsWorker *const m_worker;
+    qint64 m_completed;
+    qint64 m_total;
+    bool m_canceled;
+};
+
+
+// -- FileOperationsWorker
+
+FileOperationsWorker::FileOperationsWorker()
+{
+}
+
+FileOperationsWorker::~FileOperationsWorker()
+{
+}
+
+/*
+    Returns whether \a path names a file system entry, rather than a resource only available
+    inside the current process, like \c installer:// paths or Qt resources.
+*/
+bool FileOperationsWorker::isFileSystemPath(const QString &path)
+{
+    if (path.startsWith(QLatin1Char(':')))
+        return false;
+
+    // a scheme has at least two characters, a drive letter only one
+    const int index = path.indexOf(QLatin1String("://"));
+    if (index < 2)
+        return true;
+    for (int i = 0; i < index; ++i) {
+        if (!path.at(i).isLetterOrNumber())
+            return true;
+    }
+    return false;
+}
+
+bool FileOperationsWorker::copyFile(const QString &source, const QString &target)
+{
+    if (!canRead(source))
+        return setError(tr("Cannot read \"%1\" in this process.").arg(source));
+    if (!copyFileData(source, target, true))
+        return false;
+    const qint64 size = QFileInfo(target).size();
+    reportProgress(size, size, target);
+    return true;
+}
+
+bool FileOperationsWorker::copyTree(const QString &source, const QString &target)
+{
+    if (!canRead(source))
+        return setError(tr("Cannot read \"%1\" in this process.").arg(source));
+    if (!QFileInfo(source).isDir())
+        return setError(tr("Cannot copy \"%1\": Not a folder.").arg(source));
+
+    QStringList entries;
+    QDirIterator it(source, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden
+        | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        entries.append(it.next());
+
+    const QDir sourceDir(source);
+    const QDir targetDir(target);
+    if (!targetDir.exists() && !QDir().mkpath(target))
+        return setError(tr("Cannot create folder \"%1\".").arg(target));
+
+    for (int i = 0; i < entries.count(); ++i) {
+        const QFileInfo fi(entries.at(i));
+        const QString targetPath = targetDir.absoluteFilePath(sourceDir
+            .relativeFilePath(fi.filePath()));
+        if (fi.isSymLink()) {
+            const QString linkTarget = linkTargetForCopy(fi.filePath(), source, target);
+            if (!QFile::link(linkTarget, targetPath)) {
+                return setError(tr("Cannot create link \"%1\" to \"%2\".").arg(targetPath,
+                    linkTarget));
+            }
+        } else if (fi.isDir()) {
+            if (!QDir().mkpath(targetPath))
+                return setError(tr("Cannot create folder \"%1\".").arg(targetPath));
+        } else if (!copyFileData(fi.filePath(), targetPath, false)) {
+            return false;
+        }
+        if (!reportProgress(i + 1, entries.count(), targetPath))
+            return setError(tr("Copying \"%1\" was canceled.").arg(source));
+    }
+    return true;
+}
+
+bool FileOperationsWorker::extractArchive(const QString &archive, const QString &targetDirectory)
+{
+    if (!canRead(archive))
+        return setError(tr("Cannot read \"%1\" in this process.").arg(archive));
+    QFile file(archive);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return setError(tr("Cannot open file \"%1\" for reading: %2").arg(archive,
+            file.errorString()));
+    }
+
+    ExtractCallback callback(this);
+    QString error;
+    try {
+        Lib7z::extractArchive(&file, targetDirectory, &callback, QThread::idealThreadCount());
+    } catch (const Lib7z::SevenZipException &e) {
+        error = e.message();
+    } catch (...) {
+        error = tr("Unknown exception caught while extracting \"%1\".").arg(archive);
+    }
+
+    // the backups of overwritten files are not needed any more
+    foreach (const QString &backup, callback.backupFiles) {
+        if (!QFile::remove(backup))
+            m_leftoverFiles.append(backup);
+    }
+
+    if (!error.isEmpty())
+        return setError(error);
+    return true;
+}
+
+bool FileOperationsWorker::setPermissionsRecursively(const QString &path,
+    QFileDevice::Permissions permissions, QDir::Filters filters)
+{
+    QStringList entries(path);
+    QDirIterator it(path, filters | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        entries.append(it.next());
+
+    for (int i = 0; i < entries.count(); ++i) {
+        QFile file(entries.at(i));
+        if (!file.setPermissions(permissions)) {
+            return setError(tr("Cannot set permissions of \"%1\": %2").arg(entries.at(i),
+                file.errorString()));
+        }
+        if (!reportProgress(i + 1, entries.count(), QString()))
+            return setError(tr("Setting permissions of \"%1\" was canceled.").arg(path));
+    }
+    return true;
+}
+
+bool FileOperationsWorker::removeTree(const QString &path)
+{
+    // QDir("") points to the working directory! We never want to remove that one.
+    if (path.isEmpty())
+        return setError(tr("Cannot remove a folder without a name."));
+
+    // a folder is listed before its contents, so remove in reverse order
+    QStringList entries(path);
+    QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System,
+        QDirIterator::Subdirectories);
+    while (it.hasNext())
+        entries.append(it.next());
+
+    QDir dir;
+    for (int i = entries.count() - 1; i >= 0; --i) {
+        const QFileInfo fi(entries.at(i));
+        if (fi.isDir() && !fi.isSymLink()) {
+            if (!dir.rmdir(entries.at(i)))
+                return setError(tr("Cannot remove folder \"%1\".").arg(entries.at(i)));
+        } else {
+            QFile file(entries.at(i));
+            if (!file.remove()) {
+                return setError(tr("Cannot remove file \"%1\": %2").arg(entries.at(i),
+                    file.errorString()));
+            }
+        }
+        if (!reportProgress(entries.count() - i, entries.count(), entries.at(i)))
+            return setError(tr("Removing \"%1\" was canceled.").arg(path));
+    }
+    return true;
+}
+
+bool FileOperationsWorker::copyFileData(const QString &source, const QString &target,
+    bool reportBytes)
+{
+    QFile in(source);
+    if (!in.open(QIODevice::ReadOnly)) {
+        return setError(tr("Cannot open file \"%1\" for reading: %2").arg(source,
+            in.errorString()));
+    }
+    if (QFileInfo(target).exists() || QFileInfo(target).isSymLink())
+        return setError(tr("Cannot copy to \"%1\": The file already exists.").arg(target));
+
+    QFile out(target);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return setError(tr("Cannot open file \"%1\" for writing: %2").arg(target,
+            out.errorString()));
+    }
+
+    const qint64 total = in.size();
+    qint64 completed = 0;
+    QByteArray buffer(CopyChunkSize, Qt::Uninitialized);
+    forever {
+        const qint64 read = in.read(buffer.data(), buffer.size());
+        if (read < 0) {
+            out.remove();
+            return setError(tr("Cannot read from file \"%1\": %2").arg(source,
+                in.errorString()));
+        }
+        if (read == 0)
+            break;
+        if (out.write(buffer.constData(), read) != read) {
+            const QString error = out.errorString();
+            out.remove();
+            return setError(tr("Cannot write to file \"%1\": %2").arg(target, error));
+        }
+        completed += read;
+        if (reportBytes && !reportProgress(completed, total, QString())) {
+            out.remove();
+            return setError(tr("Copying \"%1\" was canceled.").arg(source));
+        }
+    }
+    out.close();
+    out.setPermissions(in.permissions());
+    return true;
+}
+
+bool FileOperationsWorker::setError(const QString &errorString)
+{
+    m_errorString = errorString;
+    return false;
+}
+
+} // namespace QInstaller
@@ -0,0 +1,90 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef REMOTEFILEOPERATIONS_H
+#define REMOTEFILEOPERATIONS_H
+
+#include "remoteobject.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFileDevice>
+#include <QStringList>
+
+namespace QInstaller {
+
+class FileOperationsWorker;
+
+class INSTALLER_EXPORT RemoteFileOperations : public RemoteObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(RemoteFileOperations)
+
+public:
+    explicit RemoteFileOperations(QObject *parent = 0);
+    ~RemoteFileOperations();
+
+    bool copyFile(const QString &source, const QString &target);
+    bool copyTree(const QString &source, const QString &target);
+    bool extractArchive(const QString &archive, const QString &targetDirectory);
+    bool setPermissionsRecursively(const QString &path, QFileDevice::Permissions permissions,
+        QDir::Filters filters = QDir::AllEntries);
+    bool removeTree(const QString &path);
+
+    QString errorString() const;
+    QStringList leftoverFiles() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void progressChanged(qint64 completed, qint64 total);
+    void fileProcessed(const QString &path);
+
+private:
+    void progressReceived(const QByteArray &data) Q_DECL_OVERRIDE;
+    bool isCanceled() const Q_DECL_OVERRIDE;
+
+    bool callServer(Protocol::Command command, const QByteArray &data);
+    bool takeResult(const FileOperationsWorker &worker, bool success);
+
+private:
+    QAtomicInt m_canceled;
+    QString m_errorString;
+    QStringList m_leftoverFiles;
+};
+
+} // namespace QInstaller
+
+#endif // REMOTEFILEOPERATIONS_H
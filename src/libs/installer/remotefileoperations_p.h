@@ -0,0 +1,90 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#ifndef REMOTEFILEOPERATIONS_P_H
+#define REMOTEFILEOPERATIONS_P_H
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileDevice>
+#include <QStringList>
+
+namespace QInstaller {
+
+// Performs the bulk file operations of RemoteFileOperations inside the current process. The
+// server runs it on behalf of the client, the client falls back to it if it is not elevated.
+class FileOperationsWorker
+{
+    Q_DECLARE_TR_FUNCTIONS(FileOperationsWorker)
+    Q_DISABLE_COPY(FileOperationsWorker)
+
+public:
+    FileOperationsWorker();
+    virtual ~FileOperationsWorker();
+
+    bool copyFile(const QString &source, const QString &target);
+    bool copyTree(const QString &source, const QString &target);
+    bool extractArchive(const QString &archive, const QString &targetDirectory);
+    bool setPermissionsRecursively(const QString &path, QFileDevice::Permissions permissions,
+        QDir::Filters filters);
+    bool removeTree(const QString &path);
+
+    QString errorString() const { return m_errorString; }
+    QStringList leftoverFiles() const { return m_leftoverFiles; }
+
+    static bool isFileSystemPath(const QString &path);
+
+protected:
+    // Returns whether the worker can read \a path. The server process cannot read resources
+    // like installer://, they only exist in the client.
+    virtual bool canRead(const QString &path) const { Q_UNUSED(path); return true; }
+
+    // Called while an operation runs, a non empty \a file has just been processed. Returns
+    // \c false if the operation should be canceled.
+    virtual bool reportProgress(qint64 completed, qint64 total, const QString &file) = 0;
+
+private:
+    class ExtractCallback;
+
+    bool copyFileData(const QString &source, const QString &target, bool reportBytes);
+    bool setError(const QString &errorString);
+
+private:
+    QString m_errorString;
+    QStringList m_leftoverFiles;
+};
+
+} // namespace QInstaller
+
+#endif // REMOTEFILEOPERATIONS_P_H
@@ -40,15 +40,35 @@
 
 #include <QCoreApplication>
 #include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
 #include <QThread>
 
 namespace QInstaller {
 
+static const int MaxPendingCommands = 256;
+static const int MaxPendingCommandBytes = 64 * 1024;
+
+// the remote objects with deferred calls, and the thread they were made in
+typedef QHash<const RemoteObject *, QThread *> PendingObjects;
+Q_GLOBAL_STATIC(PendingObjects, pendingObjects)
+Q_GLOBAL_STATIC(QMutex, pendingObjectsMutex)
+
+static void setPending(const RemoteObject *object, bool pending)
+{
+    QMutexLocker locker(pendingObjectsMutex());
+    if (pending)
+        pendingObjects()->insert(object, QThread::currentThread());
+    else
+        pendingObjects()->remove(object);
+}
+
 RemoteObject::RemoteObject(const QString &wrappedType, QObject *parent)
     : QObject(parent)
     , dummy(0)
     , m_type(wrappedType)
     , m_socket(0)
+    , m_pendingCommandCount(0)
 {
     Q_ASSERT_X(!m_type.isEmpty(), Q_FUNC_INFO, "The wrapped Qt type needs to be passed as "
         "argument and cannot be empty.");
@@ -56,9 +76,10 @@ RemoteObject::RemoteObject(const QString &wrappedType, QObject *parent)
 
 RemoteObject::~RemoteObject()
 {
+    setPending(this, false);
     if (m_socket) {
         if (QThread::currentThread() == m_socket->thread()) {
-            writeData(QLatin1String(Protocol::Destroy), m_type, dummy, dummy);
+            writeData(Protocol::Destroy, m_type, dummy, dummy);
         } else {
             Q_ASSERT_X(false, Q_FUNC_INFO, "Socket running in a different Thread than this object.");
         }
@@ -74,12 +95,16 @@ bool RemoteObject::authorize()
     if (m_socket)
         delete m_socket;
 
+    m_pendingCommands.clear();
+    m_pendingCommandCount = 0;
+    setPending(this, false);
+
     m_socket = new LocalSocket;
     m_socket->connectToServer(RemoteClient::instance().socketName());
 
     if (m_socket->waitForConnected()) {
-        bool authorized = callRemoteMethod<bool>(QString::fromLatin1(Protocol::Authorize),
-                                                 RemoteClient::instance().authorizationKey());
+        bool authorized = callRemoteMethod<bool>(Protocol::Authorize,
+            RemoteClient::instance().authorizationKey(), Protocol::Version);
         if (authorized)
             return true;
     }
@@ -120,9 +145,140 @@ bool RemoteObject::isConnectedToServer() const
     return false;
 }
 
-void RemoteObject::callRemoteMethod(const QString &name)
+void RemoteObject::callRemoteMethod(Protocol::Command command)
+{
+    writeData(command, dummy, dummy, dummy);
+}
+
+/*!
+    Sends \a command with its serialized arguments \a data to the server and returns the data of
+    the reply. Long running commands stream Protocol::Progress packets before their reply, each
+    of them is handed to progressReceived(). Protocol::Cancel is sent to the server once
+    isCanceled() returns \c true.
+*/
+QByteArray RemoteObject::callStreamingRemoteMethod(Protocol::Command command,
+    const QByteArray &data)
+{
+    sendCommand(command, data, true);
+
+    bool cancelSent = false;
+    forever {
+        quint16 reply;
+        QByteArray replyData;
+        while (!receivePacket(m_socket, &reply, &replyData)) {
+            if (!cancelSent && isCanceled()) {
+                sendPacket(m_socket, Protocol::Cancel, QByteArray());
+                m_socket->flush();
+                cancelSent = true;
+            }
+            if (!m_socket->waitForReadyRead(100)
+                && m_socket->state() != QLocalSocket::ConnectedState) {
+                throw Error(tr("Could not read all data after sending command: %1. "
+                    "Bytes expected: %2, Bytes received: %3. Error: %4").arg(int(command)).arg(0)
+                    .arg(m_socket->bytesAvailable()).arg(m_socket->errorString()));
+            }
+        }
+
+        if (reply == Protocol::Reply)
+            return replyData;
+
+        Q_ASSERT(reply == Protocol::Progress);
+        progressReceived(replyData);
+    }
+}
+
+void RemoteObject::progressReceived(const QByteArray &data)
+{
+    Q_UNUSED(data)
+}
+
+bool RemoteObject::isCanceled() const
+{
+    return false;
+}
+
+/*!
+    Sends \a command with its serialized arguments \a data to the server. Void calls that
+    Protocol::isDeferrable() accepts are queued and go out in a single Batch packet: in front of
+    the next call that is not deferred, once enough of them accumulated, or when control returns
+    to the event loop.
+
+    The server handles the commands of one connection in order, but every connection on its own
+    thread. Before a call that is not deferred, the deferred calls of the other connections made
+    in this thread are therefore sent and waited for, so the call observes all of them.
+*/
+void RemoteObject::sendCommand(Protocol::Command command, const QByteArray &data,
+    bool expectsReply) const
+{
+    if (!expectsReply && Protocol::isDeferrable(command)) {
+        if (m_pendingCommandCount == 0) {
+            setPending(this, true);
+            QMetaObject::invokeMethod(const_cast<RemoteObject *>(this), "sendPendingCommands",
+                Qt::QueuedConnection);
+        }
+        QDataStream out(&m_pendingCommands, QIODevice::WriteOnly | QIODevice::Append);
+        out << quint16(command) << data;
+        if (++m_pendingCommandCount < MaxPendingCommands
+            && m_pendingCommands.size() < MaxPendingCommandBytes) {
+            return;
+        }
+        flushPendingCommands();
+    } else {
+        if (command != Protocol::Ping)
+            synchronizeOtherConnections();
+        flushPendingCommands();
+        sendPacket(m_socket, command, data);
+    }
+    m_socket->flush();
+}
+
+/*!
+    \internal
+
+    Sends the deferred calls of the other remote objects of the current thread and waits until
+    the server handled them.
+*/
+void RemoteObject::synchronizeOtherConnections() const
+{
+    QList<const RemoteObject *> objects;
+    {
+        QMutexLocker locker(pendingObjectsMutex());
+        for (PendingObjects::const_iterator it = pendingObjects()->constBegin();
+            it != pendingObjects()->constEnd(); ++it) {
+            if (it.key() != this && it.value() == QThread::currentThread())
+                objects.append(it.key());
+        }
+    }
+    foreach (const RemoteObject *object, objects)
+        object->callRemoteMethod<bool>(Protocol::Ping);
+}
+
+void RemoteObject::sendPendingCommands()
 {
-    writeData(name, dummy, dummy, dummy);
+    if (!m_socket || m_pendingCommandCount == 0)
+        return;
+    flushPendingCommands();
+    m_socket->flush();
+}
+
+void RemoteObject::flushPendingCommands() const
+{
+    if (m_pendingCommandCount == 0)
+        return;
+
+    if (m_pendingCommandCount == 1) {
+        // no need to wrap a single call
+        QDataStream in(m_pendingCommands);
+        quint16 command;
+        QByteArray data;
+        in >> command >> data;
+        sendPacket(m_socket, command, data);
+    } else {
+        sendPacket(m_socket, Protocol::Batch, m_pendingCommands);
+    }
+    m_pendingCommands.clear();
+    m_pendingCommandCount = 0;
+    setPending(this, false);
 }
 
 } // namespace QInstaller
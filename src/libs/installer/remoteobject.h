@@ -56,54 +56,55 @@ public:
     virtual ~RemoteObject() = 0;
 
     bool isConnectedToServer() const;
-    void callRemoteMethod(const QString &name);
+    void callRemoteMethod(Protocol::Command command);
 
     template<typename T1, typename T2>
-    void callRemoteMethod(const QString &name, const T1 &arg, const T2 &arg2)
+    void callRemoteMethod(Protocol::Command command, const T1 &arg, const T2 &arg2)
     {
-        writeData(name, arg, arg2, dummy);
+        writeData(command, arg, arg2, dummy);
     }
 
     template<typename T1, typename T2, typename T3>
-    void callRemoteMethod(const QString &name, const T1 &arg, const T2 &arg2, const T3 & arg3)
+    void callRemoteMethod(Protocol::Command command, const T1 &arg, const T2 &arg2, const T3 & arg3)
     {
-        writeData(name, arg, arg2, arg3);
+        writeData(command, arg, arg2, arg3);
     }
 
     template<typename T>
-    T callRemoteMethod(const QString &name) const
+    T callRemoteMethod(Protocol::Command command) const
     {
-        return callRemoteMethod<T>(name, dummy, dummy, dummy);
+        return callRemoteMethod<T>(command, dummy, dummy, dummy);
     }
 
     template<typename T, typename T1>
-    T callRemoteMethod(const QString &name, const T1 &arg) const
+    T callRemoteMethod(Protocol::Command command, const T1 &arg) const
     {
-        return callRemoteMethod<T>(name, arg, dummy, dummy);
+        return callRemoteMethod<T>(command, arg, dummy, dummy);
     }
 
     template<typename T, typename T1, typename T2>
-    T callRemoteMethod(const QString &name, const T1 & arg, const T2 &arg2) const
+    T callRemoteMethod(Protocol::Command command, const T1 & arg, const T2 &arg2) const
     {
-        return callRemoteMethod<T>(name, arg, arg2, dummy);
+        return callRemoteMethod<T>(command, arg, arg2, dummy);
     }
 
     template<typename T, typename T1, typename T2, typename T3>
-    T callRemoteMethod(const QString &name, const T1 &arg, const T2 &arg2, const T3 &arg3) const
+    T callRemoteMethod(Protocol::Command command, const T1 &arg, const T2 &arg2,
+        const T3 &arg3) const
     {
-        writeData(name, arg, arg2, arg3);
+        writeData(command, arg, arg2, arg3, true);
 
-        QByteArray command;
+        quint16 reply;
         QByteArray data;
-        while (!receivePacket(m_socket, &command, &data)) {
+        while (!receivePacket(m_socket, &reply, &data)) {
             if (!m_socket->waitForReadyRead(-1)) {
                 throw Error(tr("Could not read all data after sending command: %1. "
-                    "Bytes expected: %2, Bytes received: %3. Error: %4").arg(name).arg(0)
+                    "Bytes expected: %2, Bytes received: %3. Error: %4").arg(int(command)).arg(0)
                     .arg(m_socket->bytesAvailable()).arg(m_socket->errorString()));
             }
         }
 
-        Q_ASSERT(command == Protocol::Reply);
+        Q_ASSERT(reply == Protocol::Reply);
 
         QDataStream stream(&data, QIODevice::ReadOnly);
 
@@ -118,6 +119,10 @@ protected:
     bool authorize();
     bool connectToServer(const QVariantList &arguments = QVariantList());
 
+    QByteArray callStreamingRemoteMethod(Protocol::Command command, const QByteArray &data);
+    virtual void progressReceived(const QByteArray &data);
+    virtual bool isCanceled() const;
+
     // Use this structure to allow derived classes to manipulate the template
     // function signature of the callRemoteMethod templates, since most of the
     // generated functions will differ in return type rather given arguments.
@@ -138,7 +143,8 @@ private:
     }
 
     template<typename T1, typename T2, typename T3>
-    void writeData(const QString &name, const T1 &arg, const T2 &arg2, const T3 &arg3) const
+    void writeData(Protocol::Command command, const T1 &arg, const T2 &arg2, const T3 &arg3,
+        bool expectsReply = false) const
     {
         QByteArray data;
         QDataStream out(&data, QIODevice::WriteOnly);
@@ -150,13 +156,23 @@ private:
         if (isValueType(arg3))
             out << arg3;
 
-        sendPacket(m_socket, name.toLatin1(), data);
-        m_socket->flush();
+        sendCommand(command, data, expectsReply);
     }
 
+    void sendCommand(Protocol::Command command, const QByteArray &data, bool expectsReply) const;
+    void flushPendingCommands() const;
+    void synchronizeOtherConnections() const;
+
+private slots:
+    void sendPendingCommands();
+
 private:
     QString m_type;
     QLocalSocket *m_socket;
+
+    // void calls not yet sent to the server, see Protocol::isDeferrable()
+    mutable QByteArray m_pendingCommands;
+    mutable int m_pendingCommandCount;
 };
 
 } // namespace QInstaller
@@ -59,6 +59,10 @@ RemoteServerConnection::RemoteServerConnection(qintptr socketDescriptor, const Q
     setObjectName(QString::fromLatin1("RemoteServerConnection(%1)").arg(socketDescriptor));
 }
 
+RemoteServerConnection::~RemoteServerConnection()
+{
+}
+
 // Helper RAII to ensure stream data was correctly (and completely) read
 struct StreamChecker {
     StreamChecker(QDataStream *stream) : stream(stream) {}
@@ -74,120 +78,153 @@ void RemoteServerConnection::run()
 {
     LocalSocket socket;
     socket.setSocketDescriptor(m_socketDescriptor);
-    QScopedPointer<PermissionSettings> settings;
 
     bool authorized = false;
     while (socket.state() == QLocalSocket::ConnectedState) {
-        QByteArray cmd;
+        quint16 command;
         QByteArray data;
 
-        if (!receivePacket(&socket, &cmd, &data)) {
+        if (!receivePacket(&socket, &command, &data)) {
             socket.waitForReadyRead(250);
             continue;
         }
 
-        const QString command = QString::fromLatin1(cmd);
-        QBuffer buf;
-        buf.setBuffer(&data);
-        buf.open(QIODevice::ReadOnly);
-        QDataStream stream;
-        stream.setDevice(&buf);
-        StreamChecker streamChecker(&stream);
-
-        if (authorized && command == QLatin1String(Protocol::Shutdown)) {
+        QDataStream stream(data);
+        if (authorized && command == Protocol::Shutdown) {
             authorized = false;
             sendData(&socket, true);
             socket.flush();
             socket.close();
             emit shutdownRequested();
-            return;
-        } else if (command == QLatin1String(Protocol::Authorize)) {
+            break;
+        } else if (command == Protocol::Authorize) {
+            StreamChecker streamChecker(&stream);
             QString key;
+            quint32 version;
             stream >> key;
-            sendData(&socket, (authorized = (key == m_authorizationKey)));
+            stream >> version;
+            if (version != Protocol::Version) {
+                qDebug() << "Protocol version mismatch, client:" << version << "server:"
+                    << Protocol::Version;
+            }
+            sendData(&socket, (authorized = (key == m_authorizationKey
+                && version == Protocol::Version)));
             socket.flush();
             if (!authorized) {
                 socket.close();
-                return;
+                break;
             }
         } else if (authorized) {
-            if (command.isEmpty())
-                continue;
-
-            if (command == QLatin1String(Protocol::Create)) {
+            if (command == Protocol::Destroy) {
+                StreamChecker streamChecker(&stream);
                 QString type;
                 stream >> type;
                 if (type == QLatin1String(Protocol::QSettings)) {
-                    QVariant application;
-                    QVariant organization;
-                    QVariant scope, format;
-                    QVariant fileName;
-                    stream >> application; stream >> organization; stream >> scope; stream >> format;
-                    stream >> fileName;
-
-                    if (fileName.toString().isEmpty()) {
-                        settings.reset(new PermissionSettings(QSettings::Format(format.toInt()),
-                            QSettings::Scope(scope.toInt()), organization.toString(), application
-                            .toString()));
-                    } else {
-                        settings.reset(new PermissionSettings(fileName.toString(), QSettings::Format(format.toInt())));
-                    }
+                    m_settings.reset();
                 } else if (type == QLatin1String(Protocol::QProcess)) {
                     if (m_process)
                         m_process->deleteLater();
-                    m_process = new QProcess;
-                    m_signalReceiver = new QProcessSignalReceiver(m_process);
-                } else if (type == QLatin1String(Protocol::QAbstractFileEngine)) {
-                    if (m_engine)
-                        delete m_engine;
-                    m_engine = new QFSFileEngine;
-                }
-                continue;
-            }
-
-            if (command == QLatin1String(Protocol::Destroy)) {
-                QString type;
-                stream >> type;
-                if (type == QLatin1String(Protocol::QSettings)) {
-                    settings.reset();
-                } else if (command == QLatin1String(Protocol::QProcess)) {
-                    m_signalReceiver->m_receivedSignals.clear();
-                    m_process->deleteLater();
                     m_process = 0;
-                } else if (command == QLatin1String(Protocol::QAbstractFileEngine)) {
+                    m_signalReceiver = 0;
+                } else if (type == QLatin1String(Protocol::QAbstractFileEngine)) {
                     delete m_engine;
                     m_engine = 0;
                 }
-                return;
+                break;
             }
 
-            if (command == QLatin1String(Protocol::GetQProcessSignals)) {
-                if (m_signalReceiver) {
-                    QMutexLocker _(&m_signalReceiver->m_lock);
-                    sendData(&socket, m_signalReceiver->m_receivedSignals);
-                    socket.flush();
-                    m_signalReceiver->m_receivedSignals.clear();
-                }
+            if (command == Protocol::Ping) {
+                // all earlier commands of this connection have been handled
+                sendData(&socket, true);
+                socket.flush();
                 continue;
             }
 
-            if (command.startsWith(QLatin1String(Protocol::QProcess))) {
-                handleQProcess(&socket, command, stream);
-            } else if (command.startsWith(QLatin1String(Protocol::QSettings))) {
-                handleQSettings(&socket, command, stream, settings.data());
-            } else if (command.startsWith(QLatin1String(Protocol::QAbstractFileEngine))) {
-                handleQFSFileEngine(&socket, command, stream);
+            if (command == Protocol::Batch) {
+                // deferred void calls, none of them sends a reply
+                while (!stream.atEnd()) {
+                    quint16 call;
+                    QByteArray callData;
+                    stream >> call;
+                    stream >> callData;
+                    dispatch(&socket, call, callData);
+                }
             } else {
-                qDebug() << "Unknown command:" << command;
+                dispatch(&socket, command, data);
             }
             socket.flush();
         } else {
             // authorization failed, connection not wanted
             socket.close();
             qDebug() << "Unknown command:" << command;
-            return;
+            break;
         }
     }
+    m_settings.reset();
+}
+
+/*!
+    Hands \a command over to the handler registered for its Protocol::CommandGroup.
+*/
+void RemoteServerConnection::dispatch(QIODevice *socket, quint16 command, const QByteArray &data)
+{
+    static const CommandHandler handlers[] = {
+        &RemoteServerConnection::handleConnection,      // Protocol::ConnectionCommands
+        &RemoteServerConnection::handleQProcess,        // Protocol::QProcessCommands
+        &RemoteServerConnection::handleQSettings,       // Protocol::QSettingsCommands
+        &RemoteServerConnection::handleQFSFileEngine,   // Protocol::QAbstractFileEngineCommands
+        &RemoteServerConnection::handleFileOperations   // Protocol::FileOperationsCommands
+    };
+
+    const int group = Protocol::commandGroup(command);
+    if (group >= int(sizeof(handlers) / sizeof(handlers[0]))) {
+        qDebug() << "Unknown command:" << command;
+        return;
+    }
+
+    QDataStream stream(data);
+    StreamChecker streamChecker(&stream);
+    (this->*handlers[group])(socket, command, stream);
+}
+
+void RemoteServerConnection::handleConnection(QIODevice *socket, quint16 command,
+                                              QDataStream &data)
+{
+    Q_UNUSED(socket)
+    if (command == Protocol::Cancel)
+        return; // arrived after the canceled operation finished anyway
+    if (command != Protocol::Create) {
+        qDebug() << "Unknown command:" << command;
+        return;
+    }
+
+    QString type;
+    data >> type;
+    if (type == QLatin1String(Protocol::QSettings)) {
+        QVariant application;
+        QVariant organization;
+        QVariant scope, format;
+        QVariant fileName;
+        data >> application; data >> organization; data >> scope; data >> format;
+        data >> fileName;
+
+        if (fileName.toString().isEmpty()) {
+            m_settings.reset(new PermissionSettings(QSettings::Format(format.toInt()),
+                QSettings::Scope(scope.toInt()), organization.toString(), application
+                .toString()));
+        } else {
+            m_settings.reset(new PermissionSettings(fileName.toString(), QSettings::Format(format.toInt())));
+        }
+    } else if (type == QLatin1String(Protocol::QProcess)) {
+        if (m_process)
+            m_process->deleteLater();
+        m_process = new QProcess;
+        m_signalReceiver = new QProcessSignalReceiver(m_process);
+    } else if (type == QLatin1String(Protocol::QAbstractFileEngine)) {
+        if (m_engine)
+            delete m_engine;
+        m_engine = new QFSFileEngine;
+    }
 }
 
 template <typename T>
@@ -200,23 +237,38 @@ void RemoteServerConnection::sendData(QIODevice *device, const T &data)
     sendPacket(device, Protocol::Reply, result);
 }
 
-void RemoteServerConnection::handleQProcess(QIODevice *socket, const QString &command, QDataStream &data)
+void RemoteServerConnection::handleQProcess(QIODevice *socket, quint16 command, QDataStream &data)
 {
-    if (command == QLatin1String(Protocol::QProcessCloseWriteChannel)) {
+    switch (command) {
+    case Protocol::GetQProcessSignals:
+        if (m_signalReceiver) {
+            QMutexLocker _(&m_signalReceiver->m_lock);
+            sendData(socket, m_signalReceiver->m_receivedSignals);
+            m_signalReceiver->m_receivedSignals.clear();
+        }
+        break;
+    case Protocol::QProcessCloseWriteChannel:
         m_process->closeWriteChannel();
-    } else if (command == QLatin1String(Protocol::QProcessExitCode)) {
+        break;
+    case Protocol::QProcessExitCode:
         sendData(socket, m_process->exitCode());
-    } else if (command == QLatin1String(Protocol::QProcessExitStatus)) {
+        break;
+    case Protocol::QProcessExitStatus:
         sendData(socket, static_cast<qint32> (m_process->exitStatus()));
-    } else if (command == QLatin1String(Protocol::QProcessKill)) {
+        break;
+    case Protocol::QProcessKill:
         m_process->kill();
-    } else if (command == QLatin1String(Protocol::QProcessReadAll)) {
+        break;
+    case Protocol::QProcessReadAll:
         sendData(socket, m_process->readAll());
-    } else if (command == QLatin1String(Protocol::QProcessReadAllStandardOutput)) {
+        break;
+    case Protocol::QProcessReadAllStandardOutput:
         sendData(socket, m_process->readAllStandardOutput());
-    } else if (command == QLatin1String(Protocol::QProcessReadAllStandardError)) {
+        break;
+    case Protocol::QProcessReadAllStandardError:
         sendData(socket, m_process->readAllStandardError());
-    } else if (command == QLatin1String(Protocol::QProcessStartDetached)) {
+        break;
+    case Protocol::QProcessStartDetached: {
         QString program;
         QStringList arguments;
         QString workingDirectory;
@@ -227,17 +279,24 @@ void RemoteServerConnection::handleQProcess(QIODevice *socket, const QString &co
         qint64 pid = -1;
         bool success = QInstaller::startDetached(program, arguments, workingDirectory, &pid);
         sendData(socket, qMakePair< bool, qint64>(success, pid));
-    } else if (command == QLatin1String(Protocol::QProcessSetWorkingDirectory)) {
+        break;
+    }
+    case Protocol::QProcessSetWorkingDirectory: {
         QString dir;
         data >> dir;
         m_process->setWorkingDirectory(dir);
-    } else if (command == QLatin1String(Protocol::QProcessSetEnvironment)) {
+        break;
+    }
+    case Protocol::QProcessSetEnvironment: {
         QStringList env;
         data >> env;
         m_process->setEnvironment(env);
-    } else if (command == QLatin1String(Protocol::QProcessEnvironment)) {
+        break;
+    }
+    case Protocol::QProcessEnvironment:
         sendData(socket, m_process->environment());
-    } else if (command == QLatin1String(Protocol::QProcessStart3Arg)) {
+        break;
+    case Protocol::QProcessStart3Arg: {
         QString program;
         QStringList arguments;
         qint32 mode;
@@ -245,148 +304,206 @@ void RemoteServerConnection::handleQProcess(QIODevice *socket, const QString &co
         data >> arguments;
         data >> mode;
         m_process->start(program, arguments, static_cast<QIODevice::OpenMode> (mode));
-    } else if (command == QLatin1String(Protocol::QProcessStart2Arg)) {
+        break;
+    }
+    case Protocol::QProcessStart2Arg: {
         QString program;
         qint32 mode;
         data >> program;
         data >> mode;
         m_process->start(program, static_cast<QIODevice::OpenMode> (mode));
-    } else if (command == QLatin1String(Protocol::QProcessState)) {
+        break;
+    }
+    case Protocol::QProcessState:
         sendData(socket, static_cast<qint32> (m_process->state()));
-    } else if (command == QLatin1String(Protocol::QProcessTerminate)) {
+        break;
+    case Protocol::QProcessTerminate:
         m_process->terminate();
-    } else if (command == QLatin1String(Protocol::QProcessWaitForFinished)) {
+        break;
+    case Protocol::QProcessWaitForFinished: {
         qint32 msecs;
         data >> msecs;
         sendData(socket, m_process->waitForFinished(msecs));
-    } else if (command == QLatin1String(Protocol::QProcessWaitForStarted)) {
+        break;
+    }
+    case Protocol::QProcessWaitForStarted: {
         qint32 msecs;
         data >> msecs;
         sendData(socket, m_process->waitForStarted(msecs));
-    } else if (command == QLatin1String(Protocol::QProcessWorkingDirectory)) {
+        break;
+    }
+    case Protocol::QProcessWorkingDirectory:
         sendData(socket, m_process->workingDirectory());
-    } else if (command == QLatin1String(Protocol::QProcessErrorString)) {
+        break;
+    case Protocol::QProcessErrorString:
         sendData(socket, m_process->errorString());
-    } else if (command == QLatin1String(Protocol::QProcessReadChannel)) {
+        break;
+    case Protocol::QProcessReadChannel:
         sendData(socket, static_cast<qint32> (m_process->readChannel()));
-    } else if (command == QLatin1String(Protocol::QProcessSetReadChannel)) {
+        break;
+    case Protocol::QProcessSetReadChannel: {
         qint32 processChannel;
         data >> processChannel;
         m_process->setReadChannel(static_cast<QProcess::ProcessChannel>(processChannel));
-    } else if (command == QLatin1String(Protocol::QProcessWrite)) {
+        break;
+    }
+    case Protocol::QProcessWrite: {
         QByteArray byteArray;
         data >> byteArray;
         sendData(socket, m_process->write(byteArray));
-    } else if (command == QLatin1String(Protocol::QProcessProcessChannelMode)) {
+        break;
+    }
+    case Protocol::QProcessProcessChannelMode:
         sendData(socket, static_cast<qint32> (m_process->processChannelMode()));
-    } else if (command == QLatin1String(Protocol::QProcessSetProcessChannelMode)) {
+        break;
+    case Protocol::QProcessSetProcessChannelMode: {
         qint32 processChannel;
         data >> processChannel;
         m_process->setProcessChannelMode(static_cast<QProcess::ProcessChannelMode>(processChannel));
+        break;
     }
 #ifdef Q_OS_WIN
-    else if (command == QLatin1String(Protocol::QProcessSetNativeArguments)) {
+    case Protocol::QProcessSetNativeArguments: {
         QString arguments;
         data >> arguments;
         m_process->setNativeArguments(arguments);
+        break;
     }
 #endif
-    else if (!command.isEmpty()) {
+    default:
         qDebug() << "Unknown QProcess command:" << command;
+        break;
     }
 }
 
-void RemoteServerConnection::handleQSettings(QIODevice *socket, const QString &command,
-                                             QDataStream &data, PermissionSettings *settings)
+void RemoteServerConnection::handleQSettings(QIODevice *socket, quint16 command, QDataStream &data)
 {
-    if (!settings)
+    if (!m_settings)
         return;
 
-    if (command == QLatin1String(Protocol::QSettingsAllKeys)) {
-        sendData(socket, settings->allKeys());
-    } else if (command == QLatin1String(Protocol::QSettingsBeginGroup)) {
+    switch (command) {
+    case Protocol::QSettingsAllKeys:
+        sendData(socket, m_settings->allKeys());
+        break;
+    case Protocol::QSettingsBeginGroup: {
         QString prefix;
         data >> prefix;
-        settings->beginGroup(prefix);
-    } else if (command == QLatin1String(Protocol::QSettingsBeginWriteArray)) {
+        m_settings->beginGroup(prefix);
+        break;
+    }
+    case Protocol::QSettingsBeginWriteArray: {
         QString prefix;
         data >> prefix;
         qint32 size;
         data >> size;
-        settings->beginWriteArray(prefix, size);
-    } else if (command == QLatin1String(Protocol::QSettingsBeginReadArray)) {
+        m_settings->beginWriteArray(prefix, size);
+        break;
+    }
+    case Protocol::QSettingsBeginReadArray: {
         QString prefix;
         data >> prefix;
-        sendData(socket, settings->beginReadArray(prefix));
-    } else if (command == QLatin1String(Protocol::QSettingsChildGroups)) {
-        sendData(socket, settings->childGroups());
-    } else if (command == QLatin1String(Protocol::QSettingsChildKeys)) {
-        sendData(socket, settings->childKeys());
-    } else if (command == QLatin1String(Protocol::QSettingsClear)) {
-        settings->clear();
-    } else if (command == QLatin1String(Protocol::QSettingsContains)) {
+        sendData(socket, m_settings->beginReadArray(prefix));
+        break;
+    }
+    case Protocol::QSettingsChildGroups:
+        sendData(socket, m_settings->childGroups());
+        break;
+    case Protocol::QSettingsChildKeys:
+        sendData(socket, m_settings->childKeys());
+        break;
+    case Protocol::QSettingsClear:
+        m_settings->clear();
+        break;
+    case Protocol::QSettingsContains: {
         QString key;
         data >> key;
-        sendData(socket, settings->contains(key));
-    } else if (command == QLatin1String(Protocol::QSettingsEndArray)) {
-        settings->endArray();
-    } else if (command == QLatin1String(Protocol::QSettingsEndGroup)) {
-        settings->endGroup();
-    } else if (command == QLatin1String(Protocol::QSettingsFallbacksEnabled)) {
-        sendData(socket, settings->fallbacksEnabled());
-    } else if (command == QLatin1String(Protocol::QSettingsFileName)) {
-        sendData(socket, settings->fileName());
-    } else if (command == QLatin1String(Protocol::QSettingsGroup)) {
-        sendData(socket, settings->group());
-    } else if (command == QLatin1String(Protocol::QSettingsIsWritable)) {
-        sendData(socket, settings->isWritable());
-    } else if (command == QLatin1String(Protocol::QSettingsRemove)) {
+        sendData(socket, m_settings->contains(key));
+        break;
+    }
+    case Protocol::QSettingsEndArray:
+        m_settings->endArray();
+        break;
+    case Protocol::QSettingsEndGroup:
+        m_settings->endGroup();
+        break;
+    case Protocol::QSettingsFallbacksEnabled:
+        sendData(socket, m_settings->fallbacksEnabled());
+        break;
+    case Protocol::QSettingsFileName:
+        sendData(socket, m_settings->fileName());
+        break;
+    case Protocol::QSettingsGroup:
+        sendData(socket, m_settings->group());
+        break;
+    case Protocol::QSettingsIsWritable:
+        sendData(socket, m_settings->isWritable());
+        break;
+    case Protocol::QSettingsRemove: {
         QString key;
         data >> key;
-        settings->remove(key);
-    } else if (command == QLatin1String(Protocol::QSettingsSetArrayIndex)) {
+        m_settings->remove(key);
+        break;
+    }
+    case Protocol::QSettingsSetArrayIndex: {
         qint32 i;
         data >> i;
-        settings->setArrayIndex(i);
-    } else if (command == QLatin1String(Protocol::QSettingsSetFallbacksEnabled)) {
+        m_settings->setArrayIndex(i);
+        break;
+    }
+    case Protocol::QSettingsSetFallbacksEnabled: {
         bool b;
         data >> b;
-        settings->setFallbacksEnabled(b);
-    } else if (command == QLatin1String(Protocol::QSettingsStatus)) {
-        sendData(socket, settings->status());
-    } else if (command == QLatin1String(Protocol::QSettingsSync)) {
-        settings->sync();
-    } else if (command == QLatin1String(Protocol::QSettingsSetValue)) {
+        m_settings->setFallbacksEnabled(b);
+        break;
+    }
+    case Protocol::QSettingsStatus:
+        sendData(socket, m_settings->status());
+        break;
+    case Protocol::QSettingsSync:
+        m_settings->sync();
+        break;
+    case Protocol::QSettingsSetValue: {
         QString key;
         QVariant value;
         data >> key;
         data >> value;
-        settings->setValue(key, value);
-    } else if (command == QLatin1String(Protocol::QSettingsValue)) {
+        m_settings->setValue(key, value);
+        break;
+    }
+    case Protocol::QSettingsValue: {
         QString key;
         QVariant defaultValue;
         data >> key;
         data >> defaultValue;
-        sendData(socket, settings->value(key, defaultValue));
-    } else if (command == QLatin1String(Protocol::QSettingsOrganizationName)) {
-        sendData(socket, settings->organizationName());
-    } else if (command == QLatin1String(Protocol::QSettingsApplicationName)) {
-        sendData(socket, settings->applicationName());
-    } else if (!command.isEmpty()) {
+        sendData(socket, m_settings->value(key, defaultValue));
+        break;
+    }
+    case Protocol::QSettingsOrganizationName:
+        sendData(socket, m_settings->organizationName());
+        break;
+    case Protocol::QSettingsApplicationName:
+        sendData(socket, m_settings->applicationName());
+        break;
+    default:
         qDebug() << "Unknown QSettings command:" << command;
+        break;
     }
 }
 
-void RemoteServerConnection::handleQFSFileEngine(QIODevice *socket, const QString &command,
+void RemoteServerConnection::handleQFSFileEngine(QIODevice *socket, quint16 command,
                                                  QDataStream &data)
 {
-    if (command == QLatin1String(Protocol::QAbstractFileEngineAtEnd)) {
+    switch (command) {
+    case Protocol::QAbstractFileEngineAtEnd:
         sendData(socket, m_engine->atEnd());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineCaseSensitive)) {
+        break;
+    case Protocol::QAbstractFileEngineCaseSensitive:
         sendData(socket, m_engine->caseSensitive());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineClose)) {
+        break;
+    case Protocol::QAbstractFileEngineClose:
         sendData(socket, m_engine->close());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineCopy)) {
+        break;
+    case Protocol::QAbstractFileEngineCopy: {
         QString newName;
         data >>newName;
 #ifdef Q_OS_LINUX
@@ -397,120 +514,231 @@ void RemoteServerConnection::handleQFSFileEngine(QIODevice *socket, const QStrin
 #else
         sendData(socket, m_engine->copy(newName));
 #endif
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineEntryList)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineEntryList: {
         qint32 filters;
         QStringList filterNames;
         data >>filters;
         data >>filterNames;
         sendData(socket, m_engine->entryList(static_cast<QDir::Filters> (filters), filterNames));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineError)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineError:
         sendData(socket, static_cast<qint32> (m_engine->error()));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineErrorString)) {
+        break;
+    case Protocol::QAbstractFileEngineErrorString:
         sendData(socket, m_engine->errorString());
-    }
-    else if (command == QLatin1String(Protocol::QAbstractFileEngineFileFlags)) {
+        break;
+    case Protocol::QAbstractFileEngineFileFlags: {
         qint32 flags;
         data >>flags;
         flags = m_engine->fileFlags(static_cast<QAbstractFileEngine::FileFlags>(flags));
         sendData(socket, static_cast<qint32>(flags));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineFileName)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineFileName: {
         qint32 file;
         data >>file;
         sendData(socket, m_engine->fileName(static_cast<QAbstractFileEngine::FileName> (file)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineFlush)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineFlush:
         sendData(socket, m_engine->flush());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineHandle)) {
+        break;
+    case Protocol::QAbstractFileEngineHandle:
         sendData(socket, m_engine->handle());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineIsRelativePath)) {
+        break;
+    case Protocol::QAbstractFileEngineIsRelativePath:
         sendData(socket, m_engine->isRelativePath());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineIsSequential)) {
+        break;
+    case Protocol::QAbstractFileEngineIsSequential:
         sendData(socket, m_engine->isSequential());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineLink)) {
+        break;
+    case Protocol::QAbstractFileEngineLink: {
         QString newName;
         data >>newName;
         sendData(socket, m_engine->link(newName));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineMkdir)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineMkdir: {
         QString dirName;
         bool createParentDirectories;
         data >>dirName;
         data >>createParentDirectories;
         sendData(socket, m_engine->mkdir(dirName, createParentDirectories));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineOpen)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineOpen: {
         qint32 openMode;
         data >>openMode;
         sendData(socket, m_engine->open(static_cast<QIODevice::OpenMode> (openMode)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineOwner)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineOwner: {
         qint32 owner;
         data >>owner;
         sendData(socket, m_engine->owner(static_cast<QAbstractFileEngine::FileOwner> (owner)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineOwnerId)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineOwnerId: {
         qint32 owner;
         data >>owner;
         sendData(socket, m_engine->ownerId(static_cast<QAbstractFileEngine::FileOwner> (owner)));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEnginePos)) {
+        break;
+    }
+    case Protocol::QAbstractFileEnginePos:
         sendData(socket, m_engine->pos());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRead)) {
+        break;
+    case Protocol::QAbstractFileEngineRead: {
         qint64 maxlen;
         data >> maxlen;
         QByteArray byteArray(maxlen, '\0');
         const qint64 r = m_engine->read(byteArray.data(), maxlen);
         sendData(socket, qMakePair<qint64, QByteArray>(r, byteArray));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineReadLine)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineReadLine: {
         qint64 maxlen;
         data >> maxlen;
         QByteArray byteArray(maxlen, '\0');
         const qint64 r = m_engine->readLine(byteArray.data(), maxlen);
         sendData(socket, qMakePair<qint64, QByteArray>(r, byteArray));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRemove)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineRemove:
         sendData(socket, m_engine->remove());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRename)) {
+        break;
+    case Protocol::QAbstractFileEngineRename: {
         QString newName;
         data >>newName;
         sendData(socket, m_engine->rename(newName));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRmdir)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineRmdir: {
         QString dirName;
         bool recurseParentDirectories;
         data >>dirName;
         data >>recurseParentDirectories;
         sendData(socket, m_engine->rmdir(dirName, recurseParentDirectories));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSeek)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineSeek: {
         quint64 offset;
         data >>offset;
         sendData(socket, m_engine->seek(offset));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSetFileName)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineSetFileName: {
         QString fileName;
         data >>fileName;
         m_engine->setFileName(fileName);
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSetPermissions)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineSetPermissions: {
         uint perms;
         data >>perms;
         sendData(socket, m_engine->setPermissions(perms));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSetSize)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineSetSize: {
         qint64 size;
         data >>size;
         sendData(socket, m_engine->setSize(size));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSize)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineSize:
         sendData(socket, m_engine->size());
-    } else if ((command == QLatin1String(Protocol::QAbstractFileEngineSupportsExtension))
-        || (command == QLatin1String(Protocol::QAbstractFileEngineExtension))) {
-            // Implemented client side.
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineWrite)) {
+        break;
+    case Protocol::QAbstractFileEngineSupportsExtension:
+    case Protocol::QAbstractFileEngineExtension:
+        // Implemented client side.
+        break;
+    case Protocol::QAbstractFileEngineWrite: {
         QByteArray content;
         data >> content;
         sendData(socket, m_engine->write(content.data(), content.size()));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineSyncToDisk)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineSyncToDisk:
         sendData(socket, m_engine->syncToDisk());
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineRenameOverwrite)) {
+        break;
+    case Protocol::QAbstractFileEngineRenameOverwrite: {
         QString newFilename;
         data >> newFilename;
         sendData(socket, m_engine->renameOverwrite(newFilename));
-    } else if (command == QLatin1String(Protocol::QAbstractFileEngineFileTime)) {
+        break;
+    }
+    case Protocol::QAbstractFileEngineFileTime: {
         qint32 filetime;
         data >> filetime;
         sendData(socket, m_engine->fileTime(static_cast<QAbstractFileEngine::FileTime> (filetime)));
-    } else if (!command.isEmpty()) {
+        break;
+    }
+    default:
         qDebug() << "Unknown QAbstractFileEngine command:" << command;
+        break;
+    }
+}
+
+void RemoteServerConnection::handleFileOperations(QIODevice *socket, quint16 command,
+                                                  QDataStream &data)
+{
+    FileOperationsProgressSender worker(qobject_cast<QLocalSocket *>(socket));
+
+    bool success = false;
+    switch (command) {
+    case Protocol::FileOperationsCopyFile: {
+        QString source;
+        QString target;
+        data >> source;
+        data >> target;
+        success = worker.copyFile(source, target);
+        break;
+    }
+    case Protocol::FileOperationsCopyTree: {
+        QString source;
+        QString target;
+        data >> source;
+        data >> target;
+        success = worker.copyTree(source, target);
+        break;
+    }
+    case Protocol::FileOperationsExtractArchive: {
+        QString archive;
+        QString targetDirectory;
+        data >> archive;
+        data >> targetDirectory;
+        success = worker.extractArchive(archive, targetDirectory);
+        break;
+    }
+    case Protocol::FileOperationsSetPermissionsRecursively: {
+        QString path;
+        qint32 permissions;
+        qint32 filters;
+        data >> path;
+        data >> permissions;
+        data >> filters;
+        success = worker.setPermissionsRecursively(path,
+            static_cast<QFileDevice::Permissions>(permissions),
+            static_cast<QDir::Filters>(filters));
+        break;
     }
+    case Protocol::FileOperationsRemoveTree: {
+        QString path;
+        data >> path;
+        success = worker.removeTree(path);
+        break;
+    }
+    default:
+        qDebug() << "Unknown FileOperations command:" << command;
+        return;
+    }
+
+    QByteArray result;
+    QDataStream out(&result, QIODevice::WriteOnly);
+    out << success << worker.errorString() << worker.leftoverFiles();
+    sendPacket(socket, Protocol::Reply, result);
 }
 
 } // namespace QInstaller
@@ -36,11 +36,13 @@
 #define REMOTESERVERCONNECTION_H
 
 #include <QPointer>
+#include <QScopedPointer>
 #include <QThread>
 
 #include <QtCore/private/qfsfileengine_p.h>
 
 QT_BEGIN_NAMESPACE
+class QDataStream;
 class QProcess;
 class QIODevice;
 QT_END_NAMESPACE
@@ -59,6 +61,7 @@ class RemoteServerConnection : public QThread
 public:
     RemoteServerConnection(qintptr socketDescriptor, const QString &authorizationKey,
                            QObject *parent);
+    ~RemoteServerConnection();
 
     void run() Q_DECL_OVERRIDE;
 
@@ -66,12 +69,17 @@ signals:
     void shutdownRequested();
 
 private:
+    typedef void (RemoteServerConnection::*CommandHandler)(QIODevice *device, quint16 command,
+                                                           QDataStream &data);
+
     template <typename T>
     void sendData(QIODevice *device, const T &arg);
-    void handleQProcess(QIODevice *device, const QString &command, QDataStream &data);
-    void handleQSettings(QIODevice *device, const QString &command, QDataStream &data,
-                         PermissionSettings *settings);
-    void handleQFSFileEngine(QIODevice *device, const QString &command, QDataStream &data);
+    void dispatch(QIODevice *device, quint16 command, const QByteArray &data);
+    void handleConnection(QIODevice *device, quint16 command, QDataStream &data);
+    void handleQProcess(QIODevice *device, quint16 command, QDataStream &data);
+    void handleQSettings(QIODevice *device, quint16 command, QDataStream &data);
+    void handleQFSFileEngine(QIODevice *device, quint16 command, QDataStream &data);
+    void handleFileOperations(QIODevice *device, quint16 command, QDataStream &data);
 
 private:
     qintptr m_socketDescriptor;
@@ -80,6 +88,7 @@ private:
     QFSFileEngine *m_engine;
     QString m_authorizationKey;
     QProcessSignalReceiver *m_signalReceiver;
+    QScopedPointer<PermissionSettings> m_settings;
 };
 
 } // namespace QInstaller
@@ -36,7 +36,11 @@
 #define REMOTESERVERCONNECTION_P_H
 
 #include "protocol.h"
+#include "remotefileoperations_p.h"
 
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QLocalSocket>
 #include <QMutex>
 #include <QProcess>
 #include <QVariant>
@@ -128,6 +132,52 @@ private:
     QVariantList m_receivedSignals;
 };
 
+// Streams the progress of a bulk file operation back to the client as Protocol::Progress
+// packets, and picks up a Protocol::Cancel sent while the operation runs.
+class FileOperationsProgressSender : public FileOperationsWorker
+{
+public:
+    explicit FileOperationsProgressSender(QLocalSocket *socket)
+        : m_socket(socket)
+        , m_canceled(false)
+    {
+        m_timer.start();
+    }
+
+protected:
+    bool canRead(const QString &path) const Q_DECL_OVERRIDE
+    {
+        return isFileSystemPath(path);
+    }
+
+    bool reportProgress(qint64 completed, qint64 total, const QString &file) Q_DECL_OVERRIDE
+    {
+        // plain progress updates are throttled, processed files are always reported
+        if (!file.isEmpty() || completed == total || m_timer.elapsed() >= 100) {
+            QByteArray data;
+            QDataStream out(&data, QIODevice::WriteOnly);
+            out << completed << total << file;
+            sendPacket(m_socket, Protocol::Progress, data);
+            m_socket->flush();
+            m_timer.restart();
+        }
+
+        quint16 command;
+        QByteArray data;
+        m_socket->waitForReadyRead(0);
+        while (receivePacket(m_socket, &command, &data)) {
+            if (command == Protocol::Cancel)
+                m_canceled = true;
+        }
+        return !m_canceled;
+    }
+
+private:
+    QLocalSocket *const m_socket;
+    QElapsedTimer m_timer;
+    bool m_canceled;
+};
+
 } // namespace QInstaller
 
 #endif // REMOTESERVERCONNECTION_P_H
@@ -62,6 +62,7 @@ static const QLatin1String scRemoteRepositories("RemoteRepositories");
 static const QLatin1String scDependsOnLocalInstallerBinary("DependsOnLocalInstallerBinary");
 static const QLatin1String scTranslations("Translations");
 static const QLatin1String scCreateLocalRepository("CreateLocalRepository");
+static const QLatin1String scMaxConcurrentDownloads("MaxConcurrentDownloads");
 static const QLatin1String scStyleSheet("StyleSheet");
 static const QLatin1String scIgnoreTitles("IgnoreTitles");
 static const QLatin1String scCustomFont1("CustomFont1");
@@ -275,7 +276,7 @@ Settings Settings::fromFileAndPrefix(const QString &path, const QString &prefix,
 				<< scWizardDefaultWidth << scWizardDefaultHeight
 				<< scRepositorySettingsPageVisible << scTargetConfigurationFile
 				<< scRemoteRepositories << scTranslations << QLatin1String(scControlScript)
-				<< scCreateLocalRepository
+				<< scCreateLocalRepository << scMaxConcurrentDownloads
 				<< scStyleSheet << scIgnoreTitles << scProductUUID << scCustomFont1 << scCustomFont2 << scApplicationId;
 
 	Settings s;
@@ -343,6 +344,8 @@ Settings Settings::fromFileAndPrefix(const QString &path, const QString &prefix,
 		s.d->m_data.insert(scRepositorySettingsPageVisible, true);
 	if (!s.d->m_data.contains(scCreateLocalRepository))
 		s.d->m_data.insert(scCreateLocalRepository, false);
+	if (!s.d->m_data.contains(scMaxConcurrentDownloads))
+		s.d->m_data.insert(scMaxConcurrentDownloads, 4);
 
 #ifdef LUMIT_INSTALLER
 	s.loadQtSettings();
@@ -511,6 +514,11 @@ bool Settings::allowNonAsciiCharacters() const
 	return d->m_data.value(scAllowNonAsciiCharacters, false).toBool();
 }
 
+int Settings::maxConcurrentDownloads() const
+{
+	return qMax(1, d->m_data.value(scMaxConcurrentDownloads).toInt());
+}
+
 bool Settings::dependsOnLocalInstallerBinary() const
 {
 	return d->m_data.value(scDependsOnLocalInstallerBinary).toBool();
@@ -115,6 +115,7 @@ public:
     QString configurationFileName() const;
 
     bool createLocalRepository() const;
+    int maxConcurrentDownloads() const;
 
     bool dependsOnLocalInstallerBinary() const;
     bool hasReplacementRepos() const;
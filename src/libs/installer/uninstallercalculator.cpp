@@ -77,6 +77,8 @@ void UninstallerCalculator::appendComponentsToUninstall(const QList<Component*>
         appendComponentToUninstall(component);
 
     QList<Component*> autoDependOnList;
+    // names (and replaced names) of all installed components, collected on first use
+    QSet<QString> installedNames;
     // All regular dependees are resolved. Now we are looking for auto depend on components.
     foreach (Component *component, m_installedComponents) {
         // If a components is installed and not yet scheduled for un-installation, check for auto depend.
@@ -101,12 +103,21 @@ void UninstallerCalculator::appendComponentsToUninstall(const QList<Component*>
                 continue;
             }
 
-            foreach (Component *c, m_installedComponents) {
-                const QString replaces = c->value(scReplaces);
-                const QStringList possibleNames = replaces.split(QInstaller::commaRegExp(),
-                                                                 QString::SkipEmptyParts) << c->name();
-                foreach (const QString &possibleName, possibleNames)
-                    autoDependencies.removeAll(possibleName);
+            if (installedNames.isEmpty()) {
+                foreach (Component *c, m_installedComponents) {
+                    const QString replaces = c->value(scReplaces);
+                    installedNames.unite(replaces.split(QInstaller::commaRegExp(),
+                        QString::SkipEmptyParts).toSet());
+                    installedNames.insert(c->name());
+                }
+            }
+
+            QStringList::iterator it = autoDependencies.begin();
+            while (it != autoDependencies.end()) {
+                if (installedNames.contains(*it))
+                    it = autoDependencies.erase(it);
+                else
+                    ++it;
             }
 
             // A component requested auto installation, keep it to resolve their dependencies as well.
@@ -39,6 +39,7 @@
 #include <QDir>
 #include <QProcessEnvironment>
 #include <QThread>
+#include <QThreadStorage>
 #include <QVector>
 
 #if defined(Q_OS_WIN) || defined(Q_OS_WINCE)
@@ -152,7 +153,11 @@ QByteArray QInstaller::calculateHash(QIODevice *device, QCryptographicHash::Algo
 {
     Q_ASSERT(device);
     QCryptographicHash hash(algo);
-    static QByteArray buffer(1024 * 1024, '\0');
+    // one buffer per thread, the function is used by FileHasher's thread pool
+    static QThreadStorage<QByteArray> buffers;
+    QByteArray &buffer = buffers.localData();
+    if (buffer.isEmpty())
+        buffer.resize(1024 * 1024);
     while (true) {
         const qint64 numRead = device->read(buffer.data(), buffer.size());
         if (numRead <= 0)
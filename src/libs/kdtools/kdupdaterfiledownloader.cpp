@@ -50,8 +50,18 @@
 #include <QDebug>
 #include <QSslError>
 #include <QBasicTimer>
+#include <QCoreApplication>
+#include <QMutex>
+#include <QThread>
 #include <QTimerEvent>
 
+#include <functional>
+
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
 using namespace KDUpdater;
 using namespace QInstaller;
 
@@ -615,6 +625,132 @@ void KDUpdater::FileDownloader::setIgnoreSslErrors(bool ignore)
 
 // -- KDUpdater::LocalFileDownloader
 
+namespace {
+
+/*
+    Copies one local file on a worker thread. The source is read through a large aligned buffer and
+    every block is passed to the checksum function before it is written, so the SHA-1 sum is ready
+    when the copy is. Where the file system supports it, the data is cloned by the kernel instead
+    (reflink) and the buffer is only used for the checksum pass. Without a destination file the
+    source is only hashed.
+*/
+class LocalFileCopyThread : public QThread
+{
+    Q_DECLARE_TR_FUNCTIONS(KDUpdater::LocalFileDownloader)
+
+public:
+    typedef std::function<void (const char *, int)> CheckSumFunction;
+
+    enum {
+        BufferSize = 1024 * 1024,
+        BufferAlignment = 4096
+    };
+
+    LocalFileCopyThread(QFile *source, QFile *destination, const CheckSumFunction &addCheckSum)
+        : m_source(source)
+        , m_destination(destination)
+        , m_addCheckSum(addCheckSum)
+        , m_bytesCopied(0)
+        , m_bytesTotal(source->size())
+    {}
+
+    void cancel()
+    {
+        m_canceled.storeRelease(1);
+    }
+
+    bool isCanceled() const
+    {
+        return m_canceled.loadAcquire() != 0;
+    }
+
+    void progress(qint64 *bytesCopied, qint64 *bytesTotal) const
+    {
+        QMutexLocker _(&m_mutex);
+        *bytesCopied = m_bytesCopied;
+        *bytesTotal = m_bytesTotal;
+    }
+
+    // Only valid once the thread has finished.
+    QString errorString() const
+    {
+        return m_errorString;
+    }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        char *buffer = static_cast<char *>(qMallocAligned(BufferSize, BufferAlignment));
+        if (!buffer) {
+            m_errorString = tr("Cannot allocate copy buffer.");
+            return;
+        }
+
+        const bool cloned = m_destination && cloneFile();
+        while (!isCanceled()) {
+            const qint64 numRead = m_source->read(buffer, BufferSize);
+            if (numRead < 0) {
+                m_errorString = tr("Reading from %1 failed: %2").arg(m_source->fileName(),
+                    m_source->errorString());
+                break;
+            }
+            if (numRead == 0)
+                break;
+
+            m_addCheckSum(buffer, int(numRead));
+            if (m_destination && !cloned && !writeBlock(buffer, numRead))
+                break;
+
+            QMutexLocker _(&m_mutex);
+            m_bytesCopied += numRead;
+        }
+        qFreeAligned(buffer);
+
+        if (m_errorString.isEmpty() && !isCanceled() && m_destination && !m_destination->flush()) {
+            m_errorString = tr("Writing to %1 failed: %2").arg(m_destination->fileName(),
+                m_destination->errorString());
+        }
+    }
+
+private:
+    bool writeBlock(const char *data, qint64 size)
+    {
+        qint64 toWrite = size;
+        while (toWrite > 0) {
+            const qint64 numWritten = m_destination->write(data + size - toWrite, toWrite);
+            if (numWritten < 0) {
+                m_errorString = tr("Writing to %1 failed: %2").arg(m_destination->fileName(),
+                    m_destination->errorString());
+                return false;
+            }
+            toWrite -= numWritten;
+        }
+        return true;
+    }
+
+    bool cloneFile()
+    {
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+        return ::ioctl(m_destination->handle(), FICLONE, m_source->handle()) == 0;
+#else
+        return false;
+#endif
+    }
+
+private:
+    QFile *m_source;
+    QFile *m_destination;
+    CheckSumFunction m_addCheckSum;
+
+    QAtomicInt m_canceled;
+    mutable QMutex m_mutex;
+    qint64 m_bytesCopied;
+    qint64 m_bytesTotal;
+    QString m_errorString;
+};
+
+} // namespace
+
 /*!
     \inmodule kdupdater
     \class KDUpdater::LocalFileDownloader
@@ -623,9 +759,13 @@ void KDUpdater::FileDownloader::setIgnoreSslErrors(bool ignore)
 
     The user of KDUpdater might be simultaneously downloading several files;
     sometimes in parallel to other file downloaders. If copying a local file takes
-    a long time, it will make the other downloads hang. Therefore, a timer is used
-    and one block of data is copied per unit time, even though QFile::copy() does the
-    task of copying local files from one place to another.
+    a long time, it will make the other downloads hang. Therefore, the file is copied
+    on a worker thread in large blocks, or cloned by the file system where supported,
+    while the SHA-1 checksum is calculated on the fly. Progress is picked up by the
+    download speed timer, so it is reported at the same rate as for the other downloaders.
+
+    If useSourceInPlace() is \c true, the source file is not copied at all: it is only
+    read to calculate the checksum, and downloadedFileName() returns its path.
 */
 
 struct KDUpdater::LocalFileDownloader::Private
@@ -633,15 +773,19 @@ struct KDUpdater::LocalFileDownloader::Private
     Private()
         : source(0)
         , destination(0)
+        , copier(0)
+        , bytesCopied(0)
         , downloaded(false)
-        , timerId(-1)
+        , inPlace(false)
     {}
 
     QFile *source;
     QFile *destination;
+    LocalFileCopyThread *copier;
+    qint64 bytesCopied;
     QString destFileName;
     bool downloaded;
-    int timerId;
+    bool inPlace;
 };
 
 /*!
@@ -658,7 +802,15 @@ KDUpdater::LocalFileDownloader::LocalFileDownloader(QObject *parent)
 */
 KDUpdater::LocalFileDownloader::~LocalFileDownloader()
 {
-    if (this->isAutoRemoveDownloadedFile() && !d->destFileName.isEmpty())
+    if (d->copier) {
+        d->copier->cancel();
+        d->copier->wait();
+        delete d->copier;
+    }
+    delete d->destination;
+    delete d->source;
+
+    if (this->isAutoRemoveDownloadedFile() && !d->inPlace && !d->destFileName.isEmpty())
         QFile::remove(d->destFileName);
 
     delete d;
@@ -688,12 +840,12 @@ void KDUpdater::LocalFileDownloader::doDownload()
         return;
 
     // Already started downloading
-    if (d->timerId >= 0)
+    if (d->copier)
         return;
 
     // Open source and destination files
     QString localFile = this->url().toLocalFile();
-    d->source = new QFile(localFile, this);
+    d->source = new QFile(localFile);
     if (!d->source->open(QFile::ReadOnly)) {
         onError();
         setDownloadAborted(tr("Cannot open source file '%1' for reading.").arg(QFileInfo(localFile)
@@ -701,25 +853,32 @@ void KDUpdater::LocalFileDownloader::doDownload()
         return;
     }
 
-    if (d->destFileName.isEmpty()) {
-        QTemporaryFile *file = new QTemporaryFile(this);
-        file->open();
-        d->destination = file;
-    } else {
-        d->destination = new QFile(d->destFileName, this);
-        d->destination->open(QIODevice::ReadWrite | QIODevice::Truncate);
-    }
+    if (!d->inPlace) {
+        if (d->destFileName.isEmpty()) {
+            QTemporaryFile *file = new QTemporaryFile;
+            file->open();
+            d->destination = file;
+        } else {
+            d->destination = new QFile(d->destFileName);
+            d->destination->open(QIODevice::ReadWrite | QIODevice::Truncate);
+        }
 
-    if (!d->destination->isOpen()) {
-        onError();
-        setDownloadAborted(tr("Cannot open destination file '%1' for writing.")
-            .arg(QFileInfo(d->destination->fileName()).fileName()));
-        return;
+        if (!d->destination->isOpen()) {
+            onError();
+            setDownloadAborted(tr("Cannot open destination file '%1' for writing.")
+                .arg(QFileInfo(d->destination->fileName()).fileName()));
+            return;
+        }
     }
 
+    // The worker is the only one touching the checksum until it has finished.
+    d->bytesCopied = 0;
+    d->copier = new LocalFileCopyThread(d->source, d->destination,
+        [this](const char *data, int length) { addCheckSumData(data, length); });
+    connect(d->copier, SIGNAL(finished()), this, SLOT(onCopyFinished()));
+
     runDownloadSpeedTimer();
-    // Start a timer and kickoff the copy process
-    d->timerId = startTimer(0); // as fast as possible
+    d->copier->start();
 
     emit downloadStarted();
     emit downloadProgress(0);
@@ -747,7 +906,27 @@ void KDUpdater::LocalFileDownloader::setDownloadedFileName(const QString &name)
 */
 KDUpdater::LocalFileDownloader *KDUpdater::LocalFileDownloader::clone(QObject *parent) const
 {
-    return new LocalFileDownloader(parent);
+    LocalFileDownloader *downloader = new LocalFileDownloader(parent);
+    downloader->setUseSourceInPlace(d->inPlace);
+    return downloader;
+}
+
+/*!
+    Returns \c true if the source file is used in place instead of being copied.
+*/
+bool KDUpdater::LocalFileDownloader::useSourceInPlace() const
+{
+    return d->inPlace;
+}
+
+/*!
+    Determines that the source file is used in place instead of being copied if \a inPlace is
+    \c true. The file is still read once to calculate its checksum, the downloaded file name is
+    set to the source path, and the file is never removed automatically.
+*/
+void KDUpdater::LocalFileDownloader::setUseSourceInPlace(bool inPlace)
+{
+    d->inPlace = inPlace;
 }
 
 /*!
@@ -755,11 +934,13 @@ KDUpdater::LocalFileDownloader *KDUpdater::LocalFileDownloader::clone(QObject *p
 */
 void KDUpdater::LocalFileDownloader::cancelDownload()
 {
-    if (d->timerId < 0)
+    if (!d->copier)
         return;
 
-    killTimer(d->timerId);
-    d->timerId = -1;
+    d->copier->cancel();
+    d->copier->wait();
+    delete d->copier;
+    d->copier = 0;
 
     onError();
     setDownloadCanceled();
@@ -770,43 +951,15 @@ void KDUpdater::LocalFileDownloader::cancelDownload()
 */
 void KDUpdater::LocalFileDownloader::timerEvent(QTimerEvent *event)
 {
-    if (event->timerId() == d->timerId) {
-        if (!d->source || !d->destination)
-            return;
-
-        const qint64 blockSize = 32768;
-        QByteArray buffer;
-        buffer.resize(blockSize);
-        const qint64 numRead = d->source->read(buffer.data(), buffer.size());
-        qint64 toWrite = numRead;
-        while (toWrite > 0) {
-            const qint64 numWritten = d->destination->write(buffer.constData() + numRead - toWrite, toWrite);
-            if (numWritten < 0) {
-                killTimer(d->timerId);
-                d->timerId = -1;
-                onError();
-                setDownloadAborted(tr("Writing to %1 failed: %2").arg(d->destination->fileName(),
-                    d->destination->errorString()));
-                return;
-            }
-            toWrite -= numWritten;
-        }
-        addSample(numRead);
-        addCheckSumData(buffer.data(), numRead);
-
-        if (numRead > 0) {
-            setProgress(d->source->pos(), d->source->size());
-            emit downloadProgress(calcProgress(d->source->pos(), d->source->size()));
-            return;
+    if (event->timerId() == downloadSpeedTimerId()) {
+        if (d->copier) {
+            qint64 bytesCopied, bytesTotal;
+            d->copier->progress(&bytesCopied, &bytesTotal);
+            addSample(bytesCopied - d->bytesCopied);
+            d->bytesCopied = bytesCopied;
+            setProgress(bytesCopied, bytesTotal);
+            emit downloadProgress(calcProgress(bytesCopied, bytesTotal));
         }
-
-        d->destination->flush();
-
-        killTimer(d->timerId);
-        d->timerId = -1;
-
-        setDownloadCompleted();
-    } else if (event->timerId() == downloadSpeedTimerId()) {
         emitDownloadSpeed();
         emitDownloadStatus();
         emitDownloadProgress();
@@ -814,6 +967,34 @@ void KDUpdater::LocalFileDownloader::timerEvent(QTimerEvent *event)
     }
 }
 
+/*!
+    Finishes the download after the worker thread has copied the file.
+*/
+void KDUpdater::LocalFileDownloader::onCopyFinished()
+{
+    // A canceled copy has already been cleaned up, a restarted one may still be running.
+    if (!d->copier || !d->copier->isFinished())
+        return;
+
+    qint64 bytesCopied, bytesTotal;
+    d->copier->progress(&bytesCopied, &bytesTotal);
+    const QString error = d->copier->errorString();
+    delete d->copier;
+    d->copier = 0;
+
+    if (!error.isEmpty()) {
+        onError();
+        setDownloadAborted(error);
+        return;
+    }
+
+    addSample(bytesCopied - d->bytesCopied);
+    d->bytesCopied = bytesCopied;
+    setProgress(bytesCopied, bytesTotal);
+    emit downloadProgress(calcProgress(bytesCopied, bytesTotal));
+    setDownloadCompleted();
+}
+
 /*!
     Closes the destination file after it has been successfully copied and stops
     the download speed timer.
@@ -821,10 +1002,14 @@ void KDUpdater::LocalFileDownloader::timerEvent(QTimerEvent *event)
 void LocalFileDownloader::onSuccess()
 {
     d->downloaded = true;
-    d->destFileName = d->destination->fileName();
-    if (QTemporaryFile *file = dynamic_cast<QTemporaryFile *>(d->destination))
-        file->setAutoRemove(false);
-    d->destination->close();
+    if (d->destination) {
+        d->destFileName = d->destination->fileName();
+        if (QTemporaryFile *file = dynamic_cast<QTemporaryFile *>(d->destination))
+            file->setAutoRemove(false);
+        d->destination->close();
+    } else {
+        d->destFileName = d->source->fileName();
+    }
     delete d->destination;
     d->destination = 0;
     delete d->source;
@@ -57,6 +57,9 @@ public:
     void setDownloadedFileName(const QString &name);
     LocalFileDownloader *clone(QObject *parent = 0) const;
 
+    bool useSourceInPlace() const;
+    void setUseSourceInPlace(bool inPlace);
+
 public Q_SLOTS:
     void cancelDownload();
 
@@ -67,6 +70,7 @@ protected:
 
 private Q_SLOTS:
     void doDownload();
+    void onCopyFinished();
 
 private:
     struct Private;
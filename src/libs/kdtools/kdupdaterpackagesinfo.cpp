@@ -35,7 +35,9 @@
 #include "kdupdaterpackagesinfo.h"
 #include "globals.h"
 
+#include <QDataStream>
 #include <QFileInfo>
+#include <QHash>
 #include <QtXml/QDomDocument>
 #include <QtXml/QDomElement>
 #include <QVector>
@@ -57,6 +59,12 @@ using namespace KDUpdater;
             packageInfoCount() and packageInfo() methods.
     \endlist
 
+    Changes to the installed packages can be recorded in an append-only journal next to the XML
+    file using writeToJournal(). Each call only appends the packages changed since the last call,
+    so marking a single package as installed does not depend on the total number of packages. The
+    journal is folded into the XML file by the next writeToDisk() call, or replayed and compacted
+    by refresh() if the previous run did not finish properly.
+
     Instances of this class cannot be created. Each instance of KDUpdater::Application has one
     instance of this class associated with it. You can fetch a pointer to an instance of this class
     for an application via the KDUpdater::Application::packagesInfo() method.
@@ -77,6 +85,14 @@ using namespace KDUpdater;
                                             descriptions.
 */
 
+static const quint32 scJournalMagic = 0x4b444a31; // "KDJ1"
+
+enum JournalRecordType {
+    StoreRecord = 1,
+    RemoveRecord,
+    ClearRecord
+};
+
 struct PackagesInfo::PackagesInfoData
 {
     PackagesInfoData() :
@@ -91,11 +107,167 @@ struct PackagesInfo::PackagesInfoData
     bool modified;
 
     QVector<PackageInfo> packageInfoList;
+    QHash<QString, int> packageIndex;
+
+    // records not yet appended to the journal file
+    QByteArray pendingJournal;
 
     void addPackageFrom(const QDomElement &packageE);
+    void appendPackage(const PackageInfo &info);
+    void rebuildPackageIndex();
     void setInvalidContentError(const QString &detail);
+
+    QString journalFileName() const;
+    void journalStore(const PackageInfo &info);
+    void journalRemove(const QString &name);
+    void journalClear();
+    void appendJournalRecord(const QByteArray &payload);
+    bool replayJournal();
 };
 
+namespace KDUpdater {
+
+static QDataStream &operator<<(QDataStream &stream, const PackageInfo &info)
+{
+    stream << info.name << info.pixmap << info.title << info.description << info.version
+        << info.inheritVersionFrom << info.dependencies << info.translations << info.lastUpdateDate
+        << info.installDate << info.forcedInstallation << info.virtualComp << info.uncompressedSize;
+    return stream;
+}
+
+static QDataStream &operator>>(QDataStream &stream, PackageInfo &info)
+{
+    stream >> info.name >> info.pixmap >> info.title >> info.description >> info.version
+        >> info.inheritVersionFrom >> info.dependencies >> info.translations >> info.lastUpdateDate
+        >> info.installDate >> info.forcedInstallation >> info.virtualComp >> info.uncompressedSize;
+    return stream;
+}
+
+} // namespace KDUpdater
+
+void PackagesInfo::PackagesInfoData::appendPackage(const PackageInfo &info)
+{
+    packageIndex.insert(info.name, packageInfoList.count());
+    packageInfoList.append(info);
+}
+
+void PackagesInfo::PackagesInfoData::rebuildPackageIndex()
+{
+    packageIndex.clear();
+    packageIndex.reserve(packageInfoList.count());
+    for (int i = 0; i < packageInfoList.count(); ++i)
+        packageIndex.insert(packageInfoList.at(i).name, i);
+}
+
+QString PackagesInfo::PackagesInfoData::journalFileName() const
+{
+    if (fileName.isEmpty())
+        return QString();
+    return fileName + QLatin1String(".journal");
+}
+
+void PackagesInfo::PackagesInfoData::journalStore(const PackageInfo &info)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << qint32(StoreRecord) << info;
+    appendJournalRecord(payload);
+}
+
+void PackagesInfo::PackagesInfoData::journalRemove(const QString &name)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << qint32(RemoveRecord) << name;
+    appendJournalRecord(payload);
+}
+
+void PackagesInfo::PackagesInfoData::journalClear()
+{
+    // everything recorded before is obsolete now
+    pendingJournal.clear();
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << qint32(ClearRecord);
+    appendJournalRecord(payload);
+}
+
+/*
+    Every record is framed by a magic value, the payload size and a checksum, so that a record
+    which was only partly written when the process died is detected and dropped on replay.
+*/
+void PackagesInfo::PackagesInfoData::appendJournalRecord(const QByteArray &payload)
+{
+    QDataStream stream(&pendingJournal, QIODevice::WriteOnly | QIODevice::Append);
+    stream << scJournalMagic << quint32(payload.size())
+        << quint16(qChecksum(payload.constData(), payload.size()));
+    stream.writeRawData(payload.constData(), payload.size());
+}
+
+/*
+    Applies all complete records of the journal file on top of the packages read from the XML file.
+    Returns \c true if at least one record was applied.
+*/
+bool PackagesInfo::PackagesInfoData::replayJournal()
+{
+    QFile journal(journalFileName());
+    if (!journal.exists() || !journal.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray data = journal.readAll();
+    journal.close();
+
+    bool applied = false;
+    QDataStream stream(data);
+    while (!stream.atEnd()) {
+        quint32 magic = 0;
+        quint32 size = 0;
+        quint16 checksum = 0;
+        stream >> magic >> size >> checksum;
+        if (stream.status() != QDataStream::Ok || magic != scJournalMagic)
+            break;
+
+        QByteArray payload(int(size), Qt::Uninitialized);
+        if (size > quint32(data.size()) || stream.readRawData(payload.data(), int(size)) != int(size))
+            break;
+        if (qChecksum(payload.constData(), payload.size()) != checksum)
+            break;
+
+        QDataStream record(payload);
+        qint32 type = 0;
+        record >> type;
+        switch (type) {
+            case StoreRecord: {
+                PackageInfo info;
+                record >> info;
+                const int index = packageIndex.value(info.name, -1);
+                if (index == -1)
+                    appendPackage(info);
+                else
+                    packageInfoList[index] = info;
+            }   break;
+            case RemoveRecord: {
+                QString name;
+                record >> name;
+                const int index = packageIndex.value(name, -1);
+                if (index != -1) {
+                    packageInfoList.remove(index);
+                    rebuildPackageIndex();
+                }
+            }   break;
+            case ClearRecord:
+                packageInfoList.clear();
+                packageIndex.clear();
+                break;
+            default:
+                break;
+        }
+        applied = true;
+    }
+    return applied;
+}
+
 void PackagesInfo::PackagesInfoData::setInvalidContentError(const QString &detail)
 {
     error = PackagesInfo::InvalidContentError;
@@ -231,12 +403,7 @@ PackageInfo PackagesInfo::packageInfo(int index) const
 */
 int PackagesInfo::findPackageInfo(const QString &pkgName) const
 {
-    for (int i = 0; i < d->packageInfoList.count(); i++) {
-        if (d->packageInfoList[i].name == pkgName)
-            return i;
-    }
-
-    return -1;
+    return d->packageIndex.value(pkgName, -1);
 }
 
 /*!
@@ -258,6 +425,8 @@ void PackagesInfo::refresh()
     d->applicationName.clear();
     d->applicationVersion.clear();
     d->packageInfoList.clear();
+    d->packageIndex.clear();
+    d->pendingJournal.clear();
     d->modified = false;
 
     QFile file(d->fileName);
@@ -266,6 +435,11 @@ void PackagesInfo::refresh()
     if (!file.exists()) {
         d->error = NotYetReadError;
         d->errorMessage = tr("The file %1 does not exist.").arg(d->fileName);
+        // a previous run might have died before writing the file for the first time
+        if (d->replayJournal()) {
+            d->modified = true;
+            writeToDisk();
+        }
         emit reset();
         return;
     }
@@ -320,6 +494,12 @@ void PackagesInfo::refresh()
 
     d->error = NoError;
     d->errorMessage.clear();
+
+    // recover changes of a previous run that did not get compacted into the XML file
+    if (d->replayJournal()) {
+        d->modified = true;
+        writeToDisk();
+    }
     emit reset();
 }
 
@@ -352,7 +532,8 @@ bool PackagesInfo::installPackage(const QString &name, const QString &version,
     info.forcedInstallation = forcedInstallation;
     info.virtualComp = virtualComp;
     info.uncompressedSize = uncompressedSize;
-    d->packageInfoList.push_back(info);
+    d->appendPackage(info);
+    d->journalStore(info);
     d->modified = true;
     return true;
 }
@@ -372,6 +553,7 @@ bool PackagesInfo::updatePackage(const QString &name, const QString &version, co
 
     d->packageInfoList[index].version = version;
     d->packageInfoList[index].lastUpdateDate = date;
+    d->journalStore(d->packageInfoList.at(index));
     d->modified = true;
     return true;
 }
@@ -388,6 +570,8 @@ bool PackagesInfo::removePackage(const QString &name)
         return false;
 
     d->packageInfoList.remove(index);
+    d->rebuildPackageIndex();
+    d->journalRemove(name);
     d->modified = true;
     return true;
 }
@@ -407,6 +591,37 @@ static void addTextChildHelper(QDomNode *node,
     node->appendChild(domElement);
 }
 
+/*!
+    Returns the name of the journal file that records changes not yet written to fileName().
+*/
+QString PackagesInfo::journalFileName() const
+{
+    return d->journalFileName();
+}
+
+/*!
+    Appends the changes done since the last call to the journal file. Use writeToDisk() to write
+    the complete installation information file and discard the journal.
+*/
+void PackagesInfo::writeToJournal()
+{
+#if defined(LUMIT_INSTALLER) && defined(Q_OS_OSX)
+    // Same as in writeToDisk(), we do not create any files next to Lumit.app
+    d->pendingJournal.clear();
+#else
+    if (d->pendingJournal.isEmpty() || d->fileName.isEmpty())
+        return;
+
+    QFile journal(d->journalFileName());
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append))
+        return;
+
+    if (journal.write(d->pendingJournal) == d->pendingJournal.size() && journal.flush())
+        d->pendingJournal.clear();
+    journal.close();
+#endif
+}
+
 /*!
     Writes the installation information file to disk.
 */
@@ -460,10 +675,18 @@ void PackagesInfo::writeToDisk()
         if (!file.open(QFile::WriteOnly))
             return;
 
-        file.write(doc.toByteArray(4));
+        const QByteArray content = doc.toByteArray(4);
+        const bool written = (file.write(content) == content.size()) && file.flush();
         file.close();
+        if (!written)
+            return;
         d->modified = false;
     }
+
+    // everything is in the XML file now, so the journal is obsolete
+    d->pendingJournal.clear();
+    if (!d->fileName.isEmpty() && QFile::exists(d->journalFileName()))
+        QFile::remove(d->journalFileName());
 #endif
 }
 
@@ -512,7 +735,7 @@ void PackagesInfo::PackagesInfoData::addPackageFrom(const QDomElement &packageE)
             info.installDate = QDate::fromString(childNodeE.text(), Qt::ISODate);
     }
 
-    this->packageInfoList.append(info);
+    appendPackage(info);
 }
 
 /*!
@@ -521,6 +744,8 @@ void PackagesInfo::PackagesInfoData::addPackageFrom(const QDomElement &packageE)
 void PackagesInfo::clearPackageInfoList()
 {
     d->packageInfoList.clear();
+    d->packageIndex.clear();
+    d->journalClear();
     d->modified = true;
     emit reset();
 }
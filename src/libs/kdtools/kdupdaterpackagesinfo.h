@@ -98,6 +98,9 @@ public:
     QVector<KDUpdater::PackageInfo> packageInfos() const;
     void writeToDisk();
 
+    QString journalFileName() const;
+    void writeToJournal();
+
     bool installPackage(const QString &pkgName, const QString &version, const QString &title = QString(),
                         const QString &description = QString(), const QStringList &dependencies = QStringList(),
                         bool forcedInstallation = false, bool virtualComp = false, quint64 uncompressedSize = 0,
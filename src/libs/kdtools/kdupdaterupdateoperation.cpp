@@ -348,10 +348,9 @@ bool UpdateOperation::deleteFileNowOrLater(const QString &file, QString *errorSt
 
 /*!
     Saves operation arguments and values as an XML document and returns the
-    document. You can override this method to store your
-    own extra-data. Extra-data can be any data that you need to store to perform or undo the
-    operation. The default implementation is taking care of arguments and values set via
-    UpdateOperation::setValue().
+    document. The values are the ones returned by persistentValues(); override that function
+    to store your own extra-data. Extra-data can be any data that you need to store to perform
+    or undo the operation.
 */
 QDomDocument UpdateOperation::toXml() const
 {
@@ -365,19 +364,20 @@ QDomDocument UpdateOperation::toXml() const
         args.appendChild(arg);
     }
     root.appendChild(args);
-    if (m_values.isEmpty())
+    const QVariantMap persistent = persistentValues();
+    if (persistent.isEmpty())
         return doc;
 
     // append all values set with setValue
     QDomElement values = doc.createElement(QLatin1String("values"));
-    for (QVariantMap::const_iterator it = m_values.begin(); it != m_values.end(); ++it) {
+    for (QVariantMap::const_iterator it = persistent.begin(); it != persistent.end(); ++it) {
         QDomElement value = doc.createElement(QLatin1String("value"));
         const QVariant& variant = it.value();
         value.setAttribute(QLatin1String("name"), it.key());
         value.setAttribute(QLatin1String("type"), QLatin1String( QVariant::typeToName( variant.type())));
 
         if (variant.type() != QVariant::List && variant.type() != QVariant::StringList
-            && variant.canConvert(QVariant::String)) {
+            && variant.type() != QVariant::ByteArray && variant.canConvert(QVariant::String)) {
             // it can convert to string? great!
             value.appendChild( doc.createTextNode(variant.toString()));
         } else {
@@ -410,7 +410,7 @@ bool UpdateOperation::fromXml(const QDomDocument &doc)
     }
     setArguments(args);
 
-    m_values.clear();
+    QVariantMap persistent;
     const QDomElement values = root.firstChildElement(QLatin1String("values"));
     for (QDomNode n = values.firstChild(); !n.isNull(); n = n.nextSibling()) {
         const QDomElement v = n.toElement();
@@ -423,15 +423,16 @@ bool UpdateOperation::fromXml(const QDomDocument &doc)
 
         const QVariant::Type t = QVariant::nameToType(type.toLatin1().data());
         QVariant var = qVariantFromValue(value);
-        if (t == QVariant::List || t == QVariant::StringList || !var.convert(t)) {
+        if (t == QVariant::List || t == QVariant::StringList || t == QVariant::ByteArray
+            || !var.convert(t)) {
             QDataStream stream(QByteArray::fromBase64( value.toLatin1()));
             stream >> var;
         }
 
-        m_values[name] = var;
+        persistent[name] = var;
     }
 
-    return true;
+    return setPersistentValues(persistent);
 }
 
 /*!
@@ -452,3 +453,26 @@ bool UpdateOperation::fromXml(const QString &xml)
     }
     return fromXml(doc);
 }
+
+/*!
+    Returns the values that are saved together with the arguments of the operation, for example
+    by toXml(). The default implementation returns all values set via UpdateOperation::setValue().
+    Override this method to leave out values that only matter while the operation runs, or to
+    add your own extra-data.
+
+    \sa setPersistentValues()
+*/
+QVariantMap UpdateOperation::persistentValues() const
+{
+    return m_values;
+}
+
+/*!
+    Replaces the values of the operation with \a values previously returned by persistentValues(),
+    for example by fromXml(). Returns \c true on success, otherwise \c false.
+*/
+bool UpdateOperation::setPersistentValues(const QVariantMap &values)
+{
+    m_values = values;
+    return true;
+}
@@ -84,6 +84,9 @@ public:
     virtual bool fromXml(const QString &xml);
     virtual bool fromXml(const QDomDocument &doc);
 
+    virtual QVariantMap persistentValues() const;
+    virtual bool setPersistentValues(const QVariantMap &values);
+
 protected:
     void setName(const QString &name);
     void setErrorString(const QString &errorString);
@@ -51,7 +51,7 @@ public:
     bool testOperation();
     CopyOperation *clone() const;
 
-    QDomDocument toXml() const;
+    QVariantMap persistentValues() const;
 private:
     QString sourcePath();
     QString destinationPath();
@@ -82,7 +82,7 @@ public:
     bool testOperation();
     DeleteOperation *clone() const;
 
-    QDomDocument toXml() const;
+    QVariantMap persistentValues() const;
 };
 
 class KDTOOLS_EXPORT MkdirOperation : public UpdateOperation
@@ -36,15 +36,50 @@
 #include "utils.h"
 
 #include <QFile>
+#include <QFileInfo>
 #include <QLocale>
+#include <QMutex>
 #include <QPair>
 #include <QVector>
 #include <QUrl>
+#include <QXmlStreamReader>
 
 using namespace KDUpdater;
 
+namespace {
+
+struct UpdatesInfoCache
+{
+    QMutex mutex;
+    QHash<QString, UpdatesInfo> infos;
+};
+Q_GLOBAL_STATIC(UpdatesInfoCache, updatesInfoCache)
+
+/*
+    Returns the shared copy of \a name, so that all packages of one file use the same key strings
+    instead of allocating one per element.
+*/
+QString internedKey(QHash<QString, QString> &keys, const QStringRef &name)
+{
+    const QString key = name.toString();
+    QHash<QString, QString>::const_iterator it = keys.constFind(key);
+    if (it == keys.constEnd())
+        it = keys.insert(key, key);
+    return it.value();
+}
+
+QString elementText(QXmlStreamReader &reader)
+{
+    return reader.readElementText(QXmlStreamReader::IncludeChildElements);
+}
+
+} // namespace
+
 UpdatesInfoData::UpdatesInfoData()
      : error(UpdatesInfo::NotYetReadError)
+     , hasChecksum(false)
+     , checksum(true)
+     , fileSize(-1)
 {
 }
 
@@ -54,6 +89,8 @@ UpdatesInfoData::~UpdatesInfoData()
 
 void UpdatesInfoData::setInvalidContentError(const QString &detail)
 {
+    if (error == UpdatesInfo::InvalidContentError)
+        return; // keep the first error
     error = UpdatesInfo::InvalidContentError;
     errorMessage = tr("Updates.xml contains invalid content: %1").arg(detail);
 }
@@ -67,37 +104,47 @@ void UpdatesInfoData::parseFile(const QString &updateXmlFile)
         return;
     }
 
-    QDomDocument doc;
-    QString parseErrorMessage;
-    int parseErrorLine, parseErrorColumn;
-    if (!doc.setContent(&file, &parseErrorMessage, &parseErrorLine, &parseErrorColumn)) {
+    const QFileInfo fileInfo(file);
+    fileSize = fileInfo.size();
+    lastModified = fileInfo.lastModified();
+
+    QHash<QString, QString> keys;
+    QXmlStreamReader reader(&file);
+    if (reader.readNextStartElement()) {
+        if (reader.name() != QLatin1String("Updates")) {
+            setInvalidContentError(tr("Root element %1 unexpected, should be \"Updates\".")
+                .arg(reader.name().toString()));
+            return;
+        }
+
+        while (reader.readNextStartElement()) {
+            if (reader.name() == QLatin1String("ApplicationName")) {
+                applicationName = elementText(reader);
+            } else if (reader.name() == QLatin1String("ApplicationVersion")) {
+                applicationVersion = elementText(reader);
+            } else if (reader.name() == QLatin1String("Checksum")) {
+                hasChecksum = true;
+                checksum = (elementText(reader).toLower() == QLatin1String("true"));
+            } else if (reader.name() == QLatin1String("PackageUpdate")) {
+                parsePackageUpdateElement(reader, keys); // error handled in subroutine
+            } else if (reader.name() == QLatin1String("RepositoryUpdate")) {
+                parseRepositoryUpdateElement(reader);
+            } else {
+                reader.skipCurrentElement();
+            }
+        }
+    }
+
+    if (reader.hasError()) {
         error = UpdatesInfo::InvalidXmlError;
         errorMessage = tr("Parse error in %1 at %2, %3: %4").arg(updateXmlFile,
-            QString::number(parseErrorLine), QString::number(parseErrorColumn), parseErrorMessage);
+            QString::number(reader.lineNumber()), QString::number(reader.columnNumber()),
+            reader.errorString());
         return;
     }
 
-    QDomElement rootE = doc.documentElement();
-    if (rootE.tagName() != QLatin1String("Updates")) {
-        setInvalidContentError(tr("Root element %1 unexpected, should be \"Updates\".").arg(rootE.tagName()));
+    if (error == UpdatesInfo::InvalidContentError)
         return;
-    }
-
-    QDomNodeList childNodes = rootE.childNodes();
-    for(int i = 0; i < childNodes.count(); i++) {
-        const QDomElement childE = childNodes.at(i).toElement();
-        if (childE.isNull())
-            continue;
-
-        if (childE.tagName() == QLatin1String("ApplicationName"))
-            applicationName = childE.text();
-        else if (childE.tagName() == QLatin1String("ApplicationVersion"))
-            applicationVersion = childE.text();
-        else if (childE.tagName() == QLatin1String("PackageUpdate")) {
-            if (!parsePackageUpdateElement(childE))
-                return; //error handled in subroutine
-        }
-    }
 
     if (applicationName.isEmpty()) {
         setInvalidContentError(tr("ApplicationName element is missing."));
@@ -113,50 +160,55 @@ void UpdatesInfoData::parseFile(const QString &updateXmlFile)
     error = UpdatesInfo::NoError;
 }
 
-bool UpdatesInfoData::parsePackageUpdateElement(const QDomElement &updateE)
+bool UpdatesInfoData::parsePackageUpdateElement(QXmlStreamReader &reader,
+    QHash<QString, QString> &keys)
 {
-    if (updateE.isNull())
-        return false;
-
     UpdateInfo info;
     QMap<QString, QString> localizedDescriptions;
-    for (int i = 0; i < updateE.childNodes().count(); i++) {
-        QDomElement childE = updateE.childNodes().at(i).toElement();
-        if (childE.isNull())
-            continue;
-
-        if (childE.tagName() == QLatin1String("ReleaseNotes")) {
-            info.data[childE.tagName()] = QUrl(childE.text());
-        } else if (childE.tagName() == QLatin1String("Licenses")) {
+    while (reader.readNextStartElement()) {
+        if (reader.name() == QLatin1String("ReleaseNotes")) {
+            info.data.insert(QLatin1String("ReleaseNotes"), QUrl(elementText(reader)));
+        } else if (reader.name() == QLatin1String("Licenses")) {
             QHash<QString, QVariant> licenseHash;
-            const QDomNodeList licenseNodes = childE.childNodes();
-            for (int i = 0; i < licenseNodes.count(); ++i) {
-                const QDomNode licenseNode = licenseNodes.at(i);
-                if (licenseNode.nodeName() == QLatin1String("License")) {
-                    QDomElement element = licenseNode.toElement();
-                    licenseHash.insert(element.attributeNode(QLatin1String("name")).value(),
-                        element.attributeNode(QLatin1String("file")).value());
+            while (reader.readNextStartElement()) {
+                if (reader.name() == QLatin1String("License")) {
+                    const QXmlStreamAttributes attributes = reader.attributes();
+                    licenseHash.insert(attributes.value(QLatin1String("name")).toString(),
+                        attributes.value(QLatin1String("file")).toString());
                 }
+                reader.skipCurrentElement();
             }
             if (!licenseHash.isEmpty())
                 info.data.insert(QLatin1String("Licenses"), licenseHash);
-        } else if (childE.tagName() == QLatin1String("Version")) {
+        } else if (reader.name() == QLatin1String("Version")) {
             info.data.insert(QLatin1String("inheritVersionFrom"),
-                childE.attribute(QLatin1String("inheritVersionFrom")));
-            info.data[childE.tagName()] = childE.text();
-        } else if (childE.tagName() == QLatin1String("Description")) {
-            if (!childE.hasAttribute(QLatin1String("xml:lang")))
-                info.data[QLatin1String("Description")] = childE.text();
-            QString languageAttribute = childE.attribute(QLatin1String("xml:lang"), QLatin1String("en"));
-            localizedDescriptions.insert(languageAttribute.toLower(), childE.text());
-        } else if (childE.tagName() == QLatin1String("UpdateFile")) {
-            info.data[QLatin1String("CompressedSize")] = childE.attribute(QLatin1String("CompressedSize"));
-            info.data[QLatin1String("UncompressedSize")] = childE.attribute(QLatin1String("UncompressedSize"));
+                reader.attributes().value(QLatin1String("inheritVersionFrom")).toString());
+            info.data.insert(QLatin1String("Version"), elementText(reader));
+        } else if (reader.name() == QLatin1String("Description")) {
+            const QXmlStreamAttributes attributes = reader.attributes();
+            const bool hasLanguage = attributes.hasAttribute(QLatin1String("xml:lang"));
+            const QString language = hasLanguage
+                ? attributes.value(QLatin1String("xml:lang")).toString() : QLatin1String("en");
+            const QString text = elementText(reader);
+            if (!hasLanguage)
+                info.data.insert(QLatin1String("Description"), text);
+            localizedDescriptions.insert(language.toLower(), text);
+        } else if (reader.name() == QLatin1String("UpdateFile")) {
+            const QXmlStreamAttributes attributes = reader.attributes();
+            info.data.insert(QLatin1String("CompressedSize"),
+                attributes.value(QLatin1String("CompressedSize")).toString());
+            info.data.insert(QLatin1String("UncompressedSize"),
+                attributes.value(QLatin1String("UncompressedSize")).toString());
+            reader.skipCurrentElement();
         } else {
-            info.data[childE.tagName()] = childE.text();
+            const QString key = internedKey(keys, reader.name());
+            info.data.insert(key, elementText(reader));
         }
     }
 
+    if (reader.hasError())
+        return false; // reported by the caller
+
     QStringList candidates;
     foreach (const QString &lang, QLocale().uiLanguages())
         candidates << QInstaller::localeCandidates(lang.toLower());
@@ -184,6 +236,23 @@ bool UpdatesInfoData::parsePackageUpdateElement(const QDomElement &updateE)
     return true;
 }
 
+void UpdatesInfoData::parseRepositoryUpdateElement(QXmlStreamReader &reader)
+{
+    while (reader.readNextStartElement()) {
+        if (reader.name() == QLatin1String("Repository")) {
+            RepositoryUpdateInfo info;
+            info.lineNumber = reader.lineNumber();
+            foreach (const QXmlStreamAttribute &attribute, reader.attributes()) {
+                info.attributes.insert(attribute.qualifiedName().toString(),
+                    attribute.value().toString());
+            }
+            info.action = info.attributes.value(QLatin1String("action"));
+            repositoryUpdateList.append(info);
+        }
+        reader.skipCurrentElement();
+    }
+}
+
 
 //
 // UpdatesInfo
@@ -207,17 +276,16 @@ QString UpdatesInfo::errorString() const
     return d->errorMessage;
 }
 
+UpdatesInfo::Error UpdatesInfo::error() const
+{
+    return static_cast<Error>(d->error);
+}
+
 void UpdatesInfo::setFileName(const QString &updateXmlFile)
 {
-    if (d->updateXmlFile == updateXmlFile)
+    if (d.constData()->updateXmlFile == updateXmlFile)
         return;
-
-    d->applicationName.clear();
-    d->applicationVersion.clear();
-    d->updateInfoList.clear();
-
-    d->updateXmlFile = updateXmlFile;
-    d->parseFile(d->updateXmlFile);
+    *this = fromFile(updateXmlFile);
 }
 
 QString UpdatesInfo::fileName() const
@@ -251,3 +319,63 @@ QList<UpdateInfo> UpdatesInfo::updatesInfo() const
 {
     return d->updateInfoList;
 }
+
+/*!
+    Returns whether the file contains a top level Checksum element.
+*/
+bool UpdatesInfo::hasChecksum() const
+{
+    return d->hasChecksum;
+}
+
+/*!
+    Returns the value of the Checksum element, or \c true if there is none.
+*/
+bool UpdatesInfo::checksum() const
+{
+    return d->checksum;
+}
+
+QList<RepositoryUpdateInfo> UpdatesInfo::repositoryUpdates() const
+{
+    return d->repositoryUpdateList;
+}
+
+/*!
+    Returns the parsed content of \a updateXmlFile. The file is read only once as long as its size
+    and modification time do not change; all callers share the same immutable package table.
+*/
+UpdatesInfo UpdatesInfo::fromFile(const QString &updateXmlFile)
+{
+    const QFileInfo fileInfo(updateXmlFile);
+    const QString key = fileInfo.absoluteFilePath();
+
+    UpdatesInfoCache *const cache = updatesInfoCache();
+    {
+        QMutexLocker _(&cache->mutex);
+        const UpdatesInfo info = cache->infos.value(key);
+        if (info.d->fileSize >= 0 && info.d->fileSize == fileInfo.size()
+            && info.d->lastModified == fileInfo.lastModified()) {
+                return info;
+        }
+    }
+
+    UpdatesInfo info;
+    info.d->updateXmlFile = updateXmlFile;
+    info.d->parseFile(updateXmlFile);
+
+    QMutexLocker _(&cache->mutex);
+    if (info.d->fileSize >= 0)
+        cache->infos.insert(key, info);
+    return info;
+}
+
+/*!
+    Drops all parsed files from the cache used by fromFile().
+*/
+void UpdatesInfo::clearCache()
+{
+    UpdatesInfoCache *const cache = updatesInfoCache();
+    QMutexLocker _(&cache->mutex);
+    cache->infos.clear();
+}
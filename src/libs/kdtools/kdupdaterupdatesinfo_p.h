@@ -52,6 +52,13 @@ struct KDTOOLS_EXPORT UpdateInfo
     QHash<QString, QVariant> data;
 };
 
+struct KDTOOLS_EXPORT RepositoryUpdateInfo
+{
+    QString action;
+    QHash<QString, QString> attributes;
+    qint64 lineNumber;
+};
+
 class KDTOOLS_EXPORT UpdatesInfo
 {
 public:
@@ -78,9 +85,16 @@ public:
     QString applicationName() const;
     QString applicationVersion() const;
 
+    bool hasChecksum() const;
+    bool checksum() const;
+
     int updateInfoCount() const;
     UpdateInfo updateInfo(int index) const;
     QList<UpdateInfo> updatesInfo() const;
+    QList<RepositoryUpdateInfo> repositoryUpdates() const;
+
+    static UpdatesInfo fromFile(const QString &updateXmlFile);
+    static void clearCache();
 
 private:
     QSharedDataPointer<UpdatesInfoData> d;
@@ -36,12 +36,18 @@
 #define KD_UPDATER_UPDATE_INFO_DATA_H
 
 #include <QCoreApplication>
-#include <QDomElement>
+#include <QDateTime>
+#include <QHash>
 #include <QSharedData>
 
+QT_BEGIN_NAMESPACE
+class QXmlStreamReader;
+QT_END_NAMESPACE
+
 namespace KDUpdater {
 
 struct UpdateInfo;
+struct RepositoryUpdateInfo;
 
 struct UpdatesInfoData : public QSharedData
 {
@@ -57,9 +63,16 @@ public:
     QString applicationName;
     QString applicationVersion;
     QList<UpdateInfo> updateInfoList;
+    QList<RepositoryUpdateInfo> repositoryUpdateList;
+    bool hasChecksum;
+    bool checksum;
+
+    qint64 fileSize;
+    QDateTime lastModified;
 
     void parseFile(const QString &updateXmlFile);
-    bool parsePackageUpdateElement(const QDomElement &updateE);
+    bool parsePackageUpdateElement(QXmlStreamReader &reader, QHash<QString, QString> &keys);
+    void parseRepositoryUpdateElement(QXmlStreamReader &reader);
 
     void setInvalidContentError(const QString &detail);
 };
@@ -38,6 +38,7 @@
 #include <fileio.h>
 #include <kdupdaterupdateoperation.h>
 
+#include <QBuffer>
 #include <QTest>
 #include <QTemporaryFile>
 
@@ -324,6 +325,91 @@ private slots:
         resource->close();
     }
 
+    void readMappedResource()
+    {
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        QInstaller::blockingWrite(&file, QByteArray("prefix|Resource content.|suffix"));
+        file.close();
+
+        Resource resource(file.fileName(), Range<qint64>::fromStartAndLength(7, 17));
+        QCOMPARE(resource.mappedData() == 0, true);
+        QCOMPARE(resource.open(), true);
+        QVERIFY(resource.mappedData() != 0);
+        QCOMPARE(QByteArray((const char *) resource.mappedData(), 17), QByteArray("Resource content."));
+
+        QCOMPARE(resource.seek(9), true);
+        QCOMPARE(resource.read(7), QByteArray("content"));
+        QCOMPARE(resource.seek(0), true);
+        QCOMPARE(resource.readAll(), QByteArray("Resource content."));
+
+        QTemporaryFile copy;
+        QVERIFY(copy.open());
+        resource.seek(0);
+        resource.copyData(&copy);
+        copy.seek(0);
+        QCOMPARE(copy.readAll(), QByteArray("Resource content."));
+
+        resource.close();
+        QCOMPARE(resource.mappedData() == 0, true);
+    }
+
+    void writeDuplicateResources()
+    {
+        QTemporaryFile data;
+        QVERIFY(data.open());
+        QInstaller::blockingWrite(&data, QByteArray("Shared archive.|Shared archive.|Other archive.."));
+        data.close();
+
+        ResourceCollection collection(QByteArray("Collection 1"));
+        collection.appendResource(QSharedPointer<Resource>(new Resource(data.fileName(),
+            Range<qint64>::fromStartAndLength(0, 15))));
+        collection.resources().last()->setName("Resource 1");
+        collection.appendResource(QSharedPointer<Resource>(new Resource(data.fileName(),
+            Range<qint64>::fromStartAndLength(32, 15))));
+        collection.resources().last()->setName("Resource 2");
+
+        ResourceCollection collection2(QByteArray("Collection 2"));
+        collection2.appendResource(QSharedPointer<Resource>(new Resource(data.fileName(),
+            Range<qint64>::fromStartAndLength(16, 15))));
+        collection2.resources().last()->setName("Resource 3");
+
+        ResourceCollectionManager manager;
+        manager.insertCollection(collection);
+        manager.insertCollection(collection2);
+
+        QTemporaryFile binary;
+        QInstaller::openForWrite(&binary);
+        const Range<qint64> segment = manager.write(&binary, 0);
+        binary.close();
+
+        // three resources of 15 bytes each, two of them identical
+        const qint64 tables = 2 * sizeof(qint64) + 3 * (sizeof(qint64) + 10 + 2 * sizeof(qint64));
+        QCOMPARE(segment.start(), qint64(sizeof(qint64) + tables + 2 * 15));
+
+        QInstaller::openForRead(&binary);
+        binary.seek(segment.start());
+        ResourceCollectionManager read;
+        read.read(&binary, 0);
+        binary.close();
+
+        QSharedPointer<Resource> shared = read.collectionByName("Collection 1")
+            .resourceByName("Resource 1");
+        QSharedPointer<Resource> other = read.collectionByName("Collection 1")
+            .resourceByName("Resource 2");
+        QSharedPointer<Resource> duplicate = read.collectionByName("Collection 2")
+            .resourceByName("Resource 3");
+        QCOMPARE(duplicate->segment(), shared->segment());
+        QVERIFY(other->segment().start() != shared->segment().start());
+
+        QVERIFY(duplicate->open());
+        QCOMPARE(duplicate->readAll(), QByteArray("Shared archive."));
+        duplicate->close();
+        QVERIFY(other->open());
+        QCOMPARE(other->readAll(), QByteArray("Other archive.."));
+        other->close();
+    }
+
     void testWriteBinaryContentFunction()
     {
         ResourceCollection collection(QByteArray("QResources"));
@@ -398,12 +484,122 @@ private slots:
         resource->close();
     }
 
+    void blockingCopy_data()
+    {
+        QTest::addColumn<qint64>("size");
+        QTest::addColumn<bool>("fromFile");
+        QTest::newRow("empty, file") << 0LL << true;
+        QTest::newRow("tiny, file") << scTinySize << true;
+        QTest::newRow("large, file") << scLargeSize << true;
+        QTest::newRow("tiny, buffer") << scTinySize << false;
+        QTest::newRow("large, buffer") << scLargeSize << false;
+    }
+
+    void blockingCopy()
+    {
+        QFETCH(qint64, size);
+        QFETCH(bool, fromFile);
+
+        const QByteArray data = patternData(size + scTinySize);
+
+        QTemporaryFile file;
+        QBuffer buffer;
+        QIODevice *in = &buffer;
+        if (fromFile) {
+            QInstaller::openForWrite(&file);
+            QInstaller::blockingWrite(&file, data);
+            file.close();
+            QInstaller::openForRead(&file);
+            in = &file;
+        } else {
+            buffer.setData(data);
+            QVERIFY(buffer.open(QIODevice::ReadOnly));
+        }
+
+        QTemporaryFile out;
+        QInstaller::openForWrite(&out);
+        try {
+            // start in the middle of both files, with unflushed data in the output buffer
+            QVERIFY(in->seek(scTinySize));
+            QInstaller::blockingWrite(&out, QByteArray("prefix"));
+            QCOMPARE(QInstaller::blockingCopy(in, &out, size), size);
+            QCOMPARE(in->pos(), scTinySize + size);
+            QCOMPARE(out.pos(), 6 + size);
+            QInstaller::blockingWrite(&out, QByteArray("suffix"));
+        } catch (const QInstaller::Error &error) {
+            QFAIL(qPrintable(error.message()));
+        }
+        out.close();
+
+        QInstaller::openForRead(&out);
+        QCOMPARE(out.readAll(), QByteArray("prefix") + data.mid(scTinySize) + "suffix");
+    }
+
+    void benchmarkBlockingCopy_data()
+    {
+        QTest::addColumn<bool>("fromFile");
+        QTest::newRow("file to file") << true;
+        QTest::newRow("resource to file") << false;
+    }
+
+    void benchmarkBlockingCopy()
+    {
+        QFETCH(bool, fromFile);
+
+        const qint64 size = 2 * scLargeSize;
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        QInstaller::blockingWrite(&file, patternData(size));
+        file.close();
+
+        // a resource is no QFileDevice, so it is always copied through the buffer
+        QFile source(file.fileName());
+        Resource resource(file.fileName(), Range<qint64>::fromStartAndLength(0, size));
+        QIODevice *in = &resource;
+        if (fromFile) {
+            QInstaller::openForRead(&source);
+            in = &source;
+        } else {
+            QVERIFY(resource.open());
+        }
+
+        QTemporaryFile out;
+        QInstaller::openForWrite(&out);
+
+        QBENCHMARK {
+            QVERIFY(in->seek(0));
+            QVERIFY(out.seek(0));
+            try {
+                QInstaller::blockingCopy(in, &out, size);
+                QVERIFY(out.flush());
+            } catch (const QInstaller::Error &error) {
+                QFAIL(qPrintable(error.message()));
+            }
+        }
+        QCOMPARE(out.size(), size);
+    }
+
     void cleanupTestCase()
     {
         m_manager.clear();
         QFile::remove(m_binary);
     }
 
+private:
+    static QByteArray patternData(qint64 size)
+    {
+        QByteArray block(251, '\0');
+        for (int i = 0; i < block.size(); ++i)
+            block[i] = char(i);
+
+        QByteArray data;
+        data.reserve(size);
+        while (data.size() < size)
+            data.append(block);
+        data.truncate(size);
+        return data;
+    }
+
 private:
     Layout m_layout;
     QString m_binary;
@@ -32,11 +32,16 @@
 **
 **************************************************************************/
 
+#include <binaryformatenginehandler.h>
+#include <extractarchiveoperation.h>
+#include <init.h>
+#include <lib7z_facade.h>
 #include <protocol.h>
 #include <qprocesswrapper.h>
 #include <qsettingswrapper.h>
 #include <remoteclient.h>
 #include <remotefileengine.h>
+#include <remotefileoperations.h>
 #include <remoteserver.h>
 
 #include <QBuffer>
@@ -44,6 +49,7 @@
 #include <QLocalSocket>
 #include <QTest>
 #include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QUuid>
 #include <QLocalServer>
@@ -55,17 +61,17 @@ class tst_ClientServer : public QObject
     Q_OBJECT
 
 private:
-    template<typename T>
-    void sendCommand(QIODevice *device, const QByteArray &cmd, T t)
+    template<typename T1, typename T2>
+    void sendCommand(QIODevice *device, quint16 cmd, T1 t1, T2 t2)
     {
         QByteArray data;
         QDataStream stream(&data, QIODevice::WriteOnly);
-        stream << t;
+        stream << t1 << t2;
         sendPacket(device, cmd, data);
     }
 
     template<typename T>
-    void receiveCommand(QIODevice *device, QByteArray *cmd, T *t)
+    void receiveCommand(QIODevice *device, quint16 *cmd, T *t)
     {
         QByteArray data;
         while (!receivePacket(device, cmd, &data))
@@ -92,14 +98,15 @@ private slots:
             QBuffer device(&validPackage);
             device.open(QBuffer::WriteOnly);
 
-            const QByteArray cmd = "say";
+            const quint16 cmd = 0x1234;
             const QByteArray data = "hello" ;
             QInstaller::sendPacket(&device, cmd, data);
 
-            // 1 is delimiter (\0)
-            QCOMPARE(device.buffer().size(), (int)sizeof(PackageSize) + cmd.size() + 1 + data.size());
+            QCOMPARE(device.buffer().size(), (int)(sizeof(PackageSize) + sizeof(quint16))
+                + data.size());
             QCOMPARE(device.buffer().right(data.size()), data);
-            QCOMPARE(device.buffer().mid(sizeof(PackageSize), cmd.size()), cmd);
+            QCOMPARE(device.buffer().mid(sizeof(PackageSize), sizeof(quint16)),
+                QByteArray(reinterpret_cast<const char *>(&cmd), sizeof(quint16)));
         }
 
         // now try successful receivePacket ...
@@ -107,12 +114,12 @@ private slots:
             QBuffer device(&validPackage);
             device.open(QBuffer::ReadOnly);
 
-            QByteArray cmd;
+            quint16 cmd = 0;
             QByteArray data;
             QCOMPARE(QInstaller::receivePacket(&device, &cmd, &data), true);
 
             QCOMPARE(device.pos(), device.size());
-            QCOMPARE(cmd, QByteArray("say"));
+            QCOMPARE(cmd, quint16(0x1234));
             QCOMPARE(data, QByteArray("hello"));
         }
 
@@ -125,12 +132,12 @@ private slots:
             QBuffer device(&incompletePackage);
             device.open(QBuffer::ReadOnly);
 
-            QByteArray cmd;
+            quint16 cmd = 0;
             QByteArray data;
             QCOMPARE(QInstaller::receivePacket(&device, &cmd, &data), false);
 
             QCOMPARE(device.pos(), 0);
-            QCOMPARE(cmd, QByteArray());
+            QCOMPARE(cmd, quint16(0));
             QCOMPARE(data, QByteArray());
 
             // make packet complete again, retry
@@ -140,7 +147,7 @@ private slots:
             QCOMPARE(QInstaller::receivePacket(&device, &cmd, &data), true);
 
             QCOMPARE(device.pos(), device.size());
-            QCOMPARE(cmd, QByteArray("say"));
+            QCOMPARE(cmd, quint16(0x1234));
             QCOMPARE(data, QByteArray("hello"));
         }
     }
@@ -155,14 +162,15 @@ private slots:
 
         QEventLoop loop;
 
-        const QByteArray command = "HELLO";
+        const quint16 command = 0x4242;
         const QByteArray message(10905, '0');
 
         QLocalServer server;
         { // server
             QLocalSocket *rcv = 0;
             auto srvDataArrived = [&]() {
-                QByteArray command, message;
+                quint16 command;
+                QByteArray message;
                 if (!receivePacket(rcv, &command, &message))
                     return;
                 sendPacket(rcv, command, message);
@@ -180,7 +188,8 @@ private slots:
         QLocalSocket snd;
         { // client
             auto clientDataArrived = [&]() {
-                QByteArray cmd, msg;
+                quint16 cmd;
+                QByteArray msg;
                 if (!receivePacket(&snd, &cmd, &msg))
                     return;
                 QCOMPARE(cmd, command);
@@ -216,23 +225,25 @@ private slots:
         QVERIFY2(socket.waitForConnected(), "Could not connect to server.");
         QCOMPARE(socket.state() == QLocalSocket::ConnectedState, true);
 
-        sendCommand(&socket, Protocol::Authorize, QString(Protocol::DefaultAuthorizationKey));
+        sendCommand(&socket, Protocol::Authorize, QString(Protocol::DefaultAuthorizationKey),
+            Protocol::Version);
 
         {
-            QByteArray command;
+            quint16 command;
             bool authorized;
             receiveCommand(&socket, &command, &authorized);
-            QCOMPARE(command, QByteArray(Protocol::Reply));
+            QCOMPARE(command, quint16(Protocol::Reply));
             QCOMPARE(authorized, true);
         }
 
-        sendCommand(&socket, Protocol::Authorize, QString::fromLatin1("Some Key"));
+        sendCommand(&socket, Protocol::Authorize, QString::fromLatin1("Some Key"),
+            Protocol::Version);
 
         {
-            QByteArray command;
+            quint16 command;
             bool authorized;
             receiveCommand(&socket, &command, &authorized);
-            QCOMPARE(command, QByteArray(Protocol::Reply));
+            QCOMPARE(command, quint16(Protocol::Reply));
             QCOMPARE(authorized, false);
         }
     }
@@ -249,23 +260,49 @@ private slots:
         QVERIFY2(socket.waitForConnected(), "Could not connect to server.");
         QCOMPARE(socket.state() == QLocalSocket::ConnectedState, true);
 
-        sendCommand(&socket, Protocol::Authorize, QString::fromLatin1("SomeKey"));
+        sendCommand(&socket, Protocol::Authorize, QString::fromLatin1("SomeKey"),
+            Protocol::Version);
 
         {
-            QByteArray command;
+            quint16 command;
             bool authorized;
             receiveCommand(&socket, &command, &authorized);
-            QCOMPARE(command, QByteArray(Protocol::Reply));
+            QCOMPARE(command, quint16(Protocol::Reply));
             QCOMPARE(authorized, true);
         }
 
-        sendCommand(&socket, Protocol::Authorize, QString::fromLatin1(Protocol::DefaultAuthorizationKey));
+        sendCommand(&socket, Protocol::Authorize,
+            QString::fromLatin1(Protocol::DefaultAuthorizationKey),
+            Protocol::Version);
 
         {
-            QByteArray command;
+            quint16 command;
             bool authorized;
             receiveCommand(&socket, &command, &authorized);
-            QCOMPARE(command, QByteArray(Protocol::Reply));
+            QCOMPARE(command, quint16(Protocol::Reply));
+            QCOMPARE(authorized, false);
+        }
+    }
+
+    void testServerProtocolVersion()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QString("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        QLocalSocket socket;
+        socket.connectToServer(socketName);
+        QVERIFY2(socket.waitForConnected(), "Could not connect to server.");
+
+        sendCommand(&socket, Protocol::Authorize, QString::fromLatin1("SomeKey"),
+            Protocol::Version + 1);
+
+        {
+            quint16 command;
+            bool authorized;
+            receiveCommand(&socket, &command, &authorized);
+            QCOMPARE(command, quint16(Protocol::Reply));
             QCOMPARE(authorized, false);
         }
     }
@@ -390,6 +427,36 @@ private slots:
         wrapper.endGroup();
     }
 
+    void testQSettingsWrapperDeferredCalls()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QSettingsWrapper writer("digia", "clientserver");
+        QSettingsWrapper reader("digia", "clientserver");
+        writer.clear();
+        QCOMPARE(writer.isConnectedToServer(), true);
+
+        // deferred calls of one connection are seen by the next call of another one
+        writer.setValue("deferred", 42);
+        QCOMPARE(reader.value("deferred").toInt(), 42);
+        QCOMPARE(reader.isConnectedToServer(), true);
+        writer.remove("deferred");
+        QCOMPARE(reader.contains("deferred"), false);
+
+        // and they are sent once control returns to the event loop
+        writer.setValue("later", 23);
+        QTRY_COMPARE(QSettings("digia", "clientserver").value("later").toInt(), 23);
+
+        writer.clear();
+        writer.sync();
+    }
+
     void testQProcessWrapper()
     {
         RemoteServer server;
@@ -526,6 +593,194 @@ private slots:
         QCOMPARE(file.atEnd(), true);
     }
 
+    void testRemoteFileOperations()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString source = dir.path() + QLatin1String("/source");
+        QVERIFY(QDir().mkpath(source + QLatin1String("/sub")));
+        {
+            QFile file(source + QLatin1String("/sub/file.txt"));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(QByteArray(3 * 1024 * 1024, 'x'));
+        }
+
+        RemoteFileOperations operations;
+        QSignalSpy processed(&operations, SIGNAL(fileProcessed(QString)));
+
+        const QString target = dir.path() + QLatin1String("/target");
+        QVERIFY2(operations.copyTree(source, target), qPrintable(operations.errorString()));
+        QCOMPARE(operations.isConnectedToServer(), true);
+        QCOMPARE(processed.count(), 2);
+        QCOMPARE(QFileInfo(target + QLatin1String("/sub/file.txt")).size(), 3 * 1024 * 1024);
+
+        const QString copy = dir.path() + QLatin1String("/copy.txt");
+        QVERIFY(operations.copyFile(target + QLatin1String("/sub/file.txt"), copy));
+        QCOMPARE(QFileInfo(copy).size(), 3 * 1024 * 1024);
+        QCOMPARE(operations.copyFile(target + QLatin1String("/sub/file.txt"), copy), false);
+        QCOMPARE(operations.errorString().isEmpty(), false);
+
+        QVERIFY(operations.setPermissionsRecursively(target, QFile::ReadOwner | QFile::WriteOwner
+            | QFile::ExeOwner, QDir::Dirs));
+        QCOMPARE(QFileInfo(target + QLatin1String("/sub")).permissions() & QFile::ReadOther,
+            QFile::Permissions(0));
+
+        QVERIFY(operations.removeTree(target));
+        QCOMPARE(QFileInfo(target).exists(), false);
+
+        operations.cancel();
+        QCOMPARE(operations.copyTree(source, target), false);
+    }
+
+    void testRemoteCopyTreeSymlinks()
+    {
+#ifdef Q_OS_WIN
+        QSKIP("Creating symbolic links needs extra privileges on Windows.");
+#else
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString source = dir.path() + QLatin1String("/source");
+        QVERIFY(QDir().mkpath(source + QLatin1String("/lib")));
+        {
+            QFile file(source + QLatin1String("/lib/libfoo.so.1"));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write("foo");
+        }
+        QVERIFY(QFile::link(QLatin1String("libfoo.so.1"),
+            source + QLatin1String("/lib/libfoo.so")));
+        QVERIFY(QFile::link(source + QLatin1String("/lib"), source + QLatin1String("/libs")));
+
+        RemoteFileOperations operations;
+        const QString target = dir.path() + QLatin1String("/target");
+        QVERIFY2(operations.copyTree(source, target), qPrintable(operations.errorString()));
+        QCOMPARE(operations.isConnectedToServer(), true);
+
+        // a relative link stays relative, an absolute one into the tree points into the copy
+        QVERIFY(QFileInfo(target + QLatin1String("/lib/libfoo.so")).isSymLink());
+        QCOMPARE(QFile::symLinkTarget(target + QLatin1String("/lib/libfoo.so")),
+            QFileInfo(target + QLatin1String("/lib/libfoo.so.1")).absoluteFilePath());
+        QVERIFY(QFileInfo(target + QLatin1String("/libs")).isSymLink());
+        QCOMPARE(QFile::symLinkTarget(target + QLatin1String("/libs")),
+            QFileInfo(target + QLatin1String("/lib")).absoluteFilePath());
+#endif
+    }
+
+    void testRemoteExtractResource()
+    {
+        QInstaller::init();
+
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString content = dir.path() + QLatin1String("/content.txt");
+        {
+            QFile file(content);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(QByteArray(64 * 1024, 'x'));
+        }
+        QFile archive(dir.path() + QLatin1String("/content.7z"));
+        QVERIFY(archive.open(QIODevice::ReadWrite));
+        try {
+            Lib7z::createArchive(&archive, QStringList() << content);
+        } catch (const Lib7z::SevenZipException &e) {
+            QFAIL(e.message().toUtf8());
+        }
+        archive.close();
+
+        // embedded archives only exist in the client, the server cannot read them
+        const QString resource = QLatin1String("installer://clientserver/content.7z");
+        BinaryFormatEngineHandler::instance()->registerResource(resource, archive.fileName());
+
+        const QString target = dir.path() + QLatin1String("/target");
+        ExtractArchiveOperation op;
+        op.setArguments(QStringList() << resource << target);
+        QVERIFY2(op.performOperation(), qPrintable(op.errorString()));
+        QCOMPARE(QFileInfo(target + QLatin1String("/content.txt")).size(), qint64(64 * 1024));
+        QVERIFY(op.extractedFiles().contains(QDir::toNativeSeparators(QFileInfo(target
+            + QLatin1String("/content.txt")).absoluteFilePath())));
+    }
+
+    void testQSettingsWrapperDeferredOrder()
+    {
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QSettingsWrapper wrapper("digia", "clientserver");
+        wrapper.clear();
+        QCOMPARE(wrapper.isConnectedToServer(), true);
+
+        // more calls than fit into one batch
+        const int calls = 1000;
+        for (int i = 0; i < calls; ++i)
+            wrapper.setValue("key", i);
+        // the reply can only arrive once all deferred calls have been handled
+        QCOMPARE(wrapper.value("key", -1).toInt(), calls - 1);
+
+        wrapper.clear();
+    }
+
+    void benchmarkQSettingsWrapper_data()
+    {
+        QTest::addColumn<bool>("roundTrip");
+        QTest::newRow("setValue (deferred)") << false;
+        QTest::newRow("value (round trip)") << true;
+    }
+
+    void benchmarkQSettingsWrapper()
+    {
+        QFETCH(bool, roundTrip);
+
+        RemoteServer server;
+        QString socketName = QUuid::createUuid().toString();
+        server.init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Production);
+        server.start();
+
+        RemoteClient::instance().init(socketName, QLatin1String("SomeKey"), Protocol::Mode::Debug,
+                                      Protocol::StartAs::User);
+
+        QSettingsWrapper wrapper("digia", "clientserver");
+        wrapper.clear();
+        QCOMPARE(wrapper.isConnectedToServer(), true);
+
+        int i = 0;
+        QBENCHMARK {
+            if (roundTrip)
+                wrapper.value("key");
+            else
+                wrapper.setValue("key", ++i);
+        }
+
+        wrapper.clear();
+    }
+
     void cleanupTestCase()
     {
         RemoteClient::instance().setActive(false);
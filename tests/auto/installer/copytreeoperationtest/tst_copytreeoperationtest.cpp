@@ -0,0 +1,227 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include "init.h"
+#include "copytreeoperation.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace KDUpdater;
+using namespace QInstaller;
+
+class tst_copytreeoperationtest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static void writeFile(const QString &path, const QByteArray &content)
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(content);
+    }
+
+    static QByteArray readFile(const QString &path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+        return file.readAll();
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QInstaller::init();
+
+        QVERIFY(m_source.isValid());
+        const QDir source(m_source.path());
+        QVERIFY(source.mkpath(QLatin1String("lib/plugins")));
+        QVERIFY(source.mkpath(QLatin1String("empty")));
+        writeFile(source.filePath(QLatin1String("readme.txt")), "readme");
+        writeFile(source.filePath(QLatin1String("lib/libfoo.so")), "foo");
+        writeFile(source.filePath(QLatin1String("lib/libfoo.so.sha1")), "checksum");
+        writeFile(source.filePath(QLatin1String("lib/plugins/bar.so")), "bar");
+    }
+
+    void testMissingArguments()
+    {
+        CopyTreeOperation op;
+
+        QVERIFY(op.testOperation());
+        QVERIFY(!op.performOperation());
+
+        QCOMPARE(UpdateOperation::Error(op.error()), UpdateOperation::InvalidArguments);
+        QCOMPARE(op.errorString(), QString("Invalid arguments in CopyTree: 0 arguments given, "
+            "exactly 2 expected (<source> <target>)."));
+    }
+
+    void testSourceNotAFolder()
+    {
+        CopyTreeOperation op;
+        op.setArguments(QStringList() << m_source.path() + "/readme.txt" << m_source.path() + "/x");
+
+        QVERIFY(!op.performOperation());
+        QCOMPARE(UpdateOperation::Error(op.error()), UpdateOperation::UserDefinedError);
+    }
+
+    void testCopyAndUndo()
+    {
+        QTemporaryDir targetDir;
+        QVERIFY(targetDir.isValid());
+        const QString target = targetDir.path() + "/app";
+
+        CopyTreeOperation op;
+        op.setArguments(QStringList() << m_source.path() << target);
+        op.backup();
+        QVERIFY2(op.performOperation(), qPrintable(op.errorString()));
+
+        QCOMPARE(readFile(target + "/readme.txt"), QByteArray("readme"));
+        QCOMPARE(readFile(target + "/lib/libfoo.so"), QByteArray("foo"));
+        QCOMPARE(readFile(target + "/lib/plugins/bar.so"), QByteArray("bar"));
+        QVERIFY(QFileInfo(target + "/empty").isDir());
+        QVERIFY(!QFileInfo(target + "/lib/libfoo.so.sha1").exists());
+
+        // folders are created before the files inside of them
+        const QStringList files = op.copiedFiles();
+        QCOMPARE(files.count(), 7);
+        QCOMPARE(files.first(), target);
+        QVERIFY(files.indexOf(target + "/lib") < files.indexOf(target + "/lib/plugins/bar.so"));
+
+        CopyTreeOperation restored;
+        QVERIFY(restored.fromXml(op.toXml()));
+        QCOMPARE(restored.copiedFiles(), files);
+        QVERIFY(!restored.hasValue(QLatin1String("fileList")));
+
+        QVERIFY(restored.undoOperation());
+        QVERIFY(!QFileInfo(target).exists());
+        QVERIFY(QFileInfo(targetDir.path()).isDir());
+    }
+
+    void testMissingParent()
+    {
+        QTemporaryDir targetDir;
+        QVERIFY(targetDir.isValid());
+        const QString parent = targetDir.path() + "/opt";
+        const QString target = parent + "/vendor/app";
+
+        CopyTreeOperation op;
+        op.setArguments(QStringList() << m_source.path() << target);
+        op.backup();
+        QVERIFY2(op.performOperation(), qPrintable(op.errorString()));
+        QCOMPARE(readFile(target + "/lib/plugins/bar.so"), QByteArray("bar"));
+
+        // the outermost created folder comes first, so undo removes it as well
+        const QStringList files = op.copiedFiles();
+        QCOMPARE(files.first(), parent);
+        QVERIFY(files.contains(parent + "/vendor"));
+        QVERIFY(files.contains(target));
+
+        QVERIFY(op.undoOperation());
+        QVERIFY(!QFileInfo(parent).exists());
+        QCOMPARE(QDir(targetDir.path()).entryList(QDir::AllEntries | QDir::NoDotAndDotDot)
+            .count(), 0);
+    }
+
+    void testOverwriteAndRestore()
+    {
+        QTemporaryDir targetDir;
+        QVERIFY(targetDir.isValid());
+        const QString target = targetDir.path();
+        writeFile(target + "/readme.txt", "existing");
+        writeFile(target + "/keep.txt", "keep");
+
+        CopyTreeOperation op;
+        op.setArguments(QStringList() << m_source.path() << target);
+        op.backup();
+        QVERIFY2(op.performOperation(), qPrintable(op.errorString()));
+        QCOMPARE(readFile(target + "/readme.txt"), QByteArray("readme"));
+        QVERIFY(!op.copiedFiles().contains(target));
+
+        QVERIFY(op.undoOperation());
+        QCOMPARE(readFile(target + "/readme.txt"), QByteArray("existing"));
+        QCOMPARE(readFile(target + "/keep.txt"), QByteArray("keep"));
+        QVERIFY(!QFileInfo(target + "/lib").exists());
+        QCOMPARE(QDir(target).entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden)
+            .count(), 2);
+    }
+
+    void testSymlinks()
+    {
+#ifdef Q_OS_WIN
+        QSKIP("Creating symbolic links needs extra privileges on Windows.");
+#else
+        QTemporaryDir sourceDir;
+        QVERIFY(sourceDir.isValid());
+        const QString source = sourceDir.path() + "/app";
+        QVERIFY(QDir().mkpath(source + "/lib"));
+        writeFile(source + "/lib/libfoo.so.1", "foo");
+        QVERIFY(QFile::link(source + "/lib/libfoo.so.1", source + "/lib/libfoo.so"));
+        QVERIFY(QFile::link(source, source + "/lib/loop"));   // a cycle back to the top
+
+        QTemporaryDir targetDir;
+        QVERIFY(targetDir.isValid());
+        const QString target = targetDir.path() + "/app";
+
+        CopyTreeOperation op;
+        op.setArguments(QStringList() << source << target);
+        op.backup();
+        QVERIFY2(op.performOperation(), qPrintable(op.errorString()));
+
+        QCOMPARE(op.copiedFiles().count(), 5);
+        QVERIFY(QFileInfo(target + "/lib/libfoo.so").isSymLink());
+        QCOMPARE(QFileInfo(target + "/lib/libfoo.so").symLinkTarget(),
+            QFileInfo(target + "/lib/libfoo.so.1").absoluteFilePath());
+        QVERIFY(QFileInfo(target + "/lib/loop").isSymLink());
+        QCOMPARE(QFileInfo(target + "/lib/loop").symLinkTarget(), QFileInfo(target)
+            .absoluteFilePath());
+
+        QVERIFY(op.undoOperation());
+        QVERIFY(!QFileInfo(target).exists());
+        QCOMPARE(readFile(source + "/lib/libfoo.so.1"), QByteArray("foo"));
+#endif
+    }
+
+private:
+    QTemporaryDir m_source;
+};
+
+QTEST_MAIN(tst_copytreeoperationtest)
+
+#include "tst_copytreeoperationtest.moc"
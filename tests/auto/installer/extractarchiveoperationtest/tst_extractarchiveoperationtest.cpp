@@ -36,6 +36,7 @@
 #include "extractarchiveoperation.h"
 
 #include <QDir>
+#include <QFileInfo>
 #include <QObject>
 #include <QTest>
 
@@ -75,6 +76,37 @@ private slots:
         QVERIFY(op.undoOperation());
     }
 
+    void testExtractedFilesRoundTrip()
+    {
+        ExtractArchiveOperation op;
+        op.setArguments(QStringList() << ":///data/valid.7z" << QDir::tempPath());
+
+        QVERIFY(op.performOperation());
+        const QStringList files = op.extractedFiles();
+        QVERIFY(!files.isEmpty());
+        QVERIFY(QFileInfo(files.last()).exists());
+
+        ExtractArchiveOperation restored;
+        QVERIFY(restored.fromXml(op.toXml()));
+        QCOMPARE(restored.extractedFiles(), files);
+        QVERIFY(!restored.hasValue(QLatin1String("fileList")));
+
+        QVERIFY(restored.undoOperation());
+        QVERIFY(!QFileInfo(files.last()).exists());
+    }
+
+    void testReadLegacyFileList()
+    {
+        ExtractArchiveOperation op;
+        op.setArguments(QStringList() << ":///data/valid.7z" << QDir::tempPath());
+        op.setValue(QLatin1String("files"), QStringList() << "b" << "a");
+
+        ExtractArchiveOperation restored;
+        QVERIFY(restored.fromXml(op.toXml()));
+        QCOMPARE(restored.extractedFiles(), QStringList() << "a" << "b");
+        QVERIFY(!restored.hasValue(QLatin1String("files")));
+    }
+
     void testExtractOperationInvalidFile()
     {
         ExtractArchiveOperation op;
@@ -0,0 +1,163 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <filehasher.h>
+#include <fileio.h>
+
+#include <QDir>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+
+using namespace QInstaller;
+
+static const qint64 scLargeSize = 4194304LL;
+
+class tst_FileHasher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+        for (int i = 0; i < 8; ++i) {
+            const QByteArray data(scLargeSize + i, char('a' + i));
+            QFile file(m_dir.path() + QString::fromLatin1("/file%1").arg(i));
+            QInstaller::openForWrite(&file);
+            QInstaller::blockingWrite(&file, data);
+            m_files.append(file.fileName());
+            m_data.append(data);
+        }
+    }
+
+    void hashFiles_data()
+    {
+        QTest::addColumn<int>("algorithm");
+        QTest::addColumn<int>("threadCount");
+        QTest::newRow("SHA-1, one thread") << int(QCryptographicHash::Sha1) << 1;
+        QTest::newRow("SHA-1, four threads") << int(QCryptographicHash::Sha1) << 4;
+        QTest::newRow("SHA-256, four threads") << int(QCryptographicHash::Sha256) << 4;
+    }
+
+    void hashFiles()
+    {
+        QFETCH(int, algorithm);
+        QFETCH(int, threadCount);
+
+        FileHasher hasher(static_cast<QCryptographicHash::Algorithm>(algorithm));
+        hasher.setMaxThreadCount(threadCount);
+        const QList<FileHasher::Result> results = hasher.hashFiles(m_files);
+
+        QCOMPARE(results.count(), m_files.count());
+        for (int i = 0; i < results.count(); ++i) {
+            QCOMPARE(results.at(i).fileName, m_files.at(i));
+            QCOMPARE(results.at(i).errorString, QString());
+            QCOMPARE(results.at(i).hash, QCryptographicHash::hash(m_data.at(i),
+                QCryptographicHash::Algorithm(algorithm)));
+        }
+
+        qint64 bytes = 0;
+        foreach (const QByteArray &data, m_data)
+            bytes += data.size();
+        QCOMPARE(hasher.filesHashed(), m_files.count());
+        QCOMPARE(hasher.bytesHashed(), bytes);
+
+        hasher.resetCounters();
+        QCOMPARE(hasher.filesHashed(), 0);
+        QCOMPARE(hasher.bytesHashed(), 0LL);
+    }
+
+    void hashMissingFile()
+    {
+        FileHasher hasher;
+        const QString missing = m_dir.path() + QLatin1String("/missing");
+        const QList<FileHasher::Result> results = hasher.hashFiles(QStringList() << m_files.first()
+            << missing);
+
+        QCOMPARE(results.count(), 2);
+        QCOMPARE(results.at(0).errorString, QString());
+        QCOMPARE(results.at(1).fileName, missing);
+        QCOMPARE(results.at(1).hash, QByteArray());
+        QVERIFY(!results.at(1).errorString.isEmpty());
+        QCOMPARE(hasher.filesHashed(), 1);
+    }
+
+    void verifyFiles()
+    {
+        QHash<QString, QByteArray> expected;
+        for (int i = 0; i < m_files.count(); ++i)
+            expected.insert(m_files.at(i), QCryptographicHash::hash(m_data.at(i),
+                QCryptographicHash::Sha1));
+
+        FileHasher hasher;
+        QString errorString;
+        QCOMPARE(hasher.verifyFiles(expected, &errorString), QStringList());
+        QCOMPARE(errorString, QString());
+
+        expected.insert(m_files.at(3), QByteArray("corrupt"));
+        QCOMPARE(hasher.verifyFiles(expected, &errorString), QStringList() << m_files.at(3));
+        QVERIFY(!errorString.isEmpty());
+    }
+
+    void benchmarkHashFiles_data()
+    {
+        QTest::addColumn<int>("threadCount");
+        QTest::newRow("one thread") << 1;
+        QTest::newRow("ideal thread count") << QThread::idealThreadCount();
+    }
+
+    void benchmarkHashFiles()
+    {
+        QFETCH(int, threadCount);
+
+        FileHasher hasher(QCryptographicHash::Sha1);
+        hasher.setMaxThreadCount(threadCount);
+
+        QList<FileHasher::Result> results;
+        QBENCHMARK {
+            results = hasher.hashFiles(m_files);
+        }
+        QCOMPARE(results.count(), m_files.count());
+    }
+
+private:
+    QTemporaryDir m_dir;
+    QStringList m_files;
+    QList<QByteArray> m_data;
+};
+
+QTEST_MAIN(tst_FileHasher)
+
+#include "tst_filehasher.moc"
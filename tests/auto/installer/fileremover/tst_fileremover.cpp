@@ -0,0 +1,172 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <fileremover.h>
+
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace QInstaller;
+
+class tst_FileRemover : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Creates \a depth levels of folders below \a path with \a filesPerFolder files in each, and
+    // returns all created entries, every folder before its contents.
+    static QStringList createTree(const QString &path, int depth, int filesPerFolder)
+    {
+        QStringList entries;
+        for (int i = 0; i < filesPerFolder; ++i) {
+            QFile file(path + QString::fromLatin1("/file%1.txt").arg(i));
+            if (file.open(QIODevice::WriteOnly)) {
+                file.write("content");
+                entries.append(file.fileName());
+            }
+        }
+        if (depth == 0)
+            return entries;
+        for (int i = 0; i < 2; ++i) {
+            const QString folder = path + QString::fromLatin1("/folder%1").arg(i);
+            if (QDir().mkdir(folder))
+                entries.append(folder);
+            entries.append(createTree(folder, depth - 1, filesPerFolder));
+        }
+        return entries;
+    }
+
+private slots:
+    void removeTree_data()
+    {
+        QTest::addColumn<int>("threadCount");
+        QTest::newRow("one thread") << 1;
+        QTest::newRow("four threads") << 4;
+    }
+
+    void removeTree()
+    {
+        QFETCH(int, threadCount);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString root = dir.path() + QLatin1String("/root");
+        QVERIFY(QDir().mkdir(root));
+        const QStringList entries = createTree(root, 4, 40);
+        QCOMPARE(entries.count(), 30 + 31 * 40);
+
+        FileRemover remover;
+        remover.setMaxThreadCount(threadCount);
+
+        // the signal is emitted from the pool threads
+        QMutex mutex;
+        QList<QPair<int, int> > progress;
+        connect(&remover, &FileRemover::progressChanged, this, [&](int processed, int total) {
+            QMutexLocker _(&mutex);
+            progress.append(qMakePair(processed, total));
+        }, Qt::DirectConnection);
+
+        QVERIFY2(remover.removeTree(root), qPrintable(remover.errorString()));
+        QVERIFY(!QFileInfo(root).exists());
+        QCOMPARE(remover.entriesProcessed(), entries.count() + 1);
+
+        // reported in batches and once at the end
+        QVERIFY(progress.count() > 1);
+        QVERIFY(progress.count() < entries.count() / 100);
+        QCOMPARE(progress.last().first, entries.count() + 1);
+        QCOMPARE(progress.last().second, entries.count() + 1);
+    }
+
+    void removeTreeDoesNotFollowLinks()
+    {
+#ifdef Q_OS_WIN
+        QSKIP("Creating symbolic links needs extra privileges on Windows.");
+#endif
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString outside = dir.path() + QLatin1String("/outside");
+        const QString root = dir.path() + QLatin1String("/root");
+        QVERIFY(QDir().mkdir(outside));
+        QVERIFY(QDir().mkdir(root));
+        createTree(outside, 1, 2);
+        QVERIFY(QFile::link(outside, root + QLatin1String("/link")));
+
+        FileRemover remover;
+        QVERIFY2(remover.removeTree(root), qPrintable(remover.errorString()));
+        QVERIFY(!QFileInfo(root).exists());
+        QVERIFY(QFileInfo(outside + QLatin1String("/folder1/file1.txt")).exists());
+    }
+
+    void removeTreeMissingPath()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        FileRemover remover;
+        QVERIFY(remover.removeTree(dir.path() + QLatin1String("/missing")));
+        QVERIFY(!remover.removeTree(QString()));
+        QVERIFY(!remover.errorString().isEmpty());
+    }
+
+    void removePaths()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QStringList entries = createTree(dir.path(), 2, 8);
+
+        // a file nobody recorded keeps its folder alive
+        const QString foreign = dir.path() + QLatin1String("/folder1/foreign.txt");
+        QFile file(foreign);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.close();
+
+        FileRemover remover;
+        const QStringList failed = remover.removePaths(entries + QStringList(dir.path()
+            + QLatin1String("/missing.txt")));
+        QVERIFY2(failed.isEmpty(), qPrintable(remover.errorString()));
+
+        QVERIFY(QFileInfo(foreign).exists());
+        QCOMPARE(QDir(dir.path()).entryList(QDir::AllEntries | QDir::NoDotAndDotDot),
+            QStringList(QLatin1String("folder1")));
+        QCOMPARE(QDir(dir.path() + QLatin1String("/folder1")).entryList(QDir::AllEntries
+            | QDir::NoDotAndDotDot), QStringList(QLatin1String("foreign.txt")));
+    }
+};
+
+QTEST_MAIN(tst_FileRemover)
+
+#include "tst_fileremover.moc"
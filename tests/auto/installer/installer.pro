@@ -12,8 +12,12 @@ SUBDIRS += \
     consumeoutputoperationtest \
     mkdiroperationtest \
     copyoperationtest \
+    copytreeoperationtest \
     solver \
     binaryformat \
+    filehasher \
+    fileremover \
+    operationlog \
     packagemanagercore \
     settingsoperation \
     task \
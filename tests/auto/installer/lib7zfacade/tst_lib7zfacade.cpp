@@ -37,6 +37,7 @@
 
 #include <QDir>
 #include <QObject>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
 
@@ -120,6 +121,77 @@ private slots:
         }
     }
 
+    void testCreateArchiveWithOptions_data()
+    {
+        QTest::addColumn<int>("level");
+        QTest::addColumn<int>("method");
+        QTest::addColumn<qint64>("solidBlockSize");
+        QTest::addColumn<int>("threadCount");
+
+        QTest::newRow("defaults") << -1 << int(Lib7z::CompressionOptions::DefaultMethod) << qint64(0)
+            << 0;
+        QTest::newRow("store") << 0 << int(Lib7z::CompressionOptions::Store) << qint64(-1) << 1;
+        QTest::newRow("lzma fast") << 1 << int(Lib7z::CompressionOptions::Lzma) << qint64(0) << 1;
+        QTest::newRow("lzma2 ultra") << 9 << int(Lib7z::CompressionOptions::Lzma2) << qint64(1024 * 1024)
+            << 2;
+    }
+
+    void testCreateArchiveWithOptions()
+    {
+        QFETCH(int, level);
+        QFETCH(int, method);
+        QFETCH(qint64, solidBlockSize);
+        QFETCH(int, threadCount);
+
+        QTemporaryDir source;
+        QVERIFY(source.isValid());
+        QFile file(source.path() + QLatin1String("/content"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        const QByteArray data = QByteArray("Lib7z::createArchive ").repeated(4096);
+        QCOMPARE(file.write(data), qint64(data.size()));
+        file.close();
+
+        Lib7z::CompressionOptions options;
+        options.level = level;
+        options.method = Lib7z::CompressionOptions::Method(method);
+        options.dictionarySize = 1024 * 1024;
+        options.solidBlockSize = solidBlockSize;
+        options.threadCount = threadCount;
+
+        // the archive gets written behind existing content, without a temporary file
+        const QByteArray prefix("prefix");
+        QTemporaryFile target;
+        QVERIFY(target.open());
+        QCOMPARE(target.write(prefix), qint64(prefix.size()));
+        try {
+            Lib7z::createArchive(&target, QStringList() << file.fileName(), options);
+        } catch (const Lib7z::SevenZipException& e) {
+            QFAIL(e.message().toUtf8());
+        }
+        target.close();
+
+        QVERIFY(target.open());
+        QCOMPARE(target.read(prefix.size()), prefix);
+        if (method == Lib7z::CompressionOptions::Store)
+            QVERIFY(target.size() > prefix.size() + data.size());
+        else
+            QVERIFY(target.size() < prefix.size() + data.size());
+
+        QFile archive(target.fileName() + QLatin1String(".7z"));
+        QVERIFY(archive.open(QIODevice::WriteOnly));
+        QCOMPARE(archive.write(target.readAll()), target.size() - prefix.size());
+        archive.close();
+
+        QVERIFY(archive.open(QIODevice::ReadOnly));
+        QCOMPARE(Lib7z::isSupportedArchive(&archive), true);
+        const QVector<Lib7z::File> files = Lib7z::listArchive(&archive);
+        QCOMPARE(files.count(), 1);
+        QCOMPARE(files.first().path, QString::fromLatin1("content"));
+        QCOMPARE(files.first().uncompressedSize, quint64(data.size()));
+        archive.close();
+        archive.remove();
+    }
+
     void testExtractArchive()
     {
         QFile source(":///data/valid.7z");
@@ -135,6 +207,28 @@ private slots:
         }
     }
 
+    void testExtractArchiveMultiThreaded()
+    {
+        QFile source(":///data/valid.7z");
+        QVERIFY(source.open(QIODevice::ReadOnly));
+
+        QTemporaryDir target;
+        QVERIFY(target.isValid());
+
+        try {
+            Lib7z::extractArchive(&source, target.path(), 0, 4);
+        } catch (const Lib7z::SevenZipException& e) {
+            QFAIL(e.message().toUtf8());
+        } catch (...) {
+            QFAIL("Unexpected error during extract archive!");
+        }
+
+        // the content has been written by the worker threads before the call returned
+        QFileInfo extracted(target.path() + QLatin1String("/valid"));
+        QVERIFY(extracted.exists());
+        QCOMPARE(quint64(extracted.size()), m_file.uncompressedSize);
+    }
+
     void testExtractFileFromArchive()
     {
         QFile source(":///data/valid.7z");
@@ -0,0 +1,199 @@
+/**************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Installer Framework.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+**
+** $QT_END_LICENSE$
+**
+**************************************************************************/
+
+#include <errors.h>
+#include <fileio.h>
+#include <kdupdaterupdateoperations.h>
+#include <operationlog.h>
+
+#include <QTest>
+#include <QTemporaryFile>
+
+using namespace KDUpdater;
+using namespace QInstaller;
+
+class tst_OperationLog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writeAndRestore()
+    {
+        CopyOperation copy;
+        copy.setArguments(QStringList() << QLatin1String("/opt/app/lib/libfoo.so")
+            << QLatin1String("/opt/app/lib/libbar.so"));
+        copy.setValue(QLatin1String("component"), QLatin1String("org.app"));
+        copy.setValue(QLatin1String("admin"), true);
+        copy.setValue(QLatin1String("backupOfExistingDestination"), QLatin1String("/tmp/x"));
+
+        MkdirOperation mkdir;
+        mkdir.setArguments(QStringList() << QLatin1String("C:\\Program Files\\App"));
+        mkdir.setValue(QLatin1String("component"), QLatin1String("org.app"));
+        mkdir.setValue(QLatin1String("files"), QStringList() << QLatin1String("/opt/app/lib")
+            << QLatin1String("/opt/app/lib/libfoo.so") << QString());
+        mkdir.setValue(QLatin1String("count"), 42);
+        mkdir.setValue(QLatin1String("size"), qint64(1) << 40);
+        mkdir.setValue(QLatin1String("data"), QByteArray("\0\1\2", 3));
+        mkdir.setValue(QLatin1String("ratio"), 0.5);
+
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        OperationLog::write(&file, OperationList() << &copy << &mkdir);
+        file.close();
+
+        QInstaller::openForRead(&file);
+        const QList<OperationBlob> blobs = OperationLog::read(&file);
+        QVERIFY(file.atEnd());
+        QCOMPARE(blobs.count(), 2);
+        QCOMPARE(blobs.at(0).name, QLatin1String("Copy"));
+        QCOMPARE(blobs.at(1).name, QLatin1String("Mkdir"));
+        QVERIFY(blobs.at(1).log);
+        QVERIFY(blobs.at(1).xml.isEmpty());
+
+        CopyOperation restoredCopy;
+        QVERIFY(blobs.at(0).log->restore(blobs.at(0).index, &restoredCopy));
+        QCOMPARE(restoredCopy.arguments(), copy.arguments());
+        QCOMPARE(restoredCopy.value(QLatin1String("admin")), QVariant(true));
+        QVERIFY(!restoredCopy.hasValue(QLatin1String("backupOfExistingDestination")));
+
+        MkdirOperation restoredMkdir;
+        QVERIFY(blobs.at(1).log->restore(blobs.at(1).index, &restoredMkdir));
+        QCOMPARE(restoredMkdir.arguments(), mkdir.arguments());
+        QCOMPARE(restoredMkdir.persistentValues(), mkdir.persistentValues());
+        QCOMPARE(restoredMkdir.value(QLatin1String("count")).type(), QVariant::Int);
+        QCOMPARE(restoredMkdir.value(QLatin1String("size")).type(), QVariant::LongLong);
+    }
+
+    void appendSegment()
+    {
+        CopyOperation copy;
+        copy.setArguments(QStringList() << QLatin1String("/opt/app/a")
+            << QLatin1String("/opt/app/b"));
+        MkdirOperation mkdir;
+        mkdir.setArguments(QStringList() << QLatin1String("/opt/app"));
+        mkdir.setValue(QLatin1String("component"), QLatin1String("org.app"));
+
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        const OperationLog::Chain base = OperationLog::write(&file,
+            OperationList() << &copy << &mkdir);
+        const Range<qint64> baseSegment = Range<qint64>::fromStartAndEnd(0, file.pos());
+        QCOMPARE(base.length, qint64(1));
+        QCOMPARE(base.stored, qint64(2));
+
+        // drop the copy operation and add a new one behind the stored mkdir operation
+        MkdirOperation added;
+        added.setArguments(QStringList() << QLatin1String("/opt/app/doc"));
+        QHash<const Operation *, int> positions;
+        positions.insert(&copy, 0);
+        positions.insert(&mkdir, 1);
+
+        const qint64 appendedStart = file.pos();
+        const OperationLog::Chain chain = OperationLog::append(&file, OperationList() << &mkdir
+            << &added, positions, base, baseSegment);
+        QVERIFY(chain.id != base.id);
+        QCOMPARE(chain.length, qint64(2));
+        QCOMPARE(chain.stored, qint64(3));
+        file.close();
+
+        QInstaller::openForRead(&file);
+        QVERIFY(file.seek(appendedStart));
+        QCOMPARE(OperationLog::readChain(&file).id, chain.id);
+        QVERIFY(file.seek(appendedStart));
+        const QList<OperationBlob> blobs = OperationLog::read(&file);
+        QCOMPARE(blobs.count(), 2);
+        QCOMPARE(blobs.at(0).log->chain().id, chain.id);
+
+        MkdirOperation restoredMkdir;
+        QVERIFY(blobs.at(0).log->restore(blobs.at(0).index, &restoredMkdir));
+        QCOMPARE(restoredMkdir.arguments(), mkdir.arguments());
+        QCOMPARE(restoredMkdir.value(QLatin1String("component")).toString(),
+            QLatin1String("org.app"));
+        QCOMPARE(blobs.at(0).log->value(blobs.at(0).index, QLatin1String("component")),
+            QVariant(QLatin1String("org.app")));
+        QVERIFY(!blobs.at(1).log->value(blobs.at(1).index, QLatin1String("component")).isValid());
+
+        MkdirOperation restoredAdded;
+        QVERIFY(blobs.at(1).log->restore(blobs.at(1).index, &restoredAdded));
+        QCOMPARE(restoredAdded.arguments(), added.arguments());
+    }
+
+    void readLegacyLog()
+    {
+        MkdirOperation mkdir;
+        mkdir.setArguments(QStringList() << QLatin1String("/opt/app"));
+        mkdir.setValue(QLatin1String("component"), QLatin1String("org.app"));
+
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        QInstaller::appendInt64(&file, 1);
+        QInstaller::appendString(&file, mkdir.name());
+        QInstaller::appendString(&file, mkdir.toXml().toString());
+        QInstaller::appendInt64(&file, 1);
+        file.close();
+
+        QInstaller::openForRead(&file);
+        const QList<OperationBlob> blobs = OperationLog::read(&file);
+        QVERIFY(file.atEnd());
+        QCOMPARE(blobs.count(), 1);
+        QVERIFY(!blobs.first().log);
+
+        MkdirOperation restored;
+        QVERIFY(restored.fromXml(blobs.first().xml));
+        QCOMPARE(restored.arguments(), mkdir.arguments());
+        QCOMPARE(restored.value(QLatin1String("component")).toString(), QLatin1String("org.app"));
+    }
+
+    void readUnsupportedVersion()
+    {
+        QTemporaryFile file;
+        QInstaller::openForWrite(&file);
+        QInstaller::appendInt64(&file, OperationLog::Marker);
+        QInstaller::appendInt64(&file, OperationLog::Version + 1);
+        file.close();
+
+        QInstaller::openForRead(&file);
+        try {
+            OperationLog::read(&file);
+            QFAIL("Exception expected.");
+        } catch (const QInstaller::Error &error) {
+            QCOMPARE(error.message(), QString::fromLatin1("Unsupported operation log version %1.")
+                .arg(OperationLog::Version + 1));
+        }
+    }
+};
+
+QTEST_MAIN(tst_OperationLog)
+
+#include "tst_operationlog.moc"
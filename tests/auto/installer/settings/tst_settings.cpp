@@ -73,6 +73,7 @@ void tst_Settings::loadTutorialConfig()
     QCOMPARE(settings.allowSpaceInPath(), true);
     QCOMPARE(settings.allowNonAsciiCharacters(), false);
     QCOMPARE(settings.createLocalRepository(), false);
+    QCOMPARE(settings.maxConcurrentDownloads(), 4);
 
     QCOMPARE(settings.hasReplacementRepos(), false);
     QCOMPARE(settings.repositories(), QSet<Repository>());
@@ -91,6 +92,7 @@ void tst_Settings::loadTutorialConfig()
 void tst_Settings::loadFullConfig()
 {
     Settings settings = Settings::fromFileAndPrefix(":///data/full_config.xml", ":///data");
+    QCOMPARE(settings.maxConcurrentDownloads(), 6);
 }
 
 void tst_Settings::loadEmptyConfig()
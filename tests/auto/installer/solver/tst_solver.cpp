@@ -144,6 +144,46 @@ private slots:
         qDebug("Found cycle: %s", graph.hasCycle() ? "true" : "false");
         qDebug("(%s) has a indirect dependency on (%s).", qPrintable(cycle.second.data()),
             qPrintable(cycle.first.data()));
+
+        QVERIFY(graph.hasCycle());
+        const QList<Data> path = graph.cyclePath();
+        QCOMPARE(path.count(), 6);
+        QCOMPARE(path.first(), path.last());
+        QCOMPARE(cycle.first, path.at(path.count() - 2));
+        QCOMPARE(cycle.second, path.last());
+    }
+
+    void sortGraphBenchmark_data()
+    {
+        QTest::addColumn<int>("nodeCount");
+        QTest::newRow("10k nodes") << 10000;
+        QTest::newRow("100k nodes") << 100000;
+    }
+
+    void sortGraphBenchmark()
+    {
+        QFETCH(int, nodeCount);
+
+        // every node depends on up to three of its successors, so the graph is acyclic
+        Graph<int> graph;
+        for (int i = 0; i < nodeCount; ++i) {
+            graph.addNode(i);
+            for (int j = 1; j <= 3 && i + j < nodeCount; ++j)
+                graph.addEdge(i, i + j);
+        }
+
+        QList<int> resolved;
+        QBENCHMARK {
+            resolved = graph.sort();
+        }
+
+        QVERIFY(!graph.hasCycle());
+        QCOMPARE(resolved.count(), nodeCount);
+        QHash<int, int> position;
+        for (int i = 0; i < resolved.count(); ++i)
+            position.insert(resolved.at(i), i);
+        for (int i = 0; i + 1 < nodeCount; ++i)
+            QVERIFY(position.value(i + 1) < position.value(i));
     }
 
     void resolveInstaller_data()
@@ -256,6 +296,40 @@ private slots:
     }
 
 
+    void componentIndex()
+    {
+        PackageManagerCore core;
+        core.setPackageManager();
+
+        NamedComponent *componentA = new NamedComponent(&core, QLatin1String("A"), QLatin1String("2.0.0"));
+        NamedComponent *componentB = new NamedComponent(&core, QLatin1String("B"));
+        NamedComponent *componentC = new NamedComponent(&core, QLatin1String("C"));
+        componentB->addDependency(QLatin1String("A->=1.0.0"));
+        core.appendRootComponent(componentA);
+        core.appendRootComponent(componentB);
+        core.appendRootComponent(componentC);
+
+        QCOMPARE(core.componentByName(QLatin1String("A")), componentA);
+        QCOMPARE(core.componentByName(QLatin1String("A->=2.0.0")), componentA);
+        QVERIFY(core.componentByName(QLatin1String("A->2.0.0")) == 0);
+        QVERIFY(core.componentByName(QLatin1String("D")) == 0);
+        QCOMPARE(core.dependees(componentA), QList<Component *>() << componentB);
+
+        // dependencies added later on, for example by a script, need to show up as well
+        componentC->addDependency(QLatin1String("A-<1.0.0"));
+        QCOMPARE(core.dependees(componentA), QList<Component *>() << componentB);
+        componentC->addDependency(QLatin1String("B"));
+        QCOMPARE(core.dependees(componentB), QList<Component *>() << componentC);
+
+        // children appended to an already indexed component
+        NamedComponent *componentAA = new NamedComponent(&core, QLatin1String("A.A"));
+        componentA->appendComponent(componentAA);
+        QCOMPARE(core.componentByName(QLatin1String("A.A")), componentAA);
+        componentA->removeComponent(componentAA);
+        QVERIFY(core.componentByName(QLatin1String("A.A")) == 0);
+        delete componentAA;
+    }
+
     void checkComponent_data()
     {
         QTest::addColumn<QList<Component *> >("componentsToCheck");
@@ -34,23 +34,297 @@
 #include "common/repositorygen.h"
 
 #include <errors.h>
+#include <fileio.h>
+#include <fileutils.h>
 #include <init.h>
 #include <lib7z_facade.h>
 #include <utils.h>
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDirIterator>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
 #include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
 
+#include <iomanip>
 #include <iostream>
 
+#if defined(Q_OS_WIN)
+#include <qt_windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
 using namespace Lib7z;
 using namespace QInstaller;
 
 static void printUsage()
 {
-    std::cout << "Usage: " << QFileInfo(QCoreApplication::applicationFilePath()).fileName()
-        << " directory.7z [files | directories]" << std::endl;
+    const QString appName = QFileInfo(QCoreApplication::applicationFilePath()).fileName();
+    std::cout << "Usage: " << appName << " [options] directory.7z [files | directories]" << std::endl;
+    std::cout << "       " << appName << " --benchmark [options] [files | directories]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    QInstallerTools::printCompressionOptions();
+    std::cout << std::endl;
+    std::cout << "Benchmark options:" << std::endl;
+    std::cout << "  --benchmark               Compress the files with every combination of the given" << std::endl;
+    std::cout << "                            compression options and extract each archive again." << std::endl;
+    std::cout << "                            The compression options take comma separated lists." << std::endl;
+    std::cout << "  --format table|json       Print the results as a table (default) or as JSON." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Example:" << std::endl;
+    std::cout << "  " << appName << " --benchmark --compression-method lzma,lzma2 --compression-level 1,5,9"
+        " --solid-block-size off,64m --compression-threads 1,4 packages/data" << std::endl;
+}
+
+/*
+    Resets the peak resident set size of the process, where the operating system allows that.
+*/
+static void resetPeakMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile clearRefs(QLatin1String("/proc/self/clear_refs"));
+    if (clearRefs.open(QIODevice::WriteOnly))
+        clearRefs.write("5");
+#endif
+}
+
+/*
+    Returns the peak resident set size of the process in bytes, or -1 if it is unknown.
+*/
+static qint64 peakMemory()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return -1;
+#elif defined(Q_OS_LINUX)
+    QFile status(QLatin1String("/proc/self/status"));
+    if (status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        foreach (const QByteArray &line, status.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:"))
+                return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+        }
+    }
+    return -1;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#ifdef Q_OS_OSX
+    return usage.ru_maxrss;
+#else
+    return qint64(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return -1;
+#endif
+}
+
+static qint64 totalSize(const QStringList &paths)
+{
+    qint64 size = 0;
+    foreach (const QString &path, paths) {
+        const QFileInfo fi(path);
+        if (!fi.isDir()) {
+            size += fi.size();
+            continue;
+        }
+        QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            if (!it.fileInfo().isSymLink())
+                size += it.fileInfo().size();
+        }
+    }
+    return size;
+}
+
+static QString methodName(const CompressionOptions &options)
+{
+    switch (options.method) {
+    case CompressionOptions::Lzma:
+        return QLatin1String("lzma");
+    case CompressionOptions::Lzma2:
+        return QLatin1String("lzma2");
+    case CompressionOptions::Store:
+        return QLatin1String("store");
+    default:
+        return QLatin1String("default");
+    }
+}
+
+static QString sizeName(qint64 size)
+{
+    if (size == 0)
+        return QLatin1String("default");
+    if (size < 0)
+        return QLatin1String("off");
+    if (size % (1 << 20) == 0)
+        return QString::number(size >> 20) + QLatin1Char('m');
+    if (size % (1 << 10) == 0)
+        return QString::number(size >> 10) + QLatin1Char('k');
+    return QString::number(size);
+}
+
+static QString numberName(int number)
+{
+    return number <= 0 ? QString::fromLatin1("default") : QString::number(number);
+}
+
+struct BenchmarkResult
+{
+    CompressionOptions options;
+    qint64 compressedSize;
+    qint64 compressionTime;
+    qint64 extractionTime;
+    qint64 peakMemory;
+};
+
+/*
+    Compresses \a paths using \a options into \a workDir, extracts the archive again and measures
+    both steps.
+*/
+static BenchmarkResult runBenchmark(const QStringList &paths, const CompressionOptions &options,
+    const QString &workDir)
+{
+    BenchmarkResult result;
+    result.options = options;
+    resetPeakMemory();
+
+    const QString archivePath = workDir + QLatin1String("/benchmark.7z");
+    QElapsedTimer timer;
+    {
+        QFile archive(archivePath);
+        QInstaller::openForWrite(&archive);
+        timer.start();
+        Lib7z::createArchive(&archive, paths, options);
+        archive.close();
+        result.compressionTime = timer.elapsed();
+        result.compressedSize = archive.size();
+    }
+
+    const QString targetDir = workDir + QLatin1String("/extracted");
+    {
+        QFile archive(archivePath);
+        QInstaller::openForRead(&archive);
+        timer.start();
+        Lib7z::extractArchive(&archive, targetDir, 0, qMax(1, options.threadCount));
+        result.extractionTime = timer.elapsed();
+    }
+    result.peakMemory = peakMemory();
+
+    QInstaller::removeDirectory(targetDir);
+    QFile::remove(archivePath);
+    return result;
+}
+
+static void printTable(const QList<BenchmarkResult> &results, qint64 uncompressedSize)
+{
+    std::cout << std::left << std::setw(9) << "method" << std::setw(7) << "level" << std::setw(12)
+        << "dictionary" << std::setw(9) << "solid" << std::setw(9) << "threads" << std::right
+        << std::setw(14) << "size" << std::setw(8) << "ratio" << std::setw(13) << "compress ms"
+        << std::setw(12) << "extract ms" << std::setw(14) << "peak RSS MiB" << std::endl;
+
+    foreach (const BenchmarkResult &result, results) {
+        const CompressionOptions &options = result.options;
+        const double ratio = uncompressedSize > 0 ? double(result.compressedSize) / uncompressedSize : 0;
+        std::cout << std::left << std::setw(9) << methodName(options) << std::setw(7)
+            << numberName(options.level) << std::setw(12) << sizeName(options.dictionarySize)
+            << std::setw(9) << sizeName(options.solidBlockSize) << std::setw(9)
+            << numberName(options.threadCount) << std::right << std::setw(14) << result.compressedSize
+            << std::setw(8) << std::fixed << std::setprecision(3) << ratio << std::setw(13)
+            << result.compressionTime << std::setw(12) << result.extractionTime << std::setw(14)
+            << (result.peakMemory < 0 ? QString::fromLatin1("-")
+                : QString::number(result.peakMemory / (1024.0 * 1024.0), 'f', 1)) << std::endl;
+    }
+}
+
+static void printJson(const QList<BenchmarkResult> &results, qint64 uncompressedSize)
+{
+    QJsonArray array;
+    foreach (const BenchmarkResult &result, results) {
+        const CompressionOptions &options = result.options;
+        QJsonObject object;
+        object.insert(QLatin1String("method"), methodName(options));
+        object.insert(QLatin1String("level"), options.level);
+        object.insert(QLatin1String("dictionarySize"), double(options.dictionarySize));
+        object.insert(QLatin1String("solidBlockSize"), double(options.solidBlockSize));
+        object.insert(QLatin1String("threadCount"), options.threadCount);
+        object.insert(QLatin1String("uncompressedSize"), double(uncompressedSize));
+        object.insert(QLatin1String("compressedSize"), double(result.compressedSize));
+        object.insert(QLatin1String("compressionTime"), double(result.compressionTime));
+        object.insert(QLatin1String("extractionTime"), double(result.extractionTime));
+        object.insert(QLatin1String("peakMemory"), double(result.peakMemory));
+        array.append(object);
+    }
+    std::cout << QJsonDocument(array).toJson().constData();
+}
+
+static int benchmark(QStringList args)
+{
+    // every value of a compression option multiplies the settings benchmarked so far
+    QList<CompressionOptions> matrix;
+    matrix.append(CompressionOptions());
+    bool json = false;
+    while (!args.isEmpty() && args.first().startsWith(QLatin1Char('-'))) {
+        const QString option = args.takeFirst();
+        if (args.isEmpty()) {
+            std::cerr << "Missing value for " << option << std::endl << std::endl;
+            printUsage();
+            return EXIT_FAILURE;
+        }
+        const QString value = args.takeFirst();
+
+        if (option == QLatin1String("--format") && (value == QLatin1String("table")
+            || value == QLatin1String("json"))) {
+                json = (value == QLatin1String("json"));
+                continue;
+        }
+
+        QList<CompressionOptions> expanded;
+        foreach (const CompressionOptions &options, matrix) {
+            foreach (const QString &item, value.split(QLatin1Char(','), QString::SkipEmptyParts)) {
+                CompressionOptions combination = options;
+                if (!QInstallerTools::setCompressionOption(option, item, &combination)) {
+                    std::cerr << "Invalid value " << item << " for " << option << std::endl << std::endl;
+                    printUsage();
+                    return EXIT_FAILURE;
+                }
+                expanded.append(combination);
+            }
+        }
+        matrix = expanded;
+    }
+
+    if (args.isEmpty() || matrix.isEmpty()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid())
+        throw QInstaller::Error(QLatin1String("Could not create a temporary directory."));
+
+    const qint64 uncompressedSize = totalSize(args);
+    QList<BenchmarkResult> results;
+    for (int i = 0; i < matrix.count(); ++i) {
+        std::cerr << "Running benchmark " << (i + 1) << " of " << matrix.count() << "..." << std::endl;
+        results.append(runBenchmark(args, matrix.at(i), workDir.path()));
+    }
+
+    if (json)
+        printJson(results, uncompressedSize);
+    else
+        printTable(results, uncompressedSize);
+    return EXIT_SUCCESS;
 }
 
 int main(int argc, char *argv[])
@@ -58,15 +332,31 @@ int main(int argc, char *argv[])
     try {
         QCoreApplication app(argc, argv);
 
-        if (app.arguments().count() < 3) {
+        QStringList args = app.arguments().mid(1);
+        if (!args.isEmpty() && args.first() == QLatin1String("--benchmark")) {
+            QInstaller::init();
+            return benchmark(args.mid(1));
+        }
+
+        while (!args.isEmpty() && QInstallerTools::isCompressionOption(args.first())) {
+            const QString option = args.takeFirst();
+            if (args.isEmpty() || !QInstallerTools::setCompressionOption(option, args.first())) {
+                std::cerr << "Invalid value for " << option << std::endl << std::endl;
+                printUsage();
+                return EXIT_FAILURE;
+            }
+            args.removeFirst();
+        }
+
+        if (args.count() < 2) {
             printUsage();
             return EXIT_FAILURE;
         }
 
         QInstaller::init();
         QInstaller::setVerbose(true);
-        const QStringList sourceDirectories = app.arguments().mid(2);
-        QInstallerTools::compressPaths(sourceDirectories, app.arguments().at(1));
+        const QStringList sourceDirectories = args.mid(1);
+        QInstallerTools::compressPaths(sourceDirectories, args.at(0));
         return EXIT_SUCCESS;
     } catch (const Lib7z::SevenZipException &e) {
         std::cerr << "caught 7zip exception: " << e.message() << std::endl;
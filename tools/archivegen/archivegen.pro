@@ -14,4 +14,6 @@ SOURCES += archive.cpp \
         ../common/repositorygen.cpp
 HEADERS += ../common/repositorygen.h
 
+win32:LIBS += -lpsapi   # benchmark memory usage
+
 macx:include(../../no_app_bundle.pri)
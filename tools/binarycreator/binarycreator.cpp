@@ -45,6 +45,7 @@
 #include <settings.h>
 #include <utils.h>
 
+#include <QBuffer>
 #include <QDateTime>
 #include <QDirIterator>
 #include <QDomDocument>
@@ -197,29 +198,41 @@ static int assemble(Input input, const QInstaller::Settings &settings)
     Q_UNUSED(settings)
 #endif
 
-    QTemporaryFile file(input.outputPath);
-    if (!file.open()) {
-        throw Error(QString::fromLatin1("Could not copy %1 to %2: %3").arg(input.installerExePath,
-            input.outputPath, file.errorString()));
-    }
-
-    const QString tempFile = file.fileName();
-    file.close();
-    file.remove();
-
-    QFile instExe(input.installerExePath);
-    if (!instExe.copy(tempFile)) {
-        throw Error(QString::fromLatin1("Could not copy %1 to %2: %3").arg(instExe.fileName(),
-            tempFile, instExe.errorString()));
+    // Patch the installer base in memory; unless a platform tool below has to modify the
+    // executable, it is written straight into the installer without an intermediate file.
+    QByteArray installerBase;
+    {
+        QFile instExe(input.installerExePath);
+        QInstaller::openForRead(&instExe);
+        installerBase = instExe.readAll();
     }
 
 #ifndef LUMIT_INSTALLER
-    QtPatch::patchBinaryFile(tempFile, QByteArray("MY_InstallerCreateDateTime_MY"),
-        QDateTime::currentDateTime().toString(QLatin1String("yyyy-MM-dd - HH:mm:ss")).toLatin1());
+    {
+        QBuffer buffer(&installerBase);
+        buffer.open(QIODevice::ReadWrite);
+        QtPatch::patchBinaryFile(&buffer, QByteArray("MY_InstallerCreateDateTime_MY"),
+            QDateTime::currentDateTime().toString(QLatin1String("yyyy-MM-dd - HH:mm:ss")).toLatin1());
+    }
 #endif
 
-
+    QString tempFile;
+#if defined(Q_OS_WIN) || defined(Q_OS_OSX)
+    {
+        QTemporaryFile file(input.outputPath);
+        if (!file.open()) {
+            throw Error(QString::fromLatin1("Could not copy %1 to %2: %3").arg(input.installerExePath,
+                input.outputPath, file.errorString()));
+        }
+        QInstaller::blockingWrite(&file, installerBase);
+        file.setAutoRemove(false);
+        tempFile = file.fileName();
+    }
+#ifdef Q_OS_OSX
+    chmod755(tempFile);
+#endif
     input.installerExePath = tempFile;
+#endif
 
 #if defined(Q_OS_WIN)
     // setting the windows icon must happen before we append our binary data - otherwise they get lost :-/
@@ -242,7 +255,6 @@ static int assemble(Input input, const QInstaller::Settings &settings)
     }
 #endif
 
-    QTemporaryFile out;
     QString targetName = input.outputPath;
 #ifdef Q_OS_OSX
     QDir resourcePath(QFileInfo(input.outputPath).dir());
@@ -250,6 +262,8 @@ static int assemble(Input input, const QInstaller::Settings &settings)
     resourcePath.cd(QLatin1String("Resources"));
     targetName = resourcePath.filePath(QLatin1String("installer.dat"));
 #endif
+    // next to the target, so the final rename does not have to copy the data
+    QTemporaryFile out(targetName);
 
     {
         QFile target(targetName);
@@ -262,19 +276,7 @@ static int assemble(Input input, const QInstaller::Settings &settings)
     }
 
     try {
-        QInstaller::openForWrite(&out);
-        QFile exe(input.installerExePath);
-
-#ifdef Q_OS_OSX
-        if (!exe.copy(input.outputPath)) {
-            throw Error(QString::fromLatin1("Could not copy %1 to %2: %3").arg(exe.fileName(),
-                input.outputPath, exe.errorString()));
-        }
-#else
-        QInstaller::openForRead(&exe);
-        QInstaller::appendData(&out, &exe, exe.size());
-#endif
-
+        qint64 estimatedSize = 0;
         foreach (const QInstallerTools::PackageInfo &info, input.packages) {
             QInstaller::ResourceCollection collection;
             collection.setName(info.name.toUtf8());
@@ -285,13 +287,49 @@ static int assemble(Input input, const QInstaller::Settings &settings)
                 qDebug() << QString::fromLatin1("Appending %1 (%2)").arg(file,
                     humanReadableSize(resource->size()));
                 collection.appendResource(resource);
+                estimatedSize += resource->size();
             }
             input.manager.insertCollection(collection);
         }
+        foreach (const QSharedPointer<Resource> &resource,
+            input.manager.collectionByName("QResources").resources()) {
+            estimatedSize += resource->size();
+        }
+
+        QInstaller::openForWrite(&out);
+#ifdef Q_OS_OSX
+        QFile exe(input.installerExePath);
+        if (!exe.copy(input.outputPath)) {
+            throw Error(QString::fromLatin1("Could not copy %1 to %2: %3").arg(exe.fileName(),
+                input.outputPath, exe.errorString()));
+        }
+#else
+        estimatedSize += installerBase.size();
+#endif
+        // An upper bound, resources with identical content get stored only once.
+        if (!QInstaller::preallocate(&out, estimatedSize)) {
+            throw Error(QString::fromLatin1("Not enough disk space to write %1 (%2).").arg(
+                targetName, humanReadableSize(estimatedSize)));
+        }
+
+#if defined(Q_OS_WIN)
+        QFile exe(input.installerExePath);
+        QInstaller::openForRead(&exe);
+        QInstaller::appendData(&out, &exe, exe.size());
+#elif !defined(Q_OS_OSX)
+        QInstaller::blockingWrite(&out, installerBase);
+#endif
+        installerBase.clear();
 
         const QList<QInstaller::OperationBlob> operations;
         BinaryContent::writeBinaryContent(&out, operations, input.manager,
             BinaryContent::MagicInstallerMarker, BinaryContent::MagicCookie);
+
+        // drop whatever has been reserved but not written
+        if (!out.resize(out.pos())) {
+            throw Error(QString::fromLatin1("Could not write installer to %1: %2").arg(targetName,
+                out.errorString()));
+        }
     } catch (const Error &e) {
         qCritical("Error occurred while assembling the installer: %s", qPrintable(e.message()));
         QFile::remove(tempFile);
@@ -564,6 +602,7 @@ int main(int argc, char **argv)
     QStringList filteredPackages;
     QInstallerTools::FilterType ftype = QInstallerTools::Exclude;
     bool compileResource = false;
+    int jobs = 1;
 
     const QStringList args = app.arguments().mid(1);
     for (QStringList::const_iterator it = args.begin(); it != args.end(); ++it) {
@@ -646,6 +685,22 @@ int main(int argc, char **argv)
             if (it == args.end() || it->startsWith(QLatin1String("-")))
                 return printErrorAndUsageAndExit(QString::fromLatin1("Error: Resource files to include are missing."));
             resources = it->split(QLatin1Char(','));
+        } else if (*it == QLatin1String("-j") || *it == QLatin1String("--jobs")) {
+            ++it;
+            bool ok = false;
+            if (it != args.end())
+                jobs = it->toInt(&ok);
+            if (!ok || jobs < 1) {
+                return printErrorAndUsageAndExit(QString::fromLatin1("Error: Jobs parameter needs a "
+                    "positive number."));
+            }
+        } else if (QInstallerTools::isCompressionOption(*it)) {
+            const QString option = *it;
+            ++it;
+            if (it == args.end() || !QInstallerTools::setCompressionOption(option, *it)) {
+                return printErrorAndUsageAndExit(QString::fromLatin1("Error: Invalid value for %1.")
+                    .arg(option));
+            }
         } else if (*it == QLatin1String("--ignore-translations")
             || *it == QLatin1String("--ignore-invalid-packages")) {
                 continue;
@@ -711,7 +766,7 @@ int main(int argc, char **argv)
         // 2; copy the packages data and setup the packages vector with the files we copied,
         //    must happen before copying meta data because files will be compressed if
         //    needed and meta data generation relies on this
-        QInstallerTools::copyComponentData(packagesDirectories, tmpRepoDir, &packages);
+        QInstallerTools::copyComponentData(packagesDirectories, tmpRepoDir, &packages, jobs);
 
         // 3; copy the meta data of the available packages, generate Updates.xml
         QInstallerTools::copyMetaData(tmpMetaDir, tmpRepoDir, packages, settings
@@ -34,6 +34,7 @@
 #include "repositorygen.h"
 
 #include <fileio.h>
+#include <filehasher.h>
 #include <fileutils.h>
 #include <errors.h>
 #include <globals.h>
@@ -45,11 +46,17 @@
 
 #include <kdupdater.h>
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QDirIterator>
+#include <QtCore/QThreadPool>
 
 #include <QtXml/QDomDocument>
 
+#include <algorithm>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <vector>
 
 using namespace QInstallerTools;
 
@@ -64,6 +71,105 @@ void QInstallerTools::printRepositoryGenOptions()
 
     std::cout << "  --ignore-translations     Do not use any translation" << std::endl;
     std::cout << "  --ignore-invalid-packages Ignore all invalid packages instead of aborting." << std::endl;
+    std::cout << "  -j|--jobs n               Compress and hash up to n packages in parallel." << std::endl;
+
+    printCompressionOptions();
+}
+
+void QInstallerTools::printCompressionOptions()
+{
+    std::cout << "  --compression-level n     Compression level from 0 (store) to 9 (ultra), default 5." << std::endl;
+    std::cout << "  --compression-method m    Compression method: lzma (default), lzma2 or store." << std::endl;
+    std::cout << "  --dictionary-size s       Dictionary size, for example 64m. The default depends" << std::endl;
+    std::cout << "                            on the compression level." << std::endl;
+    std::cout << "  --solid-block-size s      Size of the solid blocks, for example 1g, or off to" << std::endl;
+    std::cout << "                            compress every file on its own." << std::endl;
+    std::cout << "  --compression-threads n   Number of threads used to compress a single archive," << std::endl;
+    std::cout << "                            one per processor core by default." << std::endl;
+}
+
+static Lib7z::CompressionOptions &compressionOptions()
+{
+    static Lib7z::CompressionOptions options;
+    return options;
+}
+
+/*
+    Parses sizes like 4096, 512k, 64m or 1g. Returns 0 if \a value is not a valid size.
+*/
+static qint64 parseSize(const QString &value)
+{
+    QString number = value.toLower();
+    int shift = 0;
+    const int unit = number.isEmpty() ? -1 : QString::fromLatin1("bkmg").indexOf(number.at(number
+        .size() - 1));
+    if (unit >= 0) {
+        shift = unit * 10;
+        number.chop(1);
+    }
+
+    bool ok = false;
+    const qint64 size = number.toLongLong(&ok);
+    if (!ok || size <= 0 || size >= (Q_INT64_C(1) << (62 - shift)))
+        return 0;
+    return size << shift;
+}
+
+bool QInstallerTools::isCompressionOption(const QString &option)
+{
+    return option == QLatin1String("--compression-level")
+        || option == QLatin1String("--compression-method")
+        || option == QLatin1String("--dictionary-size")
+        || option == QLatin1String("--solid-block-size")
+        || option == QLatin1String("--compression-threads");
+}
+
+bool QInstallerTools::setCompressionOption(const QString &option, const QString &value)
+{
+    return setCompressionOption(option, value, &compressionOptions());
+}
+
+bool QInstallerTools::setCompressionOption(const QString &option, const QString &value,
+    Lib7z::CompressionOptions *options)
+{
+    bool ok = false;
+    if (option == QLatin1String("--compression-level")) {
+        const int level = value.toInt(&ok);
+        if (!ok || level < 0 || level > 9)
+            return false;
+        options->level = level;
+    } else if (option == QLatin1String("--compression-method")) {
+        const QString method = value.toLower();
+        if (method == QLatin1String("lzma"))
+            options->method = Lib7z::CompressionOptions::Lzma;
+        else if (method == QLatin1String("lzma2"))
+            options->method = Lib7z::CompressionOptions::Lzma2;
+        else if (method == QLatin1String("store"))
+            options->method = Lib7z::CompressionOptions::Store;
+        else
+            return false;
+    } else if (option == QLatin1String("--dictionary-size")) {
+        const qint64 size = parseSize(value);
+        if (size <= 0 || size > Q_INT64_C(0xFFFFFFFF))
+            return false;
+        options->dictionarySize = quint32(size);
+    } else if (option == QLatin1String("--solid-block-size")) {
+        if (value.toLower() == QLatin1String("off")) {
+            options->solidBlockSize = -1;
+        } else {
+            options->solidBlockSize = parseSize(value);
+            if (options->solidBlockSize <= 0)
+                return false;
+        }
+    } else if (option == QLatin1String("--compression-threads")) {
+        const int threads = value.toInt(&ok);
+        if (!ok || threads < 1)
+            return false;
+        options->threadCount = threads;
+    } else {
+        return false;
+    }
+    return true;
 }
 
 QString QInstallerTools::makePathAbsolute(const QString &path)
@@ -97,7 +203,7 @@ void QInstallerTools::compressPaths(const QStringList &paths, const QString &arc
 {
     QFile archive(archivePath);
     QInstaller::openForWrite(&archive);
-    Lib7z::createArchive(&archive, paths);
+    Lib7z::createArchive(&archive, paths, compressionOptions());
 }
 
 static QStringList copyFilesFromNode(const QString &parentNode, const QString &childNode, const QString &attr,
@@ -509,8 +615,65 @@ static void writeSHA1ToNodeWithName(QDomDocument &doc, QDomNodeList &list, const
     }
 }
 
+namespace {
+
+class JobRunnable : public QRunnable
+{
+public:
+    explicit JobRunnable(const std::function<void ()> &job)
+        : m_job(job)
+    {}
+
+    void run()
+    {
+        m_job();
+    }
+
+private:
+    std::function<void ()> m_job;
+};
+
+} // namespace
+
+/*
+    Calls \a job for every index below \a count, on up to \a jobs threads. Once all calls are done,
+    the exception thrown for the lowest index is rethrown, so the outcome does not depend on the
+    order in which the threads picked up their work.
+*/
+static void runJobs(int count, int jobs, const std::function<void (int)> &job)
+{
+    if (jobs <= 1) {
+        for (int i = 0; i < count; ++i)
+            job(i);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(count);
+    QAtomicInt next(0);
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+    for (int i = 0; i < qMin(jobs, count); ++i) {
+        pool.start(new JobRunnable([&]() {
+            int index;
+            while ((index = next.fetchAndAddRelaxed(1)) < count) {
+                try {
+                    job(index);
+                } catch (...) {
+                    errors[index] = std::current_exception();
+                }
+            }
+        }));
+    }
+    pool.waitForDone();
+
+    for (size_t i = 0; i < errors.size(); ++i) {
+        if (errors[i])
+            std::rethrow_exception(errors[i]);
+    }
+}
+
 void QInstallerTools::compressMetaDirectories(const QString &repoDir, const QString &baseDir,
-    const QHash<QString, QString> &versionMapping)
+    const QHash<QString, QString> &versionMapping, int jobs)
 {
     QDomDocument doc;
     QDomElement root;
@@ -524,31 +687,50 @@ void QInstallerTools::compressMetaDirectories(const QString &repoDir, const QStr
     existingUpdatesXml.close();
 
     QDir dir(repoDir);
-    const QStringList sub = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-    QDomNodeList elements =  doc.elementsByTagName(QLatin1String("PackageUpdate"));
-    foreach (const QString &i, sub) {
-        QDir sd(dir);
-        sd.cd(i);
-        const QString path = QString(i).remove(baseDir);
-        const QString versionPrefix = versionMapping[path];
-        if (path.isNull())
-            continue;
-        const QString absPath = sd.absolutePath();
-        const QString fn = QLatin1String(versionPrefix.toLatin1() + "meta.7z");
-        const QString tmpTarget = repoDir + QLatin1String("/") +fn;
+    QStringList sub;
+    foreach (const QString &i, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        if (!QString(i).remove(baseDir).isNull())
+            sub.append(i);
+    }
+
+    // compress the meta directories in parallel, the results are merged in order below
+    QStringList tmpTargets;
+    for (int i = 0; i < sub.count(); ++i)
+        tmpTargets.append(QString());
+    runJobs(sub.count(), jobs, [&](int index) {
+        const QString path = QString(sub.at(index)).remove(baseDir);
+        const QString fn = versionMapping.value(path) + QLatin1String("meta.7z");
+        // the name of the directory keeps the temporary archives of equal versions apart
+        const QString tmpTarget = repoDir + QLatin1String("/") + sub.at(index) + QLatin1Char('-')
+            + fn;
+        const QString absPath = QDir(dir.filePath(sub.at(index))).absolutePath();
         compressPaths(QStringList() << absPath, tmpTarget);
 
         // remove the files that got compressed
         QInstaller::removeFiles(absPath, true);
 
-        QFile tmp(tmpTarget);
-        tmp.open(QFile::ReadOnly);
-        const QByteArray sha1Sum = QInstaller::calculateHash(&tmp, QCryptographicHash::Sha1);
-        writeSHA1ToNodeWithName(doc, elements, sha1Sum, path);
-        const QString finalTarget = absPath + QLatin1String("/") + fn;
+        tmpTargets[index] = tmpTarget;
+    });
+
+    // hash all meta archives in parallel
+    QInstaller::FileHasher hasher(QCryptographicHash::Sha1);
+    const QList<QInstaller::FileHasher::Result> hashes = hasher.hashFiles(tmpTargets);
+
+    QDomNodeList elements =  doc.elementsByTagName(QLatin1String("PackageUpdate"));
+    for (int i = 0; i < sub.count(); ++i) {
+        const QInstaller::FileHasher::Result &result = hashes.at(i);
+        if (!result.errorString.isEmpty())
+            throw QInstaller::Error(result.errorString);
+
+        const QString path = QString(sub.at(i)).remove(baseDir);
+        writeSHA1ToNodeWithName(doc, elements, result.hash, path);
+
+        const QString finalTarget = QDir(dir.filePath(sub.at(i))).absolutePath() + QLatin1String("/")
+            + versionMapping.value(path) + QLatin1String("meta.7z");
+        QFile tmp(result.fileName);
         if (!tmp.rename(finalTarget)) {
-            throw QInstaller::Error(QString::fromLatin1("Could not move '%1' to '%2'").arg(tmpTarget,
-                finalTarget));
+            throw QInstaller::Error(QString::fromLatin1("Could not move '%1' to '%2'").arg(result
+                .fileName, finalTarget));
         }
     }
 
@@ -557,85 +739,320 @@ void QInstallerTools::compressMetaDirectories(const QString &repoDir, const QStr
     existingUpdatesXml.close();
 }
 
-void QInstallerTools::copyComponentData(const QStringList &packageDirs, const QString &repoDir,
-    PackageInfoVector *const infos)
+/*
+    Copies or compresses the data of the package \a info to its directory below \a repoDir.
+    Returns the archives in the order they were created.
+*/
+static QStringList copyPackageData(const QStringList &packageDirs, const QString &repoDir,
+    const PackageInfo &info)
 {
-    for (int i = 0; i < infos->count(); ++i) {
-        const PackageInfo info = infos->at(i);
-        const QString name = info.name;
-        qDebug() << "Copying component data for" << name;
-
-        const QString namedRepoDir = QString::fromLatin1("%1/%2").arg(repoDir, name);
-        if (!QDir().mkpath(namedRepoDir)) {
-            throw QInstaller::Error(QString::fromLatin1("Could not create repository folder for component '%1'")
-                .arg(name));
-        }
+    const QString name = info.name;
+    qDebug() << "Copying component data for" << name;
 
-        QStringList compressedFiles;
-        QStringList filesToCompress;
-        foreach (const QString &packageDir, packageDirs) {
-            const QDir dataDir(QString::fromLatin1("%1/%2/data").arg(packageDir, name));
-            foreach (const QString &entry, dataDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Files)) {
-                QFileInfo fileInfo(dataDir.absoluteFilePath(entry));
-                if (fileInfo.isFile() && !fileInfo.isSymLink()) {
-                    const QString absoluteEntryFilePath = dataDir.absoluteFilePath(entry);
-                    if (Lib7z::isSupportedArchive(absoluteEntryFilePath)) {
-                        QFile tmp(absoluteEntryFilePath);
-                        QString target = QString::fromLatin1("%1/%3%2").arg(namedRepoDir, entry, info.version);
-                        qDebug() << QString::fromLatin1("Copying archive from '%1' to '%2'").arg(tmp.fileName(),
-                            target);
-                        if (!tmp.copy(target)) {
-                            throw QInstaller::Error(QString::fromLatin1("Could not copy '%1' to '%2': %3")
-                                .arg(tmp.fileName(), target, tmp.errorString()));
-                        }
-                        compressedFiles.append(target);
-                    } else {
-                        filesToCompress.append(absoluteEntryFilePath);
+    const QString namedRepoDir = QString::fromLatin1("%1/%2").arg(repoDir, name);
+    if (!QDir().mkpath(namedRepoDir)) {
+        throw QInstaller::Error(QString::fromLatin1("Could not create repository folder for component '%1'")
+            .arg(name));
+    }
+
+    QStringList compressedFiles;
+    QStringList filesToCompress;
+    foreach (const QString &packageDir, packageDirs) {
+        const QDir dataDir(QString::fromLatin1("%1/%2/data").arg(packageDir, name));
+        foreach (const QString &entry, dataDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Files)) {
+            QFileInfo fileInfo(dataDir.absoluteFilePath(entry));
+            if (fileInfo.isFile() && !fileInfo.isSymLink()) {
+                const QString absoluteEntryFilePath = dataDir.absoluteFilePath(entry);
+                if (Lib7z::isSupportedArchive(absoluteEntryFilePath)) {
+                    QFile tmp(absoluteEntryFilePath);
+                    QString target = QString::fromLatin1("%1/%3%2").arg(namedRepoDir, entry, info.version);
+                    qDebug() << QString::fromLatin1("Copying archive from '%1' to '%2'").arg(tmp.fileName(),
+                        target);
+                    if (!tmp.copy(target)) {
+                        throw QInstaller::Error(QString::fromLatin1("Could not copy '%1' to '%2': %3")
+                            .arg(tmp.fileName(), target, tmp.errorString()));
                     }
-                } else if (fileInfo.isDir()) {
-                    qDebug() << "Compressing data directory" << entry;
-                    QString target = QString::fromLatin1("%1/%3%2.7z").arg(namedRepoDir, entry, info.version);
-                    QInstallerTools::compressPaths(QStringList() << dataDir.absoluteFilePath(entry), target);
                     compressedFiles.append(target);
-                } else if (fileInfo.isSymLink()) {
-                    filesToCompress.append(dataDir.absoluteFilePath(entry));
+                } else {
+                    filesToCompress.append(absoluteEntryFilePath);
                 }
+            } else if (fileInfo.isDir()) {
+                qDebug() << "Compressing data directory" << entry;
+                QString target = QString::fromLatin1("%1/%3%2.7z").arg(namedRepoDir, entry, info.version);
+                QInstallerTools::compressPaths(QStringList() << dataDir.absoluteFilePath(entry), target);
+                compressedFiles.append(target);
+            } else if (fileInfo.isSymLink()) {
+                filesToCompress.append(dataDir.absoluteFilePath(entry));
             }
         }
+    }
 
-        if (!filesToCompress.isEmpty()) {
-            qDebug() << "Compressing files found in data directory:" << filesToCompress;
-            QString target = QString::fromLatin1("%1/%3%2").arg(namedRepoDir, QLatin1String("content.7z"),
-                info.version);
-            QInstallerTools::compressPaths(filesToCompress, target);
-            compressedFiles.append(target);
-        }
+    if (!filesToCompress.isEmpty()) {
+        qDebug() << "Compressing files found in data directory:" << filesToCompress;
+        QString target = QString::fromLatin1("%1/%3%2").arg(namedRepoDir, QLatin1String("content.7z"),
+            info.version);
+        QInstallerTools::compressPaths(filesToCompress, target);
+        compressedFiles.append(target);
+    }
+    return compressedFiles;
+}
 
-        foreach (const QString &target, compressedFiles) {
-            (*infos)[i].copiedFiles.append(target);
+void QInstallerTools::copyComponentData(const QStringList &packageDirs, const QString &repoDir,
+    PackageInfoVector *const infos, int jobs)
+{
+    // every package is compressed on its own, the results are merged in order below
+    const PackageInfoVector packages = *infos;
+    QVector<QStringList> compressedFiles(packages.count());
+    runJobs(packages.count(), jobs, [&](int index) {
+        compressedFiles[index] = copyPackageData(packageDirs, repoDir, packages.at(index));
+    });
+
+    QList<QPair<int, QString> > archives;
+    for (int i = 0; i < compressedFiles.count(); ++i) {
+        foreach (const QString &target, compressedFiles.at(i))
+            archives.append(qMakePair(i, target));
+    }
 
-            QFile archiveFile(target);
-            QFile archiveHashFile(archiveFile.fileName() + QLatin1String(".sha1"));
+    // hash the archives of all components in parallel
+    QStringList archiveNames;
+    for (int i = 0; i < archives.count(); ++i)
+        archiveNames.append(archives.at(i).second);
+
+    QInstaller::FileHasher hasher(QCryptographicHash::Sha1);
+    const QList<QInstaller::FileHasher::Result> hashes = hasher.hashFiles(archiveNames);
+    for (int i = 0; i < hashes.count(); ++i) {
+        const QInstaller::FileHasher::Result &result = hashes.at(i);
+        if (!result.errorString.isEmpty())
+            throw QInstaller::Error(result.errorString);
+
+        PackageInfo &info = (*infos)[archives.at(i).first];
+        info.copiedFiles.append(result.fileName);
+
+        QFile archiveHashFile(result.fileName + QLatin1String(".sha1"));
+        qDebug() << "Hash is stored in" << archiveHashFile.fileName();
+
+        const QByteArray hashOfArchiveData = result.hash.toHex();
+        QInstaller::openForWrite(&archiveHashFile);
+        archiveHashFile.write(hashOfArchiveData);
+        qDebug() << "Generated sha1 hash:" << hashOfArchiveData;
+        info.copiedFiles.append(archiveHashFile.fileName());
+        archiveHashFile.close();
+    }
 
-            qDebug() << "Hash is stored in" << archiveHashFile.fileName();
-            qDebug() << "Creating hash of archive" << archiveFile.fileName();
+    qDebug() << "Hashed" << hasher.filesHashed() << "archives," << hasher.bytesHashed()
+        << "bytes in" << hasher.elapsed() << "ms.";
+}
 
-            try {
-                QInstaller::openForRead(&archiveFile);
-                const QByteArray hashOfArchiveData = QInstaller::calculateHash(&archiveFile,
-                    QCryptographicHash::Sha1).toHex();
-                archiveFile.close();
-
-                QInstaller::openForWrite(&archiveHashFile);
-                archiveHashFile.write(hashOfArchiveData);
-                qDebug() << "Generated sha1 hash:" << hashOfArchiveData;
-                (*infos)[i].copiedFiles.append(archiveHashFile.fileName());
-                archiveHashFile.close();
-            } catch (const QInstaller::Error &/*e*/) {
-                archiveFile.close();
-                archiveHashFile.close();
-                throw;
+PackageDigests QInstallerTools::calculatePackageDigests(const QStringList &packageDirs,
+    const PackageInfoVector &packages)
+{
+    // the options that change the generated archives and meta data are part of every digest;
+    // the number of threads is left out, an archive built with other threads is just as good
+    const Lib7z::CompressionOptions &compression = compressionOptions();
+    QByteArray options = QString::fromLatin1("%1 %2 %3 %4").arg(compression.level)
+        .arg(compression.method).arg(compression.dictionarySize).arg(compression.solidBlockSize)
+        .toLatin1();
+    if (qApp->arguments().contains(QString::fromLatin1("--ignore-translations")))
+        options += " --ignore-translations";
+
+    // collect the entries of all package trees first, so the files can be hashed in parallel; an
+    // entry is the relative path and type of a file system entry plus the file to hash, if any
+    typedef QPair<QString, QString> Entry;
+    QVector<QList<Entry> > entries(packages.count());
+    QStringList files;
+    for (int i = 0; i < packages.count(); ++i) {
+        QList<Entry> &packageEntries = entries[i];
+        int tree = 0;
+        foreach (const QString &packageDir, packageDirs) {
+            const QDir root(QDir(packageDir).absoluteFilePath(packages.at(i).name));
+            if (!root.exists())
+                continue;
+
+            const QString prefix = QString::number(tree++) + QLatin1Char(':');
+            QDirIterator it(root.absolutePath(), QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden
+                | QDir::System, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                const QFileInfo fi(it.next());
+                const QString path = prefix + root.relativeFilePath(fi.absoluteFilePath());
+                if (fi.isSymLink()) {
+                    packageEntries.append(qMakePair(path + QLatin1String(" -> ") + fi.symLinkTarget(),
+                        QString()));
+                } else if (fi.isDir()) {
+                    packageEntries.append(qMakePair(path + QLatin1Char('/'), QString()));
+                } else {
+                    packageEntries.append(qMakePair(path, fi.absoluteFilePath()));
+                    files.append(fi.absoluteFilePath());
+                }
             }
         }
+        std::sort(packageEntries.begin(), packageEntries.end());
+    }
+
+    QInstaller::FileHasher hasher(QCryptographicHash::Sha1);
+    QHash<QString, QByteArray> fileHashes;
+    foreach (const QInstaller::FileHasher::Result &result, hasher.hashFiles(files)) {
+        if (!result.errorString.isEmpty())
+            throw QInstaller::Error(result.errorString);
+        fileHashes.insert(result.fileName, result.hash);
+    }
+
+    PackageDigests digests;
+    for (int i = 0; i < packages.count(); ++i) {
+        QCryptographicHash digest(QCryptographicHash::Sha1);
+        digest.addData(options);
+        foreach (const Entry &entry, entries.at(i)) {
+            digest.addData(entry.first.toUtf8());
+            digest.addData("\0", 1);
+            if (!entry.second.isEmpty())
+                digest.addData(fileHashes.value(entry.second));
+        }
+        digests.insert(packages.at(i).name, digest.result());
+    }
+
+    qDebug() << "Hashed" << hasher.filesHashed() << "package files," << hasher.bytesHashed()
+        << "bytes in" << hasher.elapsed() << "ms.";
+    return digests;
+}
+
+static QString buildManifestPath(const QString &repoDir)
+{
+    return QDir(repoDir).absoluteFilePath(QLatin1String("BuildManifest.xml"));
+}
+
+/*
+    Returns the Package elements of the build manifest in \a repoDir by package name, or an empty
+    hash if there is no (valid) manifest.
+*/
+static QHash<QString, QDomElement> readBuildManifest(const QString &repoDir, QDomDocument *doc)
+{
+    QHash<QString, QDomElement> entries;
+    QFile file(buildManifestPath(repoDir));
+    if (!file.open(QIODevice::ReadOnly) || !doc->setContent(&file))
+        return entries;
+    if (doc->documentElement().tagName() != QLatin1String("BuildManifest"))
+        return entries;
+
+    QDomElement entry = doc->documentElement().firstChildElement(QLatin1String("Package"));
+    for (; !entry.isNull(); entry = entry.nextSiblingElement(QLatin1String("Package")))
+        entries.insert(entry.attribute(QLatin1String("Name")), entry);
+    return entries;
+}
+
+/*
+    Returns the hex encoded SHA1 of the meta data archive of each package listed in the
+    Updates.xml in \a repoDir.
+*/
+static QHash<QString, QString> readMetaHashes(const QString &repoDir)
+{
+    QHash<QString, QString> hashes;
+    QDomDocument doc;
+    QFile file(QDir(repoDir).absoluteFilePath(QLatin1String("Updates.xml")));
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file))
+        return hashes;
+
+    QDomElement update = doc.documentElement().firstChildElement(QLatin1String("PackageUpdate"));
+    for (; !update.isNull(); update = update.nextSiblingElement(QLatin1String("PackageUpdate"))) {
+        hashes.insert(update.firstChildElement(QLatin1String("Name")).text(),
+            update.firstChildElement(QLatin1String("SHA1")).text());
+    }
+    return hashes;
+}
+
+static QString readArchiveHash(const QString &archive)
+{
+    QFile file(archive + QLatin1String(".sha1"));
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+    return QString::fromLatin1(file.readAll().trimmed());
+}
+
+static bool isUpToDate(const QString &repoDir, const QDomElement &entry, const QByteArray &digest,
+    const QString &metaHash)
+{
+    if (entry.attribute(QLatin1String("Digest")) != QString::fromLatin1(digest.toHex()))
+        return false;
+    if (metaHash.isEmpty() || entry.attribute(QLatin1String("SHA1")) != metaHash)
+        return false;
+
+    const QDir packageDir(QDir(repoDir).absoluteFilePath(entry.attribute(QLatin1String("Name"))));
+    QDomElement file = entry.firstChildElement(QLatin1String("File"));
+    for (; !file.isNull(); file = file.nextSiblingElement(QLatin1String("File"))) {
+        const QFileInfo fi(packageDir.absoluteFilePath(file.text()));
+        if (!fi.isFile() || QString::number(fi.size()) != file.attribute(QLatin1String("Size")))
+            return false;
+        if (file.hasAttribute(QLatin1String("SHA1"))
+            && readArchiveHash(fi.absoluteFilePath()) != file.attribute(QLatin1String("SHA1"))) {
+                return false;
+        }
     }
+    return true;
+}
+
+QStringList QInstallerTools::takeUnchangedPackages(const QString &repoDir, const PackageDigests &digests,
+    PackageInfoVector *packages)
+{
+    QDomDocument doc;
+    const QHash<QString, QDomElement> entries = readBuildManifest(repoDir, &doc);
+    if (entries.isEmpty())
+        return QStringList();
+
+    const QHash<QString, QString> metaHashes = readMetaHashes(repoDir);
+    QStringList unchanged;
+    PackageInfoVector changed;
+    foreach (const PackageInfo &info, *packages) {
+        if (entries.contains(info.name) && isUpToDate(repoDir, entries.value(info.name),
+            digests.value(info.name), metaHashes.value(info.name))) {
+                qDebug() << "Reusing the archives of unchanged package" << info.name;
+                unchanged.append(info.name);
+        } else {
+            changed.append(info);
+        }
+    }
+    *packages = changed;
+    return unchanged;
+}
+
+void QInstallerTools::writeBuildManifest(const QString &repoDir, const PackageDigests &digests)
+{
+    QDomDocument oldDoc;
+    const QHash<QString, QDomElement> oldEntries = readBuildManifest(repoDir, &oldDoc);
+    const QHash<QString, QString> metaHashes = readMetaHashes(repoDir);
+
+    QStringList names = oldEntries.keys() + digests.keys();
+    names.removeDuplicates();
+    names.sort();
+
+    QDomDocument doc;
+    QDomElement root = doc.createElement(QLatin1String("BuildManifest"));
+    foreach (const QString &name, names) {
+        if (!metaHashes.contains(name))
+            continue;   // the package is not part of the repository anymore
+
+        if (!digests.contains(name)) {
+            // the package was not part of this run, keep what we knew about it
+            root.appendChild(doc.importNode(oldEntries.value(name), true));
+            continue;
+        }
+
+        QDomElement entry = doc.createElement(QLatin1String("Package"));
+        entry.setAttribute(QLatin1String("Name"), name);
+        entry.setAttribute(QLatin1String("Digest"), QString::fromLatin1(digests.value(name).toHex()));
+        entry.setAttribute(QLatin1String("SHA1"), metaHashes.value(name));
+
+        const QDir packageDir(QDir(repoDir).absoluteFilePath(name));
+        foreach (const QFileInfo &fi, packageDir.entryInfoList(QDir::Files | QDir::Hidden, QDir::Name)) {
+            QDomElement file = doc.createElement(QLatin1String("File"));
+            file.setAttribute(QLatin1String("Size"), QString::number(fi.size()));
+            const QString archiveHash = readArchiveHash(fi.absoluteFilePath());
+            if (!archiveHash.isEmpty())
+                file.setAttribute(QLatin1String("SHA1"), archiveHash);
+            entry.appendChild(file).appendChild(doc.createTextNode(fi.fileName()));
+        }
+        root.appendChild(entry);
+    }
+    doc.appendChild(root);
+
+    QFile manifest(buildManifestPath(repoDir));
+    QInstaller::openForWrite(&manifest);
+    QInstaller::blockingWrite(&manifest, doc.toByteArray());
 }
@@ -40,6 +40,10 @@
 #include <QStringList>
 #include <QVector>
 
+namespace Lib7z {
+class CompressionOptions;
+}
+
 namespace QInstallerTools {
 
 
@@ -52,6 +56,7 @@ struct PackageInfo
     QStringList copiedFiles;
 };
 typedef QVector<PackageInfo> PackageInfoVector;
+typedef QHash<QString, QByteArray> PackageDigests;
 
 enum FilterType {
     Include,
@@ -59,6 +64,11 @@ enum FilterType {
 };
 
 void printRepositoryGenOptions();
+void printCompressionOptions();
+bool isCompressionOption(const QString &option);
+bool setCompressionOption(const QString &option, const QString &value);
+bool setCompressionOption(const QString &option, const QString &value, Lib7z::CompressionOptions *options);
+
 QString makePathAbsolute(const QString &path);
 void copyWithException(const QString &source, const QString &target, const QString &kind = QString());
 
@@ -68,11 +78,17 @@ QHash<QString, QString> buildPathToVersionMapping(const PackageInfoVector &info)
 
 void compressPaths(const QStringList &paths, const QString &archivePath);
 void compressMetaDirectories(const QString &repoDir, const QString &baseDir,
-    const QHash<QString, QString> &versionMapping);
+    const QHash<QString, QString> &versionMapping, int jobs = 1);
 
 void copyMetaData(const QString &outDir, const QString &dataDir, const PackageInfoVector &packages,
     const QString &appName, const QString& appVersion);
-void copyComponentData(const QStringList &packageDir, const QString &repoDir, PackageInfoVector *const infos);
+void copyComponentData(const QStringList &packageDir, const QString &repoDir, PackageInfoVector *const infos,
+    int jobs = 1);
+
+PackageDigests calculatePackageDigests(const QStringList &packageDirs, const PackageInfoVector &packages);
+QStringList takeUnchangedPackages(const QString &repoDir, const PackageDigests &digests,
+    PackageInfoVector *packages);
+void writeBuildManifest(const QString &repoDir, const PackageDigests &digests);
 
 
 } // namespace QInstallerTools
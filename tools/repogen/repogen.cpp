@@ -68,6 +68,8 @@ static void printUsage()
 
     std::cout << "  --update                  Update a set of existing components (defined by " << std::endl;
     std::cout << "                            --include or --exclude) in the repository" << std::endl;
+    std::cout << "                            Components whose package directories did not change" << std::endl;
+    std::cout << "                            since the last run are kept as they are." << std::endl;
 
     std::cout << "  --update-new-components   Update a set of existing components (defined by " << std::endl;
     std::cout << "                            --include or --exclude) in the repository with all new components"
@@ -104,6 +106,7 @@ int main(int argc, char** argv)
         QStringList packagesDirectories;
         QInstallerTools::FilterType filterType = QInstallerTools::Exclude;
         bool remove = false;
+        int jobs = 1;
         bool updateExistingRepositoryWithNewComponents = false;
 
         //TODO: use a for loop without removing values from args like it is in binarycreator.cpp
@@ -169,6 +172,23 @@ int main(int argc, char** argv)
             } else if (args.first() == QLatin1String("-r") || args.first() == QLatin1String("--remove")) {
                 remove = true;
                 args.removeFirst();
+            } else if (args.first() == QLatin1String("-j") || args.first() == QLatin1String("--jobs")) {
+                args.removeFirst();
+                bool ok = false;
+                if (!args.isEmpty())
+                    jobs = args.first().toInt(&ok);
+                if (!ok || jobs < 1) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Jobs parameter needs a positive number"));
+                }
+                args.removeFirst();
+            } else if (QInstallerTools::isCompressionOption(args.first())) {
+                const QString option = args.takeFirst();
+                if (args.isEmpty() || !QInstallerTools::setCompressionOption(option, args.first())) {
+                    return printErrorAndUsageAndExit(QCoreApplication::translate("QInstaller",
+                        "Error: Invalid value for %1").arg(option));
+                }
+                args.removeFirst();
             } else {
                 printUsage();
                 return 1;
@@ -247,6 +267,18 @@ int main(int argc, char** argv)
             }
         }
 
+        // packages whose inputs did not change since the last run keep their archives and meta data
+        const QInstallerTools::PackageDigests digests =
+            QInstallerTools::calculatePackageDigests(packagesDirectories, packages);
+        if (update) {
+            QInstallerTools::takeUnchangedPackages(repositoryDir, digests, &packages);
+            if (packages.isEmpty()) {
+                std::cout << QString::fromLatin1("All components in '%1' are up to date.")
+                    .arg(repositoryDir) << std::endl;
+                return EXIT_SUCCESS;
+            }
+        }
+
         QHash<QString, QString> pathToVersionMapping = QInstallerTools::buildPathToVersionMapping(packages);
 
         foreach (const QInstallerTools::PackageInfo &package, packages) {
@@ -258,10 +290,10 @@ int main(int argc, char** argv)
         QTemporaryDir tmp;
         tmp.setAutoRemove(false);
         tmpMetaDir = tmp.path();
-        QInstallerTools::copyComponentData(packagesDirectories, repositoryDir, &packages);
+        QInstallerTools::copyComponentData(packagesDirectories, repositoryDir, &packages, jobs);
         QInstallerTools::copyMetaData(tmpMetaDir, repositoryDir, packages, QLatin1String("{AnyApplication}"),
             QLatin1String(QUOTE(IFW_REPOSITORY_FORMAT_VERSION)));
-        QInstallerTools::compressMetaDirectories(tmpMetaDir, tmpMetaDir, pathToVersionMapping);
+        QInstallerTools::compressMetaDirectories(tmpMetaDir, tmpMetaDir, pathToVersionMapping, jobs);
 
         QDirIterator it(repositoryDir, QStringList(QLatin1String("Updates*.xml")), QDir::Files | QDir::CaseSensitive);
         while (it.hasNext()) {
@@ -269,6 +301,7 @@ int main(int argc, char** argv)
             QFile::remove(it.fileInfo().absoluteFilePath());
         }
         QInstaller::moveDirectoryContents(tmpMetaDir, repositoryDir);
+        QInstallerTools::writeBuildManifest(repositoryDir, digests);
         exitCode = EXIT_SUCCESS;
     } catch (const Lib7z::SevenZipException &e) {
         std::cerr << "Caught 7zip exception: " << e.message() << std::endl;